@@ -66,7 +66,7 @@ static void updateUniformBuffer( uint32_t currentFrame, const SceneInstance* cam
 	GpuInputData currentGpuInputData = _inputBuffers[currentFrame];
 	VkExtent2D viewportExtent = GetImage( &currentGpuInputData, eTechniqueDataEntryImageName::SCENE_COLOR )->image->extent;
 
-	BufferAllocator allocator { GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::INSTANCE_DATA ) };
+	BufferAllocator allocator = CreateBufferSlotAllocator( GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::INSTANCE_DATA ), R_HW::eDescriptorType::BUFFER_DYNAMIC );
 	for( uint32_t i = 0; i < drawList.size(); ++i )
 	{
 		SceneInstanceSet instanceDescSet;
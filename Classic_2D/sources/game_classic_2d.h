@@ -365,11 +365,11 @@ namespace WildWeasel_Game
 		}
 	}
 
-	ECS::System lifeTimeSystem = ECS::System::Create<LifeTimeComponent, TransformationComponent>( UpdateLifeTime );
-	ECS::System physicsSystem = ECS::System::Create<PhysicsComponent, TransformationComponent>( UpdatePhysics );
-	ECS::System collisionsSystem = ECS::System::Create<CollisionComponent, TransformationComponent>( UpdateCollisions );
-	ECS::System buildDrawlistSystem = ECS::System::Create < RenderableComponent, TransformationComponent >( BuildDrawlistSystem );
-	ECS::System runEntityScriptsSystem = ECS::System::Create< ScriptComponent >( RunEntityScripts );
+	ECS::System lifeTimeSystem = ECS::System::Create<LifeTimeComponent, TransformationComponent>( UpdateLifeTime, "UpdateLifeTime" );
+	ECS::System physicsSystem = ECS::System::Create<PhysicsComponent, TransformationComponent>( UpdatePhysics, "UpdatePhysics" );
+	ECS::System collisionsSystem = ECS::System::Create<CollisionComponent, TransformationComponent>( UpdateCollisions, "UpdateCollisions" );
+	ECS::System buildDrawlistSystem = ECS::System::Create < RenderableComponent, TransformationComponent >( BuildDrawlistSystem, "BuildDrawlistSystem" );
+	ECS::System runEntityScriptsSystem = ECS::System::Create< ScriptComponent >( RunEntityScripts, "RunEntityScripts" );
 
 	void createBullet()
 	{
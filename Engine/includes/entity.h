@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <array>
 #include "memory.h"
+#include "cpu_profiler.h"
 
 namespace ECS
 {
@@ -586,16 +587,17 @@ namespace ECS
 
 	public:
 		void( *m_update ) ( Entity*, uint32_t, class EntityComponentSystem* );
+		const char* m_name;
 
-		System( ArchetypeKey key, void( *update ) ( Entity*, uint32_t, class EntityComponentSystem* ) )
-			: m_key( key ), m_update( update )
+		System( ArchetypeKey key, void( *update ) ( Entity*, uint32_t, class EntityComponentSystem* ), const char* name = "ECS::System" )
+			: m_key( key ), m_update( update ), m_name( name )
 		{
 		}
 
 		template< typename ... ComponentTypes >
-		static System Create( void( *func_update ) ( Entity*, uint32_t, class EntityComponentSystem* ) )
+		static System Create( void( *func_update ) ( Entity*, uint32_t, class EntityComponentSystem* ), const char* name = "ECS::System" )
 		{
-			return System( ArchetypeKey::Create< ComponentTypes ... >(), func_update );
+			return System( ArchetypeKey::Create< ComponentTypes ... >(), func_update, name );
 		}
 
 		bool CanRun( const ArchetypeKey& key ) const
@@ -676,6 +678,7 @@ namespace ECS
 
 		void RunSystem( const System& system )
 		{
+			PROFILE_ZONE( system.m_name );
 			EntityID entitiesIds[256];
 			uint32_t entities_count = entityComponentContainer.GetEntitiesWithKey(system.GetKey(), entitiesIds, 256);
 
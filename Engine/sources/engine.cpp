@@ -1,10 +1,16 @@
 #include "engine.h"
 
+#include "cpu_profiler.h"
+#include "file_system.h"
+#include "shader_library.h"
+
 namespace Engine
 {
 	EngineState _engineState;
 	R_HW::DisplaySurface _displaySurface;
 
+	static const char* PIPELINE_CACHE_FILE_NAME = "pipeline_cache.bin";
+
 	void SetNextScript( const char * scriptName )
 	{
 		auto it = _engineState._scripts_library.find( scriptName );
@@ -24,6 +30,7 @@ namespace Engine
 
 	static void SwapScripts( EngineState* engineState )
 	{
+		PROFILE_FUNCTION();
 		vkDeviceWaitIdle( g_gfx.device.device );
 
 		if( engineState->_currentSceneScript.name != nullptr )
@@ -50,22 +57,38 @@ namespace Engine
 		g_gfx.physicalDevice = PickSuitablePhysicalDevice( _displaySurface, g_gfx.instance );
 		g_gfx.device = R_HW::create_logical_device( _displaySurface, g_gfx.physicalDevice, useValidationLayer );
 
+		//Pipelines compiled in a previous run come from the cache, a missing or stale file just starts an empty one
+		std::vector<char> pipelineCacheData;
+		FS::tryReadFile( PIPELINE_CACHE_FILE_NAME, &pipelineCacheData );
+		R_HW::CreatePipelineCache( g_gfx.physicalDevice, pipelineCacheData, &g_gfx.device );
+
 		//Init renderer stuff
 		_engineState._initRendererImp( &_displaySurface );
 
+		PROF::SetThreadName( "Main" );
 		while( !WH::shouldClose() )
 		{
+			PROFILE_ZONE( "Frame" );
 			if( NewScriptQueued( _engineState ) )
 				SwapScripts( &_engineState );
 
-			//TODO: thread this
-			WH::ProcessMessages();
-			_engineState._currentSceneScript.updateCallback();
+			//The scene script processes the window messages itself, when its input is sampled
+			{
+				//The profiler keeps the name pointer until the trace is written
+				const char* scriptName = _engineState._currentSceneScript.name;
+				PROFILE_ZONE( scriptName ? scriptName : "SceneUpdate" );
+				_engineState._currentSceneScript.updateCallback();
+			}
 		}
 
 		R_HW::DeviceWaitIdle( g_gfx.device.device );
 		_engineState._currentSceneScript.destroyCallback();
 		_engineState._destroyRendererImp();
+		DestroyShaderLibrary();
+
+		pipelineCacheData = R_HW::GetPipelineCacheData( g_gfx.physicalDevice, g_gfx.device );
+		if( !pipelineCacheData.empty() )
+			FS::writeFile( PIPELINE_CACHE_FILE_NAME, pipelineCacheData );
 
 		WH::VK::DestroySurface( &_displaySurface, g_gfx.instance.instance );
 		Destroy( &g_gfx.device );
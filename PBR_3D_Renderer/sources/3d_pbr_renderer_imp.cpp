@@ -81,7 +81,7 @@ static void updateUniformBuffer( uint32_t currentFrame, const SceneInstance* cam
 
 	GpuInputData currentGpuInputData = _inputBuffers[currentFrame];
 
-	BufferAllocator allocator { GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::INSTANCE_DATA ) };
+	BufferAllocator allocator = CreateBufferSlotAllocator( GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::INSTANCE_DATA ), R_HW::eDescriptorType::BUFFER_DYNAMIC );
 	for( uint32_t i = 0; i < drawList.size(); ++i )
 	{
 		SceneInstanceSet instanceDescSet;
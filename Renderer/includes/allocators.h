@@ -5,6 +5,32 @@ struct BufferAllocator
 {
 	const R_HW::GpuBuffer* buffer;
 	size_t head = 0;
+	size_t alignment = 1;
 };
 
-size_t AllocateGpuBufferSlot( BufferAllocator* allocator, size_t slotSize );
\ No newline at end of file
+//Slots are aligned on what the device requires for offsets of descriptors of that type
+BufferAllocator CreateBufferSlotAllocator( const R_HW::GpuBuffer* buffer, R_HW::eDescriptorType descriptorType );
+size_t AllocateGpuBufferSlot( BufferAllocator* allocator, size_t slotSize );
+
+//Persistently mapped buffer split in one region per frame in flight, allocations are only valid for the frame.
+//The region of a frame is reused g_gfx.framesInFlight frames later, once the gpu is done with it.
+struct GpuRingAllocator
+{
+	R_HW::GpuBuffer buffer;
+	size_t frameSize = 0;
+	size_t frameStart = 0;
+	size_t head = 0;
+};
+
+struct GpuRingAllocation
+{
+	void* data;
+	R_HW::GfxDeviceSize offset;
+};
+
+void CreateGpuRingAllocator( size_t frameSize, R_HW::GfxBufferUsageFlags bufferUsageFlags, GpuRingAllocator* o_allocator );
+void Destroy( GpuRingAllocator* allocator );
+void BeginFrame( GpuRingAllocator* allocator, uint32_t frameIndex );
+GpuRingAllocation AllocateGpuRingSlot( GpuRingAllocator* allocator, size_t size, size_t alignment );
+//Flushes everything allocated since BeginFrame in one call
+void FlushFrame( const GpuRingAllocator* allocator );
\ No newline at end of file
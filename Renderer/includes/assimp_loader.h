@@ -1,5 +1,6 @@
 #pragma once
 
 #include "gfx_model.h"
+#include "mesh_optimizer.h"
 
-void LoadModel_AssImp( const char * filename, GfxModel& o_modelAsset, size_t hackModelIndex, R_HW::I_BufferAllocator* allocator );
\ No newline at end of file
+void LoadModel_AssImp( const char * filename, GfxModel& o_modelAsset, size_t hackModelIndex, R_HW::I_BufferAllocator* allocator, bool optimizeMesh = true, bool generateLods = true, MeshOptimizationStats* io_stats = nullptr );
\ No newline at end of file
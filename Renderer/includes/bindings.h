@@ -16,7 +16,9 @@ struct GpuInputData
 	//TODO the ptr here is kinda dangerous. Used to point to an array for arrays of descriptors that contains multiple descriptors... mostly just for images
 	std::array<GpuInputDataEntry, MAX_DATA_ENTRIES> data;
 	std::array<uint32_t, MAX_DATA_ENTRIES> dataCount;
-	//TOOD: add a dirty cache, so when a buffer changes, we update the descriptor sets
+	//Bumped by every Set, the descriptors are only written again when it changed. 0 is never set
+	//Set the data again after changing the content of an array
+	std::array<uint32_t, MAX_DATA_ENTRIES> versions;
 };
 
 inline void SetBuffers( GpuInputData* buffers, uint32_t id, R_HW::GpuBuffer* input, uint32_t count )
@@ -24,6 +26,7 @@ inline void SetBuffers( GpuInputData* buffers, uint32_t id, R_HW::GpuBuffer* inp
 	assert( id < MAX_DATA_ENTRIES );
 	buffers->data[id].buffer = input;
 	buffers->dataCount[id] = count;
+	++buffers->versions[id];
 }
 
 inline void SetImages( GpuInputData* buffers, uint32_t id, R_HW::GfxImageSamplerCombined* input, uint32_t count )
@@ -31,6 +34,7 @@ inline void SetImages( GpuInputData* buffers, uint32_t id, R_HW::GfxImageSampler
 	assert( id < MAX_DATA_ENTRIES );
 	buffers->data[id].image = input;
 	buffers->dataCount[id] = count;
+	++buffers->versions[id];
 }
 
 inline void SetSamplers( GpuInputData* buffers, uint32_t id, R_HW::GfxApiSampler* input, uint32_t count )
@@ -38,6 +42,7 @@ inline void SetSamplers( GpuInputData* buffers, uint32_t id, R_HW::GfxApiSampler
 	assert( id < MAX_DATA_ENTRIES );
 	buffers->data[id].sampler = input;
 	buffers->dataCount[id] = count;
+	++buffers->versions[id];
 }
 
 inline R_HW::GpuBuffer* GetBuffer( const GpuInputData* buffers, uint32_t id )
@@ -2,11 +2,30 @@
 #include "gfx_image.h"
 #include "../shaders/shadersCommon.h"
 
+#include <vector>
+
+struct RetiredBindlessTexture
+{
+	uint32_t index;
+	//Frames to wait before the slot can be given again, see RecycleBindlessTextures
+	uint32_t framesLeft;
+};
+
+//Slots without an image are holes, the bindless array is partially bound so they are never written
 struct BindlessTexturesState
 {
 	R_HW::GfxImageSamplerCombined _bindlessTextures[BINDLESS_TEXTURES_MAX];
+	//Highest slot given + 1
 	uint32_t _bindlessTexturesCount = 0;
+	std::vector<uint32_t> _freeIndices;
+	std::vector<RetiredBindlessTexture> _retiredIndices;
+	//Bumped every time a slot changes, the input data only needs to be set again when it did
+	uint32_t _version = 0;
 };
 
 uint32_t RegisterBindlessTexture( BindlessTexturesState* state, R_HW::GfxImage* image, eSamplers eSampler );
-uint32_t RegisterBindlessTexture( BindlessTexturesState* state, R_HW::GfxImage* image );
\ No newline at end of file
+uint32_t RegisterBindlessTexture( BindlessTexturesState* state, R_HW::GfxImage* image );
+//The frames in flight can still sample the texture, the image has to stay alive and the slot isn't given again until they are done
+void UnregisterBindlessTexture( BindlessTexturesState* state, uint32_t index );
+//Call once per frame, after waiting on the fence of the frame about to be recorded
+void RecycleBindlessTextures( BindlessTexturesState* state );
\ No newline at end of file
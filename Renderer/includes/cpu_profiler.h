@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+// CPU zone profiler. Every thread records into its own ring buffer, no locks are taken while recording.
+// Zone names must be string literals (or outlive the profiler), only the pointer is stored.
+namespace PROF
+{
+	constexpr uint32_t MAX_EVENTS_PER_THREAD = 1 << 16;
+	constexpr uint32_t MAX_ZONE_DEPTH = 64;
+
+	struct ZoneEvent
+	{
+		const char* name;
+		uint64_t start_ns;
+		uint64_t end_ns;
+		uint32_t depth;
+	};
+
+	uint64_t GetTimeNs();
+
+	void BeginZone( const char* name );
+	void EndZone();
+
+	void SetThreadName( const char* name );
+
+	//Writes every recorded zone of every thread in the Chrome trace event format (chrome://tracing, Perfetto)
+	bool DumpChromeTrace( const char* fileName );
+	void Clear();
+
+	struct ScopedZone
+	{
+		ScopedZone( const char* name ) { BeginZone( name ); }
+		~ScopedZone() { EndZone(); }
+		ScopedZone( const ScopedZone& ) = delete;
+		ScopedZone& operator=( const ScopedZone& ) = delete;
+	};
+}
+
+#define PROF_CONCAT_IMP( a, b ) a##b
+#define PROF_CONCAT( a, b ) PROF_CONCAT_IMP( a, b )
+
+#ifndef PROF_DISABLED
+#define PROFILE_ZONE( name ) PROF::ScopedZone PROF_CONCAT( _profile_zone_, __LINE__ )( name )
+#define PROFILE_FUNCTION() PROFILE_ZONE( __FUNCTION__ )
+#else
+#define PROFILE_ZONE( name )
+#define PROFILE_FUNCTION()
+#endif
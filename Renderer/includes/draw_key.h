@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// 64 bits sort key of a draw, from the most significant bits:
+// pass (4) | pipeline (8) | depth (20) | material (16) | geometry (16)
+// Sorting by key runs the passes in order, groups the pipelines and draws front to back.
+// Depth comes before the material and the geometry: with instancing a geometry is drawn once per pass anyway.
+constexpr uint32_t DRAW_KEY_PASS_BITS = 4;
+constexpr uint32_t DRAW_KEY_PIPELINE_BITS = 8;
+constexpr uint32_t DRAW_KEY_DEPTH_BITS = 20;
+constexpr uint32_t DRAW_KEY_MATERIAL_BITS = 16;
+constexpr uint32_t DRAW_KEY_GEOMETRY_BITS = 16;
+
+//depth is in [0,1], 0 being the closest
+uint64_t MakeDrawKey( uint32_t pass, uint32_t pipeline, float depth, uint32_t material, uint32_t geometry );
+
+//LSD radix sort, 8 bits at a time. values are moved with their keys, bytes that are the same for every key are skipped
+void RadixSortDrawKeys( std::vector<uint64_t>* keys, std::vector<uint32_t>* values );
\ No newline at end of file
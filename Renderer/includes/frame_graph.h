@@ -10,20 +10,31 @@ namespace FG
 	{
 		NONE = 1 << 0,
 		EXTERNAL = 1 << 1,
+		//Partially bound array written while in use, only the elements that were set are written. See R_HW::GFX_DESCRIPTOR_BINDING_BINDLESS
+		BINDLESS = 1 << 2,
+		//Image with the extent of the swapchain, recreated by FG::Resize
+		SWAPCHAIN_SIZED = 1 << 3,
 	};
 
 	#define EXTERNAL_IMAGE { R_HW::GfxFormat::UNDEFINED,{0,0}, ( R_HW::GfxImageUsageFlags )0 }
 	#define CREATE_IMAGE_COLOR_SAMPLER( id, format, extent, usage, sampler ) { (uint32_t)id, R_HW::eDescriptorType::IMAGE_SAMPLER, 1,  FG::eDataEntryFlags::NONE, { format , extent, ( R_HW::GfxImageUsageFlags )( R_HW::GfxImageUsageFlagBits::COLOR_ATTACHMENT | usage ) }, sampler }
 	#define CREATE_IMAGE_COLOR( id, format, extent, usage, flags ) { (uint32_t)id, R_HW::eDescriptorType::IMAGE, 1,  flags, { format , extent, ( R_HW::GfxImageUsageFlags )( R_HW::GfxImageUsageFlagBits::COLOR_ATTACHMENT | usage ) }, eSamplers::Count }
 	#define CREATE_IMAGE_DEPTH( id, format, extent, usage ) { (uint32_t)id, R_HW::eDescriptorType::IMAGE, 1,  FG::eDataEntryFlags::NONE, { format , extent, ( R_HW::GfxImageUsageFlags )( R_HW::GfxImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | usage ) },  eSamplers::Count }
+	#define CREATE_IMAGE_DEPTH_SWAPCHAIN_SIZED( id, format, swapchainExtent, usage ) { (uint32_t)id, R_HW::eDescriptorType::IMAGE, 1,  FG::eDataEntryFlags::SWAPCHAIN_SIZED, { format , swapchainExtent, ( R_HW::GfxImageUsageFlags )( R_HW::GfxImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | usage ) },  eSamplers::Count }
 	#define CREATE_IMAGE_DEPTH_SAMPLER( id, format, extent, usage, sampler ) { static_cast< uint32_t >( id ), R_HW::eDescriptorType::IMAGE_SAMPLER, 1,  FG::eDataEntryFlags::NONE, { format , extent, ( R_HW::GfxImageUsageFlags )( R_HW::GfxImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | usage ) }, sampler }
 	#define CREATE_IMAGE_SAMPLER_EXTERNAL( id, count ){ static_cast< uint32_t >(id), R_HW::eDescriptorType::IMAGE_SAMPLER, count, FG::eDataEntryFlags::EXTERNAL,	EXTERNAL_IMAGE }
 	#define CREATE_SAMPLER_EXTERNAL( id, count ){ static_cast< uint32_t >(id), R_HW::eDescriptorType::SAMPLER, count, FG::eDataEntryFlags::EXTERNAL,	EXTERNAL_IMAGE }
 	#define CREATE_IMAGE_EXTERNAL( id, count ){ static_cast< uint32_t >(id), R_HW::eDescriptorType::IMAGE, count, FG::eDataEntryFlags::EXTERNAL,	EXTERNAL_IMAGE }
+	#define CREATE_IMAGE_BINDLESS( id, count ){ static_cast< uint32_t >(id), R_HW::eDescriptorType::IMAGE, count, FG::eDataEntryFlags::EXTERNAL | FG::eDataEntryFlags::BINDLESS,	EXTERNAL_IMAGE }
 
 	#define CREATE_BUFFER_IMAGE_INTERNAL( objectSize, objectCount ) { R_HW::GfxFormat::UNDEFINED, {objectSize, objectCount}, ( R_HW::GfxImageUsageFlags )0 }
 	#define CREATE_BUFFER( id, size ) { (uint32_t)id, R_HW::eDescriptorType::BUFFER, 1,  FG::eDataEntryFlags::NONE, CREATE_BUFFER_IMAGE_INTERNAL( size, 0 ), eSamplers::Count }
 	#define CREATE_BUFFER_DYNAMIC( id, objectSize, objectCount ) { (uint32_t)id, R_HW::eDescriptorType::BUFFER_DYNAMIC, 1,  FG::eDataEntryFlags::NONE, CREATE_BUFFER_IMAGE_INTERNAL( objectSize, objectCount ), eSamplers::Count }
+	//Storage buffer owned by the user, set with SetBuffers
+	#define CREATE_BUFFER_STORAGE_EXTERNAL( id ) { (uint32_t)id, R_HW::eDescriptorType::BUFFER_STORAGE, 1,  FG::eDataEntryFlags::EXTERNAL, EXTERNAL_IMAGE, eSamplers::Count }
+	#define CREATE_BUFFER_STORAGE( id, objectSize, objectCount ) { (uint32_t)id, R_HW::eDescriptorType::BUFFER_STORAGE, 1,  FG::eDataEntryFlags::NONE, CREATE_BUFFER_IMAGE_INTERNAL( objectSize, objectCount ), eSamplers::Count }
+	//Storage buffer that can also be consumed as indirect draw arguments, the usage flags of buffers are added to the buffer usage
+	#define CREATE_BUFFER_INDIRECT( id, objectSize, objectCount ) { (uint32_t)id, R_HW::eDescriptorType::BUFFER_STORAGE, 1,  FG::eDataEntryFlags::NONE, { R_HW::GfxFormat::UNDEFINED, {objectSize, objectCount}, ( R_HW::GfxImageUsageFlags )R_HW::GFX_BUFFER_USAGE_INDIRECT_BUFFER_BIT }, eSamplers::Count }
 
 	constexpr uint32_t MAX_ATTACHMENTS_COUNT = 8;
 	constexpr uint32_t MAX_READ_TARGETS = 4;
@@ -31,6 +42,8 @@ namespace FG
 	typedef uint32_t fg_handle_t;
 	typedef uint32_t user_id_t;
 
+	constexpr fg_handle_t INVALID_FG_HANDLE = ~0u;
+
 	struct RenderTargetRef
 	{
 		fg_handle_t resourceHandle;
@@ -65,6 +78,11 @@ namespace FG
 		std::vector<RenderTargetRef> renderTargetRefs;
 		R_HW::GpuPipelineLayout gpuPipelineLayout;
 		R_HW::GpuPipelineStateDesc gpuPipelineStateDesc;
+
+		//Compute nodes have no render targets and no render pass, the first shader of the pipeline state is the compute shader
+		bool isCompute = false;
+		//Buffers read as indirect draw arguments
+		std::vector<fg_handle_t> indirectBufferRefs;
 	};
 
 	struct RenderPassCreationData
@@ -111,14 +129,30 @@ namespace FG
 		const R_HW::RenderPass* GetRenderPass( uint32_t id );
 		const R_HW::GfxImage* GetImageFromId( user_id_t render_target_id );
 		void AddExternalImage( fg_handle_t handle, uint32_t frameIndex, const R_HW::GfxImage& image );
+		//The passes writing handle get a framebuffer per swapchain image, RecordDrawCommands uses the one of the acquired image. Call it before CreateRenderPasses and FG::Resize
+		void SetSwapchainImages( fg_handle_t handle, const std::vector<R_HW::GfxImage>& images );
+	};
+
+	//Resources replaced by a resize that frames in flight can still be using
+	struct RetiredResources
+	{
+		std::vector<R_HW::GfxImage> images;
+		std::vector<R_HW::FrameBuffer> frameBuffers;
 	};
 
 	//Compilation
 	FrameGraph CreateGraph( std::vector<RenderPassCreationData> *inRpCreationData, std::vector<DataEntry> *inRtCreationData );
 	void Cleanup( FrameGraph* frameGraph );
 	void CreateRenderPasses( FrameGraph* frameGraphExternal );
+	//Recreates the SWAPCHAIN_SIZED images and the framebuffers, render passes, pipelines and buffers are kept. Add the new external images before calling it.
+	//The tables reading a recreated image are rewritten through inputBuffers, the old images and framebuffers go in o_retired until the GPU is done with them
+	void Resize( FrameGraph* frameGraph, VkExtent2D extent, std::array< GpuInputData, SIMULTANEOUS_FRAMES>& inputBuffers, RetiredResources* o_retired );
+	void Destroy( RetiredResources* retired );
+	//Only the techniques using one of the shaders get a new pipeline. Either every pipeline is rebuilt or none is and the exception is rethrown.
+	//The replaced pipelines are appended to o_oldPipelines, the caller destroys them once the GPU is done with them
+	void RebuildPipelines( FrameGraph* frameGraph, const std::vector<const R_HW::ShaderCode*>& changedShaders, std::vector<R_HW::GfxPipeline>* o_oldPipelines );
 
 
 	//Frame graph stuff
-	void RecordDrawCommands( uint32_t currentFrame, void* userData, R_HW::GfxCommandBuffer graphicsCommandBuffer, VkExtent2D extent, FrameGraph* frameGraphExternal );
+	void RecordDrawCommands( uint32_t currentFrame, uint32_t swapchainImageIndex, void* userData, R_HW::GfxCommandBuffer graphicsCommandBuffer, VkExtent2D extent, FrameGraph* frameGraphExternal );
 }
\ No newline at end of file
@@ -5,7 +5,11 @@
 namespace FG
 {
 	void AddResourcesToInputBuffer( FrameGraph* frameGraph, std::array< GpuInputData, SIMULTANEOUS_FRAMES>& inputBuffers );
-	void CreateTechniques( FrameGraph* frameGraph, R_HW::GfxDescriptorPool descriptorPool );
+	//The descriptor tables come from a pool owned by the frame graph, sized from the tables of all its passes
+	void CreateTechniques( FrameGraph* frameGraph );
+	//Only writes the bindings whose input data was set since they were last written, all in one update
 	void UpdateTechniqueDescriptorSets( const FG::FrameGraph* frameGraph, const std::array< GpuInputData, SIMULTANEOUS_FRAMES>& inputBuffers, const R_HW::GfxImage& dummyImage );
+	//The tables of frameIndex only, they must not be used by a frame in flight
+	void UpdateTechniqueDescriptorSets( const FG::FrameGraph* frameGraph, const GpuInputData& inputData, uint32_t frameIndex );
 	R_HW::GfxImage CreateDummyImage();
 }
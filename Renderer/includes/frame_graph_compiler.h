@@ -0,0 +1,74 @@
+#pragma once
+
+#include "frame_graph.h"
+
+#include <vector>
+#include <string>
+
+// Analysis half of the frame graph: ordering, culling, lifetimes and layout transitions.
+// Only touches the creation data, never the device, so it can run without a GPU.
+namespace FG
+{
+	constexpr uint32_t INVALID_PASS_INDEX = ~0u;
+
+	struct ResourceLifetime
+	{
+		//Positions in CompiledGraph::passOrder
+		uint32_t firstUse = INVALID_PASS_INDEX;
+		uint32_t lastUse = INVALID_PASS_INDEX;
+	};
+
+	//Transition done at the end of srcPass so dstPass finds the resource in the expected state
+	struct PlannedBarrier
+	{
+		fg_handle_t resourceHandle;
+		uint32_t srcPass;
+		uint32_t dstPass;
+		R_HW::GfxLayout oldLayout;
+		R_HW::GfxAccess oldAccess;
+		R_HW::GfxLayout newLayout;
+		R_HW::GfxAccess newAccess;
+	};
+
+	//Buffer written by srcPass and accessed by dstPass, done right before dstPass
+	struct PlannedBufferBarrier
+	{
+		fg_handle_t resourceHandle;
+		uint32_t srcPass;
+		uint32_t dstPass;
+		R_HW::GfxPipelineStageFlag srcStages;
+		R_HW::GfxMemoryAccessFlags srcAccess;
+		R_HW::GfxPipelineStageFlag dstStages;
+		R_HW::GfxMemoryAccessFlags dstAccess;
+	};
+
+	struct CompiledGraph
+	{
+		//Indices in the render passes array, culled passes are not in there
+		std::vector<uint32_t> passOrder;
+		std::vector<bool> culledPasses;
+		//For each pass, the passes it has to run after
+		std::vector<std::vector<uint32_t>> passDependencies;
+		std::vector<ResourceLifetime> lifetimes;
+		std::vector<PlannedBarrier> barriers;
+		std::vector<PlannedBufferBarrier> bufferBarriers;
+	};
+
+	class I_FrameGraphCompiler
+	{
+	public:
+		//Fills the attachments of the render passes and the compiled graph, returns false and an error message if the graph is invalid
+		virtual bool Compile( std::vector<RenderPassCreationData>* renderPasses, const std::vector<DataEntry>& resources, CompiledGraph* o_compiledGraph, std::string* o_error ) = 0;
+	};
+
+	class FrameGraphCompiler : public I_FrameGraphCompiler
+	{
+	public:
+		bool cullUnusedPasses = true;
+
+		bool Compile( std::vector<RenderPassCreationData>* renderPasses, const std::vector<DataEntry>& resources, CompiledGraph* o_compiledGraph, std::string* o_error ) override;
+	};
+
+	//Checks that every pass finds its attachments in the layout and access the previous pass left them in
+	bool ValidateCompiledGraph( const std::vector<RenderPassCreationData>& renderPasses, const std::vector<DataEntry>& resources, const CompiledGraph& compiledGraph, std::string* o_error );
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "glm/mat4x4.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+//Planes are ( normal, distance ) with the normal pointing inside, a point p is inside when dot( normal, p ) + distance >= 0
+//Order is left, right, bottom, top, near, far
+constexpr uint32_t FRUSTUM_PLANES_COUNT = 6;
+
+//Expects a projection with a [0,1] depth range
+void ExtractFrustumPlanes( const glm::mat4& viewProj, glm::vec4 o_planes[FRUSTUM_PLANES_COUNT] );
+bool IsSphereInFrustum( const glm::vec4 planes[FRUSTUM_PLANES_COUNT], const glm::vec3& center, float radius );
+
+//Structure of arrays so the planes can be tested against several spheres at once
+struct BoundingSpheresSoA
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+
+	void Resize( size_t count );
+};
+
+//Sets o_visible[i] to 1 for every sphere that intersects the frustum and leaves the others untouched, so calls for several frusta add up
+void CullSpheres( const glm::vec4 planes[FRUSTUM_PLANES_COUNT], const BoundingSpheresSoA& spheres, uint8_t* o_visible );
+
+//Same as CullSpheres for the shadows of the spheres, each sphere swept away from a point light over sweepLength
+void CullSweptSpheres( const glm::vec4 planes[FRUSTUM_PLANES_COUNT], const glm::vec3& lightPosition, float sweepLength, const BoundingSpheresSoA& spheres, uint8_t* o_visible );
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vk_globals.h"
+#include "gfx_model.h"
+
+#include <vector>
+
+// Vertices and indices of many models in a few large device local buffers: one per vertex attribute and one for the indices.
+// A model of the pool uses the shared buffers with its own firstIndex and vertexOffset, consecutive draws of pooled models don't rebind anything.
+// Indices are always 32 bits. Models are never freed individually, the whole pool is destroyed at once.
+// An interleaved pool keeps every attribute in interleavedVertexBuffer, vertexStride bytes per vertex.
+struct GeometryPool
+{
+	R_HW::GpuBuffer vertexBuffers[(R_HW::VIDataType)eVIDataType::VI_DATA_TYPE_COUNT];
+	R_HW::GpuBuffer interleavedVertexBuffer;
+	uint32_t vertexStride;
+	R_HW::VIDesc vertexDescs[(R_HW::VIDataType)eVIDataType::VI_DATA_TYPE_COUNT];
+	bool hasVertexInput[(R_HW::VIDataType)eVIDataType::VI_DATA_TYPE_COUNT];
+	R_HW::GpuBuffer indexBuffer;
+
+	uint32_t maxVertexCount;
+	uint32_t maxIndexCount;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+};
+
+void CreateGeometryPool( const std::vector<R_HW::VIBinding>& viBindings, uint32_t maxVertexCount, uint32_t maxIndexCount, GeometryPool* o_pool );
+void CreateInterleavedGeometryPool( const std::vector<R_HW::VIBinding>& vertexLayout, uint32_t maxVertexCount, uint32_t maxIndexCount, GeometryPool* o_pool );
+void Destroy( GeometryPool* pool );
+
+//Every attribute of the model has to match one of the pool, the other attributes of the pool are zeroed. Never true for an interleaved pool
+bool CanPoolModel( const GeometryPool& pool, const std::vector<R_HW::VIDesc>& viDescs );
+//The allocator only uploads the data, it has to be able to copy to device local memory
+GfxModel CreateGfxModel( GeometryPool* pool, const std::vector<R_HW::VIDesc>& viDescs, const std::vector<void*>& data, size_t vertexCount, const void* indicesData, size_t indiceCount, uint8_t indexTypeSize, R_HW::I_BufferAllocator* allocator );
+//vertices are already interleaved with the layout of the pool
+GfxModel CreateInterleavedGfxModel( GeometryPool* pool, const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indiceCount, R_HW::I_BufferAllocator* allocator );
\ No newline at end of file
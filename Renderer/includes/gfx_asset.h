@@ -4,5 +4,8 @@
 
 struct GfxAsset {
 	const GfxModel* modelAsset;
-	std::vector<uint32_t> textureIndices;
+	//In the MaterialTable, see material_table.h
+	uint32_t materialIndex = 0;
+	//Receivers only, like the ground, are left out of the shadow pass
+	bool castsShadows = true;
 };
@@ -13,6 +13,7 @@ public:
 	//Buffer allocator
 	bool Allocate( R_HW::GfxApiBuffer buffer, R_HW::GfxMemAlloc* o_gfx_mem_alloc );
 	bool UploadData( const R_HW::GpuBuffer& buffer, const void* data );
+	bool UploadData( const R_HW::GpuBuffer& buffer, const void* data, R_HW::GfxDeviceSize size, R_HW::GfxDeviceSize offset );
 
 private:
 	R_HW::GfxHeap* _heap;
@@ -35,6 +36,7 @@ public:
 	//Buffer allocator
 	bool Allocate( R_HW::GfxApiBuffer buffer, R_HW::GfxMemAlloc* o_gfx_mem_alloc );
 	bool UploadData( const R_HW::GpuBuffer& buffer, const void* data );
+	bool UploadData( const R_HW::GpuBuffer& buffer, const void* data, R_HW::GfxDeviceSize size, R_HW::GfxDeviceSize offset );
 
 private:
 	R_HW::GfxHeap* _heap;
@@ -46,6 +46,17 @@ static const std::vector<R_HW::VIBinding> VIBindingLayout_PosCol = {
 	{ (R_HW::VIDataType )eVIDataType::COLOR, R_HW::eVIDataElementType::FLOAT, 3, 1 },
 };
 
+constexpr uint32_t MAX_MODEL_LODS = 4;
+
+//Indices of a simplified version of the model, sharing its vertices. error is the distance to the base mesh in model space
+struct GfxModelLod
+{
+	//Relative to the firstIndex of the model
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+};
+
 struct GfxModelVertexInput
 {
 	R_HW::VIDesc desc;
@@ -60,10 +71,34 @@ struct GfxModel
 	R_HW::GpuBuffer indexBuffer;
 	uint32_t indexCount;
 	R_HW::GfxIndexType indexType;
+	//lods[0] is the base mesh, a model without LODs has a lodCount of 0. The index buffer holds the indices of every LOD
+	GfxModelLod lods[MAX_MODEL_LODS];
+	uint32_t lodCount;
+
+	//Where the model starts in its buffers, the buffers belong to a GeometryPool when isPooled
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	bool isPooled;
+	//Non zero when the vertices are interleaved in one buffer, every vertAttribBuffers then holds the same buffer
+	uint32_t vertexStride;
+
+	//Quantized positions are position * positionDequantScale + positionDequantOffset in model space, a scale of 0 means the positions aren't quantized
+	glm::vec3 positionDequantOffset;
+	float positionDequantScale;
+
+	//Model space, only known when the positions are given at creation
+	glm::vec3 boundingSphereCenter;
+	float boundingSphereRadius;
 };
 
 GfxModelVertexInput* GetVertexInput( GfxModel& gfxModel, eVIDataType dataType );
 const GfxModelVertexInput* GetVertexInput( const GfxModel& gfxModel, eVIDataType dataType );
 GfxModel CreateGfxModel( const std::vector<R_HW::VIDesc>& viDescs, size_t vertexCount, size_t indiceCount, uint8_t indexTypeSize );
 GfxModel CreateGfxModel( const std::vector<R_HW::VIDesc>& viDescs, const std::vector<void*>& data, size_t vertexCount, const void* indicesData, size_t indiceCount, uint8_t indexTypeSize, R_HW::I_BufferAllocator* allocator );
-void DestroyGfxModel(GfxModel& o_modelAsset);
\ No newline at end of file
+void DestroyGfxModel(GfxModel& o_modelAsset);
+void ComputeBounds( const glm::vec3* positions, size_t vertexCount, GfxModel* o_gfxModel );
+//indexCount of the model becomes the one of lods[0]
+void SetModelLods( const GfxModelLod* lods, uint32_t lodCount, GfxModel* o_gfxModel );
+void GetModelLodRange( const GfxModel& gfxModel, uint32_t lod, uint32_t* o_firstIndex, uint32_t* o_indexCount );
+//Coarsest LOD with an error under maxPixelError once projected, pixelsPerUnit is the size on screen of one model unit at the distance of the model
+uint32_t SelectModelLod( const GfxModel& gfxModel, float pixelsPerUnit, float maxPixelError );
\ No newline at end of file
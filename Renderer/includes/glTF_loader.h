@@ -1,9 +1,12 @@
 #pragma once
 
 #include "gfx_model.h"
+#include "geometry_pool.h"
 #include "scene_instance.h"
 #include "gfx_asset.h"
 #include "gfx_image.h"
+#include "material_table.h"
+#include "mesh_optimizer.h"
 
 namespace glTF_L
 {
@@ -11,9 +14,15 @@ namespace glTF_L
 	typedef GfxAsset* ( RegisterGfxAssetCallback_t )(const char* name);
 	typedef SceneInstance* ( RegisterSceneInstanceCallback_t )(const char* name, GfxAsset* asset);
 	typedef uint32_t( LoadTextureCallback_t )( const char* name, I_ImageAlloctor* allocator );
+	//Returns the index of the material, see GfxAsset::materialIndex
+	typedef uint32_t( RegisterMaterialCallback_t )( const GpuMaterial& material );
 
 	void LoadScene( const char* fileName, RegisterGfxModelCallback_t registerGfxModelCallback, RegisterGfxAssetCallback_t registerGfxAssetCallback,
-		RegisterSceneInstanceCallback_t registerSceneInstanceCallback, LoadTextureCallback_t loadTextureCallback, R_HW::I_BufferAllocator* allocator, I_ImageAlloctor* imageAllocator );
-	void LoadMesh( const char* fileName, GfxModel* model, R_HW::I_BufferAllocator* allocator );
+		RegisterSceneInstanceCallback_t registerSceneInstanceCallback, LoadTextureCallback_t loadTextureCallback, RegisterMaterialCallback_t registerMaterialCallback, R_HW::I_BufferAllocator* allocator, I_ImageAlloctor* imageAllocator, GeometryPool* geometryPool = nullptr, bool optimizeMeshes = true, bool generateLods = true, MeshOptimizationStats* io_stats = nullptr );
+	//With a geometry pool the meshes are put in it, allocator only uploads them
+	//optimizeMeshes dedupes the vertices and reorders them and the triangles for the GPU caches, see mesh_optimizer.h
+	//generateLods adds simplified versions of the meshes in their index buffer, see mesh_simplifier.h
+	//The stats of the optimized meshes are added to io_stats, see AddMeshOptimizationStats
+	void LoadMesh( const char* fileName, GfxModel* model, R_HW::I_BufferAllocator* allocator, GeometryPool* geometryPool = nullptr, bool optimizeMeshes = true, bool generateLods = true, MeshOptimizationStats* io_stats = nullptr );
 	void LoadCollisionData( const char* fileName, std::vector<glm::vec3>* vertices, std::vector<uint32_t>* indices );
 }
\ No newline at end of file
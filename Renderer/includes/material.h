@@ -4,10 +4,18 @@
 #include "bindings.h"
 
 #include <array>
+#include <vector>
+
+constexpr uint32_t DESCRIPTOR_NOT_WRITTEN = UINT32_MAX;
 
 struct GfxDescriptorSetBinding
 {
 	std::array< R_HW::GfxDescriptorTable, SIMULTANEOUS_FRAMES> hw_descriptorSets;
+	//Version of the input data last written in each binding of each table, in the order of desc.dataBindings. See GpuInputData::versions
+	std::array< std::array< uint32_t, MAX_DATA_ENTRIES >, SIMULTANEOUS_FRAMES> writtenVersions;
+	//Descriptors last written in each table, only the changed bindings are packed again before the whole table is written with updateTemplate
+	std::array< std::vector<uint8_t>, SIMULTANEOUS_FRAMES> packedDescriptors;
+	R_HW::GfxDescriptorUpdateTemplate updateTemplate;
 	//TODO: something to manage and generate descriptor sets. Passes can register to use one of many descriptor set layout
 	R_HW::GfxDescriptorTableLayout hw_layout;
 	R_HW::GfxDescriptorTableDesc desc;
@@ -20,8 +28,6 @@ struct Technique
 
 	R_HW::GfxPipelineLayout pipelineLayout;
 	R_HW::GfxPipeline pipeline;
-
-	VkDescriptorPool parentDescriptorPool;
 };
 
 //Don't recall this if the technique is the same
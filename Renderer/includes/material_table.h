@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vk_globals.h"
+#include "../shaders/shadersCommon.h"
+
+#include <glm/vec4.hpp>
+
+#include <vector>
+
+// Parameters of every material in one device local storage buffer, instances only carry the index of their material.
+// Instances with different materials can be drawn by the same instanced or indirect draw.
+// Same layout as Material in the shaders (std430)
+struct GpuMaterial
+{
+	glm::vec4 baseColorFactor;
+	//Bindless texture slots, see bindless_textures.h. Only read when the matching MATERIAL_FLAG is set
+	uint32_t textureIndices[MATERIAL_TEXTURES_MAX];
+	uint32_t flags;
+	uint32_t pad[3];
+};
+
+struct MaterialTable
+{
+	R_HW::GpuBuffer buffer;
+	std::vector<GpuMaterial> materials;
+	uint32_t maxMaterialCount;
+	//Materials changed since the last upload, [dirtyBegin, dirtyEnd)
+	uint32_t dirtyBegin;
+	uint32_t dirtyEnd;
+};
+
+GpuMaterial CreateTexturedMaterial( uint32_t albedoTextureIndex );
+void CreateMaterialTable( uint32_t maxMaterialCount, MaterialTable* o_table );
+void Destroy( MaterialTable* table );
+uint32_t AddMaterial( MaterialTable* table, const GpuMaterial& material );
+void SetMaterial( MaterialTable* table, uint32_t index, const GpuMaterial& material );
+//Only the materials changed since the last upload are copied. The GPU can't be reading the table, upload at load time or after waiting for the device
+void UploadMaterialTable( MaterialTable* table, R_HW::I_BufferAllocator* allocator );
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+// Import time mesh optimizations, every function works on 32 bits triangle lists.
+// The vertex attributes are given as streams, each vertex being stride bytes in each of them. Streams are modified in place.
+struct MeshStream
+{
+	void* data;
+	size_t stride;
+};
+
+//Size of the simulated post transform cache, also used to compute the ACMR
+constexpr uint32_t VERTEX_CACHE_SIZE = 32;
+constexpr uint32_t NO_NORMALS_STREAM = ~0u;
+
+struct MeshOptimizationStats
+{
+	uint32_t triangleCount;
+	uint32_t vertexCountBefore;
+	uint32_t vertexCountAfter;
+	//Average cache miss ratio, transformed vertices per triangle with a FIFO cache of VERTEX_CACHE_SIZE
+	float acmrBefore;
+	float acmrAfter;
+};
+
+float ComputeACMR( const uint32_t* indices, size_t indexCount, uint32_t cacheSize );
+
+//Merges the vertices that are identical in every stream, returns the new vertex count
+size_t DeduplicateVertices( const std::vector<MeshStream>& streams, size_t vertexCount, uint32_t* indices, size_t indexCount );
+//Triangle order for the post transform cache (Forsyth)
+void OptimizeVertexCache( uint32_t* indices, size_t indexCount, size_t vertexCount );
+//Sorts clusters of triangles front to back from the outside of the mesh, kept only if the ACMR doesn't get worse than threshold times the current one.
+//Without normals, triangles are assumed to be counter clockwise
+void OptimizeOverdraw( uint32_t* indices, size_t indexCount, const glm::vec3* positions, const glm::vec3* normals, size_t vertexCount, float threshold );
+//Renumbers the vertices in the order they are first used and drops the unused ones, returns the new vertex count
+size_t OptimizeVertexFetch( const std::vector<MeshStream>& streams, size_t vertexCount, uint32_t* indices, size_t indexCount );
+
+//Runs all of the above. streams[0] has to be the glm::vec3 positions, normalsStream the index of the glm::vec3 normals or NO_NORMALS_STREAM
+MeshOptimizationStats OptimizeMesh( const std::vector<MeshStream>& streams, uint32_t normalsStream, size_t* io_vertexCount, std::vector<uint32_t>* io_indices );
+//Adds the stats of one mesh to the totals of several, the ACMRs being averaged over all their triangles
+void AddMeshOptimizationStats( const MeshOptimizationStats& stats, MeshOptimizationStats* io_total );
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "gfx_model.h"
+
+#include <glm/vec3.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+// Quadric error edge collapse (Garland and Heckbert). Vertices are collapsed on one of their neighbours, only the indices change
+// so every LOD of a mesh shares its vertices. Border vertices and seams (several vertices at the same position) never move.
+
+//Returns the error of the simplified mesh, a distance in model space. Stops at targetIndexCount or when the next collapse would go over maxError
+float SimplifyMesh( const glm::vec3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, std::vector<uint32_t>* o_indices );
+
+//Appends the indices of up to maxLodCount - 1 simplified LODs, each with about half the triangles of the previous one, after the base indices.
+//o_lods[0] is the base mesh, returns the number of LODs written. Stops early when a mesh can't be simplified anymore
+uint32_t GenerateMeshLods( const glm::vec3* positions, size_t vertexCount, std::vector<uint32_t>* io_indices, uint32_t maxLodCount, GfxModelLod* o_lods );
\ No newline at end of file
@@ -13,4 +13,6 @@ void CreateTimeStampsQueryPool(uint32_t setCount);
 void DestroyTimeStampsPool();
 void CmdResetTimeStampSet( R_HW::GfxCommandBuffer commandBuffer, uint32_t set);
 void CmdWriteTimestamp( R_HW::GfxCommandBuffer commandBuffer, R_HW::GfxPipelineStageFlagBits stageBits, Timestamp timestamp, uint32_t set );
-float GetTimestampsDelta(Timestamp first, Timestamp last, uint32_t set);
\ No newline at end of file
+float GetTimestampsDelta(Timestamp first, Timestamp last, uint32_t set);
+//In GPU ticks of g_gfx.device.timestampPeriod nanoseconds
+uint64_t GetTimestamp( Timestamp timestamp, uint32_t set );
\ No newline at end of file
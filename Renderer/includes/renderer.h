@@ -4,6 +4,7 @@
 #include "scene_frame_data.h"
 #include "frame_graph.h"
 #include "gfx_model.h"
+#include "bindings.h"
 
 #include <vector>
 
@@ -20,17 +21,56 @@ namespace RNDR
 	struct R_State;
 
 	typedef FG::FrameGraph FG_CompileScriptCallback_t( const R_HW::Swapchain*, void* user_params );
+	//Adds the images of the new swapchain to the frame graph and calls FG::Resize
+	typedef void FG_ResizeScriptCallback_t( FG::FrameGraph*, const R_HW::Swapchain*, void* user_params, FG::RetiredResources* o_retired );
 
-	R_State* CreateRenderer( R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height );
+	//framesInFlight, from 1 to SIMULTANEOUS_FRAMES, trades latency for throughput. It can't change while the renderer lives
+	R_State* CreateRenderer( R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height, uint32_t framesInFlight, R_HW::GfxPresentMode presentMode );
 	void CompileFrameGraph( R_State* pr_state, FG_CompileScriptCallback_t FGScriptInitialize, void* fg_user_params );
-	void recreate_swap_chain( R_State* pr_state, R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height, FG_CompileScriptCallback_t FGScriptInitialize, void* fg_user_params );
+	//Doesn't wait for the device, the frames in flight finish with the old swapchain which is destroyed once they are done
+	void recreate_swap_chain( R_State* pr_state, R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height, FG_ResizeScriptCallback_t FGScriptResize, void* fg_user_params );
 	void Destroy( R_State** ppr_state );
-	void WaitForFrame( const R_State* pr_state, uint32_t currentFrame );
+	//Waits until the gpu is done with the last frame recorded in the currentFrame slot and acquires the swapchain image of the frame, currentFrame goes from 0 to g_gfx.framesInFlight - 1
+	//Both can block, sample the input and simulate after it so the frame is as recent as possible. Retired swapchains whose frames are done are destroyed here
+	//Recreate the swapchain and call it again when it returns NEED_FRAMEBUFFER_RESIZE, no image was acquired
+	eRenderError BeginFrame( R_State* pr_state, uint32_t currentFrame );
+	//Start of the input to present latency of the frame
+	void MarkInputSampled( R_State* pr_state, uint32_t currentFrame );
+	//Records the frame in the image acquired by BeginFrame, submits and presents it
 	eRenderError draw_frame( R_State* pr_state, uint32_t currentFrame, const SceneFrameData* frameData );
+	//Used from the next swapchain recreation
+	void SetPresentMode( R_State* pr_state, R_HW::GfxPresentMode presentMode );
+	//Mode of the current swapchain, FIFO when the requested one isn't supported
+	R_HW::GfxPresentMode GetPresentMode( const R_State* pr_state );
+	//Milliseconds from MarkInputSampled to the image being on screen, averaged over the last frames
+	//Without VK_KHR_present_wait it stops when the GPU is done with the frame and doesn't count the wait for the display
+	float GetInputToPresentLatency( const R_State* pr_state );
 	VkExtent2D get_backbuffer_size( const R_State* pr_state );
+	//Shaders rewritten on disk are reloaded and only the pipelines using them are rebuilt, call it between frames.
+	//Nothing is replaced if one of the pipelines fails, the old pipelines are destroyed once the frames using them are done
+	void ReloadChangedShaders( R_State* pr_state );
+	//Writes the input data set since the last update in the descriptor tables of currentFrame, call it once the frame is done on the GPU
+	void UpdateDescriptorTables( R_State* pr_state, const GpuInputData& inputData, uint32_t currentFrame );
 }
 
 
+constexpr uint32_t MAX_VERTEX_INPUT_BINDINGS = 16;
+
+//Geometry last bound in a command buffer, binding the same buffers again is skipped
+struct GeometryBindState
+{
+	R_HW::GfxApiBuffer vertexBuffers[MAX_VERTEX_INPUT_BINDINGS] = {};
+	uint32_t vertexBuffersCount = 0;
+	R_HW::GfxApiBuffer indexBuffer = VK_NULL_HANDLE;
+};
+
 void CmdBindVertexInputs( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel );
+void CmdBindVertexInputs( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel, GeometryBindState* bindState );
 void CmdDrawIndexed( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel, uint32_t indexCount );
-void CmdDrawIndexed( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel );
\ No newline at end of file
+void CmdDrawIndexed( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel );
+void CmdDrawIndexedInstanced( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel, uint32_t instanceCount, uint32_t firstInstance );
+//Models of a GeometryPool share their buffers, their draws can be merged in one indirect draw
+bool SharesGeometryBuffers( const GfxModel& a, const GfxModel& b );
+//Draws with the drawCount commands found at offset in argumentsBuffer, the models of all the commands have to share gfxModel's buffers.
+//Without a bindState the geometry buffers are bound every time
+void CmdDrawIndexedIndirect( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel, const R_HW::GpuBuffer& argumentsBuffer, R_HW::GfxDeviceSize offset, uint32_t drawCount, uint32_t stride, GeometryBindState* bindState );
\ No newline at end of file
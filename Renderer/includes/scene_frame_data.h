@@ -15,6 +15,23 @@ struct DrawListEntry
 	SceneInstanceSet descriptorSet;
 };
 
+//Instances of the same asset and LOD drawn together, firstInstance starts their range in the visible instances written by the culling
+struct DrawBatch
+{
+	const GfxAsset* asset;
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+	uint32_t lod;
+};
+
 struct SceneFrameData {
 	std::vector<DrawListEntry> drawList;
+	std::vector<DrawBatch> drawBatches;
+	//Shadow casters only, with their own order
+	std::vector<DrawBatch> shadowDrawBatches;
+	uint32_t instanceCount = 0;
+
+	//One indirect command per draw batch of each list, the instance counts are written by the GPU culling
+	const R_HW::GpuBuffer* drawCommands = nullptr;
+	const R_HW::GpuBuffer* shadowDrawCommands = nullptr;
 };
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "vk_globals.h"
+
+#include <vector>
+
+// Every SPIR-V file is read once, techniques and frame graph recompiles share the same code and the shader modules made from it.
+// The returned code stays valid until DestroyShaderLibrary. Main thread only.
+
+const R_HW::ShaderCode* LoadShader( const char* path );
+void DestroyShaderLibrary();
+
+//Reads again the loaded files that were rewritten since the last call, their code is replaced in place so the pipeline descs pointing to it see the new one.
+//Returns the code that changed. The directories are watched with inotify on Linux, the modification times are compared elsewhere
+std::vector<const R_HW::ShaderCode*> ReloadChangedShaderFiles();
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "gfx_model.h"
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+// Compact interleaved vertex, 24 bytes instead of the 56 of VIBindingsFullModel.
+// Positions are snorm16 relative to the mesh bounds, positionDequantScale and positionDequantOffset of the GfxModel bring them back in model space.
+// Normals and tangents are octahedral encoded in 2 snorm16, texture coordinates are half floats and colors are unorm8.
+struct QuantizedVertex
+{
+	int16_t position[4];
+	uint8_t color[4];
+	uint16_t texCoord[2];
+	int16_t normal[2];
+	int16_t tangent[2];
+};
+
+//Order of the attributes in QuantizedVertex, use with GetInterleavedBindingDescription
+static const std::vector<R_HW::VIBinding> VIBindingsQuantizedModel = {
+	{ ( R_HW::VIDataType )eVIDataType::POSITION, R_HW::eVIDataElementType::SNORM_SHORT, 4, 0 },
+	{ ( R_HW::VIDataType )eVIDataType::COLOR, R_HW::eVIDataElementType::UNORM_BYTE, 4, 1 },
+	{ ( R_HW::VIDataType )eVIDataType::TEX_COORD, R_HW::eVIDataElementType::HALF_FLOAT, 2, 2 },
+	{ ( R_HW::VIDataType )eVIDataType::NORMAL, R_HW::eVIDataElementType::SNORM_SHORT, 2, 3 },
+	{ ( R_HW::VIDataType )eVIDataType::TANGENT, R_HW::eVIDataElementType::SNORM_SHORT, 2, 4 }
+};
+
+static const std::vector<R_HW::VIBinding> VIBindingsQuantizedMeshOnly = {
+	{ ( R_HW::VIDataType )eVIDataType::POSITION, R_HW::eVIDataElementType::SNORM_SHORT, 4, 0 },
+};
+
+glm::vec2 OctahedralEncode( const glm::vec3& direction );
+glm::vec3 OctahedralDecode( const glm::vec2& encoded );
+
+//Uniform scale so normals transformed by the model matrix keep their direction
+void ComputePositionDequant( const glm::vec3* positions, size_t vertexCount, glm::vec3* o_offset, float* o_scale );
+
+//Any of the attributes but the positions can be null, they get a default value
+void QuantizeVertices( const glm::vec3* positions, const glm::vec3* normals, const glm::vec3* tangents, const glm::vec3* colors, const glm::vec2* texCoords, size_t vertexCount,
+	const glm::vec3& dequantOffset, float dequantScale, QuantizedVertex* o_vertices );
+void DequantizeVertex( const QuantizedVertex& vertex, const glm::vec3& dequantOffset, float dequantScale, glm::vec3* o_position, glm::vec3* o_normal, glm::vec3* o_tangent, glm::vec3* o_color, glm::vec2* o_texCoord );
+
+//Identity when the model isn't quantized, otherwise to be applied before the model matrix of the instances
+glm::mat4 GetPositionDequantMatrix( const GfxModel& gfxModel );
+//Bounding sphere of the model in the space of its quantized positions, xyz center and w radius
+glm::vec4 GetQuantizedBoundingSphere( const GfxModel& gfxModel );
\ No newline at end of file
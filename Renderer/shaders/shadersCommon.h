@@ -1,8 +1,13 @@
 #define RENDERPASS_SET 0
 #define INSTANCE_SET 1
-#define BINDLESS_TEXTURES_MAX 16
+#define BINDLESS_TEXTURES_MAX 4096
 #define SAMPLERS_MAX 16
 
+//See material_table.h
+#define MATERIAL_TEXTURES_MAX 4
+#define MATERIAL_TEXTURE_ALBEDO 0
+#define MATERIAL_FLAG_ALBEDO_TEXTURE 1
+
 #define SAMPLER_POINT_ID 0
 
 #define saturate(x) clamp( x, 0.0 , 1.0)
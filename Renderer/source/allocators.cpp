@@ -1,16 +1,64 @@
 #include "allocators.h"
 
+#include <stdexcept>
+
 /*
 Avoir un objet descripteur liEEun buffer sur lequel on aloue de la m?moire.
 Buffer Dynamique on peut alouer plusieurs objet et non dynamique seulement 1?
 */
+BufferAllocator CreateBufferSlotAllocator( const R_HW::GpuBuffer* buffer, R_HW::eDescriptorType descriptorType )
+{
+	BufferAllocator allocator = {};
+	allocator.buffer = buffer;
+	allocator.alignment = R_HW::GetMinBufferOffsetAlignment( descriptorType );
+	return allocator;
+}
+
 size_t AllocateGpuBufferSlot( BufferAllocator* allocator, size_t slotSize )
 {
 	//TODO: have buffers that you can only allocate in certain chuncks to simplify?
-	//TODO: allignment
-	size_t allocationOffset = allocator->head;
+	size_t allocationOffset = R_HW::AlignUp( allocator->head, allocator->alignment );
 	size_t newHead = allocationOffset + slotSize;
 	assert( newHead <= allocator->buffer->gpuMemory.size );
 	allocator->head = newHead;
 	return allocationOffset;
+}
+
+void CreateGpuRingAllocator( size_t frameSize, R_HW::GfxBufferUsageFlags bufferUsageFlags, GpuRingAllocator* o_allocator )
+{
+	*o_allocator = {};
+	R_HW::CreateCommitedGpuBuffer( frameSize * g_gfx.framesInFlight, bufferUsageFlags, R_HW::GFX_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &o_allocator->buffer );
+	assert( o_allocator->buffer.gpuMemory.mappedData );
+	o_allocator->frameSize = frameSize;
+}
+
+void Destroy( GpuRingAllocator* allocator )
+{
+	R_HW::Destroy( &allocator->buffer );
+	*allocator = {};
+}
+
+void BeginFrame( GpuRingAllocator* allocator, uint32_t frameIndex )
+{
+	assert( frameIndex < g_gfx.framesInFlight );
+	allocator->frameStart = frameIndex * allocator->frameSize;
+	allocator->head = allocator->frameStart;
+}
+
+GpuRingAllocation AllocateGpuRingSlot( GpuRingAllocator* allocator, size_t size, size_t alignment )
+{
+	assert( alignment > 0 );
+	const size_t offset = R_HW::AlignUp( allocator->head, alignment );
+	const size_t newHead = offset + size;
+	if( newHead > allocator->frameStart + allocator->frameSize )
+		throw std::runtime_error( "gpu ring allocator is full for this frame" );
+	allocator->head = newHead;
+
+	void* data = static_cast< uint8_t* >( allocator->buffer.gpuMemory.mappedData ) + offset;
+	return { data, offset };
+}
+
+void FlushFrame( const GpuRingAllocator* allocator )
+{
+	R_HW::FlushGpuMemory( allocator->buffer.gpuMemory, allocator->head - allocator->frameStart, allocator->frameStart );
 }
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "assimp_loader.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
 
 #include <assimp/Importer.hpp>      // C++ importer interface
 #include <assimp/scene.h>           // Output data structure
@@ -6,7 +8,7 @@
 
 #include <vector>
 
-void LoadModel_AssImp( const char * filename, GfxModel& o_modelAsset, size_t hackModelIndex, R_HW::I_BufferAllocator* allocator )
+void LoadModel_AssImp( const char * filename, GfxModel& o_modelAsset, size_t hackModelIndex, R_HW::I_BufferAllocator* allocator, bool optimizeMesh, bool generateLods, MeshOptimizationStats* io_stats )
 {
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile( filename,
@@ -46,6 +48,24 @@ void LoadModel_AssImp( const char * filename, GfxModel& o_modelAsset, size_t hac
 		indices[i * 3 + 2] = mesh->mFaces[i].mIndices[2];
 	}
 
+	size_t vertexCount = mesh->mNumVertices;
+	if( optimizeMesh )
+	{
+		const std::vector<MeshStream> streams = {
+			{ vertPos.data(), sizeof( glm::vec3 ) },
+			{ vertNormals.data(), sizeof( glm::vec3 ) },
+			{ vertTangents.data(), sizeof( glm::vec3 ) },
+			{ vertColor.data(), sizeof( glm::vec3 ) },
+			{ vertTexCoord.data(), sizeof( glm::vec2 ) },
+		};
+		const MeshOptimizationStats stats = OptimizeMesh( streams, 1, &vertexCount, &indices );
+		if( io_stats )
+			AddMeshOptimizationStats( stats, io_stats );
+	}
+
+	GfxModelLod lods[MAX_MODEL_LODS];
+	const uint32_t lodCount = generateLods ? GenerateMeshLods( vertPos.data(), vertexCount, &indices, MAX_MODEL_LODS, lods ) : 0;
+
 	std::vector<R_HW::VIDesc> modelVIDescs = {
 		{ (R_HW::VIDataType )eVIDataType::POSITION, R_HW::eVIDataElementType::FLOAT, 3 },
 		{ (R_HW::VIDataType )eVIDataType::NORMAL, R_HW::eVIDataElementType::FLOAT, 3 },
@@ -61,5 +81,7 @@ void LoadModel_AssImp( const char * filename, GfxModel& o_modelAsset, size_t hac
 		vertTexCoord.data(),
 	};
 
-	o_modelAsset = CreateGfxModel( modelVIDescs, modelData, mesh->mNumVertices, indices.data(), indexCount, sizeof(uint32_t), allocator );
+	o_modelAsset = CreateGfxModel( modelVIDescs, modelData, vertexCount, indices.data(), indices.size(), sizeof(uint32_t), allocator );
+	if( lodCount > 0 )
+		SetModelLods( lods, lodCount, &o_modelAsset );
 }
\ No newline at end of file
@@ -1,14 +1,54 @@
 #include "bindless_textures.h"
 
+#include <cassert>
+#include <stdexcept>
+
 uint32_t RegisterBindlessTexture( BindlessTexturesState* state, R_HW::GfxImage* image, eSamplers eSampler )
 {
-	assert( state->_bindlessTexturesCount < BINDLESS_TEXTURES_MAX );
+	uint32_t index;
+	if( !state->_freeIndices.empty() )
+	{
+		index = state->_freeIndices.back();
+		state->_freeIndices.pop_back();
+	}
+	else
+	{
+		if( state->_bindlessTexturesCount >= BINDLESS_TEXTURES_MAX )
+			throw std::runtime_error( "Out of bindless texture slots" );
+		index = state->_bindlessTexturesCount++;
+	}
+
 	VkSampler sampler = eSampler == eSamplers::Count ? VK_NULL_HANDLE : GetSampler( eSampler );
-	state->_bindlessTextures[state->_bindlessTexturesCount] = { image, sampler };
-	return state->_bindlessTexturesCount++;
+	state->_bindlessTextures[index] = { image, sampler };
+	++state->_version;
+	return index;
 }
 
 uint32_t RegisterBindlessTexture( BindlessTexturesState* state, R_HW::GfxImage* image )
 {
 	return RegisterBindlessTexture( state, image, eSamplers::Count );
+}
+
+void UnregisterBindlessTexture( BindlessTexturesState* state, uint32_t index )
+{
+	assert( index < state->_bindlessTexturesCount && state->_bindlessTextures[index].image );
+	state->_bindlessTextures[index] = { nullptr, VK_NULL_HANDLE };
+	state->_retiredIndices.push_back( { index, g_gfx.framesInFlight } );
+	++state->_version;
+}
+
+void RecycleBindlessTextures( BindlessTexturesState* state )
+{
+	for( size_t i = 0; i < state->_retiredIndices.size(); )
+	{
+		RetiredBindlessTexture& retired = state->_retiredIndices[i];
+		if( --retired.framesLeft > 0 )
+		{
+			++i;
+			continue;
+		}
+		state->_freeIndices.push_back( retired.index );
+		retired = state->_retiredIndices.back();
+		state->_retiredIndices.pop_back();
+	}
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "cpu_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+namespace PROF
+{
+	struct ThreadBuffer
+	{
+		ZoneEvent events[MAX_EVENTS_PER_THREAD];
+		//Only written by the owning thread, read with acquire when dumping
+		std::atomic<uint64_t> head = 0;
+		std::atomic<uint64_t> clearedHead = 0;
+
+		uint64_t openZonesStart[MAX_ZONE_DEPTH];
+		const char* openZonesName[MAX_ZONE_DEPTH];
+		uint32_t depth = 0;
+
+		uint32_t threadId;
+		const char* threadName = nullptr;
+		ThreadBuffer* next = nullptr;
+	};
+
+	//Buffers are never freed so zones of a finished thread can still be dumped
+	static std::atomic<ThreadBuffer*> g_threadBuffers = nullptr;
+	static std::atomic<uint32_t> g_threadCount = 0;
+	static const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+	static ThreadBuffer* RegisterThreadBuffer()
+	{
+		ThreadBuffer* buffer = new ThreadBuffer();
+		buffer->threadId = g_threadCount.fetch_add( 1, std::memory_order_relaxed );
+
+		ThreadBuffer* head = g_threadBuffers.load( std::memory_order_relaxed );
+		do
+		{
+			buffer->next = head;
+		} while( !g_threadBuffers.compare_exchange_weak( head, buffer, std::memory_order_release, std::memory_order_relaxed ) );
+
+		return buffer;
+	}
+
+	static ThreadBuffer* GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* threadBuffer = RegisterThreadBuffer();
+		return threadBuffer;
+	}
+
+	uint64_t GetTimeNs()
+	{
+		return static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - g_epoch ).count() );
+	}
+
+	void BeginZone( const char* name )
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+		assert( buffer->depth < MAX_ZONE_DEPTH );
+		if( buffer->depth < MAX_ZONE_DEPTH )
+		{
+			buffer->openZonesName[buffer->depth] = name;
+			buffer->openZonesStart[buffer->depth] = GetTimeNs();
+		}
+		++buffer->depth;
+	}
+
+	void EndZone()
+	{
+		const uint64_t end = GetTimeNs();
+		ThreadBuffer* buffer = GetThreadBuffer();
+		assert( buffer->depth > 0 );
+		const uint32_t depth = --buffer->depth;
+		if( depth >= MAX_ZONE_DEPTH )
+			return;
+
+		const uint64_t head = buffer->head.load( std::memory_order_relaxed );
+		ZoneEvent& event = buffer->events[head % MAX_EVENTS_PER_THREAD];
+		event.name = buffer->openZonesName[depth];
+		event.start_ns = buffer->openZonesStart[depth];
+		event.end_ns = end;
+		event.depth = depth;
+		buffer->head.store( head + 1, std::memory_order_release );
+	}
+
+	void SetThreadName( const char* name )
+	{
+		GetThreadBuffer()->threadName = name;
+	}
+
+	static void WriteEscapedString( FILE* file, const char* string )
+	{
+		for( const char* c = string; *c != '\0'; ++c )
+		{
+			if( *c == '"' || *c == '\\' )
+				fputc( '\\', file );
+			fputc( *c, file );
+		}
+	}
+
+	//Copies the events of a thread that can still be writing. The copied events the thread may have overwritten while
+	//they were read are dropped: the slot of event i is written again by event i + MAX_EVENTS_PER_THREAD
+	static void SnapshotEvents( const ThreadBuffer* buffer, std::vector<ZoneEvent>* o_events )
+	{
+		o_events->clear();
+		const uint64_t head = buffer->head.load( std::memory_order_acquire );
+		uint64_t begin = buffer->clearedHead.load( std::memory_order_relaxed );
+		if( head - begin > MAX_EVENTS_PER_THREAD )
+			begin = head - MAX_EVENTS_PER_THREAD;
+
+		o_events->resize( head - begin );
+		for( uint64_t i = begin; i < head; ++i )
+			( *o_events )[i - begin] = buffer->events[i % MAX_EVENTS_PER_THREAD];
+
+		//The event being written when head was read again overwrites event headAfterCopy - MAX_EVENTS_PER_THREAD
+		std::atomic_thread_fence( std::memory_order_acquire );
+		const uint64_t headAfterCopy = buffer->head.load( std::memory_order_relaxed );
+		if( headAfterCopy >= begin + MAX_EVENTS_PER_THREAD )
+		{
+			const uint64_t firstValid = headAfterCopy - MAX_EVENTS_PER_THREAD + 1;
+			const size_t overwrittenCount = static_cast< size_t >( std::min( firstValid, head ) - begin );
+			o_events->erase( o_events->begin(), o_events->begin() + overwrittenCount );
+		}
+	}
+
+	bool DumpChromeTrace( const char* fileName )
+	{
+		FILE* file = fopen( fileName, "w" );
+		if( !file )
+			return false;
+
+		fprintf( file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" );
+		bool first = true;
+		std::vector<ZoneEvent> events;
+		for( ThreadBuffer* buffer = g_threadBuffers.load( std::memory_order_acquire ); buffer; buffer = buffer->next )
+		{
+			if( buffer->threadName )
+			{
+				fprintf( file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", buffer->threadId );
+				WriteEscapedString( file, buffer->threadName );
+				fprintf( file, "\"}}" );
+				first = false;
+			}
+
+			//Copied first, writing the file is slow and gives the other threads time to wrap around
+			SnapshotEvents( buffer, &events );
+			for( const ZoneEvent& event : events )
+			{
+				fprintf( file, "%s{\"name\":\"", first ? "" : ",\n" );
+				WriteEscapedString( file, event.name );
+				fprintf( file, "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%u}}",
+					buffer->threadId, event.start_ns / 1000.0, ( event.end_ns - event.start_ns ) / 1000.0, event.depth );
+				first = false;
+			}
+		}
+		fprintf( file, "\n]}\n" );
+
+		const bool success = ferror( file ) == 0;
+		fclose( file );
+		return success;
+	}
+
+	void Clear()
+	{
+		for( ThreadBuffer* buffer = g_threadBuffers.load( std::memory_order_acquire ); buffer; buffer = buffer->next )
+			buffer->clearedHead.store( buffer->head.load( std::memory_order_acquire ), std::memory_order_relaxed );
+	}
+}
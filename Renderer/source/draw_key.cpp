@@ -0,0 +1,80 @@
+#include "draw_key.h"
+
+#include <algorithm>
+#include <cassert>
+
+static_assert( DRAW_KEY_PASS_BITS + DRAW_KEY_PIPELINE_BITS + DRAW_KEY_DEPTH_BITS + DRAW_KEY_MATERIAL_BITS + DRAW_KEY_GEOMETRY_BITS == 64, "The draw key fields have to fill 64 bits" );
+
+static uint64_t ToKeyBits( uint32_t value, uint32_t bitCount )
+{
+	assert( value < ( 1ull << bitCount ) );
+	return static_cast< uint64_t >( value ) & ( ( 1ull << bitCount ) - 1 );
+}
+
+uint64_t MakeDrawKey( uint32_t pass, uint32_t pipeline, float depth, uint32_t material, uint32_t geometry )
+{
+	const uint32_t maxDepth = ( 1u << DRAW_KEY_DEPTH_BITS ) - 1;
+	const uint32_t quantizedDepth = static_cast< uint32_t >( std::clamp( depth, 0.0f, 1.0f ) * maxDepth );
+
+	uint64_t key = ToKeyBits( pass, DRAW_KEY_PASS_BITS );
+	key = ( key << DRAW_KEY_PIPELINE_BITS ) | ToKeyBits( pipeline, DRAW_KEY_PIPELINE_BITS );
+	key = ( key << DRAW_KEY_DEPTH_BITS ) | quantizedDepth;
+	key = ( key << DRAW_KEY_MATERIAL_BITS ) | ToKeyBits( material, DRAW_KEY_MATERIAL_BITS );
+	key = ( key << DRAW_KEY_GEOMETRY_BITS ) | ToKeyBits( geometry, DRAW_KEY_GEOMETRY_BITS );
+	return key;
+}
+
+void RadixSortDrawKeys( std::vector<uint64_t>* keys, std::vector<uint32_t>* values )
+{
+	assert( keys->size() == values->size() );
+	const size_t count = keys->size();
+	if( count < 2 )
+		return;
+
+	//One histogram per byte, all filled in a single pass over the keys
+	constexpr uint32_t RADIX_PASSES = 8;
+	uint32_t histograms[RADIX_PASSES][256] = {};
+	for( uint64_t key : *keys )
+		for( uint32_t pass = 0; pass < RADIX_PASSES; ++pass )
+			++histograms[pass][( key >> ( pass * 8 ) ) & 0xFF];
+
+	std::vector<uint64_t> keysScratch( count );
+	std::vector<uint32_t> valuesScratch( count );
+	std::vector<uint64_t>* srcKeys = keys;
+	std::vector<uint32_t>* srcValues = values;
+	std::vector<uint64_t>* dstKeys = &keysScratch;
+	std::vector<uint32_t>* dstValues = &valuesScratch;
+
+	for( uint32_t pass = 0; pass < RADIX_PASSES; ++pass )
+	{
+		uint32_t* histogram = histograms[pass];
+		const uint32_t shift = pass * 8;
+		if( histogram[( ( *srcKeys )[0] >> shift ) & 0xFF] == count )
+			continue;
+
+		uint32_t offsets[256];
+		uint32_t offset = 0;
+		for( uint32_t i = 0; i < 256; ++i )
+		{
+			offsets[i] = offset;
+			offset += histogram[i];
+		}
+
+		for( size_t i = 0; i < count; ++i )
+		{
+			const uint64_t key = ( *srcKeys )[i];
+			const uint32_t destination = offsets[( key >> shift ) & 0xFF]++;
+			( *dstKeys )[destination] = key;
+			( *dstValues )[destination] = ( *srcValues )[i];
+		}
+
+		std::swap( srcKeys, dstKeys );
+		std::swap( srcValues, dstValues );
+	}
+
+	if( srcKeys != keys )
+	{
+		keys->swap( keysScratch );
+		values->swap( valuesScratch );
+	}
+}
\ No newline at end of file
@@ -1,10 +1,11 @@
 #include "frame_graph.h"
 #include "frame_graph_common_internal.h"
+#include "frame_graph_compiler.h"
 
 #include "gfx_heaps_batched_allocator.h"
+#include "cpu_profiler.h"
 
 #include <vector>
-#include <map>
 #include <stdexcept>
 
 namespace FG
@@ -24,6 +25,15 @@ namespace FG
 		imp->_render_targets[handle][frameIndex] = image;
 	}
 
+	void FrameGraph::SetSwapchainImages( fg_handle_t handle, const std::vector<R_HW::GfxImage>& images )
+	{
+		assert( !images.empty() );
+		imp->_swapchainImage_h = handle;
+		imp->_swapchainImages = images;
+		for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; ++frameIndex )
+			imp->_render_targets[handle][frameIndex] = images[0];
+	}
+
 	FrameGraph::FrameGraph()
 		: imp( nullptr ) {}
 
@@ -43,163 +53,38 @@ namespace FG
 		return image;
 	}
 
-	static R_HW::AttachementDescription CreateRTCommon( R_HW::GfxFormat format, fg_handle_t render_target_handle, R_HW::GfxLayout optimalLayout, R_HW::GfxAccess access )
-	{
-		R_HW::AttachementDescription description;
-		description.format = format;
-		description.access = access;
-		description.layout = optimalLayout;
-		description.finalAccess = access; //TODO: Just like old Access, this isn't great, We never set this to write, only read.
-		description.finalLayout = optimalLayout;
-		description.loadOp = R_HW::GfxLoadOp::DONT_CARE;
-		description.oldAccess = R_HW::GfxAccess::WRITE;//TODO: old access isn't changed anywhere if old access is read we are boned
-		description.oldLayout = R_HW::GfxLayout::UNDEFINED;
-
-		return description;
-	}
-
-	static R_HW::AttachementDescription RenderColor( R_HW::GfxFormat format, fg_handle_t render_target_handle )
-	{
-		return CreateRTCommon( format, render_target_handle, R_HW::GfxLayout::COLOR, R_HW::GfxAccess::WRITE );
-	}
-
-	static R_HW::AttachementDescription RenderDepth( R_HW::GfxFormat format, fg_handle_t render_target_handle )
+	//Swapchain sized images get their own memory so a resize can free them without the heap, nothing is uploaded
+	static R_HW::GfxImage CreateSwapchainSizedImage( const ResourceDesc& resourceDesc )
 	{
-		return CreateRTCommon( format, render_target_handle, R_HW::GfxLayout::DEPTH_STENCIL, R_HW::GfxAccess::WRITE );
-	}
-
-	static R_HW::AttachementDescription ReadRenderTargetDepth( R_HW::GfxFormat format, fg_handle_t render_target_handle )
-	{
-		return CreateRTCommon( format, render_target_handle, R_HW::GfxLayout::DEPTH_STENCIL, R_HW::GfxAccess::READ );
-	}
-
-	void ClearTarget( R_HW::AttachementDescription* attachementDesc )
-	{
-		attachementDesc->loadOp = R_HW::GfxLoadOp::CLEAR;
-	}
-
-	static int32_t FindResourceIndex( const RenderPassCreationData& pass, fg_handle_t render_target_handle )
-	{
-		for (int32_t i = 0; i < pass.attachmentCount; ++i)
-		{
-			if (pass.fgHandleAttachement[i] == render_target_handle )
-				return i;
-		}
-
-		return -1;
-	}
-
-	static R_HW::AttachementDescription* GetAttachementDesc( RenderPassCreationData* pass, fg_handle_t render_target_handle )
-	{
-		uint32_t resource_index = FindResourceIndex( *pass, render_target_handle );
-		assert( resource_index >= 0 && resource_index < pass->attachmentCount );
-		return &pass->descriptions[resource_index];
+		GfxHeaps_CommitedResourceAllocator allocator = {};
+		return CreateImage( resourceDesc.format, resourceDesc.extent, resourceDesc.usage_flags, &allocator );
 	}
 
 	static void CreateBuffer( const FG::DataEntry& techniqueDataEntry, R_HW::I_BufferAllocator* bufferAllocator, R_HW::GpuBuffer* o_buffer )
 	{
 		R_HW::GfxDeviceSize size;
+		R_HW::GfxBufferUsageFlags usage = R_HW::GFX_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 		switch( techniqueDataEntry.descriptorType )
 		{
 		case R_HW::eDescriptorType::BUFFER:
 			size = techniqueDataEntry.resourceDesc.extent.width;
 			break;
 		case R_HW::eDescriptorType::BUFFER_DYNAMIC:
+			//Each object gets a slot aligned for dynamic offsets
+			size = R_HW::AlignUp( techniqueDataEntry.resourceDesc.extent.width, R_HW::GetMinBufferOffsetAlignment( techniqueDataEntry.descriptorType ) ) * techniqueDataEntry.resourceDesc.extent.height;
+			break;
+		case R_HW::eDescriptorType::BUFFER_STORAGE:
 			size = techniqueDataEntry.resourceDesc.extent.width * techniqueDataEntry.resourceDesc.extent.height;
+			usage = R_HW::GFX_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			break;
 		}
+		usage |= techniqueDataEntry.resourceDesc.usage_flags;
 
 		//TODO: could have to change VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT if we write (store). Will have to check all bindings to know.
-		o_buffer->buffer = create_buffer( size, R_HW::GFX_BUFFER_USAGE_UNIFORM_BUFFER_BIT );
+		o_buffer->buffer = create_buffer( size, usage );
 		bufferAllocator->Allocate( o_buffer->buffer, &o_buffer->gpuMemory );
 	}
 
-	static void ComposeGraph( FrameGraphCreationData& creationData, FrameGraphInternal* o_frameGraph )
-	{
-		//TODO: this is wrong, render targets don't include buffers
-		o_frameGraph->_render_targets_count = creationData.resources.size();
-		std::map< fg_handle_t, RenderPassCreationData*> lastPass;
-
-		for (uint32_t i = 0; i < creationData.renderPasses.size(); ++i)
-		{
-			RenderPassCreationData& pass = creationData.renderPasses[i];
-
-			for( uint32_t rtIndex = 0; rtIndex < pass.frame_graph_node.renderTargetRefs.size(); ++rtIndex )
-			{
-				const RenderTargetRef& rtRef = pass.frame_graph_node.renderTargetRefs[rtIndex];
-				const fg_handle_t resource_h = rtRef.resourceHandle;
-				const R_HW::GfxFormat format = creationData.resources[rtRef.resourceHandle].resourceDesc.format;
-
-				if( rtRef.flags & FG_RENDERTARGET_REF_READ_BIT )
-				{
-					// read resources -	Look at read resources and change the the final layout of the last appearence to be used as shader resource or depth read
-					auto it_found = lastPass.find( resource_h );
-					if( it_found != lastPass.end() )
-					{
-						RenderPassCreationData* lastPassWithResource = it_found->second;
-						int32_t otherPassReferenceIndex = FindResourceIndex( *lastPassWithResource, resource_h );
-						if( otherPassReferenceIndex >= 0 )
-						{
-							//Last pass should transition to read resource at the end
-							lastPassWithResource->descriptions[otherPassReferenceIndex].finalLayout = R_HW::GfxLayout::COLOR;
-							lastPassWithResource->descriptions[otherPassReferenceIndex].finalAccess = R_HW::GfxAccess::READ;
-						}
-						else
-						{
-							//We are already in a read state
-						}
-					}
-					else
-					{
-						throw std::runtime_error( "This render pass does not exist already!" );
-					}
-				}
-				else
-				{
-					assert( pass.attachmentCount < MAX_ATTACHMENTS_COUNT );
-
-					const uint32_t attachement_index = pass.attachmentCount++;
-					pass.fgHandleAttachement[attachement_index] = resource_h;
-					R_HW::AttachementDescription& description = pass.descriptions[attachement_index];
-
-					if( creationData.resources[resource_h].resourceDesc.usage_flags & R_HW::DEPTH_STENCIL_ATTACHMENT )
-					{
-						if( rtRef.flags & FG_RENDERTARGET_REF_DEPTH_READ )
-							description = ReadRenderTargetDepth( format, rtRef.resourceHandle );
-						else
-							description = RenderDepth( format, rtRef.resourceHandle );
-					}
-					else
-						description = RenderColor( format, rtRef.resourceHandle );
-
-					if( rtRef.flags & FG_RENDERTARGET_REF_CLEAR_BIT )
-						ClearTarget( &description );
-
-					auto it_found = lastPass.find( resource_h );
-					if( it_found != lastPass.end() )
-					{
-						RenderPassCreationData* lastPassWithResource = it_found->second;
-						//The last pass will have to transition into this pass' layout
-						R_HW::AttachementDescription* lastAttachementDesc = GetAttachementDesc( lastPassWithResource, resource_h );
-						lastAttachementDesc->finalLayout = description.layout;
-						if( rtRef.flags & FG_RENDERTARGET_REF_DEPTH_READ )
-						{
-							lastAttachementDesc->finalAccess = R_HW::GfxAccess::READ;
-							description.oldAccess = R_HW::GfxAccess::READ;
-						}
-
-						//This pass'initial layout should be the same as the layout since the line above will transition it
-						description.oldLayout = description.layout;
-
-						//If another pass wrote into this, we shouldn't discard the data
-						description.loadOp = R_HW::GfxLoadOp::LOAD;//TODO: Maybe we shouldn't load if we specified a CLEAR
-					}
-				}
-
-				lastPass[resource_h] = &pass;
-			}
-		}
-	}
-
 	static void CreateResources( FrameGraphCreationData& creationData, FrameGraphInternal* o_frameGraph )
 	{
 		o_frameGraph->_gfx_mem_heap = R_HW::create_gfx_heap( 16 * 1024 * 1024, R_HW::GFX_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
@@ -215,7 +100,7 @@ namespace FG
 			{
 				if( IsBufferType( creationData.resources[fg_Handle].descriptorType ) )
 				{
-					for( uint32_t frameIndex = 0; frameIndex < SIMULTANEOUS_FRAMES; ++frameIndex )
+					for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; ++frameIndex )
 						CreateBuffer( creationData.resources[fg_Handle], &buffer_allocator, &o_frameGraph->_buffers[fg_Handle][frameIndex] );
 				}
 				else if( creationData.resources[fg_Handle].descriptorType == R_HW::eDescriptorType::SAMPLER )
@@ -224,8 +109,11 @@ namespace FG
 				else
 				{
 					ResourceDesc* resourceDesc = &creationData.resources[fg_Handle].resourceDesc;
-					o_frameGraph->_render_targets[fg_Handle][0] = CreateImage( resourceDesc->format, resourceDesc->extent, resourceDesc->usage_flags, &image_allocator );
-					for( uint32_t frameIndex = 1; frameIndex < SIMULTANEOUS_FRAMES; ++frameIndex )
+					if( creationData.resources[fg_Handle].flags & eDataEntryFlags::SWAPCHAIN_SIZED )
+						o_frameGraph->_render_targets[fg_Handle][0] = CreateSwapchainSizedImage( *resourceDesc );
+					else
+						o_frameGraph->_render_targets[fg_Handle][0] = CreateImage( resourceDesc->format, resourceDesc->extent, resourceDesc->usage_flags, &image_allocator );
+					for( uint32_t frameIndex = 1; frameIndex < g_gfx.framesInFlight; ++frameIndex )
 						o_frameGraph->_render_targets[fg_Handle][frameIndex] = o_frameGraph->_render_targets[fg_Handle][0];
 				}
 			}
@@ -234,11 +122,50 @@ namespace FG
 		image_allocator.Commit();
 	}
 
+	static bool WritesSwapchainImage( const RenderPassCreationData& passCreationData, uint32_t colorCount, const FrameGraphInternal* frameGraph )
+	{
+		for( uint32_t colorIndex = 0; colorIndex < colorCount; ++colorIndex )
+		{
+			if( passCreationData.fgHandleAttachement[colorIndex] == frameGraph->_swapchainImage_h )
+				return true;
+		}
+		return false;
+	}
+
+	//The other attachments are the same in every frame, see CreateResources
+	static void CreateSwapchainFrameBuffers( R_HW::RenderPass* renderpass, uint32_t passIndex, const RenderPassCreationData& passCreationData, uint32_t colorCount, bool containsDepth, FrameGraphInternal* frameGraph )
+	{
+		VkExtent2D extent = frameGraph->_swapchainImages[0].extent;
+		std::vector<R_HW::FrameBuffer>& frameBuffers = frameGraph->_swapchainFrameBuffers[passIndex];
+		for( const R_HW::GfxImage& swapchainImage : frameGraph->_swapchainImages )
+		{
+			R_HW::GfxImageView colorImages[MAX_ATTACHMENTS_COUNT];
+			for( uint32_t colorIndex = 0; colorIndex < colorCount; ++colorIndex )
+			{
+				const fg_handle_t resourceHandle = passCreationData.fgHandleAttachement[colorIndex];
+				colorImages[colorIndex] = resourceHandle == frameGraph->_swapchainImage_h ? swapchainImage.imageView : frameGraph->_render_targets[resourceHandle][0].imageView;
+			}
+			R_HW::GfxImageView* depthImage = containsDepth ? &frameGraph->_render_targets[passCreationData.fgHandleAttachement[colorCount]][0].imageView : nullptr;
+
+			frameBuffers.push_back( CreateFrameBuffer( colorImages, colorCount, depthImage, extent, *renderpass ) );
+		}
+
+		//Replaced by the framebuffer of the acquired image in RecordDrawCommands
+		for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; frameIndex++ )
+			renderpass->outputFrameBuffer[frameIndex] = frameBuffers[0];
+	}
+
 	//TODO: probably doesn't need the frame graph
-	static void CreateFrameBuffer( R_HW::RenderPass* renderpass, const RenderPassCreationData& passCreationData, uint32_t colorCount, bool containsDepth, FrameGraphInternal* frameGraph )
+	static void CreateFrameBuffer( R_HW::RenderPass* renderpass, uint32_t passIndex, const RenderPassCreationData& passCreationData, uint32_t colorCount, bool containsDepth, FrameGraphInternal* frameGraph )
 	{
+		if( WritesSwapchainImage( passCreationData, colorCount, frameGraph ) )
+		{
+			CreateSwapchainFrameBuffers( renderpass, passIndex, passCreationData, colorCount, containsDepth, frameGraph );
+			return;
+		}
+
 		VkExtent2D extent = frameGraph->_render_targets[passCreationData.fgHandleAttachement[0]][0].extent;
-		for( uint32_t frameIndex = 0; frameIndex < SIMULTANEOUS_FRAMES; frameIndex++ )
+		for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; frameIndex++ )
 		{
 			R_HW::GfxImageView colorImages[MAX_ATTACHMENTS_COUNT];
 			for( uint32_t colorIndex = 0; colorIndex < colorCount; ++colorIndex )
@@ -253,17 +180,38 @@ namespace FG
 		}
 	}
 
-	static void CreateRenderPass(const RenderPassCreationData& passCreationData, const char* name, R_HW::RenderPass* o_renderPass, FrameGraphInternal* frameGraph)
+	//The framebuffers owned by the pass, the outputFrameBuffer of a pass writing the swapchain image only alias them
+	static void TakeFrameBuffers( R_HW::RenderPass* renderpass, uint32_t passIndex, FrameGraphInternal* frameGraph, std::vector<R_HW::FrameBuffer>* o_frameBuffers )
 	{
-		assert(passCreationData.attachmentCount > 0);
-		bool containsDepth = passCreationData.descriptions[passCreationData.attachmentCount - 1].layout == R_HW::GfxLayout::DEPTH_STENCIL;
+		std::vector<R_HW::FrameBuffer>& swapchainFrameBuffers = frameGraph->_swapchainFrameBuffers[passIndex];
+		if( !swapchainFrameBuffers.empty() )
+		{
+			o_frameBuffers->insert( o_frameBuffers->end(), swapchainFrameBuffers.begin(), swapchainFrameBuffers.end() );
+			swapchainFrameBuffers.clear();
+		}
+		else
+			o_frameBuffers->insert( o_frameBuffers->end(), renderpass->outputFrameBuffer, renderpass->outputFrameBuffer + g_gfx.framesInFlight );
+
+		for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; frameIndex++ )
+			renderpass->outputFrameBuffer[frameIndex] = {};
+	}
+
+	static bool ContainsDepth( const RenderPassCreationData& passCreationData )
+	{
+		assert( passCreationData.attachmentCount > 0 );
+		return passCreationData.descriptions[passCreationData.attachmentCount - 1].layout == R_HW::GfxLayout::DEPTH_STENCIL;
+	}
+
+	static void CreateRenderPass(const RenderPassCreationData& passCreationData, uint32_t passIndex, const char* name, R_HW::RenderPass* o_renderPass, FrameGraphInternal* frameGraph)
+	{
+		bool containsDepth = ContainsDepth( passCreationData );
 		uint32_t colorCount = passCreationData.attachmentCount - (containsDepth ? 1 : 0);
 		const R_HW::AttachementDescription* ptrDepthStencilAttachement = (containsDepth ? &passCreationData.descriptions[colorCount] : nullptr );
 
 		*o_renderPass = CreateRenderPass( name, passCreationData.descriptions, colorCount, ptrDepthStencilAttachement );
 
 		//Create the frame buffer of the render pass
-		CreateFrameBuffer( o_renderPass, passCreationData, colorCount, containsDepth, frameGraph );
+		CreateFrameBuffer( o_renderPass, passIndex, passCreationData, colorCount, containsDepth, frameGraph );
 	}
 
 	void CreateRenderPasses( FrameGraph* frameGraphExternal )
@@ -272,9 +220,12 @@ namespace FG
 		const FrameGraphCreationData& creationData = frameGraph->creationData;
 		for( uint32_t i = 0; i < creationData.renderPasses.size(); ++i )
 		{
-			//Create the pass
+			//Create the pass, compute nodes keep an empty one so indices match the creation data
 			const RenderPassCreationData* rpCreationData = &creationData.renderPasses[i];
-			CreateRenderPass( *rpCreationData, rpCreationData->name, &frameGraph->_render_passes[frameGraph->_render_passes_count++], frameGraph );
+			R_HW::RenderPass* renderPass = &frameGraph->_render_passes[frameGraph->_render_passes_count++];
+			*renderPass = {};
+			if( !rpCreationData->frame_graph_node.isCompute )
+				CreateRenderPass( *rpCreationData, i, rpCreationData->name, renderPass, frameGraph );
 		}
 	}
 
@@ -288,13 +239,69 @@ namespace FG
 		creationData.resources = *inRtCreationData;
 		creationData.renderPasses = *inRpCreationData;
 
-		ComposeGraph( creationData, frameGraphInternal );
+		//TODO: this is wrong, render targets don't include buffers
+		frameGraphInternal->_render_targets_count = creationData.resources.size();
+
+		FrameGraphCompiler compiler;
+		std::string error;
+		if( !compiler.Compile( &creationData.renderPasses, creationData.resources, &frameGraphInternal->compiledGraph, &error ) )
+			throw std::runtime_error( error );
+#ifndef NDEBUG
+		if( !ValidateCompiledGraph( creationData.renderPasses, creationData.resources, frameGraphInternal->compiledGraph, &error ) )
+			throw std::runtime_error( error );
+#endif
 
 		CreateResources( creationData, frameGraphInternal );
 
 		return frameGraph;
 	}
 
+	void Resize( FrameGraph* frameGraphExternal, VkExtent2D extent, std::array< GpuInputData, SIMULTANEOUS_FRAMES>& inputBuffers, RetiredResources* o_retired )
+	{
+		FrameGraphInternal* frameGraph = frameGraphExternal->imp;
+		for( fg_handle_t handle = 0; handle < frameGraph->creationData.resources.size(); ++handle )
+		{
+			DataEntry& resource = frameGraph->creationData.resources[handle];
+			if( !(resource.flags & eDataEntryFlags::SWAPCHAIN_SIZED) )
+				continue;
+
+			resource.resourceDesc.extent = extent;
+			o_retired->images.push_back( frameGraph->_render_targets[handle][0] );
+			frameGraph->_render_targets[handle][0] = CreateSwapchainSizedImage( resource.resourceDesc );
+			for( uint32_t frameIndex = 1; frameIndex < g_gfx.framesInFlight; ++frameIndex )
+				frameGraph->_render_targets[handle][frameIndex] = frameGraph->_render_targets[handle][0];
+
+			//Setting it again changes its version, each frame rewrites its own tables once the GPU is done with them
+			R_HW::GfxImageSamplerCombined* imageInfo = &frameGraph->allImages[resource.user_id];
+			if( imageInfo->image )
+			{
+				for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; ++frameIndex )
+					SetImages( &inputBuffers[frameIndex], resource.user_id, imageInfo, 1 );
+			}
+		}
+
+		for( uint32_t i = 0; i < frameGraph->_render_passes_count; ++i )
+		{
+			R_HW::RenderPass* renderPass = &frameGraph->_render_passes[i];
+			if( renderPass->vk_renderpass == VK_NULL_HANDLE )
+				continue;
+			TakeFrameBuffers( renderPass, i, frameGraph, &o_retired->frameBuffers );
+
+			const RenderPassCreationData& passCreationData = frameGraph->creationData.renderPasses[i];
+			const bool containsDepth = ContainsDepth( passCreationData );
+			CreateFrameBuffer( renderPass, i, passCreationData, passCreationData.attachmentCount - (containsDepth ? 1 : 0), containsDepth, frameGraph );
+		}
+	}
+
+	void Destroy( RetiredResources* retired )
+	{
+		for( R_HW::GfxImage& image : retired->images )
+			R_HW::DestroyImage( &image );
+		for( R_HW::FrameBuffer& frameBuffer : retired->frameBuffers )
+			Destroy( &frameBuffer );
+		*retired = {};
+	}
+
 	void Cleanup( FrameGraph* frameGraphExternal )
 	{
 		if( !frameGraphExternal->imp )
@@ -314,7 +321,7 @@ namespace FG
 		frameGraph->_render_targets_count = 0;
 		for( uint32_t i = 0; i < frameGraph->creationData.resources.size(); ++i )
 		{
-			for( uint32_t frameIndex = 0; frameIndex < SIMULTANEOUS_FRAMES; ++frameIndex )
+			for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; ++frameIndex )
 			{
 				if( IsValid( frameGraph->_buffers[i][frameIndex] ) )
 					Destroy( &frameGraph->_buffers[i][frameIndex] );
@@ -324,10 +331,12 @@ namespace FG
 		for (uint32_t i = 0; i < frameGraph->_render_passes_count; ++i)
 		{
 			R_HW::RenderPass& renderpass = frameGraph->_render_passes[i];
-			for (uint32_t fb_index = 0; fb_index < SIMULTANEOUS_FRAMES; ++fb_index)
-			{
-				Destroy( &renderpass.outputFrameBuffer[fb_index] );
-			}
+			if( renderpass.vk_renderpass == VK_NULL_HANDLE )
+				continue;
+			std::vector<R_HW::FrameBuffer> frameBuffers;
+			TakeFrameBuffers( &renderpass, i, frameGraph, &frameBuffers );
+			for( R_HW::FrameBuffer& frameBuffer : frameBuffers )
+				Destroy( &frameBuffer );
 			Destroy( &renderpass );
 		}
 		frameGraph->_render_passes_count = 0;
@@ -340,6 +349,9 @@ namespace FG
 			technique = {};
 		}
 		frameGraph->_techniques_count = 0;
+		//Frees the descriptor tables of all the techniques at once
+		if( frameGraph->_descriptorPool != VK_NULL_HANDLE )
+			R_HW::Destroy( &frameGraph->_descriptorPool );
 
 		frameGraph->allImages = {};
 
@@ -350,11 +362,46 @@ namespace FG
 		frameGraphExternal->imp = nullptr;
 	}
 
-	void RecordDrawCommands(uint32_t currentFrame, void* userData, R_HW::GfxCommandBuffer graphicsCommandBuffer, VkExtent2D extent, FrameGraph* frameGraphExternal)
+	//All the buffers a pass reads are covered by a single barrier
+	static void CmdBufferBarriers( R_HW::GfxCommandBuffer commandBuffer, const CompiledGraph& compiledGraph, uint32_t passIndex )
+	{
+		R_HW::GfxPipelineStageFlag srcStages = 0;
+		R_HW::GfxMemoryAccessFlags srcAccess = 0;
+		R_HW::GfxPipelineStageFlag dstStages = 0;
+		R_HW::GfxMemoryAccessFlags dstAccess = 0;
+		for( const PlannedBufferBarrier& barrier : compiledGraph.bufferBarriers )
+		{
+			if( barrier.dstPass != passIndex )
+				continue;
+			srcStages |= barrier.srcStages;
+			srcAccess |= barrier.srcAccess;
+			dstStages |= barrier.dstStages;
+			dstAccess |= barrier.dstAccess;
+		}
+
+		if( dstStages != 0 )
+			R_HW::GfxMemoryBarrier( commandBuffer, srcStages, srcAccess, dstStages, dstAccess );
+	}
+
+	void RecordDrawCommands(uint32_t currentFrame, uint32_t swapchainImageIndex, void* userData, R_HW::GfxCommandBuffer graphicsCommandBuffer, VkExtent2D extent, FrameGraph* frameGraphExternal)
 	{
+		PROFILE_ZONE( "FG::RecordDrawCommands" );
 		FrameGraphInternal* frameGraph = frameGraphExternal->imp;
-		for (uint32_t i = 0; i < frameGraph->_render_passes_count; ++i)
+		if( frameGraph->_swapchainImage_h != INVALID_FG_HANDLE )
+		{
+			assert( swapchainImageIndex < frameGraph->_swapchainImages.size() );
+			frameGraph->_render_targets[frameGraph->_swapchainImage_h][currentFrame] = frameGraph->_swapchainImages[swapchainImageIndex];
+			for( uint32_t i = 0; i < frameGraph->_render_passes_count; ++i )
+			{
+				if( !frameGraph->_swapchainFrameBuffers[i].empty() )
+					frameGraph->_render_passes[i].outputFrameBuffer[currentFrame] = frameGraph->_swapchainFrameBuffers[i][swapchainImageIndex];
+			}
+		}
+
+		for( uint32_t i : frameGraph->compiledGraph.passOrder )
 		{
+			PROFILE_ZONE( frameGraph->creationData.renderPasses[i].name );
+			CmdBufferBarriers( graphicsCommandBuffer, frameGraph->compiledGraph, i );
 			TaskInputData taskInputData = { userData, currentFrame, extent, &frameGraph->_render_passes[i], &frameGraph->_techniques[i] };
 			frameGraph->creationData.renderPasses[i].frame_graph_node.RecordDrawCommands( graphicsCommandBuffer, taskInputData );
 		}
@@ -4,7 +4,12 @@
 
 #include "vk_globals.h"
 #include "material.h"
+#include "cpu_profiler.h"
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 
 namespace FG
 {	
@@ -32,20 +37,50 @@ namespace FG
 		return CreateDescriptorTableLayoutBinding( dataBinding.binding, dataBinding.stageFlags, dataEntry.descriptorType, dataBinding.descriptorAccess, dataEntry.count );
 	}
 
-	static void CreateDescriptorTableLayout( const FG::FrameGraph* frameGraph, const FG::DescriptorTableDesc * desc, R_HW::GfxDescriptorTableLayout * o_tableLayout )
+	static uint32_t GetDescriptorTableLayoutBindings( const FG::FrameGraph* frameGraph, const FG::DescriptorTableDesc * desc, std::array<R_HW::GfxDescriptorTableLayoutBinding, 8>* o_bindings, std::array<R_HW::GfxDescriptorBindingFlags, 8>* o_bindingFlags )
 	{
-		std::array<R_HW::GfxDescriptorTableLayoutBinding, 8> tempBindings;
 		uint32_t count = 0;
 
+		assert( desc->dataBindings.size() <= o_bindings->size() );
 		for( uint32_t i = 0; i < desc->dataBindings.size(); ++i, ++count )
 		{
 			const FG::DataBinding& dataBinding = desc->dataBindings[i];
 			const FG::DataEntry* dataEntry = GetDataEntryFromHandle( frameGraph, dataBinding.resourceHandle );
 
-			tempBindings[count] = CreateDescriptorTableLayoutBinding( dataBinding.desc, *dataEntry );
+			(*o_bindings)[count] = CreateDescriptorTableLayoutBinding( dataBinding.desc, *dataEntry );
+			(*o_bindingFlags)[count] = dataEntry->flags & eDataEntryFlags::BINDLESS ? R_HW::GFX_DESCRIPTOR_BINDING_BINDLESS : 0;
 		}
 
-		R_HW::CreateDesciptorTableLayout( tempBindings.data(), count, o_tableLayout );
+		return count;
+	}
+
+	static void CreateDescriptorTableLayout( const FG::FrameGraph* frameGraph, const FG::DescriptorTableDesc * desc, R_HW::GfxDescriptorTableLayout * o_tableLayout, R_HW::GfxDescriptorUpdateTemplate* o_updateTemplate )
+	{
+		std::array<R_HW::GfxDescriptorTableLayoutBinding, 8> tempBindings;
+		std::array<R_HW::GfxDescriptorBindingFlags, 8> tempBindingFlags;
+		const uint32_t count = GetDescriptorTableLayoutBindings( frameGraph, desc, &tempBindings, &tempBindingFlags );
+
+		R_HW::CreateDesciptorTableLayout( tempBindings.data(), tempBindingFlags.data(), count, o_tableLayout );
+		R_HW::CreateDescriptorUpdateTemplate( tempBindings.data(), tempBindingFlags.data(), count, *o_tableLayout, o_updateTemplate );
+	}
+
+	//Every table of every pass, one per simultaneous frame
+	static R_HW::DescriptorPoolSizes GetDescriptorPoolSizes( const FG::FrameGraph* frameGraph )
+	{
+		R_HW::DescriptorPoolSizes sizes;
+		for( uint32_t i = 0; i < frameGraph->imp->_render_passes_count; ++i )
+		{
+			for( const FG::DescriptorTableDesc& tableDesc : frameGraph->imp->creationData.renderPasses[i].frame_graph_node.descriptorSets )
+			{
+				std::array<R_HW::GfxDescriptorTableLayoutBinding, 8> bindings;
+				std::array<R_HW::GfxDescriptorBindingFlags, 8> bindingFlags;
+				const uint32_t count = GetDescriptorTableLayoutBindings( frameGraph, &tableDesc, &bindings, &bindingFlags );
+				R_HW::AddDescriptorTables( bindings.data(), count, g_gfx.framesInFlight, &sizes );
+				for( uint32_t i = 0; i < count; ++i )
+					sizes.updateAfterBind |= (bindingFlags[i] & R_HW::GFX_DESCRIPTOR_BINDING_BINDLESS) != 0;
+			}
+		}
+		return sizes;
 	}
 
 	static void CreateDescriptorTable( R_HW::GfxDescriptorTableLayout descriptorSetLayout, R_HW::GfxDescriptorPool descriptorPool, R_HW::GfxDescriptorTable* o_descriptorSet )
@@ -66,7 +101,7 @@ namespace FG
 
 			if( IsBufferType( dataEntry->descriptorType ) )
 			{
-				for( size_t frameIndex = 0; frameIndex < SIMULTANEOUS_FRAMES; ++frameIndex )
+				for( size_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; ++frameIndex )
 				{
 					const R_HW::GpuBuffer* buffer = frameGraph->imp->GetBufferFromId( dataEntry->user_id, frameIndex );
 					assert( IsValid( buffer->gpuMemory ) );
@@ -81,14 +116,15 @@ namespace FG
 				if( imageInfo->image == nullptr )
 				{
 					*imageInfo = { const_cast< R_HW::GfxImage* >(image), GetSampler( dataEntry->sampler ) };
-					for( size_t frameIndex = 0; frameIndex < SIMULTANEOUS_FRAMES; ++frameIndex )
+					for( size_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; ++frameIndex )
 						SetImages( &(*inputBuffers)[frameIndex], dataEntry->user_id, imageInfo, 1 );
 				}
 			}
 		}
 	}
 
-	static Technique CreateTechnique( FG::FrameGraph* frameGraph, R_HW::GfxDescriptorPool descriptorPool, const R_HW::RenderPass* renderpass, const FG::RenderPassCreationData* passCreationData )
+	//Everything but the pipeline, see CreateTechniquePipeline
+	static Technique CreateTechnique( FG::FrameGraph* frameGraph, R_HW::GfxDescriptorPool descriptorPool, const FG::RenderPassCreationData* passCreationData )
 	{
 		Technique technique;
 
@@ -99,45 +135,156 @@ namespace FG
 		{
 			const FG::DescriptorTableDesc& setDesc = passCreationData->frame_graph_node.descriptorSets[i];
 			R_HW::GfxDescriptorTableLayout& layout = layouts[i];
-			CreateDescriptorTableLayout( frameGraph, &setDesc, &layout );
+			GfxDescriptorSetBinding& setBinding = technique.descriptor_sets[setDesc.binding];
+			CreateDescriptorTableLayout( frameGraph, &setDesc, &layout, &setBinding.updateTemplate );
 
 			//TODO: not all of them need one for each simultaneous frames
-			GfxDescriptorSetBinding& setBinding = technique.descriptor_sets[setDesc.binding];
 			setBinding.desc.binding = setDesc.binding;
 			setBinding.desc.dataBindings.resize( setDesc.dataBindings.size() );
 			for( uint32_t i = 0; i < setDesc.dataBindings.size(); ++i )
 				setBinding.desc.dataBindings[i] = setDesc.dataBindings[i].desc;
 			setBinding.hw_layout = layout;
 			setBinding.isValid = true;
+			for( std::array<uint32_t, MAX_DATA_ENTRIES>& writtenVersions : setBinding.writtenVersions )
+				writtenVersions.fill( DESCRIPTOR_NOT_WRITTEN );
+			for( std::vector<uint8_t>& packedDescriptors : setBinding.packedDescriptors )
+				packedDescriptors.resize( setBinding.updateTemplate.dataSize );
 
-			for( size_t i = 0; i < SIMULTANEOUS_FRAMES; ++i )
+			for( size_t i = 0; i < g_gfx.framesInFlight; ++i )
 				CreateDescriptorTable( layout, descriptorPool, &setBinding.hw_descriptorSets[i]);
 
 			tableDescs[i].binding = setBinding.desc.binding;
 			tableDescs[i].dataBindings = setBinding.desc.dataBindings;
 
 		}
-		technique.parentDescriptorPool = descriptorPool;
 
 		CreateGfxPipelineLayout( tableDescs, layouts, passCreationData->frame_graph_node.descriptorSets.size(),
 			passCreationData->frame_graph_node.gpuPipelineLayout.RootConstantRanges.data(), passCreationData->frame_graph_node.gpuPipelineLayout.RootConstantRanges.size(),
 			&technique.pipelineLayout );
-				
-		CreatePipeline( passCreationData->frame_graph_node.gpuPipelineStateDesc,
-			*renderpass,
-			technique.pipelineLayout,
-			&technique.pipeline );
 
 		return technique;
 	}
 
-	void CreateTechniques( FG::FrameGraph* frameGraph, R_HW::GfxDescriptorPool descriptorPool )
+	//Only touches the technique and the pipeline cache of the device, which is internally synchronized, so it can run on any thread
+	static void CreateTechniquePipeline( const R_HW::RenderPass* renderpass, const FG::RenderPassCreationData* passCreationData, Technique* technique )
 	{
-		for( uint32_t i = 0; i < frameGraph->imp->_render_passes_count; ++i )
+		if( passCreationData->frame_graph_node.isCompute )
+		{
+			assert( passCreationData->frame_graph_node.gpuPipelineStateDesc.shaders.size() == 1 );
+			CreateComputePipeline( passCreationData->frame_graph_node.gpuPipelineStateDesc.shaders[0], technique->pipelineLayout, &technique->pipeline );
+		}
+		else
+		{
+			CreatePipeline( passCreationData->frame_graph_node.gpuPipelineStateDesc,
+				*renderpass,
+				technique->pipelineLayout,
+				&technique->pipeline );
+		}
+	}
+
+	void CreateTechniques( FG::FrameGraph* frameGraph )
+	{
+		PROFILE_FUNCTION();
+		const uint32_t passCount = frameGraph->imp->_render_passes_count;
+
+		//Sized for exactly the tables of this graph, it's destroyed with the graph instead of freeing the tables one by one
+		const R_HW::DescriptorPoolSizes poolSizes = GetDescriptorPoolSizes( frameGraph );
+		if( poolSizes.maxTables > 0 )
+			R_HW::CreateDescriptorPool( poolSizes, &frameGraph->imp->_descriptorPool );
+		const R_HW::GfxDescriptorPool descriptorPool = frameGraph->imp->_descriptorPool;
+
+		//Descriptor tables come from a shared pool, they are allocated on this thread
+		for( uint32_t i = 0; i < passCount; ++i )
 		{
-			frameGraph->imp->_techniques[i] = CreateTechnique( frameGraph, descriptorPool, &frameGraph->imp->_render_passes[i], &frameGraph->imp->creationData.renderPasses[i] );
+			frameGraph->imp->_techniques[i] = CreateTechnique( frameGraph, descriptorPool, &frameGraph->imp->creationData.renderPasses[i] );
 			++frameGraph->imp->_techniques_count;
 		}
+
+		//The pipelines are compiled in parallel, the compilation takes about as long as the slowest one.
+		//No profiler zones in there, every new thread would get its own profiler buffer
+		std::vector<std::exception_ptr> errors( passCount );
+		std::atomic<uint32_t> nextPass = 0;
+		auto createPipelines = [&]()
+		{
+			for( uint32_t i = nextPass++; i < passCount; i = nextPass++ )
+			{
+				try
+				{
+					CreateTechniquePipeline( &frameGraph->imp->_render_passes[i], &frameGraph->imp->creationData.renderPasses[i], &frameGraph->imp->_techniques[i] );
+				}
+				catch( ... )
+				{
+					errors[i] = std::current_exception();
+				}
+			}
+		};
+
+		const uint32_t threadCount = std::min( passCount, std::max( std::thread::hardware_concurrency(), 1u ) );
+		std::vector<std::thread> workers;
+		for( uint32_t i = 1; i < threadCount; ++i )
+			workers.emplace_back( createPipelines );
+		createPipelines();
+		for( std::thread& worker : workers )
+			worker.join();
+
+		//The pipelines that did compile are destroyed before reporting the first error, the graph is left without any
+		const auto firstError = std::find_if( errors.begin(), errors.end(), []( const std::exception_ptr& error ) { return error != nullptr; } );
+		if( firstError != errors.end() )
+		{
+			for( uint32_t i = 0; i < passCount; ++i )
+			{
+				if( errors[i] )
+					frameGraph->imp->_techniques[i].pipeline = VK_NULL_HANDLE;
+				else
+					R_HW::Destroy( &frameGraph->imp->_techniques[i].pipeline );
+			}
+			std::rethrow_exception( *firstError );
+		}
+	}
+
+	static bool UsesAnyShader( const R_HW::GpuPipelineStateDesc& pipelineStateDesc, const std::vector<const R_HW::ShaderCode*>& shaders )
+	{
+		for( const R_HW::ShaderCreation& shader : pipelineStateDesc.shaders )
+		{
+			if( std::find( shaders.begin(), shaders.end(), shader.code ) != shaders.end() )
+				return true;
+		}
+		return false;
+	}
+
+	void RebuildPipelines( FrameGraph* frameGraph, const std::vector<const R_HW::ShaderCode*>& changedShaders, std::vector<R_HW::GfxPipeline>* o_oldPipelines )
+	{
+		PROFILE_FUNCTION();
+		std::vector<uint32_t> rebuiltTechniques;
+		std::vector<R_HW::GfxPipeline> rebuiltPipelines;
+		try
+		{
+			for( uint32_t i = 0; i < frameGraph->imp->_techniques_count; ++i )
+			{
+				const FG::RenderPassCreationData* passCreationData = &frameGraph->imp->creationData.renderPasses[i];
+				if( !UsesAnyShader( passCreationData->frame_graph_node.gpuPipelineStateDesc, changedShaders ) )
+					continue;
+
+				Technique rebuilt = frameGraph->imp->_techniques[i];
+				CreateTechniquePipeline( &frameGraph->imp->_render_passes[i], passCreationData, &rebuilt );
+				rebuiltTechniques.push_back( i );
+				rebuiltPipelines.push_back( rebuilt.pipeline );
+			}
+		}
+		catch( ... )
+		{
+			//The techniques keep all their old pipelines
+			for( R_HW::GfxPipeline& pipeline : rebuiltPipelines )
+				R_HW::Destroy( &pipeline );
+			throw;
+		}
+
+		for( size_t i = 0; i < rebuiltTechniques.size(); ++i )
+		{
+			Technique* technique = &frameGraph->imp->_techniques[rebuiltTechniques[i]];
+			o_oldPipelines->push_back( technique->pipeline );
+			technique->pipeline = rebuiltPipelines[i];
+		}
 	}
 
 	void AddResourcesToInputBuffer( FG::FrameGraph* frameGraph, std::array< GpuInputData, SIMULTANEOUS_FRAMES>& inputBuffers )
@@ -151,94 +298,124 @@ namespace FG
 		}
 	}
 
-	static void UpdateDescriptorTable( const FG::FrameGraph* frameGraph, const GpuInputData* inputData, const DescriptorTableDesc& descriptorSetDesc, R_HW::GfxDescriptorTable* descriptorTable )
+	//Dummies for the elements of a binding that have no data, from firstElement to the end of the array
+	static void PackDummyDescriptors( const R_HW::GfxDescriptorUpdateTemplate& updateTemplate, uint32_t bindingIndex, const FG::DataEntry& dataEntry, uint32_t firstElement, const R_HW::GfxImage& dummyImage, uint8_t* io_packedDescriptors )
 	{
-		assert( descriptorSetDesc.dataBindings.size() <= MAX_DATA_ENTRIES );
-		R_HW::BatchDescriptorsUpdater batchDescriptorsUpdater;
-
-		//Fill in buffer
-		for( uint32_t dataBindingIndex = 0; dataBindingIndex < descriptorSetDesc.dataBindings.size(); ++dataBindingIndex )
+		if( dataEntry.descriptorType == R_HW::eDescriptorType::IMAGE_SAMPLER || dataEntry.descriptorType == R_HW::eDescriptorType::IMAGE )
 		{
-			const DataBinding& dataBinding = descriptorSetDesc.dataBindings[dataBindingIndex];
-			const R_HW::GfxDataBinding& gfxDataBinding = dataBinding.desc;
-			const FG::DataEntry* techniqueDataEntry = GetDataEntryFromHandle( frameGraph, dataBinding.resourceHandle );
-			uint32_t buffersCount = GetDataCount( inputData, techniqueDataEntry->user_id );
-			assert( buffersCount <= techniqueDataEntry->count );
-
-			batchDescriptorsUpdater.AddBinding( GetData( inputData, techniqueDataEntry->user_id ), buffersCount, gfxDataBinding.binding, techniqueDataEntry->descriptorType, gfxDataBinding.descriptorAccess );
+			const R_HW::GfxImageSamplerCombined combinedDummyImage = { const_cast< R_HW::GfxImage*>(&dummyImage), GetSampler( eSamplers::Trilinear ) };
+			for( uint32_t element = firstElement; element < dataEntry.count; ++element )
+				R_HW::PackDescriptors( updateTemplate, bindingIndex, element, &combinedDummyImage, 1, io_packedDescriptors );
+		}
+		else if( dataEntry.descriptorType == R_HW::eDescriptorType::SAMPLER )
+		{
+			const R_HW::GfxApiSampler dummySampler = GetSampler( eSamplers::Point );
+			for( uint32_t element = firstElement; element < dataEntry.count; ++element )
+				R_HW::PackDescriptors( updateTemplate, bindingIndex, element, &dummySampler, 1, io_packedDescriptors );
+		}
+		else
+		{
+			//Buffers have no dummy, see PackChangedDescriptors. Other image types not yet implemented
+			assert( false );
 		}
-
-		batchDescriptorsUpdater.Submit( *descriptorTable );
 	}
 
+	//Partially bound, the elements without an image are skipped and keep whatever they had. Nothing samples them
+	static void AddBindlessDescriptors( R_HW::GfxDescriptorTable descriptorTable, const FG::DataEntry& dataEntry, const R_HW::GfxDataBinding& gfxDataBinding, const R_HW::GfxImageSamplerCombined* images, uint32_t count, R_HW::BatchDescriptorsUpdater* batchDescriptorsUpdater )
+	{
+		uint32_t element = 0;
+		while( element < count )
+		{
+			if( !images[element].image )
+			{
+				++element;
+				continue;
+			}
+			const uint32_t firstElement = element;
+			while( element < count && images[element].image )
+				++element;
+			batchDescriptorsUpdater->AddImagesBinding( descriptorTable, &images[firstElement], element - firstElement, gfxDataBinding.binding, firstElement, dataEntry.descriptorType, gfxDataBinding.descriptorAccess );
+		}
+	}
 
-	//TODO: Not very efficient, buffers being recreated all of the time because of array descriptors.
-	static void FillWithDummyDescriptors( const FG::FrameGraph* frameGraph, const DescriptorTableDesc& descriptorSetDesc, const R_HW::GfxImage& dummyImage, R_HW::GfxDescriptorTable* descriptorTable )
+	//Only the bindings whose input data changed since they were last written in this table are packed, returns false when the template has nothing to write.
+	//Bindless bindings are not in the template, they go in batchDescriptorsUpdater
+	static bool PackChangedDescriptors( const FG::FrameGraph* frameGraph, const GpuInputData& inputData, const DescriptorTableDesc& descriptorSetDesc, const R_HW::GfxImage& dummyImage, R_HW::GfxDescriptorTable descriptorTable, const R_HW::GfxDescriptorUpdateTemplate& updateTemplate,
+		std::array<uint32_t, MAX_DATA_ENTRIES>* io_writtenVersions, uint8_t* io_packedDescriptors, R_HW::BatchDescriptorsUpdater* batchDescriptorsUpdater )
 	{
 		assert( descriptorSetDesc.dataBindings.size() <= MAX_DATA_ENTRIES );
-		R_HW::BatchDescriptorsUpdater batchDescriptorsUpdater;
 
-		const R_HW::GfxImageSamplerCombined combinedDummyImage = { const_cast< R_HW::GfxImage*>(&dummyImage), GetSampler( eSamplers::Trilinear ) };
-		const R_HW::GfxApiSampler dummySampler = GetSampler( eSamplers::Point );
-		constexpr uint32_t maxDescriptors = 16;
-		R_HW::GfxImageSamplerCombined dummyImageDescriptors[maxDescriptors];
-		R_HW::GfxApiSampler dummySamplers[maxDescriptors];
-		for( uint32_t i = 0; i < maxDescriptors; ++i )
+		//The whole table is written at once, it waits until all of its buffers are known
+		for( const DataBinding& dataBinding : descriptorSetDesc.dataBindings )
 		{
-			dummyImageDescriptors[i] = combinedDummyImage;
-			dummySamplers[i] = dummySampler;
+			const FG::DataEntry* techniqueDataEntry = GetDataEntryFromHandle( frameGraph, dataBinding.resourceHandle );
+			if( IsBufferType( techniqueDataEntry->descriptorType ) && (inputData.versions[techniqueDataEntry->user_id] == 0 || GetDataCount( &inputData, techniqueDataEntry->user_id ) == 0) )
+				return false;
 		}
 
-		//Fill in buffer
+		bool changed = false;
 		for( uint32_t dataBindingIndex = 0; dataBindingIndex < descriptorSetDesc.dataBindings.size(); ++dataBindingIndex )
 		{
-			const FG::DataBinding& dataBinding = descriptorSetDesc.dataBindings[dataBindingIndex];
-			const R_HW::GfxDataBinding& gfxDataBinding = dataBinding.desc;
+			const DataBinding& dataBinding = descriptorSetDesc.dataBindings[dataBindingIndex];
 			const FG::DataEntry* techniqueDataEntry = GetDataEntryFromHandle( frameGraph, dataBinding.resourceHandle );
-			if( IsBufferType( techniqueDataEntry->descriptorType ) )
-			{
-			}
-			else if( techniqueDataEntry->descriptorType == R_HW::eDescriptorType::IMAGE_SAMPLER || techniqueDataEntry->descriptorType == R_HW::eDescriptorType::IMAGE )
-			{
-				assert( techniqueDataEntry->count <= maxDescriptors );
-				batchDescriptorsUpdater.AddImagesBinding( dummyImageDescriptors, techniqueDataEntry->count, gfxDataBinding.binding, techniqueDataEntry->descriptorType, gfxDataBinding.descriptorAccess );
-			}
-			else if( techniqueDataEntry->descriptorType == R_HW::eDescriptorType::SAMPLER )
-			{
-				assert( techniqueDataEntry->count <= maxDescriptors );
-				batchDescriptorsUpdater.AddSamplersBinding( dummySamplers, techniqueDataEntry->count, gfxDataBinding.binding );
+			const uint32_t version = inputData.versions[techniqueDataEntry->user_id];
+			if( (*io_writtenVersions)[dataBindingIndex] == version )
+				continue;
+			(*io_writtenVersions)[dataBindingIndex] = version;
 
-			}
-			else
+			const uint32_t dataCount = version == 0 ? 0 : GetDataCount( &inputData, techniqueDataEntry->user_id );
+			assert( dataCount <= techniqueDataEntry->count );
+			if( techniqueDataEntry->flags & eDataEntryFlags::BINDLESS )
 			{
-				//TODO: Other image types not yet implemented
-				assert( false );
+				if( dataCount > 0 )
+					AddBindlessDescriptors( descriptorTable, *techniqueDataEntry, dataBinding.desc, reinterpret_cast< const R_HW::GfxImageSamplerCombined* >(GetData( &inputData, techniqueDataEntry->user_id )), dataCount, batchDescriptorsUpdater );
+				continue;
 			}
-		}
 
-		batchDescriptorsUpdater.Submit( *descriptorTable );
+			changed = true;
+			if( dataCount > 0 )
+				R_HW::PackDescriptors( updateTemplate, dataBindingIndex, 0, GetData( &inputData, techniqueDataEntry->user_id ), dataCount, io_packedDescriptors );
+			if( dataCount < techniqueDataEntry->count )
+				PackDummyDescriptors( updateTemplate, dataBindingIndex, *techniqueDataEntry, dataCount, dummyImage, io_packedDescriptors );
+		}
+		return changed;
 	}
 
-	void UpdateTechniqueDescriptorSets( const FG::FrameGraph* frameGraph, const std::array< GpuInputData, SIMULTANEOUS_FRAMES>& inputBuffers, const R_HW::GfxImage& dummyImage )
+	//One template update per table that changed, nothing is allocated unless a bindless array changed
+	static void UpdateChangedFrameDescriptors( const FG::FrameGraph* frameGraph, const GpuInputData& inputData, uint32_t frameIndex, const R_HW::GfxImage& dummyImage, R_HW::BatchDescriptorsUpdater* batchDescriptorsUpdater )
 	{
-		for( uint32_t i = 0; i < frameGraph->imp->_render_passes_count; ++i )
+		for( uint32_t i = 0; i < frameGraph->imp->_techniques_count; ++i )
 		{
 			Technique& technique = frameGraph->imp->_techniques[i];
 			const FG::RenderPassCreationData* passCreationData = &frameGraph->imp->creationData.renderPasses[i];
 
 			for( const DescriptorTableDesc& tableDesc : passCreationData->frame_graph_node.descriptorSets )
 			{
-				//TODO: not all of them need one for each simultaneous frames
-				for( size_t i = 0; i < SIMULTANEOUS_FRAMES; ++i )
-				{
-					R_HW::GfxDescriptorTable descriptorTable = technique.descriptor_sets[tableDesc.binding].hw_descriptorSets[i];
-					FillWithDummyDescriptors( frameGraph, tableDesc, dummyImage, &descriptorTable );
-					UpdateDescriptorTable( frameGraph, &inputBuffers[i], tableDesc, &descriptorTable );
-				}
+				GfxDescriptorSetBinding& setBinding = technique.descriptor_sets[tableDesc.binding];
+				uint8_t* packedDescriptors = setBinding.packedDescriptors[frameIndex].data();
+				if( PackChangedDescriptors( frameGraph, inputData, tableDesc, dummyImage, setBinding.hw_descriptorSets[frameIndex], setBinding.updateTemplate, &setBinding.writtenVersions[frameIndex], packedDescriptors, batchDescriptorsUpdater ) )
+					R_HW::UpdateDescriptorTable( setBinding.hw_descriptorSets[frameIndex], setBinding.updateTemplate, packedDescriptors );
 			}
 		}
 	}
 
+	void UpdateTechniqueDescriptorSets( const FG::FrameGraph* frameGraph, const std::array< GpuInputData, SIMULTANEOUS_FRAMES>& inputBuffers, const R_HW::GfxImage& dummyImage )
+	{
+		PROFILE_FUNCTION();
+		R_HW::BatchDescriptorsUpdater batchDescriptorsUpdater;
+		//TODO: not all of them need one for each simultaneous frames
+		for( uint32_t frameIndex = 0; frameIndex < g_gfx.framesInFlight; ++frameIndex )
+			UpdateChangedFrameDescriptors( frameGraph, inputBuffers[frameIndex], frameIndex, dummyImage, &batchDescriptorsUpdater );
+		batchDescriptorsUpdater.Submit();
+	}
+
+	void UpdateTechniqueDescriptorSets( const FG::FrameGraph* frameGraph, const GpuInputData& inputData, uint32_t frameIndex )
+	{
+		R_HW::BatchDescriptorsUpdater batchDescriptorsUpdater;
+		UpdateChangedFrameDescriptors( frameGraph, inputData, frameIndex, frameGraph->dummyImage, &batchDescriptorsUpdater );
+		batchDescriptorsUpdater.Submit();
+	}
+
 	R_HW::GfxImage CreateDummyImage()
 	{
 		R_HW::GfxImage image = {};
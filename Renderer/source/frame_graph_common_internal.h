@@ -3,6 +3,7 @@
 #include <vector>
 #include <array>
 #include "gfx_image.h"
+#include "frame_graph_compiler.h"
 
 namespace FG
 {
@@ -25,6 +26,7 @@ namespace FG
 		uint32_t _buffers_count;
 
 		FrameGraphCreationData creationData;
+		CompiledGraph compiledGraph;
 
 		const R_HW::GfxImage* GetImageFromId( user_id_t user_id ) const
 		{
@@ -58,8 +60,14 @@ namespace FG
 		std::array<R_HW::RenderPass, 8> _render_passes;
 		uint32_t _render_passes_count = 0;
 
+		//Presented image, see FrameGraph::SetSwapchainImages. The passes writing it have one framebuffer per swapchain image
+		fg_handle_t _swapchainImage_h = INVALID_FG_HANDLE;
+		std::vector<R_HW::GfxImage> _swapchainImages;
+		std::array<std::vector<R_HW::FrameBuffer>, 8> _swapchainFrameBuffers;
+
 		std::array<Technique, 8> _techniques;
 		uint32_t _techniques_count = 0;
+		R_HW::GfxDescriptorPool _descriptorPool = VK_NULL_HANDLE;
 
 		const R_HW::RenderPass* GetRenderPass( uint32_t id ) const
 		{
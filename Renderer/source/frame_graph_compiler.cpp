@@ -0,0 +1,590 @@
+#include "frame_graph_compiler.h"
+
+#include "cpu_profiler.h"
+
+#include <set>
+#include <algorithm>
+#include <cassert>
+
+namespace FG
+{
+	static R_HW::AttachementDescription CreateRTCommon( R_HW::GfxFormat format, R_HW::GfxLayout optimalLayout, R_HW::GfxAccess access )
+	{
+		R_HW::AttachementDescription description;
+		description.format = format;
+		description.access = access;
+		description.layout = optimalLayout;
+		description.finalAccess = access; //TODO: Just like old Access, this isn't great, We never set this to write, only read.
+		description.finalLayout = optimalLayout;
+		description.loadOp = R_HW::GfxLoadOp::DONT_CARE;
+		description.oldAccess = R_HW::GfxAccess::WRITE;//TODO: old access isn't changed anywhere if old access is read we are boned
+		description.oldLayout = R_HW::GfxLayout::UNDEFINED;
+
+		return description;
+	}
+
+	static R_HW::AttachementDescription RenderColor( R_HW::GfxFormat format )
+	{
+		return CreateRTCommon( format, R_HW::GfxLayout::COLOR, R_HW::GfxAccess::WRITE );
+	}
+
+	static R_HW::AttachementDescription RenderDepth( R_HW::GfxFormat format )
+	{
+		return CreateRTCommon( format, R_HW::GfxLayout::DEPTH_STENCIL, R_HW::GfxAccess::WRITE );
+	}
+
+	static R_HW::AttachementDescription ReadRenderTargetDepth( R_HW::GfxFormat format )
+	{
+		return CreateRTCommon( format, R_HW::GfxLayout::DEPTH_STENCIL, R_HW::GfxAccess::READ );
+	}
+
+	static void ClearTarget( R_HW::AttachementDescription* attachementDesc )
+	{
+		attachementDesc->loadOp = R_HW::GfxLoadOp::CLEAR;
+	}
+
+	static constexpr uint32_t INVALID_ATTACHMENT_INDEX = ~0u;
+
+	static uint32_t FindResourceIndex( const RenderPassCreationData& pass, fg_handle_t render_target_handle )
+	{
+		for( uint32_t i = 0; i < pass.attachmentCount; ++i )
+		{
+			if( pass.fgHandleAttachement[i] == render_target_handle )
+				return i;
+		}
+
+		return INVALID_ATTACHMENT_INDEX;
+	}
+
+	static bool IsRead( const RenderTargetRef& rtRef )
+	{
+		return rtRef.flags & FG_RENDERTARGET_REF_READ_BIT;
+	}
+
+	static std::string PassName( const RenderPassCreationData& pass, uint32_t passIndex )
+	{
+		return pass.name ? std::string( pass.name ) : "pass " + std::to_string( passIndex );
+	}
+
+	static void AddDependency( std::vector<std::vector<uint32_t>>* dependencies, uint32_t before, uint32_t after )
+	{
+		std::vector<uint32_t>& passDependencies = ( *dependencies )[after];
+		if( before != after && std::find( passDependencies.begin(), passDependencies.end(), before ) == passDependencies.end() )
+			passDependencies.push_back( before );
+	}
+
+	struct BufferAccess
+	{
+		fg_handle_t resourceHandle;
+		bool write;
+		R_HW::GfxPipelineStageFlag stages;
+		R_HW::GfxMemoryAccessFlags access;
+	};
+
+	static R_HW::GfxPipelineStageFlag ToPipelineStages( const FrameGraphNode& node, R_HW::GfxShaderStageFlags shaderStages )
+	{
+		if( node.isCompute )
+			return R_HW::GFX_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		R_HW::GfxPipelineStageFlag stages = 0;
+		if( shaderStages & R_HW::GFX_SHADER_STAGE_VERTEX_BIT )
+			stages |= R_HW::GFX_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+		if( shaderStages & R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT )
+			stages |= R_HW::GFX_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		return stages != 0 ? stages : R_HW::GFX_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+	}
+
+	//Buffers bound in descriptors or read as indirect arguments, images are tracked through the render target refs
+	static void GetBufferAccesses( const FrameGraphNode& node, const std::vector<DataEntry>& resources, std::vector<BufferAccess>* o_accesses )
+	{
+		o_accesses->clear();
+		for( const DescriptorTableDesc& descriptorSet : node.descriptorSets )
+		{
+			for( const DataBinding& dataBinding : descriptorSet.dataBindings )
+			{
+				const fg_handle_t resource_h = dataBinding.resourceHandle;
+				if( resource_h >= resources.size() || !R_HW::IsBufferType( resources[resource_h].descriptorType ) )
+					continue;
+
+				BufferAccess access;
+				access.resourceHandle = resource_h;
+				access.write = dataBinding.desc.descriptorAccess == R_HW::eDescriptorAccess::WRITE;
+				access.stages = ToPipelineStages( node, dataBinding.desc.stageFlags );
+				if( access.write )
+					access.access = R_HW::GFX_ACCESS_SHADER_READ_BIT | R_HW::GFX_ACCESS_SHADER_WRITE_BIT;
+				else if( resources[resource_h].descriptorType == R_HW::eDescriptorType::BUFFER_STORAGE )
+					access.access = R_HW::GFX_ACCESS_SHADER_READ_BIT;
+				else
+					access.access = R_HW::GFX_ACCESS_UNIFORM_READ_BIT;
+				o_accesses->push_back( access );
+			}
+		}
+
+		for( fg_handle_t resource_h : node.indirectBufferRefs )
+			o_accesses->push_back( { resource_h, false, R_HW::GFX_PIPELINE_STAGE_DRAW_INDIRECT_BIT, R_HW::GFX_ACCESS_INDIRECT_COMMAND_READ_BIT } );
+	}
+
+	static void AddAccessDependencies( uint32_t passIndex, fg_handle_t resource_h, bool write, std::vector<uint32_t>* lastWriter, std::vector<std::vector<uint32_t>>* readersSinceWrite, std::vector<std::vector<uint32_t>>* dependencies )
+	{
+		if( ( *lastWriter )[resource_h] != INVALID_PASS_INDEX )
+			AddDependency( dependencies, ( *lastWriter )[resource_h], passIndex );
+
+		if( !write )
+		{
+			( *readersSinceWrite )[resource_h].push_back( passIndex );
+			return;
+		}
+
+		for( uint32_t reader : ( *readersSinceWrite )[resource_h] )
+			AddDependency( dependencies, reader, passIndex );
+		( *readersSinceWrite )[resource_h].clear();
+		( *lastWriter )[resource_h] = passIndex;
+	}
+
+	//Edges follow the declaration order of the accesses: read after write, write after read and write after write
+	static bool BuildDependencies( const std::vector<RenderPassCreationData>& renderPasses, const std::vector<DataEntry>& resources, CompiledGraph* o_compiledGraph, std::string* o_error )
+	{
+		constexpr uint32_t NO_WRITER = INVALID_PASS_INDEX;
+		std::vector<uint32_t> lastWriter( resources.size(), NO_WRITER );
+		std::vector<std::vector<uint32_t>> readersSinceWrite( resources.size() );
+		//Buffers can be read without a writer, their content comes from the CPU
+		std::vector<uint32_t> bufferLastWriter( resources.size(), NO_WRITER );
+		std::vector<std::vector<uint32_t>> bufferReadersSinceWrite( resources.size() );
+		std::vector<BufferAccess> bufferAccesses;
+
+		o_compiledGraph->passDependencies.assign( renderPasses.size(), {} );
+		for( uint32_t passIndex = 0; passIndex < renderPasses.size(); ++passIndex )
+		{
+			const RenderPassCreationData& pass = renderPasses[passIndex];
+			for( const RenderTargetRef& rtRef : pass.frame_graph_node.renderTargetRefs )
+			{
+				const fg_handle_t resource_h = rtRef.resourceHandle;
+				if( resource_h >= resources.size() )
+				{
+					*o_error = PassName( pass, passIndex ) + " references unknown resource " + std::to_string( resource_h );
+					return false;
+				}
+
+				if( IsRead( rtRef ) && lastWriter[resource_h] == NO_WRITER )
+				{
+					*o_error = PassName( pass, passIndex ) + " reads resource " + std::to_string( resource_h ) + " before any pass writes it";
+					return false;
+				}
+				AddAccessDependencies( passIndex, resource_h, !IsRead( rtRef ), &lastWriter, &readersSinceWrite, &o_compiledGraph->passDependencies );
+			}
+
+			for( const DescriptorTableDesc& descriptorSet : pass.frame_graph_node.descriptorSets )
+			{
+				for( const DataBinding& dataBinding : descriptorSet.dataBindings )
+				{
+					if( dataBinding.resourceHandle >= resources.size() )
+					{
+						*o_error = PassName( pass, passIndex ) + " binds unknown resource " + std::to_string( dataBinding.resourceHandle );
+						return false;
+					}
+				}
+			}
+
+			for( fg_handle_t resource_h : pass.frame_graph_node.indirectBufferRefs )
+			{
+				if( resource_h >= resources.size() || resources[resource_h].descriptorType != R_HW::eDescriptorType::BUFFER_STORAGE )
+				{
+					*o_error = PassName( pass, passIndex ) + " reads indirect arguments from " + std::to_string( resource_h ) + " which isn't a storage buffer";
+					return false;
+				}
+			}
+
+			GetBufferAccesses( pass.frame_graph_node, resources, &bufferAccesses );
+			for( const BufferAccess& access : bufferAccesses )
+				AddAccessDependencies( passIndex, access.resourceHandle, access.write, &bufferLastWriter, &bufferReadersSinceWrite, &o_compiledGraph->passDependencies );
+		}
+
+		for( uint32_t i = 0; i < resources.size(); ++i )
+		{
+			if( resources[i].descriptorType != R_HW::eDescriptorType::IMAGE && resources[i].descriptorType != R_HW::eDescriptorType::IMAGE_SAMPLER && lastWriter[i] != NO_WRITER )
+			{
+				*o_error = "Resource " + std::to_string( i ) + " is used as a render target but isn't an image";
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//Kahn's algorithm, ties are broken with the declaration order so a well ordered graph keeps its order
+	static bool SortPasses( const CompiledGraph& compiledGraph, std::vector<uint32_t>* o_order, std::string* o_error )
+	{
+		const uint32_t passCount = static_cast< uint32_t >( compiledGraph.passDependencies.size() );
+		std::vector<uint32_t> remainingDependencies( passCount );
+		std::vector<std::vector<uint32_t>> dependents( passCount );
+		for( uint32_t passIndex = 0; passIndex < passCount; ++passIndex )
+		{
+			remainingDependencies[passIndex] = static_cast< uint32_t >( compiledGraph.passDependencies[passIndex].size() );
+			for( uint32_t dependency : compiledGraph.passDependencies[passIndex] )
+				dependents[dependency].push_back( passIndex );
+		}
+
+		std::set<uint32_t> ready;
+		for( uint32_t passIndex = 0; passIndex < passCount; ++passIndex )
+			if( remainingDependencies[passIndex] == 0 )
+				ready.insert( passIndex );
+
+		o_order->clear();
+		o_order->reserve( passCount );
+		while( !ready.empty() )
+		{
+			const uint32_t passIndex = *ready.begin();
+			ready.erase( ready.begin() );
+			o_order->push_back( passIndex );
+
+			for( uint32_t dependent : dependents[passIndex] )
+				if( --remainingDependencies[dependent] == 0 )
+					ready.insert( dependent );
+		}
+
+		if( o_order->size() != passCount )
+		{
+			*o_error = "The frame graph contains a dependency cycle";
+			return false;
+		}
+		return true;
+	}
+
+	//A pass is kept if it writes an external resource or something a kept pass consumes later.
+	//Writing into a resource that was already written loads it, so it also consumes it.
+	static void CullPasses( const std::vector<RenderPassCreationData>& renderPasses, const std::vector<DataEntry>& resources, const std::vector<uint32_t>& order, std::vector<bool>* o_culled )
+	{
+		std::vector<BufferAccess> bufferAccesses;
+		std::vector<bool> neededLater( resources.size(), false );
+		for( uint32_t i = 0; i < resources.size(); ++i )
+			neededLater[i] = resources[i].flags & eDataEntryFlags::EXTERNAL;
+
+		o_culled->assign( renderPasses.size(), false );
+		for( auto it = order.rbegin(); it != order.rend(); ++it )
+		{
+			const FrameGraphNode& node = renderPasses[*it].frame_graph_node;
+
+			bool hasWrite = false;
+			bool isNeeded = false;
+			for( const RenderTargetRef& rtRef : node.renderTargetRefs )
+			{
+				if( !IsRead( rtRef ) )
+				{
+					hasWrite = true;
+					isNeeded |= neededLater[rtRef.resourceHandle];
+				}
+			}
+			GetBufferAccesses( node, resources, &bufferAccesses );
+			for( const BufferAccess& access : bufferAccesses )
+			{
+				if( access.write )
+				{
+					hasWrite = true;
+					isNeeded |= neededLater[access.resourceHandle];
+				}
+			}
+
+			//Passes without outputs are kept, we can't know what they do
+			if( hasWrite && !isNeeded )
+			{
+				( *o_culled )[*it] = true;
+				continue;
+			}
+
+			for( const RenderTargetRef& rtRef : node.renderTargetRefs )
+				neededLater[rtRef.resourceHandle] = true;
+			for( const BufferAccess& access : bufferAccesses )
+				neededLater[access.resourceHandle] = true;
+		}
+	}
+
+	static void ComposeAttachments( std::vector<RenderPassCreationData>* renderPasses, const std::vector<DataEntry>& resources, const std::vector<uint32_t>& order )
+	{
+		std::vector<uint32_t> lastWriter( resources.size(), INVALID_PASS_INDEX );
+		std::vector<bool> readSinceWrite( resources.size(), false );
+
+		for( uint32_t passIndex : order )
+			( *renderPasses )[passIndex].attachmentCount = 0;
+
+		for( uint32_t passIndex : order )
+		{
+			RenderPassCreationData& pass = ( *renderPasses )[passIndex];
+
+			for( const RenderTargetRef& rtRef : pass.frame_graph_node.renderTargetRefs )
+			{
+				const fg_handle_t resource_h = rtRef.resourceHandle;
+				const R_HW::GfxFormat format = resources[resource_h].resourceDesc.format;
+
+				if( IsRead( rtRef ) )
+				{
+					// read resources -	Change the final layout of the last write to be used as shader resource or depth read
+					RenderPassCreationData& lastPassWithResource = ( *renderPasses )[lastWriter[resource_h]];
+					const uint32_t otherPassReferenceIndex = FindResourceIndex( lastPassWithResource, resource_h );
+					assert( otherPassReferenceIndex != INVALID_ATTACHMENT_INDEX );
+					lastPassWithResource.descriptions[otherPassReferenceIndex].finalLayout = R_HW::GfxLayout::COLOR;
+					lastPassWithResource.descriptions[otherPassReferenceIndex].finalAccess = R_HW::GfxAccess::READ;
+					readSinceWrite[resource_h] = true;
+					continue;
+				}
+
+				assert( pass.attachmentCount < MAX_ATTACHMENTS_COUNT );
+
+				const uint32_t attachement_index = pass.attachmentCount++;
+				pass.fgHandleAttachement[attachement_index] = resource_h;
+				R_HW::AttachementDescription& description = pass.descriptions[attachement_index];
+
+				if( resources[resource_h].resourceDesc.usage_flags & R_HW::DEPTH_STENCIL_ATTACHMENT )
+				{
+					if( rtRef.flags & FG_RENDERTARGET_REF_DEPTH_READ )
+						description = ReadRenderTargetDepth( format );
+					else
+						description = RenderDepth( format );
+				}
+				else
+					description = RenderColor( format );
+
+				if( rtRef.flags & FG_RENDERTARGET_REF_CLEAR_BIT )
+					ClearTarget( &description );
+
+				if( lastWriter[resource_h] != INVALID_PASS_INDEX )
+				{
+					RenderPassCreationData& lastPassWithResource = ( *renderPasses )[lastWriter[resource_h]];
+					R_HW::AttachementDescription& lastAttachementDesc = lastPassWithResource.descriptions[FindResourceIndex( lastPassWithResource, resource_h )];
+					if( readSinceWrite[resource_h] )
+					{
+						//Someone sampled it in between, the last pass stays in the read layout and this pass transitions out of it
+						description.oldLayout = lastAttachementDesc.finalLayout;
+						description.oldAccess = lastAttachementDesc.finalAccess;
+					}
+					else
+					{
+						//The last pass will have to transition into this pass' layout
+						lastAttachementDesc.finalLayout = description.layout;
+						if( rtRef.flags & FG_RENDERTARGET_REF_DEPTH_READ )
+						{
+							lastAttachementDesc.finalAccess = R_HW::GfxAccess::READ;
+							description.oldAccess = R_HW::GfxAccess::READ;
+						}
+
+						//This pass'initial layout should be the same as the layout since the line above will transition it
+						description.oldLayout = description.layout;
+					}
+
+					//If another pass wrote into this, we shouldn't discard the data
+					description.loadOp = R_HW::GfxLoadOp::LOAD;//TODO: Maybe we shouldn't load if we specified a CLEAR
+				}
+
+				lastWriter[resource_h] = passIndex;
+				readSinceWrite[resource_h] = false;
+			}
+		}
+	}
+
+	static void UpdateLifetime( ResourceLifetime* lifetime, uint32_t position )
+	{
+		if( lifetime->firstUse == INVALID_PASS_INDEX )
+			lifetime->firstUse = position;
+		lifetime->lastUse = position;
+	}
+
+	static void ComputeLifetimesAndBarriers( const std::vector<RenderPassCreationData>& renderPasses, const std::vector<DataEntry>& resources, CompiledGraph* o_compiledGraph )
+	{
+		o_compiledGraph->lifetimes.assign( resources.size(), {} );
+		o_compiledGraph->barriers.clear();
+		o_compiledGraph->bufferBarriers.clear();
+
+		std::vector<uint32_t> lastWriter( resources.size(), INVALID_PASS_INDEX );
+		std::vector<bool> transitionedToRead( resources.size(), false );
+
+		std::vector<BufferAccess> bufferAccesses;
+		std::vector<uint32_t> bufferLastWriter( resources.size(), INVALID_PASS_INDEX );
+		std::vector<R_HW::GfxPipelineStageFlag> bufferWriterStages( resources.size(), 0 );
+		std::vector<std::vector<BufferAccess>> bufferReadsSinceWrite( resources.size() );
+		std::vector<std::vector<uint32_t>> bufferReadersSinceWrite( resources.size() );
+
+		for( uint32_t position = 0; position < o_compiledGraph->passOrder.size(); ++position )
+		{
+			const uint32_t passIndex = o_compiledGraph->passOrder[position];
+			const RenderPassCreationData& pass = renderPasses[passIndex];
+
+			for( const DescriptorTableDesc& descriptorSet : pass.frame_graph_node.descriptorSets )
+				for( const DataBinding& dataBinding : descriptorSet.dataBindings )
+					UpdateLifetime( &o_compiledGraph->lifetimes[dataBinding.resourceHandle], position );
+
+			GetBufferAccesses( pass.frame_graph_node, resources, &bufferAccesses );
+			for( const BufferAccess& access : bufferAccesses )
+			{
+				const fg_handle_t resource_h = access.resourceHandle;
+				UpdateLifetime( &o_compiledGraph->lifetimes[resource_h], position );
+
+				const uint32_t srcPass = bufferLastWriter[resource_h];
+				if( srcPass != INVALID_PASS_INDEX && srcPass != passIndex )
+					o_compiledGraph->bufferBarriers.push_back( { resource_h, srcPass, passIndex, bufferWriterStages[resource_h], R_HW::GFX_ACCESS_SHADER_WRITE_BIT, access.stages, access.access } );
+
+				if( !access.write )
+				{
+					bufferReadsSinceWrite[resource_h].push_back( access );
+					bufferReadersSinceWrite[resource_h].push_back( passIndex );
+					continue;
+				}
+
+				//Write after read only needs the readers to be done
+				for( uint32_t i = 0; i < bufferReadersSinceWrite[resource_h].size(); ++i )
+				{
+					const uint32_t reader = bufferReadersSinceWrite[resource_h][i];
+					if( reader != passIndex )
+						o_compiledGraph->bufferBarriers.push_back( { resource_h, reader, passIndex, bufferReadsSinceWrite[resource_h][i].stages, 0, access.stages, access.access } );
+				}
+				bufferReadsSinceWrite[resource_h].clear();
+				bufferReadersSinceWrite[resource_h].clear();
+				bufferLastWriter[resource_h] = passIndex;
+				bufferWriterStages[resource_h] = access.stages;
+			}
+
+			for( const RenderTargetRef& rtRef : pass.frame_graph_node.renderTargetRefs )
+			{
+				const fg_handle_t resource_h = rtRef.resourceHandle;
+				UpdateLifetime( &o_compiledGraph->lifetimes[resource_h], position );
+
+				const uint32_t srcPass = lastWriter[resource_h];
+				if( IsRead( rtRef ) )
+				{
+					if( srcPass != INVALID_PASS_INDEX && !transitionedToRead[resource_h] )
+					{
+						const R_HW::AttachementDescription& src = renderPasses[srcPass].descriptions[FindResourceIndex( renderPasses[srcPass], resource_h )];
+						o_compiledGraph->barriers.push_back( { resource_h, srcPass, passIndex, src.layout, src.access, src.finalLayout, src.finalAccess } );
+						transitionedToRead[resource_h] = true;
+					}
+					continue;
+				}
+
+				const R_HW::AttachementDescription& dst = pass.descriptions[FindResourceIndex( pass, resource_h )];
+				if( srcPass != INVALID_PASS_INDEX && !transitionedToRead[resource_h] )
+				{
+					const R_HW::AttachementDescription& src = renderPasses[srcPass].descriptions[FindResourceIndex( renderPasses[srcPass], resource_h )];
+					if( src.layout != dst.layout || src.access != dst.access )
+						o_compiledGraph->barriers.push_back( { resource_h, srcPass, passIndex, src.layout, src.access, dst.layout, dst.access } );
+				}
+				else if( srcPass != INVALID_PASS_INDEX )
+				{
+					o_compiledGraph->barriers.push_back( { resource_h, srcPass, passIndex, dst.oldLayout, dst.oldAccess, dst.layout, dst.access } );
+				}
+
+				lastWriter[resource_h] = passIndex;
+				transitionedToRead[resource_h] = false;
+			}
+		}
+	}
+
+	bool FrameGraphCompiler::Compile( std::vector<RenderPassCreationData>* renderPasses, const std::vector<DataEntry>& resources, CompiledGraph* o_compiledGraph, std::string* o_error )
+	{
+		PROFILE_ZONE( "FG::Compile" );
+
+		if( !BuildDependencies( *renderPasses, resources, o_compiledGraph, o_error ) )
+			return false;
+
+		std::vector<uint32_t> order;
+		if( !SortPasses( *o_compiledGraph, &order, o_error ) )
+			return false;
+
+		if( cullUnusedPasses )
+			CullPasses( *renderPasses, resources, order, &o_compiledGraph->culledPasses );
+		else
+			o_compiledGraph->culledPasses.assign( renderPasses->size(), false );
+
+		//Culled passes still get valid attachments, their render pass objects are created anyway
+		ComposeAttachments( renderPasses, resources, order );
+
+		o_compiledGraph->passOrder.clear();
+		for( uint32_t passIndex : order )
+			if( !o_compiledGraph->culledPasses[passIndex] )
+				o_compiledGraph->passOrder.push_back( passIndex );
+
+		ComputeLifetimesAndBarriers( *renderPasses, resources, o_compiledGraph );
+
+		return true;
+	}
+
+	struct ResourceState
+	{
+		bool written = false;
+		R_HW::GfxLayout layout;
+		R_HW::GfxAccess access;
+	};
+
+	bool ValidateCompiledGraph( const std::vector<RenderPassCreationData>& renderPasses, const std::vector<DataEntry>& resources, const CompiledGraph& compiledGraph, std::string* o_error )
+	{
+		std::vector<uint32_t> positions( renderPasses.size(), INVALID_PASS_INDEX );
+		for( uint32_t position = 0; position < compiledGraph.passOrder.size(); ++position )
+		{
+			const uint32_t passIndex = compiledGraph.passOrder[position];
+			if( passIndex >= renderPasses.size() || compiledGraph.culledPasses[passIndex] || positions[passIndex] != INVALID_PASS_INDEX )
+			{
+				*o_error = "Invalid pass " + std::to_string( passIndex ) + " in the execution order";
+				return false;
+			}
+			positions[passIndex] = position;
+		}
+
+		std::vector<ResourceState> states( resources.size() );
+		for( uint32_t position = 0; position < compiledGraph.passOrder.size(); ++position )
+		{
+			const uint32_t passIndex = compiledGraph.passOrder[position];
+			const RenderPassCreationData& pass = renderPasses[passIndex];
+
+			for( uint32_t dependency : compiledGraph.passDependencies[passIndex] )
+			{
+				if( !compiledGraph.culledPasses[dependency] && positions[dependency] > position )
+				{
+					*o_error = PassName( pass, passIndex ) + " runs before " + PassName( renderPasses[dependency], dependency ) + " which it depends on";
+					return false;
+				}
+			}
+
+			for( const RenderTargetRef& rtRef : pass.frame_graph_node.renderTargetRefs )
+			{
+				const ResourceState& state = states[rtRef.resourceHandle];
+				if( IsRead( rtRef ) && ( !state.written || state.access != R_HW::GfxAccess::READ ) )
+				{
+					*o_error = PassName( pass, passIndex ) + " reads resource " + std::to_string( rtRef.resourceHandle ) + " that wasn't transitioned to a read state";
+					return false;
+				}
+			}
+
+			for( uint32_t i = 0; i < pass.attachmentCount; ++i )
+			{
+				const fg_handle_t resource_h = pass.fgHandleAttachement[i];
+				const R_HW::AttachementDescription& description = pass.descriptions[i];
+				ResourceState& state = states[resource_h];
+				if( state.written )
+				{
+					if( description.oldLayout != state.layout )
+					{
+						*o_error = PassName( pass, passIndex ) + " expects resource " + std::to_string( resource_h ) + " in a different layout than the one it was left in";
+						return false;
+					}
+					if( description.loadOp == R_HW::GfxLoadOp::DONT_CARE )
+					{
+						*o_error = PassName( pass, passIndex ) + " discards the content of resource " + std::to_string( resource_h ) + " written by a previous pass";
+						return false;
+					}
+				}
+
+				state.written = true;
+				state.layout = description.finalLayout;
+				state.access = description.finalAccess;
+			}
+		}
+
+		for( const PlannedBufferBarrier& barrier : compiledGraph.bufferBarriers )
+		{
+			if( positions[barrier.srcPass] == INVALID_PASS_INDEX || positions[barrier.dstPass] == INVALID_PASS_INDEX || positions[barrier.srcPass] >= positions[barrier.dstPass] )
+			{
+				*o_error = "Barrier on buffer " + std::to_string( barrier.resourceHandle ) + " doesn't go from an earlier pass to a later one";
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,160 @@
+#include "frustum.h"
+
+#include <glm/geometric.hpp>
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+
+void ExtractFrustumPlanes( const glm::mat4& viewProj, glm::vec4 o_planes[FRUSTUM_PLANES_COUNT] )
+{
+	//glm is column major, rows of the matrix are gathered by hand
+	glm::vec4 rows[4];
+	for( uint32_t i = 0; i < 4; ++i )
+		rows[i] = glm::vec4( viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i] );
+
+	o_planes[0] = rows[3] + rows[0];
+	o_planes[1] = rows[3] - rows[0];
+	o_planes[2] = rows[3] + rows[1];
+	o_planes[3] = rows[3] - rows[1];
+	o_planes[4] = rows[2];
+	o_planes[5] = rows[3] - rows[2];
+
+	for( uint32_t i = 0; i < FRUSTUM_PLANES_COUNT; ++i )
+		o_planes[i] /= glm::length( glm::vec3( o_planes[i] ) );
+}
+
+bool IsSphereInFrustum( const glm::vec4 planes[FRUSTUM_PLANES_COUNT], const glm::vec3& center, float radius )
+{
+	for( uint32_t i = 0; i < FRUSTUM_PLANES_COUNT; ++i )
+	{
+		if( glm::dot( glm::vec3( planes[i] ), center ) + planes[i].w < -radius )
+			return false;
+	}
+	return true;
+}
+
+void BoundingSpheresSoA::Resize( size_t count )
+{
+	centerX.resize( count );
+	centerY.resize( count );
+	centerZ.resize( count );
+	radius.resize( count );
+}
+
+void CullSpheres( const glm::vec4 planes[FRUSTUM_PLANES_COUNT], const BoundingSpheresSoA& spheres, uint8_t* o_visible )
+{
+	__m128 planesX[FRUSTUM_PLANES_COUNT], planesY[FRUSTUM_PLANES_COUNT], planesZ[FRUSTUM_PLANES_COUNT], planesW[FRUSTUM_PLANES_COUNT];
+	for( uint32_t i = 0; i < FRUSTUM_PLANES_COUNT; ++i )
+	{
+		planesX[i] = _mm_set1_ps( planes[i].x );
+		planesY[i] = _mm_set1_ps( planes[i].y );
+		planesZ[i] = _mm_set1_ps( planes[i].z );
+		planesW[i] = _mm_set1_ps( planes[i].w );
+	}
+
+	const size_t count = spheres.radius.size();
+	size_t i = 0;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		const __m128 x = _mm_loadu_ps( &spheres.centerX[i] );
+		const __m128 y = _mm_loadu_ps( &spheres.centerY[i] );
+		const __m128 z = _mm_loadu_ps( &spheres.centerZ[i] );
+		const __m128 negRadius = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( &spheres.radius[i] ) );
+
+		//All bits set, and-ed with the result of every plane
+		__m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+		for( uint32_t planeIndex = 0; planeIndex < FRUSTUM_PLANES_COUNT; ++planeIndex )
+		{
+			const __m128 distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, planesX[planeIndex] ), _mm_mul_ps( y, planesY[planeIndex] ) ),
+				_mm_add_ps( _mm_mul_ps( z, planesZ[planeIndex] ), planesW[planeIndex] ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( distance, negRadius ) );
+		}
+
+		const int mask = _mm_movemask_ps( inside );
+		o_visible[i + 0] |= mask & 1;
+		o_visible[i + 1] |= ( mask >> 1 ) & 1;
+		o_visible[i + 2] |= ( mask >> 2 ) & 1;
+		o_visible[i + 3] |= ( mask >> 3 ) & 1;
+	}
+
+	for( ; i < count; ++i )
+	{
+		if( IsSphereInFrustum( planes, glm::vec3( spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i] ), spheres.radius[i] ) )
+			o_visible[i] = 1;
+	}
+}
+
+static bool IsSweptSphereInFrustum( const glm::vec4 planes[FRUSTUM_PLANES_COUNT], const glm::vec3& center, const glm::vec3& sweep, float radius )
+{
+	for( uint32_t i = 0; i < FRUSTUM_PLANES_COUNT; ++i )
+	{
+		const float startDistance = glm::dot( glm::vec3( planes[i] ), center ) + planes[i].w;
+		const float endDistance = startDistance + glm::dot( glm::vec3( planes[i] ), sweep );
+		if( std::max( startDistance, endDistance ) < -radius )
+			return false;
+	}
+	return true;
+}
+
+void CullSweptSpheres( const glm::vec4 planes[FRUSTUM_PLANES_COUNT], const glm::vec3& lightPosition, float sweepLength, const BoundingSpheresSoA& spheres, uint8_t* o_visible )
+{
+	__m128 planesX[FRUSTUM_PLANES_COUNT], planesY[FRUSTUM_PLANES_COUNT], planesZ[FRUSTUM_PLANES_COUNT], planesW[FRUSTUM_PLANES_COUNT];
+	for( uint32_t i = 0; i < FRUSTUM_PLANES_COUNT; ++i )
+	{
+		planesX[i] = _mm_set1_ps( planes[i].x );
+		planesY[i] = _mm_set1_ps( planes[i].y );
+		planesZ[i] = _mm_set1_ps( planes[i].z );
+		planesW[i] = _mm_set1_ps( planes[i].w );
+	}
+	const __m128 lightX = _mm_set1_ps( lightPosition.x );
+	const __m128 lightY = _mm_set1_ps( lightPosition.y );
+	const __m128 lightZ = _mm_set1_ps( lightPosition.z );
+	const __m128 length = _mm_set1_ps( sweepLength );
+	const __m128 minLengthSquared = _mm_set1_ps( 1e-12f );
+
+	const size_t count = spheres.radius.size();
+	size_t i = 0;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		const __m128 x = _mm_loadu_ps( &spheres.centerX[i] );
+		const __m128 y = _mm_loadu_ps( &spheres.centerY[i] );
+		const __m128 z = _mm_loadu_ps( &spheres.centerZ[i] );
+		const __m128 negRadius = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( &spheres.radius[i] ) );
+
+		//Sweep vector, from the light through the center, sweepLength long
+		__m128 sweepX = _mm_sub_ps( x, lightX );
+		__m128 sweepY = _mm_sub_ps( y, lightY );
+		__m128 sweepZ = _mm_sub_ps( z, lightZ );
+		const __m128 lengthSquared = _mm_add_ps( _mm_add_ps( _mm_mul_ps( sweepX, sweepX ), _mm_mul_ps( sweepY, sweepY ) ), _mm_mul_ps( sweepZ, sweepZ ) );
+		const __m128 scale = _mm_div_ps( length, _mm_sqrt_ps( _mm_max_ps( lengthSquared, minLengthSquared ) ) );
+		sweepX = _mm_mul_ps( sweepX, scale );
+		sweepY = _mm_mul_ps( sweepY, scale );
+		sweepZ = _mm_mul_ps( sweepZ, scale );
+
+		__m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+		for( uint32_t planeIndex = 0; planeIndex < FRUSTUM_PLANES_COUNT; ++planeIndex )
+		{
+			const __m128 startDistance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, planesX[planeIndex] ), _mm_mul_ps( y, planesY[planeIndex] ) ),
+				_mm_add_ps( _mm_mul_ps( z, planesZ[planeIndex] ), planesW[planeIndex] ) );
+			const __m128 endDistance = _mm_add_ps( startDistance, _mm_add_ps( _mm_add_ps( _mm_mul_ps( sweepX, planesX[planeIndex] ), _mm_mul_ps( sweepY, planesY[planeIndex] ) ),
+				_mm_mul_ps( sweepZ, planesZ[planeIndex] ) ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_max_ps( startDistance, endDistance ), negRadius ) );
+		}
+
+		const int mask = _mm_movemask_ps( inside );
+		o_visible[i + 0] |= mask & 1;
+		o_visible[i + 1] |= ( mask >> 1 ) & 1;
+		o_visible[i + 2] |= ( mask >> 2 ) & 1;
+		o_visible[i + 3] |= ( mask >> 3 ) & 1;
+	}
+
+	for( ; i < count; ++i )
+	{
+		const glm::vec3 center( spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i] );
+		const glm::vec3 direction = center - lightPosition;
+		const glm::vec3 sweep = direction * ( sweepLength / sqrtf( std::max( glm::dot( direction, direction ), 1e-12f ) ) );
+		if( IsSweptSphereInFrustum( planes, center, sweep, spheres.radius[i] ) )
+			o_visible[i] = 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "geometry_pool.h"
+
+#include <cassert>
+#include <stdexcept>
+
+void CreateGeometryPool( const std::vector<R_HW::VIBinding>& viBindings, uint32_t maxVertexCount, uint32_t maxIndexCount, GeometryPool* o_pool )
+{
+	*o_pool = {};
+	for( const R_HW::VIBinding& viBinding : viBindings )
+	{
+		const R_HW::VIDataType dataType = viBinding.desc.dataType;
+		assert( !o_pool->hasVertexInput[dataType] );
+		o_pool->vertexDescs[dataType] = viBinding.desc;
+		o_pool->hasVertexInput[dataType] = true;
+		const R_HW::GfxDeviceSize bufferSize = R_HW::GetBindingSize( &viBinding.desc ) * maxVertexCount;
+		R_HW::CreateCommitedGpuBuffer( bufferSize, R_HW::GFX_BUFFER_USAGE_VERTEX_BUFFER_BIT | R_HW::GFX_BUFFER_USAGE_TRANSFER_DST_BIT, R_HW::GFX_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &o_pool->vertexBuffers[dataType] );
+	}
+
+	R_HW::CreateCommitedGpuBuffer( sizeof( uint32_t ) * maxIndexCount, R_HW::GFX_BUFFER_USAGE_INDEX_BUFFER_BIT | R_HW::GFX_BUFFER_USAGE_TRANSFER_DST_BIT, R_HW::GFX_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &o_pool->indexBuffer );
+
+	o_pool->maxVertexCount = maxVertexCount;
+	o_pool->maxIndexCount = maxIndexCount;
+}
+
+void CreateInterleavedGeometryPool( const std::vector<R_HW::VIBinding>& vertexLayout, uint32_t maxVertexCount, uint32_t maxIndexCount, GeometryPool* o_pool )
+{
+	*o_pool = {};
+	for( const R_HW::VIBinding& viBinding : vertexLayout )
+	{
+		const R_HW::VIDataType dataType = viBinding.desc.dataType;
+		assert( !o_pool->hasVertexInput[dataType] );
+		o_pool->vertexDescs[dataType] = viBinding.desc;
+		o_pool->hasVertexInput[dataType] = true;
+	}
+	o_pool->vertexStride = R_HW::GetInterleavedStride( vertexLayout );
+	R_HW::CreateCommitedGpuBuffer( static_cast< R_HW::GfxDeviceSize >( o_pool->vertexStride ) * maxVertexCount, R_HW::GFX_BUFFER_USAGE_VERTEX_BUFFER_BIT | R_HW::GFX_BUFFER_USAGE_TRANSFER_DST_BIT, R_HW::GFX_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &o_pool->interleavedVertexBuffer );
+
+	R_HW::CreateCommitedGpuBuffer( sizeof( uint32_t ) * maxIndexCount, R_HW::GFX_BUFFER_USAGE_INDEX_BUFFER_BIT | R_HW::GFX_BUFFER_USAGE_TRANSFER_DST_BIT, R_HW::GFX_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &o_pool->indexBuffer );
+
+	o_pool->maxVertexCount = maxVertexCount;
+	o_pool->maxIndexCount = maxIndexCount;
+}
+
+void Destroy( GeometryPool* pool )
+{
+	for( R_HW::GpuBuffer& vertexBuffer : pool->vertexBuffers )
+	{
+		if( IsValid( vertexBuffer ) )
+			R_HW::Destroy( &vertexBuffer );
+	}
+	if( IsValid( pool->interleavedVertexBuffer ) )
+		R_HW::Destroy( &pool->interleavedVertexBuffer );
+	R_HW::Destroy( &pool->indexBuffer );
+	*pool = {};
+}
+
+bool CanPoolModel( const GeometryPool& pool, const std::vector<R_HW::VIDesc>& viDescs )
+{
+	if( pool.vertexStride != 0 )
+		return false;
+	for( const R_HW::VIDesc& viDesc : viDescs )
+	{
+		if( viDesc.dataType >= ( R_HW::VIDataType )eVIDataType::VI_DATA_TYPE_COUNT || !pool.hasVertexInput[viDesc.dataType] || !( pool.vertexDescs[viDesc.dataType] == viDesc ) )
+			return false;
+	}
+	return true;
+}
+
+GfxModel CreateGfxModel( GeometryPool* pool, const std::vector<R_HW::VIDesc>& viDescs, const std::vector<void*>& data, size_t vertexCount, const void* indicesData, size_t indiceCount, uint8_t indexTypeSize, R_HW::I_BufferAllocator* allocator )
+{
+	assert( CanPoolModel( *pool, viDescs ) );
+	if( pool->vertexCount + vertexCount > pool->maxVertexCount || pool->indexCount + indiceCount > pool->maxIndexCount )
+		throw std::runtime_error( "geometry pool is full" );
+
+	GfxModel gfxModel = {};
+	gfxModel.vertexCount = static_cast< uint32_t >( vertexCount );
+	gfxModel.indexCount = static_cast< uint32_t >( indiceCount );
+	gfxModel.vertexOffset = static_cast< int32_t >( pool->vertexCount );
+	gfxModel.firstIndex = pool->indexCount;
+	gfxModel.isPooled = true;
+
+	//Every attribute of the pool gets the same vertex range, the ones the model doesn't have are zeroed
+	std::vector<uint8_t> zeroes;
+	for( R_HW::VIDataType dataType = 0; dataType < ( R_HW::VIDataType )eVIDataType::VI_DATA_TYPE_COUNT; ++dataType )
+	{
+		if( !pool->hasVertexInput[dataType] )
+			continue;
+
+		GfxModelVertexInput* currentVI = GetVertexInput( gfxModel, static_cast< eVIDataType >( dataType ) );
+		currentVI->desc = pool->vertexDescs[dataType];
+		currentVI->buffer = pool->vertexBuffers[dataType];
+
+		const void* viData = nullptr;
+		for( size_t i = 0; i < viDescs.size(); ++i )
+		{
+			if( viDescs[i].dataType == dataType )
+				viData = data[i];
+		}
+
+		const bool hasData = viData != nullptr;
+		const R_HW::GfxDeviceSize bindingSize = R_HW::GetBindingSize( &currentVI->desc );
+		const R_HW::GfxDeviceSize size = bindingSize * vertexCount;
+		if( !hasData )
+		{
+			zeroes.assign( size, 0 );
+			viData = zeroes.data();
+		}
+		allocator->UploadData( currentVI->buffer, viData, size, bindingSize * pool->vertexCount );
+
+		if( dataType == ( R_HW::VIDataType )eVIDataType::POSITION && hasData && currentVI->desc.elementType == R_HW::eVIDataElementType::FLOAT && currentVI->desc.elementsCount == 3 )
+			ComputeBounds( reinterpret_cast< const glm::vec3* >( viData ), vertexCount, &gfxModel );
+	}
+
+	//The pool indices are 32 bits, they stay relative to the model, vertexOffset is added when drawing
+	std::vector<uint32_t> indices_32;
+	const void* poolIndices = indicesData;
+	if( indexTypeSize != sizeof( uint32_t ) )
+	{
+		assert( indexTypeSize == sizeof( uint16_t ) );
+		indices_32.resize( indiceCount );
+		for( size_t i = 0; i < indiceCount; ++i )
+			indices_32[i] = static_cast< const uint16_t* >( indicesData )[i];
+		poolIndices = indices_32.data();
+	}
+	gfxModel.indexBuffer = pool->indexBuffer;
+	gfxModel.indexType = R_HW::GfxIndexType::UINT32;
+	allocator->UploadData( pool->indexBuffer, poolIndices, sizeof( uint32_t ) * indiceCount, sizeof( uint32_t ) * pool->indexCount );
+
+	pool->vertexCount += static_cast< uint32_t >( vertexCount );
+	pool->indexCount += static_cast< uint32_t >( indiceCount );
+
+	return gfxModel;
+}
+
+GfxModel CreateInterleavedGfxModel( GeometryPool* pool, const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indiceCount, R_HW::I_BufferAllocator* allocator )
+{
+	assert( pool->vertexStride != 0 );
+	if( pool->vertexCount + vertexCount > pool->maxVertexCount || pool->indexCount + indiceCount > pool->maxIndexCount )
+		throw std::runtime_error( "geometry pool is full" );
+
+	GfxModel gfxModel = {};
+	gfxModel.vertexCount = static_cast< uint32_t >( vertexCount );
+	gfxModel.indexCount = static_cast< uint32_t >( indiceCount );
+	gfxModel.vertexOffset = static_cast< int32_t >( pool->vertexCount );
+	gfxModel.firstIndex = pool->indexCount;
+	gfxModel.isPooled = true;
+	gfxModel.vertexStride = pool->vertexStride;
+
+	for( R_HW::VIDataType dataType = 0; dataType < ( R_HW::VIDataType )eVIDataType::VI_DATA_TYPE_COUNT; ++dataType )
+	{
+		if( !pool->hasVertexInput[dataType] )
+			continue;
+		GfxModelVertexInput* currentVI = GetVertexInput( gfxModel, static_cast< eVIDataType >( dataType ) );
+		currentVI->desc = pool->vertexDescs[dataType];
+		currentVI->buffer = pool->interleavedVertexBuffer;
+	}
+	const R_HW::GfxDeviceSize stride = pool->vertexStride;
+	allocator->UploadData( pool->interleavedVertexBuffer, vertices, stride * vertexCount, stride * pool->vertexCount );
+
+	gfxModel.indexBuffer = pool->indexBuffer;
+	gfxModel.indexType = R_HW::GfxIndexType::UINT32;
+	allocator->UploadData( pool->indexBuffer, indices, sizeof( uint32_t ) * indiceCount, sizeof( uint32_t ) * pool->indexCount );
+
+	pool->vertexCount += static_cast< uint32_t >( vertexCount );
+	pool->indexCount += static_cast< uint32_t >( indiceCount );
+
+	return gfxModel;
+}
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include <cassert>
 
+//Buffer to image copies need offsets aligned on the texel size and on 4 bytes
+static const size_t stagingCopyAlignment = 16;
+
 GfxHeaps_Allocator::GfxHeaps_Allocator( R_HW::GfxHeap* heap )
 	:_heap( heap ), head( 0 )
 {
@@ -22,8 +25,7 @@ bool GfxHeaps_Allocator::Allocate( R_HW::GfxApiBuffer buffer, R_HW::GfxMemAlloc*
 
 	const R_HW::GfxDeviceSize alignment = R_HW::GetAlignment( memRequirements );
 	const R_HW::GfxDeviceSize size = R_HW::GetSize( memRequirements );
-	const size_t alignementOffset = alignment - (head % alignment);
-	const size_t memOffset = head + alignementOffset;
+	const size_t memOffset = R_HW::AlignUp( head, alignment );
 	const size_t newHead = memOffset + size;
 
 	*o_gfx_mem_alloc = suballocate_gfx_memory( _heap->gfx_mem_alloc, size, memOffset );
@@ -36,8 +38,12 @@ bool GfxHeaps_Allocator::Allocate( R_HW::GfxApiBuffer buffer, R_HW::GfxMemAlloc*
 
 bool GfxHeaps_Allocator::UploadData( const R_HW::GpuBuffer& buffer, const void* data )
 {
-	R_HW::GfxDeviceSize memorySize = buffer.gpuMemory.size;
-	UpdateGpuBuffer( &buffer, data, memorySize, 0 );
+	return UploadData( buffer, data, buffer.gpuMemory.size, 0 );
+}
+
+bool GfxHeaps_Allocator::UploadData( const R_HW::GpuBuffer& buffer, const void* data, R_HW::GfxDeviceSize size, R_HW::GfxDeviceSize offset )
+{
+	UpdateGpuBuffer( &buffer, data, size, offset );
 
 	return true;
 }
@@ -62,6 +68,7 @@ void GfxHeaps_BatchedAllocator::Prepare()
 	commandBuffer = R_HW::beginSingleTimeCommands();
 	stagingBufferAllocator = {};
 	stagingBufferAllocator.buffer = &stagingBuffer;
+	stagingBufferAllocator.alignment = stagingCopyAlignment;
 }
 
 void GfxHeaps_BatchedAllocator::Commit()
@@ -78,8 +85,7 @@ bool GfxHeaps_BatchedAllocator::Allocate( R_HW::GfxApiImage image, R_HW::GfxMemA
 
 	const R_HW::GfxDeviceSize alignment = R_HW::GetAlignment( memRequirements );
 	const R_HW::GfxDeviceSize size = R_HW::GetSize( memRequirements );
-	const size_t alignementOffset = alignment - (head % alignment);
-	const size_t memOffset = head + alignementOffset;
+	const size_t memOffset = R_HW::AlignUp( head, alignment );
 	const size_t newHead = memOffset + size;
 
 	*o_gfx_mem_alloc = suballocate_gfx_memory( _heap->gfx_mem_alloc, size, memOffset );
@@ -121,8 +127,7 @@ bool GfxHeaps_BatchedAllocator::Allocate( R_HW::GfxApiBuffer buffer, R_HW::GfxMe
 
 	const R_HW::GfxDeviceSize alignment = R_HW::GetAlignment( memRequirements );
 	const R_HW::GfxDeviceSize size = R_HW::GetSize( memRequirements );
-	const size_t alignementOffset = alignment - (head % alignment);
-	const size_t memOffset = head + alignementOffset;
+	const size_t memOffset = R_HW::AlignUp( head, alignment );
 	const size_t newHead = memOffset + size;
 
 	*o_gfx_mem_alloc = suballocate_gfx_memory( _heap->gfx_mem_alloc, size, memOffset );
@@ -135,10 +140,14 @@ bool GfxHeaps_BatchedAllocator::Allocate( R_HW::GfxApiBuffer buffer, R_HW::GfxMe
 
 bool GfxHeaps_BatchedAllocator::UploadData( const R_HW::GpuBuffer& buffer, const void* data )
 {
-	R_HW::GfxDeviceSize memorySize = buffer.gpuMemory.size;
-	R_HW::GfxDeviceSize stagingBufferOffset = AllocateGpuBufferSlot( &stagingBufferAllocator, memorySize );
-	UpdateGpuBuffer( &stagingBuffer, data, memorySize, stagingBufferOffset );
-	R_HW::copy_buffer( commandBuffer, buffer.buffer, stagingBuffer.buffer, 0, stagingBufferOffset, memorySize );
+	return UploadData( buffer, data, buffer.gpuMemory.size, 0 );
+}
+
+bool GfxHeaps_BatchedAllocator::UploadData( const R_HW::GpuBuffer& buffer, const void* data, R_HW::GfxDeviceSize size, R_HW::GfxDeviceSize offset )
+{
+	R_HW::GfxDeviceSize stagingBufferOffset = AllocateGpuBufferSlot( &stagingBufferAllocator, size );
+	UpdateGpuBuffer( &stagingBuffer, data, size, stagingBufferOffset );
+	R_HW::copy_buffer( commandBuffer, buffer.buffer, stagingBuffer.buffer, offset, stagingBufferOffset, size );
 
 	return true;
 }
@@ -150,6 +159,7 @@ void GfxHeaps_CommitedResourceAllocator::Prepare()
 	commandBuffer = R_HW::beginSingleTimeCommands();
 	stagingBufferAllocator = {};
 	stagingBufferAllocator.buffer = &stagingBuffer;
+	stagingBufferAllocator.alignment = stagingCopyAlignment;
 }
 
 void GfxHeaps_CommitedResourceAllocator::Commit()
@@ -1,10 +1,23 @@
 #include "gfx_model.h"
 
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
 #include <unordered_map>
+#include <algorithm>
+#include <cassert>
 #include <stdexcept>
+#include <cmath>
 
 void DestroyGfxModel(GfxModel& gfxModel)
 {
+	//The pool owns the buffers
+	if( gfxModel.isPooled )
+	{
+		gfxModel = {};
+		return;
+	}
+
 	for( uint8_t i = 0; i < (R_HW::VIDataType )eVIDataType::VI_DATA_TYPE_COUNT; ++i )
 	{
 		if( IsValid( gfxModel.vertAttribBuffers[i].buffer ) )
@@ -38,6 +51,32 @@ const GfxModelVertexInput* GetVertexInput( const GfxModel& gfxModel, eVIDataType
 }
 
 
+//Not the tightest sphere, centered on the bounding box
+void ComputeBounds( const glm::vec3* positions, size_t vertexCount, GfxModel* o_gfxModel )
+{
+	if( vertexCount == 0 )
+		return;
+
+	glm::vec3 min = positions[0];
+	glm::vec3 max = positions[0];
+	for( size_t i = 1; i < vertexCount; ++i )
+	{
+		min = glm::min( min, positions[i] );
+		max = glm::max( max, positions[i] );
+	}
+
+	const glm::vec3 center = ( min + max ) * 0.5f;
+	float radiusSquared = 0.0f;
+	for( size_t i = 0; i < vertexCount; ++i )
+	{
+		const glm::vec3 delta = positions[i] - center;
+		radiusSquared = glm::max( radiusSquared, glm::dot( delta, delta ) );
+	}
+
+	o_gfxModel->boundingSphereCenter = center;
+	o_gfxModel->boundingSphereRadius = sqrtf( radiusSquared );
+}
+
 GfxModel CreateGfxModel( const std::vector<R_HW::VIDesc>& viDescs, size_t vertexCount, size_t indiceCount, uint8_t indexTypeSize )
 {
 	GfxModel gfxModel = {};
@@ -74,6 +113,9 @@ GfxModel CreateGfxModel( const std::vector<R_HW::VIDesc>& viDescs, const std::ve
 		currentVI->buffer.buffer = R_HW::create_buffer( bufferSize, R_HW::GFX_BUFFER_USAGE_VERTEX_BUFFER_BIT | R_HW::GFX_BUFFER_USAGE_TRANSFER_DST_BIT );
 		allocator->Allocate( currentVI->buffer.buffer, &currentVI->buffer.gpuMemory );
 		allocator->UploadData( currentVI->buffer, data[i] );
+
+		if( viDesc.dataType == ( R_HW::VIDataType )eVIDataType::POSITION && viDesc.elementType == R_HW::eVIDataElementType::FLOAT && viDesc.elementsCount == 3 )
+			ComputeBounds( reinterpret_cast< const glm::vec3* >( data[i] ), vertexCount, &gfxModel );
 	}
 
 	R_HW::GfxDeviceSize bufferSize = indexTypeSize * indiceCount;
@@ -83,4 +125,33 @@ GfxModel CreateGfxModel( const std::vector<R_HW::VIDesc>& viDescs, const std::ve
 	gfxModel.indexType = GetIndexType( indexTypeSize );
 
 	return gfxModel;
+}
+
+void SetModelLods( const GfxModelLod* lods, uint32_t lodCount, GfxModel* o_gfxModel )
+{
+	assert( lodCount > 0 && lodCount <= MAX_MODEL_LODS );
+	std::copy( lods, lods + lodCount, o_gfxModel->lods );
+	o_gfxModel->lodCount = lodCount;
+	o_gfxModel->indexCount = lods[0].indexCount;
+}
+
+void GetModelLodRange( const GfxModel& gfxModel, uint32_t lod, uint32_t* o_firstIndex, uint32_t* o_indexCount )
+{
+	if( gfxModel.lodCount == 0 )
+	{
+		*o_firstIndex = gfxModel.firstIndex;
+		*o_indexCount = gfxModel.indexCount;
+		return;
+	}
+	assert( lod < gfxModel.lodCount );
+	*o_firstIndex = gfxModel.firstIndex + gfxModel.lods[lod].firstIndex;
+	*o_indexCount = gfxModel.lods[lod].indexCount;
+}
+
+uint32_t SelectModelLod( const GfxModel& gfxModel, float pixelsPerUnit, float maxPixelError )
+{
+	uint32_t lod = 0;
+	while( lod + 1 < gfxModel.lodCount && gfxModel.lods[lod + 1].error * pixelsPerUnit <= maxPixelError )
+		++lod;
+	return lod;
 }
\ No newline at end of file
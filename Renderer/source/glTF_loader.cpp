@@ -6,6 +6,10 @@
 #include <vector>
 
 #include "gfx_model.h"
+#include "vertex_quantization.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "cpu_profiler.h"
 
 
 namespace glTF_L
@@ -105,13 +109,17 @@ namespace glTF_L
 	{
 		std::string name;
 		std::vector<Primitive> primitives;
+		//extras
+		bool castShadows;
 	};
 
 	void from_json( const nlohmann::json& j, Mesh& m )
 	{
+		auto extras = j.find( "extras" );
 		m = {
 			j["name"].get<std::string>(),
-			j["primitives"].get<std::vector<Primitive>>()
+			j["primitives"].get<std::vector<Primitive>>(),
+			extras == j.end() ? true : GetDefaultIfNull<bool>( *extras, "castShadows", true )
 		};
 	}
 
@@ -221,12 +229,14 @@ namespace glTF_L
 	{
 		std::string name;
 		int texture_index;
+		std::vector<float> baseColorFactor;
 	};
 
 	void from_json( const nlohmann::json& j, Material& m )
 	{
 		m = { GetDefaultIfNull<std::string>( j, "name", "" ),
-			GetDefaultIfNull<int>( j["pbrMetallicRoughness"]["baseColorTexture"], "index", INVALID_INT )
+			GetDefaultIfNull<int>( j["pbrMetallicRoughness"]["baseColorTexture"], "index", INVALID_INT ),
+			GetDefaultIfNull<std::vector<float>>( j["pbrMetallicRoughness"], "baseColorFactor", { 1.0f, 1.0f, 1.0f, 1.0f } )
 		};
 	}
 
@@ -368,7 +378,7 @@ namespace glTF_L
 			bufferChunk };
 	}
 
-	static GfxModel LoadMesh( const Mesh& mesh, const std::vector<Accessor>& accessors, const std::vector<BufferView>& buffer_views, const byte* data, R_HW::I_BufferAllocator* allocator )
+	static GfxModel LoadMesh( const Mesh& mesh, const std::vector<Accessor>& accessors, const std::vector<BufferView>& buffer_views, const byte* data, R_HW::I_BufferAllocator* allocator, GeometryPool* geometryPool, bool optimizeMesh, bool generateLods, MeshOptimizationStats* io_stats )
 	{
 		assert( mesh.primitives.size() == 1 );
 
@@ -433,22 +443,66 @@ namespace glTF_L
 			indexes_32[i] = GetType<unsigned short>( indexes, i, 0, SCALAR, UNSIGNED_SHORT );
 		}
 
-		std::vector<R_HW::VIDesc> modelVIDescs = {
-			{ (R_HW::VIDataType )eVIDataType::POSITION, R_HW::eVIDataElementType::FLOAT, 3 },
-			{ (R_HW::VIDataType )eVIDataType::NORMAL, R_HW::eVIDataElementType::FLOAT, 3 },
-			{ (R_HW::VIDataType )eVIDataType::TANGENT, R_HW::eVIDataElementType::FLOAT, 3 },
-			{ (R_HW::VIDataType )eVIDataType::COLOR, R_HW::eVIDataElementType::FLOAT, 3 },
-			{ (R_HW::VIDataType )eVIDataType::TEX_COORD, R_HW::eVIDataElementType::FLOAT, 2 },
-		};
-		std::vector<void*> modelData = {
-			vertPos.data(),
-			vertNormals.data(),
-			vertTangents.data(),
-			vertColor.data(),
-			vertTexCoord.data(),
-		};
+		if( optimizeMesh )
+		{
+			const std::vector<MeshStream> streams = {
+				{ vertPos.data(), sizeof( glm::vec3 ) },
+				{ vertNormals.data(), sizeof( glm::vec3 ) },
+				{ vertTangents.data(), sizeof( glm::vec3 ) },
+				{ vertColor.data(), sizeof( glm::vec3 ) },
+				{ vertTexCoord.data(), sizeof( glm::vec2 ) },
+			};
+			const MeshOptimizationStats stats = OptimizeMesh( streams, 1, &vertexCount, &indexes_32 );
+			if( io_stats )
+				AddMeshOptimizationStats( stats, io_stats );
+		}
+
+		//The LODs indices follow the base ones in the index buffer
+		GfxModelLod lods[MAX_MODEL_LODS];
+		const uint32_t lodCount = generateLods ? GenerateMeshLods( vertPos.data(), vertexCount, &indexes_32, MAX_MODEL_LODS, lods ) : 0;
+		indexCount = indexes_32.size();
+
+		GfxModel gfxModel;
+		if( geometryPool && geometryPool->vertexStride != 0 )
+		{
+			assert( geometryPool->vertexStride == sizeof( QuantizedVertex ) );
+			glm::vec3 dequantOffset;
+			float dequantScale;
+			ComputePositionDequant( vertPos.data(), vertexCount, &dequantOffset, &dequantScale );
+			std::vector<QuantizedVertex> quantizedVertices( vertexCount );
+			QuantizeVertices( vertPos.data(), vertNormals.data(), vertTangents.data(), vertColor.data(), vertTexCoord.data(), vertexCount, dequantOffset, dequantScale, quantizedVertices.data() );
+
+			gfxModel = CreateInterleavedGfxModel( geometryPool, quantizedVertices.data(), vertexCount, indexes_32.data(), indexCount, allocator );
+			gfxModel.positionDequantOffset = dequantOffset;
+			gfxModel.positionDequantScale = dequantScale;
+			ComputeBounds( vertPos.data(), vertexCount, &gfxModel );
+		}
+		else
+		{
+			std::vector<R_HW::VIDesc> modelVIDescs = {
+				{ (R_HW::VIDataType )eVIDataType::POSITION, R_HW::eVIDataElementType::FLOAT, 3 },
+				{ (R_HW::VIDataType )eVIDataType::NORMAL, R_HW::eVIDataElementType::FLOAT, 3 },
+				{ (R_HW::VIDataType )eVIDataType::TANGENT, R_HW::eVIDataElementType::FLOAT, 3 },
+				{ (R_HW::VIDataType )eVIDataType::COLOR, R_HW::eVIDataElementType::FLOAT, 3 },
+				{ (R_HW::VIDataType )eVIDataType::TEX_COORD, R_HW::eVIDataElementType::FLOAT, 2 },
+			};
+			std::vector<void*> modelData = {
+				vertPos.data(),
+				vertNormals.data(),
+				vertTangents.data(),
+				vertColor.data(),
+				vertTexCoord.data(),
+			};
+
+			if( geometryPool && CanPoolModel( *geometryPool, modelVIDescs ) )
+				gfxModel = CreateGfxModel( geometryPool, modelVIDescs, modelData, vertexCount, indexes_32.data(), indexCount, sizeof( uint32_t ), allocator );
+			else
+				gfxModel = CreateGfxModel( modelVIDescs, modelData, vertexCount, indexes_32.data(), indexCount, sizeof( uint32_t ), allocator );
+		}
 
-		return CreateGfxModel( modelVIDescs, modelData, vertexCount, indexes_32.data(), indexCount, sizeof( uint32_t ), allocator );
+		if( lodCount > 0 )
+			SetModelLods( lods, lodCount, &gfxModel );
+		return gfxModel;
 	}
 
 	void LoadCollisionData( const char* fileName, std::vector<glm::vec3>* vertices, std::vector<uint32_t>* indices )
@@ -518,18 +572,19 @@ namespace glTF_L
 		}
 	}
 
-	void LoadMesh( const char* fileName, GfxModel* model, R_HW::I_BufferAllocator* allocator )
+	void LoadMesh( const char* fileName, GfxModel* model, R_HW::I_BufferAllocator* allocator, GeometryPool* geometryPool, bool optimizeMeshes, bool generateLods, MeshOptimizationStats* io_stats )
 	{
 		const glTF_Json gltf_json = ReadJson( fileName );
 
 		assert( gltf_json.meshes.size() == 1 );
 
-		*model = LoadMesh( gltf_json.meshes[0], gltf_json.accessors, gltf_json.bufferViews, gltf_json.data.data(), allocator );
+		*model = LoadMesh( gltf_json.meshes[0], gltf_json.accessors, gltf_json.bufferViews, gltf_json.data.data(), allocator, geometryPool, optimizeMeshes, generateLods, io_stats );
 	}
 
 	void LoadScene( const char* fileName, RegisterGfxModelCallback_t registerGfxModelCallback, RegisterGfxAssetCallback_t registerGfxAssetCallback,
-		RegisterSceneInstanceCallback_t registerSceneInstanceCallback, LoadTextureCallback_t loadTextureCallback, R_HW::I_BufferAllocator* allocator, I_ImageAlloctor* imageAllocator )
+		RegisterSceneInstanceCallback_t registerSceneInstanceCallback, LoadTextureCallback_t loadTextureCallback, RegisterMaterialCallback_t registerMaterialCallback, R_HW::I_BufferAllocator* allocator, I_ImageAlloctor* imageAllocator, GeometryPool* geometryPool, bool optimizeMeshes, bool generateLods, MeshOptimizationStats* io_stats )
 	{
+		PROFILE_ZONE( "glTF_L::LoadScene" );
 		const glTF_Json gltf_json = ReadJson( fileName );
 
 		const std::string basePath = GetGltfPath( fileName ) + "/";
@@ -543,6 +598,21 @@ namespace glTF_L
 			imageIndexes.push_back( loadTextureCallback( filePath.c_str(), imageAllocator ) );
 		}
 
+		std::vector<uint32_t> materialIndexes;
+		materialIndexes.reserve( gltf_json.materials.size() );
+		for( const Material& material : gltf_json.materials )
+		{
+			GpuMaterial gpuMaterial = {};
+			assert( material.baseColorFactor.size() == 4 );
+			gpuMaterial.baseColorFactor = glm::vec4( material.baseColorFactor[0], material.baseColorFactor[1], material.baseColorFactor[2], material.baseColorFactor[3] );
+			if( material.texture_index != INVALID_INT )
+			{
+				gpuMaterial.textureIndices[MATERIAL_TEXTURE_ALBEDO] = imageIndexes[gltf_json.textures[material.texture_index].imageIndex];
+				gpuMaterial.flags |= MATERIAL_FLAG_ALBEDO_TEXTURE;
+			}
+			materialIndexes.push_back( registerMaterialCallback( gpuMaterial ) );
+		}
+
 		//Load meshes and build assets
 		//TODO: currently 1 model == 1 asset
 		std::vector<GfxAsset*> gfxAssets;
@@ -551,14 +621,12 @@ namespace glTF_L
 		for( const Mesh& mesh : gltf_json.meshes )
 		{
 			GfxModel* gfxModel = registerGfxModelCallback( mesh.name.c_str() );
-			*gfxModel = LoadMesh( mesh, gltf_json.accessors, gltf_json.bufferViews, gltf_json.data.data(), allocator );
+			*gfxModel = LoadMesh( mesh, gltf_json.accessors, gltf_json.bufferViews, gltf_json.data.data(), allocator, geometryPool, optimizeMeshes, generateLods, io_stats );
 			GfxAsset* gfxAsset = registerGfxAssetCallback( mesh.name.c_str() );
 			gfxAsset->modelAsset = gfxModel;
+			gfxAsset->castsShadows = mesh.castShadows;
 			const int materialIndex = mesh.primitives[0].material_index;
-			const int textureIndex = gltf_json.materials[materialIndex].texture_index;
-			const int imageIndex = gltf_json.textures[textureIndex].imageIndex;
-			const uint32_t bindlesstextureIndex = imageIndexes[imageIndex];
-			gfxAsset->textureIndices.push_back( bindlesstextureIndex );
+			gfxAsset->materialIndex = materialIndexes[materialIndex];
 			gfxAssets.push_back( gfxAsset );
 		}
 
@@ -15,12 +15,13 @@ void Destroy( Technique* technique )
 {
 	R_HW::Destroy( &technique->pipeline );
 	R_HW::Destroy( &technique->pipelineLayout );
+	//The descriptor tables are freed with the pool of the frame graph
 	for( GfxDescriptorSetBinding& setBinding : technique->descriptor_sets )
 	{
-		if( setBinding.isValid )
-		{
-			R_HW::Destroy( &setBinding.hw_layout );
-			R_HW::Destroy( setBinding.hw_descriptorSets.data(), setBinding.hw_descriptorSets.size(), technique->parentDescriptorPool );
-		}
+		if( !setBinding.isValid )
+			continue;
+		R_HW::Destroy( &setBinding.hw_layout );
+		if( setBinding.updateTemplate.updateTemplate != VK_NULL_HANDLE )
+			R_HW::Destroy( &setBinding.updateTemplate );
 	}
 }
\ No newline at end of file
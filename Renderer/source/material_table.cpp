@@ -0,0 +1,71 @@
+#include "material_table.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+static_assert( sizeof( GpuMaterial ) % 16 == 0, "GpuMaterial has to match the std430 layout of Material in the shaders" );
+
+static void MarkDirty( MaterialTable* table, uint32_t index )
+{
+	if( table->dirtyBegin == table->dirtyEnd )
+	{
+		table->dirtyBegin = index;
+		table->dirtyEnd = index + 1;
+		return;
+	}
+	table->dirtyBegin = std::min( table->dirtyBegin, index );
+	table->dirtyEnd = std::max( table->dirtyEnd, index + 1 );
+}
+
+GpuMaterial CreateTexturedMaterial( uint32_t albedoTextureIndex )
+{
+	GpuMaterial material = {};
+	material.baseColorFactor = glm::vec4( 1.0f );
+	material.textureIndices[MATERIAL_TEXTURE_ALBEDO] = albedoTextureIndex;
+	material.flags = MATERIAL_FLAG_ALBEDO_TEXTURE;
+	return material;
+}
+
+void CreateMaterialTable( uint32_t maxMaterialCount, MaterialTable* o_table )
+{
+	*o_table = {};
+	R_HW::CreateCommitedGpuBuffer( sizeof( GpuMaterial ) * maxMaterialCount, R_HW::GFX_BUFFER_USAGE_STORAGE_BUFFER_BIT | R_HW::GFX_BUFFER_USAGE_TRANSFER_DST_BIT, R_HW::GFX_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &o_table->buffer );
+	o_table->materials.reserve( maxMaterialCount );
+	o_table->maxMaterialCount = maxMaterialCount;
+}
+
+void Destroy( MaterialTable* table )
+{
+	R_HW::Destroy( &table->buffer );
+	*table = {};
+}
+
+uint32_t AddMaterial( MaterialTable* table, const GpuMaterial& material )
+{
+	if( table->materials.size() >= table->maxMaterialCount )
+		throw std::runtime_error( "material table is full" );
+
+	const uint32_t index = static_cast< uint32_t >( table->materials.size() );
+	table->materials.push_back( material );
+	MarkDirty( table, index );
+	return index;
+}
+
+void SetMaterial( MaterialTable* table, uint32_t index, const GpuMaterial& material )
+{
+	assert( index < table->materials.size() );
+	table->materials[index] = material;
+	MarkDirty( table, index );
+}
+
+void UploadMaterialTable( MaterialTable* table, R_HW::I_BufferAllocator* allocator )
+{
+	if( table->dirtyBegin == table->dirtyEnd )
+		return;
+
+	const uint32_t count = table->dirtyEnd - table->dirtyBegin;
+	allocator->UploadData( table->buffer, &table->materials[table->dirtyBegin], sizeof( GpuMaterial ) * count, sizeof( GpuMaterial ) * table->dirtyBegin );
+	table->dirtyBegin = 0;
+	table->dirtyEnd = 0;
+}
\ No newline at end of file
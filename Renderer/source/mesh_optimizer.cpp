@@ -0,0 +1,372 @@
+#include "mesh_optimizer.h"
+
+#include "cpu_profiler.h"
+#include "vk_globals.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+constexpr uint32_t INVALID_INDEX = ~0u;
+
+float ComputeACMR( const uint32_t* indices, size_t indexCount, uint32_t cacheSize )
+{
+	if( indexCount < 3 )
+		return 0.0f;
+
+	std::vector<uint32_t> fifo( cacheSize, INVALID_INDEX );
+	uint32_t fifoHead = 0;
+	size_t misses = 0;
+	for( size_t i = 0; i < indexCount; ++i )
+	{
+		if( std::find( fifo.begin(), fifo.end(), indices[i] ) != fifo.end() )
+			continue;
+		fifo[fifoHead] = indices[i];
+		fifoHead = ( fifoHead + 1 ) % cacheSize;
+		++misses;
+	}
+	return static_cast< float >( misses ) / static_cast< float >( indexCount / 3 );
+}
+
+struct VertexHasher
+{
+	const std::vector<MeshStream>* streams;
+
+	size_t operator()( uint32_t vertex ) const
+	{
+		uint64_t hash = R_HW::FNV1A_OFFSET_BASIS;
+		for( const MeshStream& stream : *streams )
+			hash = R_HW::HashFnv1a( static_cast< const uint8_t* >( stream.data ) + vertex * stream.stride, stream.stride, hash );
+		return static_cast< size_t >( hash );
+	}
+};
+
+struct VertexEqual
+{
+	const std::vector<MeshStream>* streams;
+
+	bool operator()( uint32_t a, uint32_t b ) const
+	{
+		for( const MeshStream& stream : *streams )
+		{
+			const uint8_t* data = static_cast< const uint8_t* >( stream.data );
+			if( memcmp( data + a * stream.stride, data + b * stream.stride, stream.stride ) != 0 )
+				return false;
+		}
+		return true;
+	}
+};
+
+size_t DeduplicateVertices( const std::vector<MeshStream>& streams, size_t vertexCount, uint32_t* indices, size_t indexCount )
+{
+	std::unordered_map<uint32_t, uint32_t, VertexHasher, VertexEqual> uniqueVertices( vertexCount, VertexHasher{ &streams }, VertexEqual{ &streams } );
+	std::vector<uint32_t> remap( vertexCount );
+	uint32_t uniqueCount = 0;
+	for( uint32_t vertex = 0; vertex < vertexCount; ++vertex )
+	{
+		auto found = uniqueVertices.find( vertex );
+		if( found != uniqueVertices.end() )
+		{
+			remap[vertex] = found->second;
+			continue;
+		}
+
+		//Unique vertices keep their order, the new index is never after the old one so the streams can be compacted in place
+		remap[vertex] = uniqueCount;
+		if( uniqueCount != vertex )
+		{
+			for( const MeshStream& stream : streams )
+			{
+				uint8_t* data = static_cast< uint8_t* >( stream.data );
+				memcpy( data + uniqueCount * stream.stride, data + vertex * stream.stride, stream.stride );
+			}
+		}
+		//Keyed on the compacted vertex, the original one can be overwritten later
+		uniqueVertices.emplace( uniqueCount, uniqueCount );
+		++uniqueCount;
+	}
+
+	for( size_t i = 0; i < indexCount; ++i )
+		indices[i] = remap[indices[i]];
+
+	return uniqueCount;
+}
+
+static float ForsythVertexScore( int32_t cachePosition, uint32_t remainingTriangles )
+{
+	if( remainingTriangles == 0 )
+		return -1.0f;
+
+	float score = 0.0f;
+	if( cachePosition >= 0 )
+	{
+		//The last triangle's vertices get a fixed score so the next triangle doesn't always reuse its edge
+		if( cachePosition < 3 )
+			score = 0.75f;
+		else
+			score = std::pow( 1.0f - static_cast< float >( cachePosition - 3 ) / ( VERTEX_CACHE_SIZE - 3 ), 1.5f );
+	}
+	//Finish the vertices with few triangles left first
+	score += 2.0f / std::sqrt( static_cast< float >( remainingTriangles ) );
+	return score;
+}
+
+void OptimizeVertexCache( uint32_t* indices, size_t indexCount, size_t vertexCount )
+{
+	PROFILE_FUNCTION();
+	const size_t triangleCount = indexCount / 3;
+	if( triangleCount == 0 )
+		return;
+
+	//Triangles of each vertex, the first remainingTriangles[v] are the ones not emitted yet
+	std::vector<uint32_t> remainingTriangles( vertexCount, 0 );
+	for( size_t i = 0; i < indexCount; ++i )
+		++remainingTriangles[indices[i]];
+	std::vector<uint32_t> adjacencyOffsets( vertexCount + 1, 0 );
+	for( size_t v = 0; v < vertexCount; ++v )
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+	std::vector<uint32_t> adjacency( indexCount );
+	std::vector<uint32_t> fillOffsets( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+	for( uint32_t t = 0; t < triangleCount; ++t )
+	{
+		for( uint32_t k = 0; k < 3; ++k )
+			adjacency[fillOffsets[indices[t * 3 + k]]++] = t;
+	}
+
+	std::vector<int32_t> cachePositions( vertexCount, -1 );
+	std::vector<float> vertexScores( vertexCount );
+	for( size_t v = 0; v < vertexCount; ++v )
+		vertexScores[v] = ForsythVertexScore( -1, remainingTriangles[v] );
+
+	std::vector<float> triangleScores( triangleCount );
+	uint32_t bestTriangle = 0;
+	for( uint32_t t = 0; t < triangleCount; ++t )
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if( triangleScores[t] > triangleScores[bestTriangle] )
+			bestTriangle = t;
+	}
+
+	std::vector<bool> emitted( triangleCount, false );
+	std::vector<uint32_t> output;
+	output.reserve( indexCount );
+
+	//The 3 extra entries hold the vertices pushed out by the last triangle
+	uint32_t cache[VERTEX_CACHE_SIZE + 3];
+	uint32_t cacheCount = 0;
+	size_t scanCursor = 0;
+
+	while( output.size() < triangleCount * 3 )
+	{
+		if( bestTriangle == INVALID_INDEX )
+		{
+			//Nothing left around the cache, restart from the next triangle in the original order
+			while( emitted[scanCursor] )
+				++scanCursor;
+			bestTriangle = static_cast< uint32_t >( scanCursor );
+		}
+
+		emitted[bestTriangle] = true;
+		uint32_t newCache[VERTEX_CACHE_SIZE + 3];
+		uint32_t newCacheCount = 0;
+		for( uint32_t k = 0; k < 3; ++k )
+		{
+			const uint32_t vertex = indices[bestTriangle * 3 + k];
+			output.push_back( vertex );
+			if( std::find( newCache, newCache + newCacheCount, vertex ) == newCache + newCacheCount )
+				newCache[newCacheCount++] = vertex;
+
+			const uint32_t begin = adjacencyOffsets[vertex];
+			const uint32_t end = begin + remainingTriangles[vertex];
+			uint32_t* triangle = std::find( &adjacency[begin], &adjacency[0] + end, bestTriangle );
+			assert( triangle != &adjacency[0] + end );
+			std::swap( *triangle, adjacency[end - 1] );
+			--remainingTriangles[vertex];
+		}
+		for( uint32_t i = 0; i < cacheCount; ++i )
+		{
+			if( std::find( newCache, newCache + newCacheCount, cache[i] ) == newCache + newCacheCount )
+				newCache[newCacheCount++] = cache[i];
+		}
+
+		for( uint32_t i = 0; i < newCacheCount; ++i )
+		{
+			const uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < VERTEX_CACHE_SIZE ? static_cast< int32_t >( i ) : -1;
+			vertexScores[vertex] = ForsythVertexScore( cachePositions[vertex], remainingTriangles[vertex] );
+		}
+
+		//Only the triangles touching the cache changed score, the next one is picked among them
+		bestTriangle = INVALID_INDEX;
+		float bestScore = -1.0f;
+		for( uint32_t i = 0; i < newCacheCount; ++i )
+		{
+			const uint32_t vertex = newCache[i];
+			const uint32_t begin = adjacencyOffsets[vertex];
+			for( uint32_t a = begin; a < begin + remainingTriangles[vertex]; ++a )
+			{
+				const uint32_t t = adjacency[a];
+				triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if( triangleScores[t] > bestScore )
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		cacheCount = std::min( newCacheCount, VERTEX_CACHE_SIZE );
+		std::copy( newCache, newCache + cacheCount, cache );
+	}
+
+	std::copy( output.begin(), output.end(), indices );
+}
+
+struct TriangleCluster
+{
+	uint32_t firstTriangle;
+	uint32_t triangleCount;
+	float sortKey;
+};
+
+void OptimizeOverdraw( uint32_t* indices, size_t indexCount, const glm::vec3* positions, const glm::vec3* normals, size_t vertexCount, float threshold )
+{
+	PROFILE_FUNCTION();
+	const size_t triangleCount = indexCount / 3;
+	if( triangleCount == 0 )
+		return;
+
+	//A cluster starts at every triangle missing all its vertices in the cache, reordering clusters barely changes the ACMR
+	std::vector<TriangleCluster> clusters;
+	std::vector<uint32_t> fifo( VERTEX_CACHE_SIZE, INVALID_INDEX );
+	uint32_t fifoHead = 0;
+	for( uint32_t t = 0; t < triangleCount; ++t )
+	{
+		uint32_t misses = 0;
+		for( uint32_t k = 0; k < 3; ++k )
+		{
+			const uint32_t vertex = indices[t * 3 + k];
+			if( std::find( fifo.begin(), fifo.end(), vertex ) != fifo.end() )
+				continue;
+			fifo[fifoHead] = vertex;
+			fifoHead = ( fifoHead + 1 ) % VERTEX_CACHE_SIZE;
+			++misses;
+		}
+		if( misses == 3 || clusters.empty() )
+			clusters.push_back( { t, 0, 0.0f } );
+		++clusters.back().triangleCount;
+	}
+	if( clusters.size() < 2 )
+		return;
+
+	glm::vec3 meshCenter( 0.0f );
+	for( size_t v = 0; v < vertexCount; ++v )
+		meshCenter += positions[v];
+	meshCenter /= static_cast< float >( vertexCount );
+
+	//Clusters facing away from the center are more likely to occlude the others
+	for( TriangleCluster& cluster : clusters )
+	{
+		glm::vec3 center( 0.0f );
+		glm::vec3 normal( 0.0f );
+		float area = 0.0f;
+		for( uint32_t t = cluster.firstTriangle; t < cluster.firstTriangle + cluster.triangleCount; ++t )
+		{
+			const uint32_t i0 = indices[t * 3], i1 = indices[t * 3 + 1], i2 = indices[t * 3 + 2];
+			glm::vec3 triangleNormal = glm::cross( positions[i1] - positions[i0], positions[i2] - positions[i0] );
+			if( normals && glm::dot( triangleNormal, normals[i0] + normals[i1] + normals[i2] ) < 0.0f )
+				triangleNormal = -triangleNormal;
+			const float triangleArea = glm::length( triangleNormal );
+			center += ( positions[i0] + positions[i1] + positions[i2] ) * ( triangleArea / 3.0f );
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+		if( area > 0.0f )
+			center /= area;
+		const float normalLength = glm::length( normal );
+		if( normalLength > 0.0f )
+			normal /= normalLength;
+		cluster.sortKey = glm::dot( center - meshCenter, normal );
+	}
+
+	std::stable_sort( clusters.begin(), clusters.end(), []( const TriangleCluster& a, const TriangleCluster& b ) { return a.sortKey > b.sortKey; } );
+
+	std::vector<uint32_t> sortedIndices;
+	sortedIndices.reserve( triangleCount * 3 );
+	for( const TriangleCluster& cluster : clusters )
+		sortedIndices.insert( sortedIndices.end(), indices + cluster.firstTriangle * 3, indices + ( cluster.firstTriangle + cluster.triangleCount ) * 3 );
+
+	if( ComputeACMR( sortedIndices.data(), sortedIndices.size(), VERTEX_CACHE_SIZE ) <= ComputeACMR( indices, triangleCount * 3, VERTEX_CACHE_SIZE ) * threshold )
+		std::copy( sortedIndices.begin(), sortedIndices.end(), indices );
+}
+
+size_t OptimizeVertexFetch( const std::vector<MeshStream>& streams, size_t vertexCount, uint32_t* indices, size_t indexCount )
+{
+	std::vector<uint32_t> remap( vertexCount, INVALID_INDEX );
+	uint32_t usedCount = 0;
+	for( size_t i = 0; i < indexCount; ++i )
+	{
+		uint32_t& newIndex = remap[indices[i]];
+		if( newIndex == INVALID_INDEX )
+			newIndex = usedCount++;
+		indices[i] = newIndex;
+	}
+
+	std::vector<uint8_t> reordered;
+	for( const MeshStream& stream : streams )
+	{
+		uint8_t* data = static_cast< uint8_t* >( stream.data );
+		reordered.resize( usedCount * stream.stride );
+		for( size_t v = 0; v < vertexCount; ++v )
+		{
+			if( remap[v] != INVALID_INDEX )
+				memcpy( reordered.data() + remap[v] * stream.stride, data + v * stream.stride, stream.stride );
+		}
+		memcpy( data, reordered.data(), reordered.size() );
+	}
+
+	return usedCount;
+}
+
+MeshOptimizationStats OptimizeMesh( const std::vector<MeshStream>& streams, uint32_t normalsStream, size_t* io_vertexCount, std::vector<uint32_t>* io_indices )
+{
+	PROFILE_FUNCTION();
+	assert( !streams.empty() && streams[0].stride == sizeof( glm::vec3 ) );
+	assert( io_indices->size() % 3 == 0 );
+
+	MeshOptimizationStats stats = {};
+	stats.triangleCount = static_cast< uint32_t >( io_indices->size() / 3 );
+	stats.vertexCountBefore = static_cast< uint32_t >( *io_vertexCount );
+	stats.acmrBefore = ComputeACMR( io_indices->data(), io_indices->size(), VERTEX_CACHE_SIZE );
+
+	size_t vertexCount = DeduplicateVertices( streams, *io_vertexCount, io_indices->data(), io_indices->size() );
+	OptimizeVertexCache( io_indices->data(), io_indices->size(), vertexCount );
+
+	const glm::vec3* positions = static_cast< const glm::vec3* >( streams[0].data );
+	const glm::vec3* normals = normalsStream != NO_NORMALS_STREAM ? static_cast< const glm::vec3* >( streams[normalsStream].data ) : nullptr;
+	OptimizeOverdraw( io_indices->data(), io_indices->size(), positions, normals, vertexCount, 1.05f );
+
+	vertexCount = OptimizeVertexFetch( streams, vertexCount, io_indices->data(), io_indices->size() );
+
+	stats.vertexCountAfter = static_cast< uint32_t >( vertexCount );
+	stats.acmrAfter = ComputeACMR( io_indices->data(), io_indices->size(), VERTEX_CACHE_SIZE );
+	*io_vertexCount = vertexCount;
+	return stats;
+}
+
+void AddMeshOptimizationStats( const MeshOptimizationStats& stats, MeshOptimizationStats* io_total )
+{
+	const uint32_t triangleCount = io_total->triangleCount + stats.triangleCount;
+	if( triangleCount == 0 )
+		return;
+
+	io_total->acmrBefore = ( io_total->acmrBefore * io_total->triangleCount + stats.acmrBefore * stats.triangleCount ) / triangleCount;
+	io_total->acmrAfter = ( io_total->acmrAfter * io_total->triangleCount + stats.acmrAfter * stats.triangleCount ) / triangleCount;
+	io_total->triangleCount = triangleCount;
+	io_total->vertexCountBefore += stats.vertexCountBefore;
+	io_total->vertexCountAfter += stats.vertexCountAfter;
+}
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "mesh_simplifier.h"
+
+#include "mesh_optimizer.h"
+#include "cpu_profiler.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+//Symmetric 4x4 matrix of the squared distance to a set of planes, weighted by the area of their triangles
+struct Quadric
+{
+	double a2, ab, ac, ad;
+	double b2, bc, bd;
+	double c2, cd;
+	double d2;
+	double weight;
+};
+
+static void AddPlane( Quadric* quadric, const glm::vec3& normal, float distance, float weight )
+{
+	const double a = normal.x, b = normal.y, c = normal.z, d = distance;
+	quadric->a2 += a * a * weight;
+	quadric->ab += a * b * weight;
+	quadric->ac += a * c * weight;
+	quadric->ad += a * d * weight;
+	quadric->b2 += b * b * weight;
+	quadric->bc += b * c * weight;
+	quadric->bd += b * d * weight;
+	quadric->c2 += c * c * weight;
+	quadric->cd += c * d * weight;
+	quadric->d2 += d * d * weight;
+	quadric->weight += weight;
+}
+
+static void AddQuadric( Quadric* quadric, const Quadric& other )
+{
+	quadric->a2 += other.a2;
+	quadric->ab += other.ab;
+	quadric->ac += other.ac;
+	quadric->ad += other.ad;
+	quadric->b2 += other.b2;
+	quadric->bc += other.bc;
+	quadric->bd += other.bd;
+	quadric->c2 += other.c2;
+	quadric->cd += other.cd;
+	quadric->d2 += other.d2;
+	quadric->weight += other.weight;
+}
+
+//Average squared distance of the point to the planes
+static float EvaluateQuadric( const Quadric& a, const Quadric& b, const glm::vec3& point )
+{
+	Quadric q = a;
+	AddQuadric( &q, b );
+	const double x = point.x, y = point.y, z = point.z;
+	const double error = q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x
+		+ q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y
+		+ q.c2 * z * z + 2.0 * q.cd * z
+		+ q.d2;
+	return q.weight > 0.0 ? static_cast< float >( std::abs( error ) / q.weight ) : 0.0f;
+}
+
+struct PositionHasher
+{
+	const glm::vec3* positions;
+	size_t operator()( uint32_t vertex ) const
+	{
+		uint32_t bits[3];
+		memcpy( bits, &positions[vertex], sizeof( bits ) );
+		return static_cast< size_t >( ( bits[0] * 73856093u ) ^ ( bits[1] * 19349663u ) ^ ( bits[2] * 83492791u ) );
+	}
+};
+
+struct PositionEqual
+{
+	const glm::vec3* positions;
+	bool operator()( uint32_t a, uint32_t b ) const
+	{
+		return positions[a] == positions[b];
+	}
+};
+
+//Border edges have a single triangle, edges are counted on the positions so seams don't look like borders
+static void FindLockedVertices( const glm::vec3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, std::vector<uint8_t>* o_locked )
+{
+	std::unordered_map<uint32_t, uint32_t, PositionHasher, PositionEqual> positionIds( vertexCount, PositionHasher{ positions }, PositionEqual{ positions } );
+	std::vector<uint32_t> positionId( vertexCount );
+	std::vector<uint32_t> verticesPerPosition( vertexCount, 0 );
+	for( uint32_t v = 0; v < vertexCount; ++v )
+	{
+		positionId[v] = positionIds.emplace( v, v ).first->second;
+		++verticesPerPosition[positionId[v]];
+	}
+
+	std::unordered_map<uint64_t, uint32_t> edgeTriangleCounts;
+	edgeTriangleCounts.reserve( indexCount );
+	for( size_t i = 0; i < indexCount; i += 3 )
+	{
+		for( uint32_t k = 0; k < 3; ++k )
+		{
+			const uint32_t a = positionId[indices[i + k]];
+			const uint32_t b = positionId[indices[i + ( k + 1 ) % 3]];
+			const uint64_t edgeKey = ( static_cast< uint64_t >( std::min( a, b ) ) << 32 ) | std::max( a, b );
+			++edgeTriangleCounts[edgeKey];
+		}
+	}
+
+	std::vector<uint8_t> lockedPositions( vertexCount, 0 );
+	for( const auto& edge : edgeTriangleCounts )
+	{
+		//Borders and non manifold edges
+		if( edge.second != 2 )
+		{
+			lockedPositions[static_cast< uint32_t >( edge.first >> 32 )] = 1;
+			lockedPositions[static_cast< uint32_t >( edge.first & 0xFFFFFFFF )] = 1;
+		}
+	}
+
+	o_locked->resize( vertexCount );
+	for( uint32_t v = 0; v < vertexCount; ++v )
+		( *o_locked )[v] = lockedPositions[positionId[v]] || verticesPerPosition[positionId[v]] > 1;
+}
+
+struct Collapse
+{
+	uint32_t from;
+	uint32_t to;
+	float error;
+};
+
+static bool FlipsTriangles( const glm::vec3* positions, const uint32_t* indices, const uint32_t* triangles, uint32_t triangleCount, uint32_t from, uint32_t to )
+{
+	for( uint32_t i = 0; i < triangleCount; ++i )
+	{
+		const uint32_t* triangle = &indices[triangles[i] * 3];
+		if( triangle[0] == to || triangle[1] == to || triangle[2] == to )
+			continue;
+
+		glm::vec3 corners[3];
+		glm::vec3 newCorners[3];
+		for( uint32_t k = 0; k < 3; ++k )
+		{
+			corners[k] = positions[triangle[k]];
+			newCorners[k] = triangle[k] == from ? positions[to] : corners[k];
+		}
+		const glm::vec3 normal = glm::cross( corners[1] - corners[0], corners[2] - corners[0] );
+		const glm::vec3 newNormal = glm::cross( newCorners[1] - newCorners[0], newCorners[2] - newCorners[0] );
+		if( glm::dot( normal, newNormal ) <= 0.0f )
+			return true;
+	}
+	return false;
+}
+
+float SimplifyMesh( const glm::vec3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, std::vector<uint32_t>* o_indices )
+{
+	PROFILE_FUNCTION();
+	assert( indexCount % 3 == 0 );
+	o_indices->assign( indices, indices + indexCount );
+
+	std::vector<uint8_t> locked;
+	FindLockedVertices( positions, vertexCount, indices, indexCount, &locked );
+
+	std::vector<Quadric> quadrics( vertexCount, Quadric{} );
+	for( size_t i = 0; i < indexCount; i += 3 )
+	{
+		const glm::vec3& p0 = positions[indices[i]];
+		const glm::vec3 normal = glm::cross( positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0 );
+		const float doubleArea = glm::length( normal );
+		if( doubleArea == 0.0f )
+			continue;
+		const glm::vec3 unitNormal = normal / doubleArea;
+		for( uint32_t k = 0; k < 3; ++k )
+			AddPlane( &quadrics[indices[i + k]], unitNormal, -glm::dot( unitNormal, p0 ), doubleArea * 0.5f );
+	}
+
+	const float maxSquaredError = maxError * maxError;
+	float resultError = 0.0f;
+	std::vector<uint32_t> adjacencyOffsets, adjacency, remap;
+	std::vector<uint8_t> touched;
+	std::vector<Collapse> collapses;
+
+	//Every pass collapses as many independent edges as possible, cheapest first
+	while( o_indices->size() > targetIndexCount )
+	{
+		std::vector<uint32_t>& currentIndices = *o_indices;
+		const size_t triangleCount = currentIndices.size() / 3;
+
+		adjacencyOffsets.assign( vertexCount + 1, 0 );
+		for( uint32_t index : currentIndices )
+			++adjacencyOffsets[index + 1];
+		for( size_t v = 0; v < vertexCount; ++v )
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		adjacency.resize( currentIndices.size() );
+		std::vector<uint32_t> fillOffsets( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+		for( uint32_t t = 0; t < triangleCount; ++t )
+		{
+			for( uint32_t k = 0; k < 3; ++k )
+				adjacency[fillOffsets[currentIndices[t * 3 + k]]++] = t;
+		}
+
+		collapses.clear();
+		for( size_t i = 0; i < currentIndices.size(); i += 3 )
+		{
+			for( uint32_t k = 0; k < 3; ++k )
+			{
+				const uint32_t a = currentIndices[i + k];
+				const uint32_t b = currentIndices[i + ( k + 1 ) % 3];
+				if( !locked[a] )
+					collapses.push_back( { a, b, EvaluateQuadric( quadrics[a], quadrics[b], positions[b] ) } );
+				if( !locked[b] )
+					collapses.push_back( { b, a, EvaluateQuadric( quadrics[a], quadrics[b], positions[a] ) } );
+			}
+		}
+		std::sort( collapses.begin(), collapses.end(), []( const Collapse& a, const Collapse& b ) { return a.error < b.error; } );
+
+		remap.resize( vertexCount );
+		for( uint32_t v = 0; v < vertexCount; ++v )
+			remap[v] = v;
+		touched.assign( vertexCount, 0 );
+
+		size_t remainingTriangles = triangleCount;
+		uint32_t collapsedCount = 0;
+		for( const Collapse& collapse : collapses )
+		{
+			if( remainingTriangles * 3 <= targetIndexCount || collapse.error > maxSquaredError )
+				break;
+			if( touched[collapse.from] || touched[collapse.to] )
+				continue;
+
+			//The whole ring of the collapsed vertex has to be untouched for the flip test to see the real triangles
+			const uint32_t* triangles = &adjacency[adjacencyOffsets[collapse.from]];
+			const uint32_t trianglesCount = adjacencyOffsets[collapse.from + 1] - adjacencyOffsets[collapse.from];
+			bool ringTouched = false;
+			uint32_t removedTriangles = 0;
+			for( uint32_t i = 0; i < trianglesCount; ++i )
+			{
+				const uint32_t* triangle = &currentIndices[triangles[i] * 3];
+				ringTouched |= touched[triangle[0]] || touched[triangle[1]] || touched[triangle[2]];
+				removedTriangles += triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to;
+			}
+			if( ringTouched || FlipsTriangles( positions, currentIndices.data(), triangles, trianglesCount, collapse.from, collapse.to ) )
+				continue;
+
+			remap[collapse.from] = collapse.to;
+			AddQuadric( &quadrics[collapse.to], quadrics[collapse.from] );
+			for( uint32_t i = 0; i < trianglesCount; ++i )
+			{
+				const uint32_t* triangle = &currentIndices[triangles[i] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+			}
+			touched[collapse.to] = 1;
+			remainingTriangles -= removedTriangles;
+			resultError = std::max( resultError, collapse.error );
+			++collapsedCount;
+		}
+
+		if( collapsedCount == 0 )
+			break;
+
+		//Drop the triangles that lost an edge
+		size_t writeIndex = 0;
+		for( size_t i = 0; i < currentIndices.size(); i += 3 )
+		{
+			const uint32_t a = remap[currentIndices[i]];
+			const uint32_t b = remap[currentIndices[i + 1]];
+			const uint32_t c = remap[currentIndices[i + 2]];
+			if( a == b || b == c || a == c )
+				continue;
+			currentIndices[writeIndex++] = a;
+			currentIndices[writeIndex++] = b;
+			currentIndices[writeIndex++] = c;
+		}
+		currentIndices.resize( writeIndex );
+	}
+
+	return std::sqrt( resultError );
+}
+
+uint32_t GenerateMeshLods( const glm::vec3* positions, size_t vertexCount, std::vector<uint32_t>* io_indices, uint32_t maxLodCount, GfxModelLod* o_lods )
+{
+	PROFILE_FUNCTION();
+	assert( maxLodCount > 0 );
+	o_lods[0] = { 0, static_cast< uint32_t >( io_indices->size() ), 0.0f };
+	uint32_t lodCount = 1;
+
+	std::vector<uint32_t> previousLod( io_indices->begin(), io_indices->end() );
+	std::vector<uint32_t> lodIndices;
+	while( lodCount < maxLodCount )
+	{
+		const size_t targetIndexCount = previousLod.size() / 6 * 3;
+		const float error = SimplifyMesh( positions, vertexCount, previousLod.data(), previousLod.size(), targetIndexCount, std::numeric_limits<float>::max(), &lodIndices );
+		//Not worth the memory when the mesh barely got simpler
+		if( lodIndices.empty() || lodIndices.size() * 4 > previousLod.size() * 3 )
+			break;
+
+		OptimizeVertexCache( lodIndices.data(), lodIndices.size(), vertexCount );
+		o_lods[lodCount].firstIndex = static_cast< uint32_t >( io_indices->size() );
+		o_lods[lodCount].indexCount = static_cast< uint32_t >( lodIndices.size() );
+		//Each LOD is simplified from the previous one, their errors add up
+		o_lods[lodCount].error = o_lods[lodCount - 1].error + error;
+		io_indices->insert( io_indices->end(), lodIndices.begin(), lodIndices.end() );
+		previousLod.swap( lodIndices );
+		++lodCount;
+	}
+
+	return lodCount;
+}
\ No newline at end of file
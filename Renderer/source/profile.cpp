@@ -40,4 +40,11 @@ float GetTimestampsDelta(Timestamp first, Timestamp last, uint32_t set)
 
 	float miliseconds = (values[1] - values[0]) / 1000000.0f;
 	return miliseconds;
+}
+
+uint64_t GetTimestamp( Timestamp timestamp, uint32_t set )
+{
+	uint64_t value;
+	R_HW::GfxApiGetTimeStampResults( g_timeStampQueryPool, timestamp + set * Timestamp::TIMESTAMP_COUNT, 1, &value );
+	return value;
 }
\ No newline at end of file
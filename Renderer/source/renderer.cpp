@@ -1,14 +1,47 @@
 #include "renderer.h"
 
 #include "profile.h"
+#include "cpu_profiler.h"
 #include "frame_graph.h"
+#include "frame_graph_bindings.h"
 #include "gfx_heaps_batched_allocator.h"
+#include "shader_library.h"
 
 #include <array>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 namespace RNDR
 {
+	//Kept until the frames submitted before the resize are done
+	struct RetiredSwapchain
+	{
+		R_HW::Swapchain swapchain;
+		FG::RetiredResources frameGraphResources;
+		uint64_t timelineValue;
+	};
+
+	struct RetiredPipeline
+	{
+		R_HW::GfxPipeline pipeline;
+		uint64_t timelineValue;
+	};
+
+	//Presented frame whose latency isn't known yet
+	struct PendingPresent
+	{
+		R_HW::GfxSwapchain swapchain;
+		uint64_t presentId;
+		uint64_t timelineValue;
+		std::chrono::steady_clock::time_point inputTime;
+		uint32_t frame;
+	};
+
+	//Weight of the last frame in the average latency
+	constexpr float LATENCY_SMOOTHING = 0.1f;
+	constexpr size_t MAX_PENDING_PRESENTS = 16;
+
 	struct R_State
 	{
 		R_HW::GfxCommandPool g_graphicsCommandPool;
@@ -18,26 +51,49 @@ namespace RNDR
 
 		std::array<R_HW::GfxSemaphore, SIMULTANEOUS_FRAMES> imageAvailableSemaphores;
 		std::array<R_HW::GfxSemaphore, SIMULTANEOUS_FRAMES> renderFinishedSemaphores;
-		std::array<R_HW::GfxFence, SIMULTANEOUS_FRAMES> end_of_frame_fences;
+
+		//Each submitted frame signals the next value, a frame slot is free once the value it signaled is reached
+		R_HW::GfxSemaphore graphicsTimeline;
+		uint64_t graphicsTimelineValue;
+		std::array<uint64_t, SIMULTANEOUS_FRAMES> frameTimelineValues;
+
+		std::vector<RetiredSwapchain> retiredSwapchains;
+		//Replaced by a shader reload, still used by the frames submitted before it
+		std::vector<RetiredPipeline> retiredPipelines;
+		//Used by the next swapchain recreation
+		R_HW::GfxPresentMode presentMode;
+
+		//Image acquired by BeginFrame for each frame slot
+		std::array<R_HW::GfxSwapchainImage, SIMULTANEOUS_FRAMES> frameSwapchainImages;
+		std::array<R_HW::GfxSwapchainOperationResult, SIMULTANEOUS_FRAMES> frameAcquireResults;
+		std::array<bool, SIMULTANEOUS_FRAMES> frameImageAcquired;
+
+		std::array<std::chrono::steady_clock::time_point, SIMULTANEOUS_FRAMES> frameInputTimes;
+		std::vector<PendingPresent> pendingPresents;
+		float inputToPresentLatencyMs;
 
 		FG::FrameGraph _frameGraph;
 	};
 
 	static void create_sync_objects( R_State* pr_state )
 	{
-		for( size_t i = 0; i < SIMULTANEOUS_FRAMES; ++i )
+		for( size_t i = 0; i < g_gfx.framesInFlight; ++i )
 		{
 			if( !R_HW::CreateGfxSemaphore( &pr_state->imageAvailableSemaphores[i] ) ||
-				!R_HW::CreateGfxSemaphore( &pr_state->renderFinishedSemaphores[i] ) ||
-				!R_HW::CreateGfxFence( &pr_state->end_of_frame_fences[i] ) )
+				!R_HW::CreateGfxSemaphore( &pr_state->renderFinishedSemaphores[i] ) )
 			{
 				throw std::runtime_error( "failed to create semaphores!" );
 			}
 
 			R_HW::MarkGfxObject( pr_state->imageAvailableSemaphores[i], "image available semaphore" );
 			R_HW::MarkGfxObject( pr_state->renderFinishedSemaphores[i], "render finished semaphore" );
-			R_HW::MarkGfxObject( pr_state->end_of_frame_fences[i], "In flight fence" );
 		}
+
+		if( !R_HW::CreateGfxTimelineSemaphore( 0, &pr_state->graphicsTimeline ) )
+			throw std::runtime_error( "failed to create timeline semaphore!" );
+		R_HW::MarkGfxObject( pr_state->graphicsTimeline, "graphics timeline" );
+		pr_state->graphicsTimelineValue = 0;
+		pr_state->frameTimelineValues.fill( 0 );
 	}
 
 	VkExtent2D get_backbuffer_size( const R_State* pr_state )
@@ -45,22 +101,30 @@ namespace RNDR
 		return pr_state->g_swapchain.extent;
 	}
 
-	R_State* CreateRenderer( R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height )
+	R_State* CreateRenderer( R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height, uint32_t framesInFlight, R_HW::GfxPresentMode presentMode )
 	{
+		if( framesInFlight < 1 || framesInFlight > SIMULTANEOUS_FRAMES )
+			throw std::runtime_error( "frames in flight must be between 1 and SIMULTANEOUS_FRAMES!" );
+		g_gfx.framesInFlight = framesInFlight;
+
 		R_State* pr_state = new R_State();
+		pr_state->presentMode = presentMode;
+		pr_state->frameImageAcquired.fill( false );
+		pr_state->frameInputTimes.fill( std::chrono::steady_clock::now() );
+		pr_state->inputToPresentLatencyMs = 0.0f;
 
-		CreateSwapChain( swapchainSurface, width, height, pr_state->g_swapchain );
+		CreateSwapChain( swapchainSurface, width, height, g_gfx.framesInFlight, presentMode, VK_NULL_HANDLE, pr_state->g_swapchain );
 
 		R_HW::CreateCommandPool( g_gfx.device.graphics_queue.queueFamilyIndex, &pr_state->g_graphicsCommandPool );
 		R_HW::CreateSingleUseCommandPool( g_gfx.device.graphics_queue.queueFamilyIndex, &g_gfx.graphicsSingleUseCommandPool );
-		if( !R_HW::CreateCommandBuffers( pr_state->g_graphicsCommandPool, pr_state->g_graphicsCommandBuffers.data(), static_cast< uint32_t >(pr_state->g_graphicsCommandBuffers.size()) ) )
+		if( !R_HW::CreateCommandBuffers( pr_state->g_graphicsCommandPool, pr_state->g_graphicsCommandBuffers.data(), g_gfx.framesInFlight ) )
 			throw std::runtime_error( "failed to allocate command buffers!" );
 
 		InitSamplers();
 
 		create_sync_objects( pr_state );
 
-		CreateTimeStampsQueryPool( SIMULTANEOUS_FRAMES );
+		CreateTimeStampsQueryPool( g_gfx.framesInFlight );
 
 		return pr_state;
 	}
@@ -73,19 +137,148 @@ namespace RNDR
 		pr_state->_frameGraph = FGScriptInitialize( &pr_state->g_swapchain, fg_user_params );
 	}
 
-	void recreate_swap_chain( R_State* pr_state, R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height, FG_CompileScriptCallback_t FGScriptInitialize, void* fg_user_params )
+	void recreate_swap_chain( R_State* pr_state, R_HW::DisplaySurface swapchainSurface, uint64_t width, uint64_t height, FG_ResizeScriptCallback_t FGScriptResize, void* fg_user_params )
 	{
-		R_HW::DeviceWaitIdle( g_gfx.device.device );
+		PROFILE_FUNCTION();
+		//Presents have no fence, the old swapchain waits for framesInFlight more frames so its last presents are done too
+		RetiredSwapchain retired = {};
+		retired.swapchain = pr_state->g_swapchain;
+		retired.timelineValue = pr_state->graphicsTimelineValue + g_gfx.framesInFlight;
+
+		pr_state->g_swapchain = {};
+		CreateSwapChain( swapchainSurface, width, height, g_gfx.framesInFlight, pr_state->presentMode, retired.swapchain.swapchain, pr_state->g_swapchain );
+		//Present ids belong to the old swapchain
+		pr_state->pendingPresents.clear();
+
+		FGScriptResize( &pr_state->_frameGraph, &pr_state->g_swapchain, fg_user_params, &retired.frameGraphResources );
+		pr_state->retiredSwapchains.push_back( std::move( retired ) );
+	}
 
-		Destroy( &pr_state->g_swapchain );
+	static void DestroyRetiredSwapchains( R_State* pr_state, bool all )
+	{
+		if( pr_state->retiredSwapchains.empty() )
+			return;
 
-		//TODO: try to use the "oldSwapchain" parameter to optimize when recreating swap chains
-		CreateSwapChain( swapchainSurface, width, height, pr_state->g_swapchain );
+		const uint64_t completedValue = R_HW::GetSemaphoreValue( pr_state->graphicsTimeline );
+		for( size_t i = 0; i < pr_state->retiredSwapchains.size(); )
+		{
+			RetiredSwapchain& retired = pr_state->retiredSwapchains[i];
+			if( !all && retired.timelineValue > completedValue )
+			{
+				++i;
+				continue;
+			}
+			FG::Destroy( &retired.frameGraphResources );
+			Destroy( &retired.swapchain );
+			retired = std::move( pr_state->retiredSwapchains.back() );
+			pr_state->retiredSwapchains.pop_back();
+		}
+	}
 
-		CompileFrameGraph( pr_state, FGScriptInitialize, fg_user_params );
+	static void DestroyRetiredPipelines( R_State* pr_state, bool all )
+	{
+		if( pr_state->retiredPipelines.empty() )
+			return;
+
+		const uint64_t completedValue = R_HW::GetSemaphoreValue( pr_state->graphicsTimeline );
+		for( size_t i = 0; i < pr_state->retiredPipelines.size(); )
+		{
+			RetiredPipeline& retired = pr_state->retiredPipelines[i];
+			if( !all && retired.timelineValue > completedValue )
+			{
+				++i;
+				continue;
+			}
+			R_HW::Destroy( &retired.pipeline );
+			retired = pr_state->retiredPipelines.back();
+			pr_state->retiredPipelines.pop_back();
+		}
+	}
+
+	void ReloadChangedShaders( R_State* pr_state )
+	{
+		const std::vector<const R_HW::ShaderCode*> changedShaders = ReloadChangedShaderFiles();
+		if( changedShaders.empty() )
+			return;
+
+		PROFILE_FUNCTION();
+		std::vector<R_HW::GfxPipeline> oldPipelines;
+		try
+		{
+			FG::RebuildPipelines( &pr_state->_frameGraph, changedShaders, &oldPipelines );
+		}
+		catch( const std::exception& e )
+		{
+			//The old pipelines are kept until the shaders are fixed
+			std::cout << "Shader reload failed: " << e.what() << std::endl;
+			return;
+		}
+
+		//The frames submitted so far still use the old pipelines
+		for( R_HW::GfxPipeline pipeline : oldPipelines )
+			pr_state->retiredPipelines.push_back( { pipeline, pr_state->graphicsTimelineValue } );
+	}
+
+	void UpdateDescriptorTables( R_State* pr_state, const GpuInputData& inputData, uint32_t currentFrame )
+	{
+		FG::UpdateTechniqueDescriptorSets( &pr_state->_frameGraph, inputData, currentFrame );
+	}
+
+	void SetPresentMode( R_State* pr_state, R_HW::GfxPresentMode presentMode )
+	{
+		pr_state->presentMode = presentMode;
+	}
+
+	R_HW::GfxPresentMode GetPresentMode( const R_State* pr_state )
+	{
+		return pr_state->g_swapchain.presentMode;
 	}
 
-	static void RecordCommandBuffer( R_State* pr_state, uint32_t currentFrame, const SceneFrameData* frameData )
+	float GetInputToPresentLatency( const R_State* pr_state )
+	{
+		return pr_state->inputToPresentLatencyMs;
+	}
+
+	//End of the frame on the steady clock from its last GPU timestamp, gpuNow and hostNow being sampled together
+	static std::chrono::steady_clock::time_point GetFrameEndTime( uint32_t frame, uint64_t gpuNow, uint64_t hostNow )
+	{
+		const int64_t ticksSinceEnd = static_cast< int64_t >( gpuNow - GetTimestamp( Timestamp::COMMAND_BUFFER_END, frame ) );
+		const int64_t hostEnd = static_cast< int64_t >( hostNow ) - static_cast< int64_t >( ticksSinceEnd * static_cast< double >( g_gfx.device.timestampPeriod ) );
+		return std::chrono::steady_clock::time_point( std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::nanoseconds( hostEnd ) ) );
+	}
+
+	//Polled each frame, a present seen with present wait is late by up to a frame.
+	//Without present wait the end of the frame on the GPU is as close as we get, it's timestamped by the GPU when the clocks are calibrated
+	static void UpdatePresentLatency( R_State* pr_state )
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const uint64_t completedValue = R_HW::GetSemaphoreValue( pr_state->graphicsTimeline );
+		const bool useGpuTimestamps = !g_gfx.device.presentWait && g_gfx.device.calibratedTimestamps;
+		uint64_t gpuNow = 0;
+		uint64_t hostNow = 0;
+		if( useGpuTimestamps )
+			R_HW::GetCalibratedTimestamps( &gpuNow, &hostNow );
+
+		for( size_t i = 0; i < pr_state->pendingPresents.size(); )
+		{
+			const PendingPresent& pending = pr_state->pendingPresents[i];
+			const bool presented = g_gfx.device.presentWait ? R_HW::PresentDone( pending.swapchain, pending.presentId ) : completedValue >= pending.timelineValue;
+			if( !presented )
+			{
+				++i;
+				continue;
+			}
+
+			//The timestamps of the frame slot are only kept until it's recorded again
+			const bool timestamped = useGpuTimestamps && pr_state->frameTimelineValues[pending.frame] == pending.timelineValue;
+			const std::chrono::steady_clock::time_point presentTime = timestamped ? GetFrameEndTime( pending.frame, gpuNow, hostNow ) : now;
+			const float latencyMs = std::chrono::duration< float, std::milli >( presentTime - pending.inputTime ).count();
+			pr_state->inputToPresentLatencyMs += (latencyMs - pr_state->inputToPresentLatencyMs) * LATENCY_SMOOTHING;
+			pr_state->pendingPresents.erase( pr_state->pendingPresents.begin() + i );
+		}
+	}
+
+	static void RecordCommandBuffer( R_State* pr_state, uint32_t currentFrame, uint32_t swapchainImageIndex, const SceneFrameData* frameData )
 	{
 		R_HW::GfxCommandBuffer graphicsCommandBuffer = pr_state->g_graphicsCommandBuffers[currentFrame];
 		R_HW::BeginCommandBufferRecording( graphicsCommandBuffer );
@@ -94,49 +287,69 @@ namespace RNDR
 
 		CmdWriteTimestamp( graphicsCommandBuffer, R_HW::GFX_PIPELINE_STAGE_TOP_OF_PIPE_BIT, Timestamp::COMMAND_BUFFER_START, currentFrame );
 
-		FG::RecordDrawCommands( currentFrame, const_cast< SceneFrameData* >(frameData), graphicsCommandBuffer, pr_state->g_swapchain.extent, &pr_state->_frameGraph );
+		FG::RecordDrawCommands( currentFrame, swapchainImageIndex, const_cast< SceneFrameData* >(frameData), graphicsCommandBuffer, pr_state->g_swapchain.extent, &pr_state->_frameGraph );
 
 		//TODO: Maybe make a present task so it changes the final layout in the frame graph?
-		R_HW::GfxImageBarrier( graphicsCommandBuffer, pr_state->g_swapchain.images[currentFrame].image, R_HW::GfxLayout::COLOR, R_HW::GfxAccess::WRITE, R_HW::GfxLayout::PRESENT, R_HW::GfxAccess::READ );
+		R_HW::GfxImageBarrier( graphicsCommandBuffer, pr_state->g_swapchain.images[swapchainImageIndex].image, R_HW::GfxLayout::COLOR, R_HW::GfxAccess::WRITE, R_HW::GfxLayout::PRESENT, R_HW::GfxAccess::READ );
 
 		CmdWriteTimestamp( graphicsCommandBuffer, R_HW::GFX_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, Timestamp::COMMAND_BUFFER_END, currentFrame );
 
 		R_HW::EndCommandBufferRecording( graphicsCommandBuffer );
 	}
 
-	void WaitForFrame( const R_State* pr_state, uint32_t currentFrame )
+	eRenderError BeginFrame( R_State* pr_state, uint32_t currentFrame )
+	{
+		PROFILE_FUNCTION();
+		//Before blocking so the presents done during the wait aren't timed at its end
+		UpdatePresentLatency( pr_state );
+		R_HW::WaitForSemaphoreValue( pr_state->graphicsTimeline, pr_state->frameTimelineValues[currentFrame] );
+		DestroyRetiredSwapchains( pr_state, false );
+		DestroyRetiredPipelines( pr_state, false );
+
+		assert( !pr_state->frameImageAcquired[currentFrame] );
+		R_HW::GfxSwapchainImage* swapchainImage = &pr_state->frameSwapchainImages[currentFrame];
+		pr_state->frameAcquireResults[currentFrame] = AcquireNextSwapchainImage( pr_state->g_swapchain.swapchain, pr_state->imageAvailableSemaphores[currentFrame], swapchainImage );
+		//A suboptimal image is still rendered and presented so its semaphore gets waited on, the swapchain is recreated after
+		pr_state->frameImageAcquired[currentFrame] = R_HW::SwapchainImageAcquired( pr_state->frameAcquireResults[currentFrame] );
+		if( !pr_state->frameImageAcquired[currentFrame] )
+			return eRenderError::NEED_FRAMEBUFFER_RESIZE;
+
+		return eRenderError::SUCCESS;
+	}
+
+	void MarkInputSampled( R_State* pr_state, uint32_t currentFrame )
 	{
-		R_HW::WaitForFence( &pr_state->end_of_frame_fences[currentFrame], 1 );
+		pr_state->frameInputTimes[currentFrame] = std::chrono::steady_clock::now();
 	}
 
 	eRenderError draw_frame( R_State* pr_state, uint32_t currentFrame, const SceneFrameData* frameData )
 	{
-		RecordCommandBuffer( pr_state, currentFrame, frameData );
+		PROFILE_FUNCTION();
+		assert( pr_state->frameImageAcquired[currentFrame] );
+		const R_HW::GfxSwapchainImage swapchainImage = pr_state->frameSwapchainImages[currentFrame];
+		const R_HW::GfxSwapchainOperationResult aquireSwapChainImageResult = pr_state->frameAcquireResults[currentFrame];
+		pr_state->frameImageAcquired[currentFrame] = false;
 
-		R_HW::GfxSwapchainImage swapchainImage;
-		const R_HW::GfxSwapchainOperationResult aquireSwapChainImageResult = AcquireNextSwapchainImage( pr_state->g_swapchain.swapchain, pr_state->imageAvailableSemaphores[currentFrame], &swapchainImage );
-		//TODO: Do I really need 2 check for recreate swap chain in this function?
-		if( !R_HW::SwapchainImageIsValid( aquireSwapChainImageResult ) ) {
-			R_HW::unsignalSemaphore( pr_state->imageAvailableSemaphores[currentFrame] );
-			return eRenderError::NEED_FRAMEBUFFER_RESIZE;
-		}
+		RecordCommandBuffer( pr_state, currentFrame, swapchainImage.imageIndex, frameData );
 
 		//Submit work
 		R_HW::GfxSemaphore waitSemaphores[] = { pr_state->imageAvailableSemaphores[currentFrame] };
 		R_HW::GfxPipelineStageFlag waitStages[] = { R_HW::GFX_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		R_HW::GfxSemaphore signalSemaphores[] = { pr_state->renderFinishedSemaphores[currentFrame] }; //TODO make a system that keeps the semaphores ordered
 
-		R_HW::ResetGfxFences( &pr_state->end_of_frame_fences[currentFrame], 1 );
-
-		if( !R_HW::QueueSubmit( g_gfx.device.graphics_queue.queue, &pr_state->g_graphicsCommandBuffers[currentFrame], 1, waitSemaphores, waitStages, 1, signalSemaphores, 1, pr_state->end_of_frame_fences[currentFrame] ) )
+		const uint64_t frameTimelineValue = ++pr_state->graphicsTimelineValue;
+		if( !R_HW::QueueSubmit( g_gfx.device.graphics_queue.queue, &pr_state->g_graphicsCommandBuffers[currentFrame], 1, waitSemaphores, waitStages, 1, signalSemaphores, 1, pr_state->graphicsTimeline, frameTimelineValue ) )
 			throw std::runtime_error( "failed to submit draw command buffer!" );
+		pr_state->frameTimelineValues[currentFrame] = frameTimelineValue;
 
-		//Present
-		const R_HW::GfxSwapchainOperationResult presentResult = QueuePresent( g_gfx.device.present_queue.queue, swapchainImage, &pr_state->renderFinishedSemaphores[currentFrame], 1 );
-		if( !R_HW::SwapchainImageIsValid( presentResult ) )
-		{
-			eRenderError::NEED_FRAMEBUFFER_RESIZE;
-		}
+		//Present, the timeline value is also a present id that increases with each present
+		const R_HW::GfxSwapchainOperationResult presentResult = QueuePresent( g_gfx.device.present_queue.queue, swapchainImage, &pr_state->renderFinishedSemaphores[currentFrame], 1, frameTimelineValue );
+		if( pr_state->pendingPresents.size() == MAX_PENDING_PRESENTS )
+			pr_state->pendingPresents.erase( pr_state->pendingPresents.begin() );
+		pr_state->pendingPresents.push_back( { swapchainImage.swapchain, frameTimelineValue, frameTimelineValue, pr_state->frameInputTimes[currentFrame], currentFrame } );
+
+		if( !R_HW::SwapchainImageIsValid( aquireSwapChainImageResult ) || !R_HW::SwapchainImageIsValid( presentResult ) )
+			return eRenderError::NEED_FRAMEBUFFER_RESIZE;
 
 		return eRenderError::SUCCESS;
 	}
@@ -145,20 +358,22 @@ namespace RNDR
 	{
 		R_State* pr_state = *ppr_state;
 
-		R_HW::DestroyCommandBuffers( pr_state->g_graphicsCommandPool, pr_state->g_graphicsCommandBuffers.data(), static_cast< uint32_t >(pr_state->g_graphicsCommandBuffers.size()) );
+		R_HW::DestroyCommandBuffers( pr_state->g_graphicsCommandPool, pr_state->g_graphicsCommandBuffers.data(), g_gfx.framesInFlight );
 
+		DestroyRetiredSwapchains( pr_state, true );
+		DestroyRetiredPipelines( pr_state, true );
 		Destroy( &pr_state->g_swapchain );
 
 		DestroySamplers();
 
 		FG::Cleanup( &pr_state->_frameGraph );
 
-		for( size_t i = 0; i < SIMULTANEOUS_FRAMES; ++i )
+		for( size_t i = 0; i < g_gfx.framesInFlight; ++i )
 		{
 			R_HW::DestroyGfxSemaphore( &pr_state->renderFinishedSemaphores[i] );
 			R_HW::DestroyGfxSemaphore( &pr_state->imageAvailableSemaphores[i] );
-			R_HW::DestroyGfxFence( &pr_state->end_of_frame_fences[i] );
 		}
+		R_HW::DestroyGfxSemaphore( &pr_state->graphicsTimeline );
 
 		R_HW::Destroy( &pr_state->g_graphicsCommandPool );
 		R_HW::Destroy( &g_gfx.graphicsSingleUseCommandPool );
@@ -172,11 +387,15 @@ namespace RNDR
 
 void CmdBindVertexInputs( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel )
 {
-	const uint32_t maxVertexInputBinding = 16;
-	const uint32_t gpuPipelineVIBingindCount = gpuPipelineVIBindings.size();
-	assert( gpuPipelineVIBingindCount <= maxVertexInputBinding );
-	R_HW::GfxApiBuffer vertexBuffers[maxVertexInputBinding];
-	R_HW::GfxDeviceSize offsets[maxVertexInputBinding];
+	CmdBindVertexInputs( commandBuffer, gpuPipelineVIBindings, gfxModel, nullptr );
+}
+
+void CmdBindVertexInputs( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel, GeometryBindState* bindState )
+{
+	uint32_t gpuPipelineVIBingindCount = gpuPipelineVIBindings.size();
+	assert( gpuPipelineVIBingindCount <= MAX_VERTEX_INPUT_BINDINGS );
+	R_HW::GfxApiBuffer vertexBuffers[MAX_VERTEX_INPUT_BINDINGS];
+	R_HW::GfxDeviceSize offsets[MAX_VERTEX_INPUT_BINDINGS];
 
 	for( uint32_t i = 0; i < gpuPipelineVIBingindCount; ++i )
 	{
@@ -186,6 +405,17 @@ void CmdBindVertexInputs( R_HW::GfxCommandBuffer commandBuffer, const std::vecto
 		vertexBuffers[i] = modelVI->buffer.buffer;
 		offsets[i] = 0;
 	}
+	//Interleaved vertices, the pipeline has a single binding for all its attributes
+	if( gfxModel.vertexStride != 0 && gpuPipelineVIBingindCount > 0 )
+		gpuPipelineVIBingindCount = 1;
+
+	if( bindState )
+	{
+		if( bindState->vertexBuffersCount == gpuPipelineVIBingindCount && std::equal( vertexBuffers, vertexBuffers + gpuPipelineVIBingindCount, bindState->vertexBuffers ) )
+			return;
+		std::copy( vertexBuffers, vertexBuffers + gpuPipelineVIBingindCount, bindState->vertexBuffers );
+		bindState->vertexBuffersCount = gpuPipelineVIBingindCount;
+	}
 
 	R_HW::CmdBindVertexInputs( commandBuffer, vertexBuffers, 0, gpuPipelineVIBingindCount, offsets );
 }
@@ -194,10 +424,41 @@ void CmdDrawIndexed( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_H
 {
 	CmdBindVertexInputs( commandBuffer, gpuPipelineVIBindings, gfxModel );
 	CmdBindIndexBuffer( commandBuffer, gfxModel.indexBuffer.buffer, 0, gfxModel.indexType );
-	R_HW::CmdDrawIndexed( commandBuffer, indexCount, 1, 0, 0, 0 );
+	R_HW::CmdDrawIndexed( commandBuffer, indexCount, 1, gfxModel.firstIndex, gfxModel.vertexOffset, 0 );
 }
 
 void CmdDrawIndexed( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel )
 {
 	CmdDrawIndexed( commandBuffer, gpuPipelineVIBindings, gfxModel, gfxModel.indexCount );
+}
+
+void CmdDrawIndexedInstanced( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel, uint32_t instanceCount, uint32_t firstInstance )
+{
+	CmdBindVertexInputs( commandBuffer, gpuPipelineVIBindings, gfxModel );
+	CmdBindIndexBuffer( commandBuffer, gfxModel.indexBuffer.buffer, 0, gfxModel.indexType );
+	R_HW::CmdDrawIndexed( commandBuffer, gfxModel.indexCount, instanceCount, gfxModel.firstIndex, gfxModel.vertexOffset, firstInstance );
+}
+
+bool SharesGeometryBuffers( const GfxModel& a, const GfxModel& b )
+{
+	if( a.indexBuffer.buffer != b.indexBuffer.buffer || a.indexType != b.indexType )
+		return false;
+	for( uint8_t i = 0; i < ( R_HW::VIDataType )eVIDataType::VI_DATA_TYPE_COUNT; ++i )
+	{
+		if( a.vertAttribBuffers[i].buffer.buffer != b.vertAttribBuffers[i].buffer.buffer )
+			return false;
+	}
+	return true;
+}
+
+void CmdDrawIndexedIndirect( R_HW::GfxCommandBuffer commandBuffer, const std::vector<R_HW::VIBinding>& gpuPipelineVIBindings, const GfxModel& gfxModel, const R_HW::GpuBuffer& argumentsBuffer, R_HW::GfxDeviceSize offset, uint32_t drawCount, uint32_t stride, GeometryBindState* bindState )
+{
+	CmdBindVertexInputs( commandBuffer, gpuPipelineVIBindings, gfxModel, bindState );
+	if( !bindState || bindState->indexBuffer != gfxModel.indexBuffer.buffer )
+	{
+		CmdBindIndexBuffer( commandBuffer, gfxModel.indexBuffer.buffer, 0, gfxModel.indexType );
+		if( bindState )
+			bindState->indexBuffer = gfxModel.indexBuffer.buffer;
+	}
+	R_HW::CmdDrawIndexedIndirect( commandBuffer, argumentsBuffer.buffer, offset, drawCount, stride );
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "shader_library.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+struct LoadedShader
+{
+	std::unique_ptr<R_HW::ShaderCode> code;
+	std::filesystem::file_time_type writeTime;
+};
+
+static std::unordered_map<std::string, LoadedShader> shaderLibrary;
+
+#ifdef __linux__
+static int shaderWatchFd = -1;
+//Watch descriptor to the directory as written in the loaded paths
+static std::unordered_map<int, std::string> watchedDirectories;
+#endif
+
+static std::vector<char> ReadShaderFile( const char* path )
+{
+	std::ifstream file( path, std::ios::ate | std::ios::binary );
+	if( !file.is_open() )
+		throw std::runtime_error( "failed to open shader file!" );
+
+	const size_t fileSize = static_cast< size_t >( file.tellg() );
+	std::vector<char> spirv( fileSize );
+	file.seekg( 0 );
+	file.read( spirv.data(), fileSize );
+	return spirv;
+}
+
+static std::filesystem::file_time_type GetWriteTime( const std::string& path )
+{
+	std::error_code error;
+	const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time( path, error );
+	return error ? std::filesystem::file_time_type::min() : writeTime;
+}
+
+#ifdef __linux__
+static void WatchDirectory( const std::string& directory )
+{
+	if( shaderWatchFd < 0 )
+	{
+		shaderWatchFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+		if( shaderWatchFd < 0 )
+			return;
+	}
+
+	for( const auto& watched : watchedDirectories )
+	{
+		if( watched.second == directory )
+			return;
+	}
+
+	//The shader compiler either rewrites the file or moves a temporary file over it
+	const int watchDescriptor = inotify_add_watch( shaderWatchFd, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO );
+	if( watchDescriptor >= 0 )
+		watchedDirectories.insert( { watchDescriptor, directory } );
+}
+
+static void GetChangedFiles( std::vector<std::string>* o_paths )
+{
+	if( shaderWatchFd < 0 )
+		return;
+
+	alignas( inotify_event ) char buffer[4096];
+	ssize_t length;
+	while( ( length = read( shaderWatchFd, buffer, sizeof( buffer ) ) ) > 0 )
+	{
+		for( ssize_t offset = 0; offset < length; )
+		{
+			const inotify_event* event = reinterpret_cast< const inotify_event* >( buffer + offset );
+			auto it = watchedDirectories.find( event->wd );
+			if( event->len > 0 && it != watchedDirectories.end() )
+				o_paths->push_back( ( std::filesystem::path( it->second ) / event->name ).string() );
+			offset += sizeof( inotify_event ) + event->len;
+		}
+	}
+}
+#else
+static void GetChangedFiles( std::vector<std::string>* o_paths )
+{
+	for( const auto& shader : shaderLibrary )
+	{
+		if( GetWriteTime( shader.first ) != shader.second.writeTime )
+			o_paths->push_back( shader.first );
+	}
+}
+#endif
+
+const R_HW::ShaderCode* LoadShader( const char* path )
+{
+	auto it = shaderLibrary.find( path );
+	if( it != shaderLibrary.end() )
+		return it->second.code.get();
+
+	LoadedShader shader;
+	shader.writeTime = GetWriteTime( path );
+	const std::vector<char> spirv = ReadShaderFile( path );
+	shader.code = std::make_unique<R_HW::ShaderCode>( R_HW::CreateShaderCode( spirv.data(), spirv.size() ) );
+	const R_HW::ShaderCode* loadedCode = shader.code.get();
+	shaderLibrary.insert( { path, std::move( shader ) } );
+
+#ifdef __linux__
+	WatchDirectory( std::filesystem::path( path ).parent_path().string() );
+#endif
+
+	return loadedCode;
+}
+
+std::vector<const R_HW::ShaderCode*> ReloadChangedShaderFiles()
+{
+	std::vector<std::string> changedPaths;
+	GetChangedFiles( &changedPaths );
+
+	std::vector<const R_HW::ShaderCode*> changedShaders;
+	for( const std::string& path : changedPaths )
+	{
+		auto it = shaderLibrary.find( path );
+		if( it == shaderLibrary.end() )
+			continue;
+
+		LoadedShader& shader = it->second;
+		shader.writeTime = GetWriteTime( path );
+
+		R_HW::ShaderCode code;
+		try
+		{
+			const std::vector<char> spirv = ReadShaderFile( path.c_str() );
+			code = R_HW::CreateShaderCode( spirv.data(), spirv.size() );
+		}
+		catch( const std::exception& )
+		{
+			//Usually read in the middle of its write, the end of the write sends another event
+			continue;
+		}
+
+		//Touched but not changed, or already reloaded by an earlier event
+		if( code.hash == shader.code->hash && code.words == shader.code->words )
+			continue;
+
+		//The pipelines made from the old module don't need it anymore
+		R_HW::DestroyShaderModule( *shader.code );
+		*shader.code = std::move( code );
+		changedShaders.push_back( shader.code.get() );
+	}
+
+	return changedShaders;
+}
+
+void DestroyShaderLibrary()
+{
+	shaderLibrary.clear();
+	R_HW::DestroyShaderModules();
+
+#ifdef __linux__
+	if( shaderWatchFd >= 0 )
+		close( shaderWatchFd );
+	shaderWatchFd = -1;
+	watchedDirectories.clear();
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "vertex_quantization.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+static int16_t QuantizeSnorm16( float value )
+{
+	return static_cast< int16_t >( glm::packSnorm1x16( value ) );
+}
+
+static float DequantizeSnorm16( int16_t value )
+{
+	return glm::unpackSnorm1x16( static_cast< uint16_t >( value ) );
+}
+
+static float SignNotZero( float value )
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+glm::vec2 OctahedralEncode( const glm::vec3& direction )
+{
+	const float l1Norm = std::abs( direction.x ) + std::abs( direction.y ) + std::abs( direction.z );
+	if( l1Norm == 0.0f )
+		return glm::vec2( 0.0f );
+	const glm::vec3 n = direction / l1Norm;
+	if( n.z >= 0.0f )
+		return glm::vec2( n.x, n.y );
+	//Fold the lower hemisphere over the diagonals
+	return glm::vec2( ( 1.0f - std::abs( n.y ) ) * SignNotZero( n.x ), ( 1.0f - std::abs( n.x ) ) * SignNotZero( n.y ) );
+}
+
+glm::vec3 OctahedralDecode( const glm::vec2& encoded )
+{
+	glm::vec3 n( encoded.x, encoded.y, 1.0f - std::abs( encoded.x ) - std::abs( encoded.y ) );
+	if( n.z < 0.0f )
+	{
+		const float x = n.x;
+		n.x = ( 1.0f - std::abs( n.y ) ) * SignNotZero( x );
+		n.y = ( 1.0f - std::abs( x ) ) * SignNotZero( n.y );
+	}
+	return glm::normalize( n );
+}
+
+void ComputePositionDequant( const glm::vec3* positions, size_t vertexCount, glm::vec3* o_offset, float* o_scale )
+{
+	assert( vertexCount > 0 );
+	glm::vec3 min = positions[0];
+	glm::vec3 max = positions[0];
+	for( size_t i = 1; i < vertexCount; ++i )
+	{
+		min = glm::min( min, positions[i] );
+		max = glm::max( max, positions[i] );
+	}
+
+	const glm::vec3 halfExtent = ( max - min ) * 0.5f;
+	*o_offset = ( min + max ) * 0.5f;
+	*o_scale = std::max( std::max( halfExtent.x, halfExtent.y ), std::max( halfExtent.z, 1e-6f ) );
+}
+
+void QuantizeVertices( const glm::vec3* positions, const glm::vec3* normals, const glm::vec3* tangents, const glm::vec3* colors, const glm::vec2* texCoords, size_t vertexCount,
+	const glm::vec3& dequantOffset, float dequantScale, QuantizedVertex* o_vertices )
+{
+	const float quantScale = 1.0f / dequantScale;
+	for( size_t i = 0; i < vertexCount; ++i )
+	{
+		QuantizedVertex& vertex = o_vertices[i];
+
+		const glm::vec3 position = ( positions[i] - dequantOffset ) * quantScale;
+		vertex.position[0] = QuantizeSnorm16( position.x );
+		vertex.position[1] = QuantizeSnorm16( position.y );
+		vertex.position[2] = QuantizeSnorm16( position.z );
+		vertex.position[3] = QuantizeSnorm16( 1.0f );
+
+		const glm::vec4 color = colors ? glm::vec4( colors[i], 1.0f ) : glm::vec4( 1.0f );
+		const uint32_t packedColor = glm::packUnorm4x8( color );
+		for( uint32_t c = 0; c < 4; ++c )
+			vertex.color[c] = static_cast< uint8_t >( packedColor >> ( c * 8 ) );
+
+		const glm::vec2 texCoord = texCoords ? texCoords[i] : glm::vec2( 0.0f );
+		vertex.texCoord[0] = glm::packHalf1x16( texCoord.x );
+		vertex.texCoord[1] = glm::packHalf1x16( texCoord.y );
+
+		const glm::vec2 normal = OctahedralEncode( normals ? normals[i] : glm::vec3( 0.0f, 0.0f, 1.0f ) );
+		vertex.normal[0] = QuantizeSnorm16( normal.x );
+		vertex.normal[1] = QuantizeSnorm16( normal.y );
+
+		const glm::vec2 tangent = OctahedralEncode( tangents ? tangents[i] : glm::vec3( 1.0f, 0.0f, 0.0f ) );
+		vertex.tangent[0] = QuantizeSnorm16( tangent.x );
+		vertex.tangent[1] = QuantizeSnorm16( tangent.y );
+	}
+}
+
+void DequantizeVertex( const QuantizedVertex& vertex, const glm::vec3& dequantOffset, float dequantScale, glm::vec3* o_position, glm::vec3* o_normal, glm::vec3* o_tangent, glm::vec3* o_color, glm::vec2* o_texCoord )
+{
+	*o_position = glm::vec3( DequantizeSnorm16( vertex.position[0] ), DequantizeSnorm16( vertex.position[1] ), DequantizeSnorm16( vertex.position[2] ) ) * dequantScale + dequantOffset;
+	*o_normal = OctahedralDecode( glm::vec2( DequantizeSnorm16( vertex.normal[0] ), DequantizeSnorm16( vertex.normal[1] ) ) );
+	*o_tangent = OctahedralDecode( glm::vec2( DequantizeSnorm16( vertex.tangent[0] ), DequantizeSnorm16( vertex.tangent[1] ) ) );
+	*o_color = glm::vec3( vertex.color[0], vertex.color[1], vertex.color[2] ) / 255.0f;
+	*o_texCoord = glm::vec2( glm::unpackHalf1x16( vertex.texCoord[0] ), glm::unpackHalf1x16( vertex.texCoord[1] ) );
+}
+
+glm::mat4 GetPositionDequantMatrix( const GfxModel& gfxModel )
+{
+	if( gfxModel.positionDequantScale == 0.0f )
+		return glm::mat4( 1.0f );
+	return glm::scale( glm::translate( glm::mat4( 1.0f ), gfxModel.positionDequantOffset ), glm::vec3( gfxModel.positionDequantScale ) );
+}
+
+glm::vec4 GetQuantizedBoundingSphere( const GfxModel& gfxModel )
+{
+	if( gfxModel.positionDequantScale == 0.0f )
+		return glm::vec4( gfxModel.boundingSphereCenter, gfxModel.boundingSphereRadius );
+	const float quantScale = 1.0f / gfxModel.positionDequantScale;
+	return glm::vec4( ( gfxModel.boundingSphereCenter - gfxModel.positionDequantOffset ) * quantScale, gfxModel.boundingSphereRadius * quantScale );
+}
\ No newline at end of file
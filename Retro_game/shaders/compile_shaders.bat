@@ -3,6 +3,7 @@ CALL :Compile retro_opaque.frag
 CALL :Compile skybox.vert
 CALL :Compile skybox.frag
 CALL :Compile textCompute.comp
+CALL :Compile culling.comp
 CALL :Compile text.vert
 CALL :Compile text.frag
 CALL :Compile shadows.vert
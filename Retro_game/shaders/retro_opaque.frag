@@ -1,9 +1,8 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 #include "shadersCommon/shadersCommon.h"
 
-#define ALBEDO_TEXTURE_ID 0
-
 layout(set = RENDERPASS_SET, binding = 0) uniform UniformBufferObject {
     mat4 view;
     mat4 proj;
@@ -17,11 +16,19 @@ layout(set = RENDERPASS_SET, binding = 1) uniform Light
 layout(set = RENDERPASS_SET, binding = 2) uniform texture2D bindlessTextures[BINDLESS_TEXTURES_MAX];
 layout(set = RENDERPASS_SET, binding = 3) uniform sampler samplers[SAMPLERS_MAX];
 layout(set = RENDERPASS_SET, binding = 4) uniform sampler2DShadow shadowSampler;
-
-layout(set = INSTANCE_SET, binding = 0) uniform InstanceMatrices {
-    mat4 model;
+//See material_table.h
+struct Material
+{
+	vec4 baseColorFactor;
 	uvec4 textureIndices;
-} instanceMat;
+	uint flags;
+	uint pad0;
+	uint pad1;
+	uint pad2;
+};
+layout(std430, set = RENDERPASS_SET, binding = 5) readonly buffer MaterialBuffer {
+	Material materials[];
+} materialBuffer;
 
 layout(location = 0) in VS_OUT
 {
@@ -32,6 +39,7 @@ layout(location = 0) in VS_OUT
 	vec3 bitangent_vs;
 	vec3 viewVector;
 	vec4 shadowCoord;
+	flat uint materialIndex;
 }fs_in;
 
 layout(location = 0) out vec4 outColor;
@@ -40,14 +48,18 @@ layout(push_constant) uniform PushConsts {
 	uint index;
 } pushConsts;
 
-vec4 Sample2D( uint textureId, vec2 textureCoordinate, uint samplerId )
+vec4 Sample2D( uint textureIndex, vec2 textureCoordinate, uint samplerId )
 {
-	return texture( sampler2D( bindlessTextures[instanceMat.textureIndices[textureId]], samplers[samplerId] ), textureCoordinate );
+	//Instances of one indirect draw can use different textures
+	return texture( sampler2D( bindlessTextures[nonuniformEXT( textureIndex )], samplers[samplerId] ), textureCoordinate );
 }
 
 void main() 
 {	
-	vec3 albedo = Sample2D( ALBEDO_TEXTURE_ID, fs_in.fragTexCoord, 0 ).rgb;
+	Material material = materialBuffer.materials[fs_in.materialIndex];
+	vec3 albedo = material.baseColorFactor.rgb;
+	if( (material.flags & MATERIAL_FLAG_ALBEDO_TEXTURE) != 0 )
+		albedo *= Sample2D( material.textureIndices[MATERIAL_TEXTURE_ALBEDO], fs_in.fragTexCoord, 0 ).rgb;
 
 	outColor = vec4(albedo, 1.0);
 }
\ No newline at end of file
@@ -13,16 +13,28 @@ layout(set = RENDERPASS_SET, binding = 1) uniform Light
 	vec3 location;
 	float intensity;
 }light;
-layout(set = INSTANCE_SET, binding = 0) uniform InstanceMatrices {
-    mat4 model;
-	uvec4 textureIndices;
-} instanceMat;
+struct InstanceData
+{
+	mat4 model;
+	uint materialIndex;
+	uint drawIndex;
+	uint castsShadow;
+	uint shadowDrawIndex;
+};
+layout(std430, set = INSTANCE_SET, binding = 0) readonly buffer InstanceBuffer {
+	InstanceData instances[];
+} instanceBuffer;
+//Written by the culling, indexed by the instance index of the draw
+layout(std430, set = INSTANCE_SET, binding = 1) readonly buffer VisibleInstances {
+	uint indices[];
+} visibleInstances;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
+//Quantized vertex, see vertex_quantization.h. The instance model matrix includes the position dequantization
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inColor;
 layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
+layout(location = 3) in vec2 inNormalOct;
+layout(location = 4) in vec2 inTangentOct;
 
 layout(location = 0) out VS_OUT
 {
@@ -33,16 +45,30 @@ layout(location = 0) out VS_OUT
 	vec3 bitangent_vs;
 	vec3 viewVector;
 	vec4 shadowCoord;
+	flat uint materialIndex;
 }vs_out;
 
+vec3 OctahedralDecode( vec2 encoded )
+{
+	vec3 n = vec3( encoded, 1.0 - abs( encoded.x ) - abs( encoded.y ) );
+	if( n.z < 0.0 )
+		n.xy = ( 1.0 - abs( n.yx ) ) * vec2( n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0 );
+	return normalize( n );
+}
+
 void main() {
-	mat4 model_view_matrix = sceneMat.view * instanceMat.model;
-	vs_out.viewVector = (model_view_matrix *  vec4(inPosition, 1.0)).xyz;
+	vec3 inNormal = OctahedralDecode( inNormalOct );
+	vec3 inTangent = OctahedralDecode( inTangentOct );
+	InstanceData instance = instanceBuffer.instances[visibleInstances.indices[gl_InstanceIndex]];
+	mat4 model_view_matrix = sceneMat.view * instance.model;
+	vs_out.viewVector = (model_view_matrix * vec4(inPosition.xyz, 1.0)).xyz;
     gl_Position = sceneMat.proj * vec4(vs_out.viewVector, 1.0);
-	vs_out.fragColor = inColor;
+	vs_out.fragColor = inColor.rgb;
 	vs_out.fragTexCoord = inTexCoord;
-	vs_out.normal_vs = ( model_view_matrix * vec4(inNormal,0.0)).xyz;
-	vs_out.tangent_vs = ( model_view_matrix * vec4(inTangent, 0.0)).xyz;
+	//The dequantization scale is uniform, renormalizing is enough
+	vs_out.normal_vs = normalize(( model_view_matrix * vec4(inNormal,0.0)).xyz);
+	vs_out.tangent_vs = normalize(( model_view_matrix * vec4(inTangent, 0.0)).xyz);
 	vs_out.tangent_vs = cross(vs_out.normal_vs, vs_out.tangent_vs);
-	vs_out.shadowCoord = (light.shadowMatrix * instanceMat.model) * vec4(inPosition, 1.0);
+	vs_out.shadowCoord = (light.shadowMatrix * instance.model) * vec4(inPosition.xyz, 1.0);
+	vs_out.materialIndex = instance.materialIndex;
 }
\ No newline at end of file
@@ -6,14 +6,26 @@ layout(set = RENDERPASS_SET, binding = 0) uniform SceneMatrices {
     mat4 view;
     mat4 proj;
 } sceneMatrices;
-layout(set = INSTANCE_SET, binding = 0) uniform InstanceMatrices {
-    mat4 model;
-	uint textureIndices[4];
-} instanceMat;
+struct InstanceData
+{
+	mat4 model;
+	uint materialIndex;
+	uint drawIndex;
+	uint castsShadow;
+	uint shadowDrawIndex;
+};
+layout(std430, set = INSTANCE_SET, binding = 0) readonly buffer InstanceBuffer {
+	InstanceData instances[];
+} instanceBuffer;
+//Written by the culling, indexed by the instance index of the draw
+layout(std430, set = INSTANCE_SET, binding = 1) readonly buffer VisibleInstances {
+	uint indices[];
+} visibleInstances;
 
-layout (location = 0) in vec3 position;
+//Quantized position, the instance model matrix includes the dequantization
+layout (location = 0) in vec4 position;
 
 void main(void)
 {
-    gl_Position = sceneMatrices.proj * sceneMatrices.view * instanceMat.model * vec4(position, 1.0f);
+    gl_Position = sceneMatrices.proj * sceneMatrices.view * instanceBuffer.instances[visibleInstances.indices[gl_InstanceIndex]].model * vec4(position.xyz, 1.0f);
 }
\ No newline at end of file
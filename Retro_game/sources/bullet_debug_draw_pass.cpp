@@ -1,6 +1,6 @@
 #include "bullet_debug_draw_pass.h"
 #include "..\shaders\shadersCommon.h"
-#include "file_system.h"
+#include "shader_library.h"
 #include "retro_physics.h"
 #include "renderer.h"
 
@@ -37,8 +37,8 @@ R_HW::GpuPipelineStateDesc GetBtDebugPipelineState()
 	GetBindingDescription( VIBindings_PosColUV, &gpuPipelineState.viState );
 
 	gpuPipelineState.shaders = {
-		{ FS::readFile( "shaders/line_draw.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
-		{ FS::readFile( "shaders/line_draw.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
+		{ LoadShader( "shaders/line_draw.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
+		{ LoadShader( "shaders/line_draw.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
 
 	gpuPipelineState.rasterizationState.backFaceCulling = false;
 	gpuPipelineState.rasterizationState.depthBiased = false;
@@ -83,7 +83,7 @@ void BtDebugRecordDrawCommandsBuffer( R_HW::GfxCommandBuffer graphicsCommandBuff
 
 	CmdEndRenderPass( graphicsCommandBuffer );
 
-	g_btDebugDrawState.currentFrameIndex = (g_btDebugDrawState.currentFrameIndex + 1) % SIMULTANEOUS_FRAMES;
+	g_btDebugDrawState.currentFrameIndex = (g_btDebugDrawState.currentFrameIndex + 1) % g_gfx.framesInFlight;
 	g_btDebugDrawState.vertexOffset = 0;
 	g_btDebugDrawState.indexOffset = 0;
 }
@@ -0,0 +1,34 @@
+#include "culling_pass.h"
+#include "../shaders/shadersCommon.h"
+
+#include "shader_library.h"
+
+constexpr uint32_t CULLING_GROUP_SIZE = 64;
+
+R_HW::GpuPipelineLayout GetCullingPipelineLayout()
+{
+	return R_HW::GpuPipelineLayout();
+}
+
+R_HW::GpuPipelineStateDesc GetCullingPipelineState()
+{
+	R_HW::GpuPipelineStateDesc gpuPipelineState = {};
+	gpuPipelineState.shaders = {
+		{ LoadShader( "shaders/culling.comp.spv" ), "main", R_HW::GFX_SHADER_STAGE_COMPUTE_BIT } };
+
+	return gpuPipelineState;
+}
+
+void CullingRecordDrawCommandsBuffer( R_HW::GfxCommandBuffer graphicsCommandBuffer, const FG::TaskInputData& inputData )
+{
+	const SceneFrameData* frameData = static_cast< const SceneFrameData* >( inputData.userData );
+	const Technique* technique = inputData.technique;
+	if( frameData->instanceCount == 0 )
+		return;
+
+	R_HW::CmdBeginLabel( graphicsCommandBuffer, "Culling", glm::vec4( 0.2f, 0.6f, 0.2f, 1.0f ) );
+	R_HW::CmdBindPipeline( graphicsCommandBuffer, R_HW::GfxPipelineBindPoint::COMPUTE, technique->pipeline );
+	R_HW::CmdBindDescriptorTable( graphicsCommandBuffer, R_HW::GfxPipelineBindPoint::COMPUTE, technique->pipelineLayout, RENDERPASS_SET, technique->descriptor_sets[RENDERPASS_SET].hw_descriptorSets[inputData.currentFrame] );
+	R_HW::CmdDispatch( graphicsCommandBuffer, ( frameData->instanceCount + CULLING_GROUP_SIZE - 1 ) / CULLING_GROUP_SIZE, 1, 1 );
+	R_HW::CmdEndLabel( graphicsCommandBuffer );
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "vk_globals.h"
+
+#include "scene_frame_data.h"
+#include "material.h"
+#include "frame_graph.h"
+#include "frustum.h"
+
+#include "glm/vec4.hpp"
+
+//Matches VkDrawIndexedIndirectCommand, followed by the model space bounding sphere used by the culling shader
+struct GpuDrawCommand
+{
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t firstInstance;
+	uint32_t pad[3];
+	glm::vec4 boundingSphere;
+};
+
+struct CullingUniform
+{
+	glm::vec4 cameraPlanes[FRUSTUM_PLANES_COUNT];
+	uint32_t instanceCount;
+};
+
+R_HW::GpuPipelineLayout GetCullingPipelineLayout();
+R_HW::GpuPipelineStateDesc GetCullingPipelineState();
+
+void CullingRecordDrawCommandsBuffer( R_HW::GfxCommandBuffer graphicsCommandBuffer, const FG::TaskInputData& inputData );
\ No newline at end of file
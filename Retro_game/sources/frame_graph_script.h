@@ -7,6 +7,7 @@
 #include "skybox.h"
 #include "text_overlay.h"
 #include "bullet_debug_draw_pass.h"
+#include "culling_pass.h"
 
 #include "../shaders/shadersCommon.h"
 
@@ -21,6 +22,12 @@ enum class eTechniqueDataEntryName
 	SCENE_DATA,
 	LIGHT_DATA,
 	SKYBOX_DATA,
+	CULLING_DATA,
+	DRAW_COMMANDS,
+	SHADOW_DRAW_COMMANDS,
+	VISIBLE_INSTANCES,
+	SHADOW_VISIBLE_INSTANCES,
+	MATERIALS,
 
 	SAMPLERS,
 
@@ -48,7 +55,7 @@ enum class eTechniqueDataEntryImageName
 // Render pass and techniques are as one here, use that idea to define them.
 // Have a list of descriptor sets instead of instance and pass to keep things generic. Check the binding point to know to which (instance or pass) it belongs.
 
-const uint32_t maxModelsCount = 32;
+const uint32_t maxInstancesCount = 1024;
 constexpr VkExtent2D RT_EXTENT_SHADOW = { 1024, 1024 };
 
 inline void SetBuffers( GpuInputData* buffers, eTechniqueDataEntryName id, R_HW::GpuBuffer* input, uint32_t count )
@@ -77,8 +84,38 @@ inline R_HW::GfxImageSamplerCombined* GetImage( const GpuInputData* buffers, eTe
 }
 
 
+static FG::RenderPassCreationData FG_Culling_CreateGraphNode( FG::fg_handle_t cullingData, FG::fg_handle_t instanceData, FG::fg_handle_t drawCommands, FG::fg_handle_t visibleInstances,
+	FG::fg_handle_t shadowDrawCommands, FG::fg_handle_t shadowVisibleInstances )
+{
+	FG::DescriptorTableDesc cullingPassSet =
+	{
+		RENDERPASS_SET,
+		{
+			{ cullingData, 0, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_COMPUTE_BIT },
+			{ instanceData, 1, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_COMPUTE_BIT },
+			{ drawCommands, 2, R_HW::eDescriptorAccess::WRITE, R_HW::GFX_SHADER_STAGE_COMPUTE_BIT },
+			{ visibleInstances, 3, R_HW::eDescriptorAccess::WRITE, R_HW::GFX_SHADER_STAGE_COMPUTE_BIT },
+			{ shadowDrawCommands, 4, R_HW::eDescriptorAccess::WRITE, R_HW::GFX_SHADER_STAGE_COMPUTE_BIT },
+			{ shadowVisibleInstances, 5, R_HW::eDescriptorAccess::WRITE, R_HW::GFX_SHADER_STAGE_COMPUTE_BIT },
+		}
+	};
+
+	FG::RenderPassCreationData renderPassCreationData;
+	renderPassCreationData.name = "culling_pass";
+
+	FG::FrameGraphNode* frameGraphNode = &renderPassCreationData.frame_graph_node;
+	frameGraphNode->RecordDrawCommands = CullingRecordDrawCommandsBuffer;
+	frameGraphNode->isCompute = true;
+
+	frameGraphNode->gpuPipelineLayout = GetCullingPipelineLayout();
+	frameGraphNode->gpuPipelineStateDesc = GetCullingPipelineState();
+	frameGraphNode->descriptorSets.push_back( cullingPassSet );
+
+	return renderPassCreationData;
+}
+
 static FG::RenderPassCreationData FG_Opaque_CreateGraphNode( FG::fg_handle_t sceneColor, FG::fg_handle_t sceneDepth, FG::fg_handle_t bindlessTextures, FG::fg_handle_t shadowMap, FG::fg_handle_t shadowData,
-	FG::fg_handle_t instanceData, FG::fg_handle_t lightData, FG::fg_handle_t sceneData, FG::fg_handle_t samplers )
+	FG::fg_handle_t instanceData, FG::fg_handle_t visibleInstances, FG::fg_handle_t drawCommands, FG::fg_handle_t lightData, FG::fg_handle_t sceneData, FG::fg_handle_t samplers, FG::fg_handle_t materials )
 {
 	FG::DescriptorTableDesc geoPassSetDesc =
 	{
@@ -89,6 +126,7 @@ static FG::RenderPassCreationData FG_Opaque_CreateGraphNode( FG::fg_handle_t sce
 			{ bindlessTextures, 2, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT },
 			{ samplers, 3, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT | R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
 			{ shadowMap, 4, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT },
+			{ materials, 5, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT },
 		}
 	};
 
@@ -96,7 +134,8 @@ static FG::RenderPassCreationData FG_Opaque_CreateGraphNode( FG::fg_handle_t sce
 	{
 		INSTANCE_SET,
 		{
-			{ instanceData, 0, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_VERTEX_BIT | R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT }
+			{ instanceData, 0, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
+			{ visibleInstances, 1, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_VERTEX_BIT }
 		}
 	};
 
@@ -113,12 +152,13 @@ static FG::RenderPassCreationData FG_Opaque_CreateGraphNode( FG::fg_handle_t sce
 	frameGraphNode->renderTargetRefs.push_back( { sceneColor, FG::FG_RENDERTARGET_REF_CLEAR_BIT } );
 	frameGraphNode->renderTargetRefs.push_back( { sceneDepth, FG::FG_RENDERTARGET_REF_CLEAR_BIT } );
 	frameGraphNode->renderTargetRefs.push_back( { shadowMap, FG::FG_RENDERTARGET_REF_READ_BIT } );
+	frameGraphNode->indirectBufferRefs.push_back( drawCommands );
 
 	return renderPassCreationData;
 }
 
 
-static FG::RenderPassCreationData FG_Shadow_CreateGraphNode( FG::fg_handle_t shadowMap, FG::fg_handle_t shadowData, FG::fg_handle_t instanceData )
+static FG::RenderPassCreationData FG_Shadow_CreateGraphNode( FG::fg_handle_t shadowMap, FG::fg_handle_t shadowData, FG::fg_handle_t instanceData, FG::fg_handle_t visibleInstances, FG::fg_handle_t drawCommands )
 {
 	FG::DescriptorTableDesc shadowPassSet =
 	{
@@ -132,7 +172,8 @@ static FG::RenderPassCreationData FG_Shadow_CreateGraphNode( FG::fg_handle_t sha
 	{
 		INSTANCE_SET,
 		{
-			{ instanceData, 0, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_VERTEX_BIT }
+			{ instanceData, 0, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
+			{ visibleInstances, 1, R_HW::eDescriptorAccess::READ, R_HW::GFX_SHADER_STAGE_VERTEX_BIT }
 		}
 	};
 	FG::RenderPassCreationData renderPassCreationData;
@@ -146,6 +187,7 @@ static FG::RenderPassCreationData FG_Shadow_CreateGraphNode( FG::fg_handle_t sha
 	frameGraphNode->descriptorSets.push_back( shadowPassSet );
 	frameGraphNode->descriptorSets.push_back( shadowInstanceSet );
 	frameGraphNode->renderTargetRefs.push_back( { shadowMap, FG::FG_RENDERTARGET_REF_CLEAR_BIT } );
+	frameGraphNode->indirectBufferRefs.push_back( drawCommands );
 
 	return renderPassCreationData;
 }
@@ -242,9 +284,11 @@ public:
 struct RetroFrameGraphParams
 {
 	std::array< GpuInputData, SIMULTANEOUS_FRAMES>* _pInputBuffers;
-	VkDescriptorPool _descriptorPool;
 
 	bool d_btDrawDebug;
+
+	//Set by InitializeScript
+	FG::fg_handle_t _swapchainImage_h;
 };
 
 FG::FrameGraph InitializeScript( const R_HW::Swapchain* swapchain, void* user_params )
@@ -255,40 +299,54 @@ FG::FrameGraph InitializeScript( const R_HW::Swapchain* swapchain, void* user_pa
 	VkExtent2D swapchainExtent = swapchain->extent;
 
 	ResourceGatherer resourceGatherer;
-	FG::fg_handle_t instance_data_h = resourceGatherer.AddResource( CREATE_BUFFER_DYNAMIC( eTechniqueDataEntryName::INSTANCE_DATA, sizeof( GfxInstanceData ), maxModelsCount ) );
+	FG::fg_handle_t instance_data_h = resourceGatherer.AddResource( CREATE_BUFFER_STORAGE( eTechniqueDataEntryName::INSTANCE_DATA, sizeof( GfxInstanceData ), maxInstancesCount ) );
 	FG::fg_handle_t scene_data_h = resourceGatherer.AddResource( CREATE_BUFFER( eTechniqueDataEntryName::SCENE_DATA, sizeof( SceneMatricesUniform ) ) );
 	FG::fg_handle_t shadow_data_h = resourceGatherer.AddResource( CREATE_BUFFER( eTechniqueDataEntryName::SHADOW_DATA, sizeof( SceneMatricesUniform ) ) );
 	FG::fg_handle_t light_data_h = resourceGatherer.AddResource( CREATE_BUFFER( eTechniqueDataEntryName::LIGHT_DATA, sizeof( LightUniform ) ) );
 	FG::fg_handle_t skybox_data_h = resourceGatherer.AddResource( CREATE_BUFFER( eTechniqueDataEntryName::SKYBOX_DATA, sizeof( SkyboxUniformBufferObject ) ) );
+	FG::fg_handle_t culling_data_h = resourceGatherer.AddResource( CREATE_BUFFER( eTechniqueDataEntryName::CULLING_DATA, sizeof( CullingUniform ) ) );
+	FG::fg_handle_t draw_commands_h = resourceGatherer.AddResource( CREATE_BUFFER_INDIRECT( eTechniqueDataEntryName::DRAW_COMMANDS, sizeof( GpuDrawCommand ), maxInstancesCount ) );
+	FG::fg_handle_t shadow_draw_commands_h = resourceGatherer.AddResource( CREATE_BUFFER_INDIRECT( eTechniqueDataEntryName::SHADOW_DRAW_COMMANDS, sizeof( GpuDrawCommand ), maxInstancesCount ) );
+	FG::fg_handle_t visible_instances_h = resourceGatherer.AddResource( CREATE_BUFFER_STORAGE( eTechniqueDataEntryName::VISIBLE_INSTANCES, sizeof( uint32_t ), maxInstancesCount ) );
+	FG::fg_handle_t shadow_visible_instances_h = resourceGatherer.AddResource( CREATE_BUFFER_STORAGE( eTechniqueDataEntryName::SHADOW_VISIBLE_INSTANCES, sizeof( uint32_t ), maxInstancesCount ) );
 
 	//TODO: Remove external resources that don't need to be managed
-	FG::fg_handle_t bindless_textures_h = resourceGatherer.AddResource( CREATE_IMAGE_EXTERNAL( eTechniqueDataEntryImageName::BINDLESS_TEXTURES, BINDLESS_TEXTURES_MAX ) );
+	FG::fg_handle_t bindless_textures_h = resourceGatherer.AddResource( CREATE_IMAGE_BINDLESS( eTechniqueDataEntryImageName::BINDLESS_TEXTURES, BINDLESS_TEXTURES_MAX ) );
 	FG::fg_handle_t text_texture_h = resourceGatherer.AddResource( CREATE_IMAGE_SAMPLER_EXTERNAL( eTechniqueDataEntryImageName::TEXT, 1 ) );
 	FG::fg_handle_t skybox_texture_h = resourceGatherer.AddResource( CREATE_IMAGE_SAMPLER_EXTERNAL( eTechniqueDataEntryImageName::SKYBOX, 1 ) );
 	FG::fg_handle_t samplers_h = resourceGatherer.AddResource( CREATE_SAMPLER_EXTERNAL( eTechniqueDataEntryName::SAMPLERS, SAMPLERS_MAX ) );
+	FG::fg_handle_t materials_h = resourceGatherer.AddResource( CREATE_BUFFER_STORAGE_EXTERNAL( eTechniqueDataEntryName::MATERIALS ) );
 
 	//TODO: I shouldn't have to specify usage such as "sampled" should be implicit
-	FG::fg_handle_t scene_depth_h = resourceGatherer.AddResource( CREATE_IMAGE_DEPTH( eTechniqueDataEntryImageName::SCENE_DEPTH, R_HW::GfxFormat::D32_SFLOAT, swapchainExtent, 0 ) );
+	FG::fg_handle_t scene_depth_h = resourceGatherer.AddResource( CREATE_IMAGE_DEPTH_SWAPCHAIN_SIZED( eTechniqueDataEntryImageName::SCENE_DEPTH, R_HW::GfxFormat::D32_SFLOAT, swapchainExtent, 0 ) );
 	FG::fg_handle_t shadow_map_h = resourceGatherer.AddResource( CREATE_IMAGE_DEPTH_SAMPLER( eTechniqueDataEntryImageName::SHADOW_MAP, R_HW::GfxFormat::D32_SFLOAT, RT_EXTENT_SHADOW, R_HW::GfxImageUsageFlagBits::SAMPLED, eSamplers::Shadow ) );
 	FG::fg_handle_t scene_color_h = resourceGatherer.AddResource( CREATE_IMAGE_COLOR( eTechniqueDataEntryImageName::SCENE_COLOR, swapchainFormat, swapchainExtent, 0, FG::eDataEntryFlags::EXTERNAL ) );
 
 	//Setup passes
 	std::vector<FG::RenderPassCreationData> rpCreationData;
-	rpCreationData.push_back( FG_Shadow_CreateGraphNode( shadow_map_h, shadow_data_h, instance_data_h ) );
-	rpCreationData.push_back( FG_Opaque_CreateGraphNode( scene_color_h, scene_depth_h, bindless_textures_h, shadow_map_h, shadow_data_h, instance_data_h, light_data_h, scene_data_h, samplers_h ) );
+	rpCreationData.push_back( FG_Culling_CreateGraphNode( culling_data_h, instance_data_h, draw_commands_h, visible_instances_h, shadow_draw_commands_h, shadow_visible_instances_h ) );
+	rpCreationData.push_back( FG_Shadow_CreateGraphNode( shadow_map_h, shadow_data_h, instance_data_h, shadow_visible_instances_h, shadow_draw_commands_h ) );
+	rpCreationData.push_back( FG_Opaque_CreateGraphNode( scene_color_h, scene_depth_h, bindless_textures_h, shadow_map_h, shadow_data_h, instance_data_h, visible_instances_h, draw_commands_h, light_data_h, scene_data_h, samplers_h, materials_h ) );
 	rpCreationData.push_back( FG_Skybox_CreateGraphNode( scene_color_h, scene_depth_h, skybox_texture_h, skybox_data_h ) );
 	if( params->d_btDrawDebug )
 		rpCreationData.push_back( FG_BtDebug_CreateGraphNode( scene_color_h, scene_data_h ) );
 	rpCreationData.push_back( FG_TextOverlay_CreateGraphNode( scene_color_h, text_texture_h ) );
 
 	FG::FrameGraph fg = FG::CreateGraph( &rpCreationData, &resourceGatherer.m_resources );
-	for( uint32_t frameIndex = 0; frameIndex < SIMULTANEOUS_FRAMES; ++frameIndex )
-		fg.AddExternalImage( scene_color_h, frameIndex, swapchain->images[frameIndex] );
+	params->_swapchainImage_h = scene_color_h;
+	fg.SetSwapchainImages( scene_color_h, swapchain->images );
 	FG::CreateRenderPasses( &fg );
 	FG::AddResourcesToInputBuffer( &fg, *params->_pInputBuffers );
-	FG::CreateTechniques( &fg, params->_descriptorPool );
+	FG::CreateTechniques( &fg );
 	fg.dummyImage = FG::CreateDummyImage();
 	FG::UpdateTechniqueDescriptorSets( &fg, *params->_pInputBuffers, fg.dummyImage );
 
 	return fg;
 }
+
+void ResizeScript( FG::FrameGraph* fg, const R_HW::Swapchain* swapchain, void* user_params, FG::RetiredResources* o_retired )
+{
+	RetroFrameGraphParams* params = reinterpret_cast< RetroFrameGraphParams* >(user_params);
+	fg->SetSwapchainImages( params->_swapchainImage_h, swapchain->images );
+	FG::Resize( fg, swapchain->extent, *params->_pInputBuffers, o_retired );
+}
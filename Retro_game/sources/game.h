@@ -9,6 +9,7 @@
 #include "gfx_heaps_batched_allocator.h"
 #include "retro_physics.h"
 #include "glTF_loader.h"
+#include "vertex_quantization.h"
 
 #include <glm/glm.hpp>
 #include <glm/vec4.hpp>
@@ -42,6 +43,8 @@ namespace Scene3DGame
 	float frameDeltaTime = 0.0f;
 
 	R_HW::GfxHeap gfx_heap_device_local;
+	GeometryPool geometryPool;
+	MaterialTable materialTable;
 
 	phs::CollisionMesh groundPlaneCollisionMesh;
 
@@ -116,6 +119,15 @@ namespace Scene3DGame
 		shipSceneInstance.location -= PitchVector() * (frameDeltaTime / 1000.0f) * movementSpeed;
 	}
 
+	void PresentModeCallback( const std::string* params, uint32_t paramsCount )
+	{
+		R_HW::GfxPresentMode presentMode;
+		if( paramsCount > 1 && ParsePresentMode( params[1].c_str(), &presentMode ) )
+			SetPresentMode( presentMode );
+		else
+			std::cout << "present_mode fifo|fifo_relaxed|mailbox|immediate" << std::endl;
+	}
+
 	void PhsDrawDebugCallback(const std::string* params, uint32_t paramsCount)
 	{
 		if( paramsCount > 1 )
@@ -134,14 +146,19 @@ namespace Scene3DGame
 	}
 
 	void mainLoop() {
+		//Waits for the GPU and the swapchain first so the input and the simulation are as late as possible
+		BeginFrame( current_frame );
+
 		size_t currentTime = WH::GetTime();
 		static size_t lastTime = currentTime;
 			
 		frameDeltaTime = static_cast<float>(currentTime - lastTime);
 		lastTime = currentTime;
 
-		//Input
+		//Input, the messages received during the wait are processed first
+		WH::ProcessMessages();
 		IH::DoCommands();
+		MarkInputSampled( current_frame );
 
 		//Update objects
 		TickUpdate(frameDeltaTime);
@@ -156,12 +173,12 @@ namespace Scene3DGame
 
 		DrawFrame( current_frame, &cameraSceneInstance, &g_light, drawList);
 
-		current_frame = (++current_frame) % SIMULTANEOUS_FRAMES;
+		current_frame = (++current_frame) % g_gfx.framesInFlight;
 	}
 
-	void CreateGfxAsset(const GfxModel* modelAsset, uint32_t albedoIndex, GfxAsset* o_renderable)
+	void CreateGfxAsset(const GfxModel* modelAsset, uint32_t materialIndex, GfxAsset* o_renderable)
 	{
-		*o_renderable = { modelAsset, { albedoIndex } };
+		*o_renderable = { modelAsset, materialIndex };
 	}
 
 	SceneInstance* GetInstancedAssetSlot( const char* name, GfxAsset* asset )
@@ -177,6 +194,11 @@ namespace Scene3DGame
 		return RegisterBindlessTexture( &bindlessTexturesState, image );
 	}
 
+	uint32_t RegisterMaterial( const GpuMaterial& material )
+	{
+		return AddMaterial( &materialTable, material );
+	}
+
 	void Init()
 	{
 		//Input callbacks
@@ -200,6 +222,7 @@ namespace Scene3DGame
 		ConCom::Init();
 		ConCom::RegisterCommand( "light", &LightCallback );
 		ConCom::RegisterCommand( "phs_draw_debug", &PhsDrawDebugCallback );
+		ConCom::RegisterCommand( "present_mode", &PresentModeCallback );
 
 		//Objects update callbacks
 		RegisterTickFunction( &TickObjectCallback );
@@ -207,6 +230,8 @@ namespace Scene3DGame
 		gfx_heap_device_local = R_HW::create_gfx_heap( 16 * 1024 * 1024, R_HW::GFX_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
 		GfxHeaps_BatchedAllocator gfx_device_local_mem_allocator( &gfx_heap_device_local );
 		gfx_device_local_mem_allocator.Prepare();
+		CreateInterleavedGeometryPool( VIBindingsQuantizedModel, 256 * 1024, 1024 * 1024, &geometryPool );
+		CreateMaterialTable( 1024, &materialTable );
 
 		//LoadAssets
 		R_HW::GfxImage* skyboxTexture = AL::LoadCubeTexture( "SkyboxTexture", "assets/mountaincube.ktx", &gfx_device_local_mem_allocator );
@@ -215,20 +240,25 @@ namespace Scene3DGame
 		R_HW::GfxImage* BadHelicopterAlbedoTexture = AL::LoadTexture( "BadHelicopterAlbedoTexture", "assets/Tructext.png", &gfx_device_local_mem_allocator );
 
 		const char* groundFileName = "assets/ground.glb";
-		GfxModel* cubeModelAsset = AL::LoadglTf3DModel( "Cube", "assets/horrible_helicopter.glb", &gfx_device_local_mem_allocator );
+		GfxModel* cubeModelAsset = AL::LoadglTf3DModel( "Cube", "assets/horrible_helicopter.glb", &gfx_device_local_mem_allocator, &geometryPool );
 
 		glTF_L::LoadCollisionData( groundFileName, &groundPlaneCollisionMesh.vertices, &groundPlaneCollisionMesh.indices );
 
-		glTF_L::LoadScene( "assets/scene.gltf", AL::AL_GetModelSlot, AL::AL_GetAssetSlot, GetInstancedAssetSlot, LoadTexture, &gfx_device_local_mem_allocator, &gfx_device_local_mem_allocator );
+		MeshOptimizationStats sceneMeshStats = {};
+		glTF_L::LoadScene( "assets/scene.gltf", AL::AL_GetModelSlot, AL::AL_GetAssetSlot, GetInstancedAssetSlot, LoadTexture, RegisterMaterial, &gfx_device_local_mem_allocator, &gfx_device_local_mem_allocator, &geometryPool, true, true, &sceneMeshStats );
+		std::cout << "Scene meshes: " << sceneMeshStats.vertexCountBefore << " -> " << sceneMeshStats.vertexCountAfter << " vertices, ACMR "
+			<< sceneMeshStats.acmrBefore << " -> " << sceneMeshStats.acmrAfter << std::endl;
 
 		uint32_t albedoIndex = RegisterBindlessTexture( &bindlessTexturesState, albedoTexture );
 		uint32_t badHelicopterTextIndex = RegisterBindlessTexture( &bindlessTexturesState, BadHelicopterAlbedoTexture );
+		const uint32_t badHelicopterMaterialIndex = AddMaterial( &materialTable, CreateTexturedMaterial( badHelicopterTextIndex ) );
 
+		UploadMaterialTable( &materialTable, &gfx_device_local_mem_allocator );
 		gfx_device_local_mem_allocator.Commit();
 
-		CreateGfxAsset( cubeModelAsset, badHelicopterTextIndex, &cubeRenderable );
+		CreateGfxAsset( cubeModelAsset, badHelicopterMaterialIndex, &cubeRenderable );
 
-		CompileScene( &bindlessTexturesState, skyboxTexture );
+		CompileScene( &bindlessTexturesState, &materialTable, skyboxTexture );
 
 		shipSceneInstance = { glm::vec3( 0.0f, 1.0f, 2.0f ), glm::angleAxis( glm::radians( 0.0f ), glm::vec3{0.0f, 1.0f, 0.0f} ), 0.5f };
 		cameraSceneInstance = { glm::vec3( 0.0f, 1.0f, -6.0f ), glm::angleAxis( glm::radians( 0.0f ), glm::vec3{0.0f, 1.0f, 0.0f} ), 1.0f, &shipSceneInstance };
@@ -243,7 +273,15 @@ namespace Scene3DGame
 		IH::CleanupInputs();
 		ConCom::Cleanup();
 
+		//The slots can't point to the images destroyed with the asset library
+		for( uint32_t i = 0; i < bindlessTexturesState._bindlessTexturesCount; ++i )
+		{
+			if( bindlessTexturesState._bindlessTextures[i].image )
+				UnregisterBindlessTexture( &bindlessTexturesState, i );
+		}
 		AL::Cleanup();
+		Destroy( &geometryPool );
+		Destroy( &materialTable );
 		destroy( &gfx_heap_device_local );
 	}
 }
\ No newline at end of file
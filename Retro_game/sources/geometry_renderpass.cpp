@@ -1,8 +1,10 @@
 #include "geometry_renderpass.h"
 #include "..\shaders\shadersCommon.h"
 
-#include "file_system.h"
+#include "shader_library.h"
 #include "renderer.h"
+#include "culling_pass.h"
+#include "vertex_quantization.h"
 
 R_HW::GpuPipelineLayout GetGeoPipelineLayout()
 {
@@ -20,11 +22,11 @@ R_HW::GpuPipelineLayout GetGeoPipelineLayout()
 R_HW::GpuPipelineStateDesc GetGeoPipelineState()
 {
 	R_HW::GpuPipelineStateDesc gpuPipelineState = {};
-	GetBindingDescription( VIBindingsFullModel, &gpuPipelineState.viState );
+	GetInterleavedBindingDescription( VIBindingsQuantizedModel, VIBindingsQuantizedModel, &gpuPipelineState.viState );
 
 	gpuPipelineState.shaders = {
-		{ FS::readFile( "shaders/retro_opaque.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
-		{ FS::readFile( "shaders/retro_opaque.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
+		{ LoadShader( "shaders/retro_opaque.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
+		{ LoadShader( "shaders/retro_opaque.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
 
 	gpuPipelineState.rasterizationState.backFaceCulling = true;
 	gpuPipelineState.rasterizationState.depthBiased = false;
@@ -55,28 +57,33 @@ void CmdEndGeometryRenderPass(VkCommandBuffer vkCommandBuffer)
 	R_HW::CmdEndLabel( vkCommandBuffer );
 }
 
-static void CmdDrawModelAsset( VkCommandBuffer commandBuffer, const DrawListEntry* drawModel, uint32_t currentFrame, const Technique* technique )
+static void CmdDrawModelAsset( VkCommandBuffer commandBuffer, const DrawBatch* drawBatch, const R_HW::GpuBuffer* drawCommands, uint32_t drawIndex, uint32_t drawCount, GeometryBindState* bindState )
 {	
 	//TODO: could do like the VIB, query a texture of X from an array using an enum index
 	//Have a list of all required paremeters for this pass.
 	//vkCmdPushConstants( commandBuffer, technique->pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof( uint32_t ), &drawModel->asset->albedoIndex );
 
-	const SceneInstanceSet* instanceSet = &drawModel->descriptorSet;
-	const GfxModel* modelAsset = drawModel->asset->modelAsset;
-	R_HW::CmdBindRootDescriptor(commandBuffer, R_HW::GfxPipelineBindPoint::GRAPHICS, technique->pipelineLayout, INSTANCE_SET,
-		technique->descriptor_sets[INSTANCE_SET].hw_descriptorSets[currentFrame], instanceSet->geometryBufferOffsets );
-
-	CmdDrawIndexed(commandBuffer, VIBindingsFullModel, *modelAsset);
+	const GfxModel* modelAsset = drawBatch->asset->modelAsset;
+	CmdDrawIndexedIndirect( commandBuffer, VIBindingsQuantizedModel, *modelAsset, *drawCommands, drawIndex * sizeof( GpuDrawCommand ), drawCount, sizeof( GpuDrawCommand ), bindState );
 }
 
 void GeometryRecordDrawCommandsBuffer( R_HW::GfxCommandBuffer graphicsCommandBuffer, const FG::TaskInputData& inputData )
 {
 	const SceneFrameData* frameData = static_cast< const SceneFrameData* >( inputData.userData );
-	CmdBeginGeometryRenderPass( graphicsCommandBuffer, inputData.currentFrame, inputData.renderpass, inputData.technique );
-	for (size_t i = 0; i < frameData->drawList.size(); ++i)
+	const Technique* technique = inputData.technique;
+	CmdBeginGeometryRenderPass( graphicsCommandBuffer, inputData.currentFrame, inputData.renderpass, technique );
+	R_HW::CmdBindDescriptorTable( graphicsCommandBuffer, R_HW::GfxPipelineBindPoint::GRAPHICS, technique->pipelineLayout, INSTANCE_SET, technique->descriptor_sets[INSTANCE_SET].hw_descriptorSets[inputData.currentFrame] );
+	//Batches are sorted, consecutive batches sharing their geometry buffers are drawn with one indirect draw
+	GeometryBindState bindState;
+	const std::vector<DrawBatch>& drawBatches = frameData->drawBatches;
+	size_t runStart = 0;
+	while( runStart < drawBatches.size() )
 	{
-		const DrawListEntry* drawModel = &frameData->drawList[i];
-		CmdDrawModelAsset(graphicsCommandBuffer, drawModel, inputData.currentFrame, inputData.technique);
+		size_t runEnd = runStart + 1;
+		while( runEnd < drawBatches.size() && SharesGeometryBuffers( *drawBatches[runStart].asset->modelAsset, *drawBatches[runEnd].asset->modelAsset ) )
+			++runEnd;
+		CmdDrawModelAsset( graphicsCommandBuffer, &drawBatches[runStart], frameData->drawCommands, static_cast< uint32_t >( runStart ), static_cast< uint32_t >( runEnd - runStart ), &bindState );
+		runStart = runEnd;
 	}
 	CmdEndGeometryRenderPass(graphicsCommandBuffer);
 }
@@ -9,7 +9,14 @@
 
 struct GfxInstanceData {
 	glm::mat4 model;
-	uint32_t texturesIndexes[4];
+	//In the material table, see material_table.h
+	uint32_t materialIndex;
+	//Draw command of the batch the instance belongs to
+	uint32_t drawIndex;
+	//Decided on the CPU, see CullDrawList
+	uint32_t castsShadow;
+	//Draw command of the shadow batch, only set for the shadow casters
+	uint32_t shadowDrawIndex;
 };
 
 struct GfxAssetInstance
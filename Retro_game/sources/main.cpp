@@ -1,9 +1,27 @@
 #include "engine.h"
 #include "game.h"
 
-int main() {
+#include <cstring>
+#include <string>
+
+int main( int argc, char* argv[] ) {
 
 	try {
+		//-frames_in_flight N, from 1 to SIMULTANEOUS_FRAMES
+		//-present_mode fifo|fifo_relaxed|mailbox|immediate
+		for( int i = 1; i + 1 < argc; ++i )
+		{
+			if( strcmp( argv[i], "-frames_in_flight" ) == 0 )
+				SetFramesInFlight( std::stoul( argv[i + 1] ) );
+			else if( strcmp( argv[i], "-present_mode" ) == 0 )
+			{
+				R_HW::GfxPresentMode presentMode;
+				if( !ParsePresentMode( argv[i + 1], &presentMode ) )
+					throw std::runtime_error( "unknown present mode!" );
+				SetPresentMode( presentMode );
+			}
+		}
+
 		const Engine::SceneScript gameScene { "Game", Scene3DGame::Init, Scene3DGame::mainLoop, Scene3DGame::cleanup };
 		Engine::EngineState engineState( InitRendererImp, CleanupRendererImp, "3D game", Scene3DGame::VIEWPORT_WIDTH, Scene3DGame::VIEWPORT_HEIGHT );
 
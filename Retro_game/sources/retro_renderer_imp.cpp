@@ -5,14 +5,20 @@
 #include "profile.h"
 #include "console_command.h"
 #include "window_handler.h"
-#include "allocators.h"
 #include "retro_physics.h"
+#include "draw_key.h"
+#include "vertex_quantization.h"
 
 #include <glm/glm.hpp>
 #include <glm/vec4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-R_HW::GfxDescriptorPool descriptorPool;
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <utility>
 
 const R_HW::DisplaySurface* m_swapchainSurface;
 
@@ -21,6 +27,37 @@ std::array< GpuInputData, SIMULTANEOUS_FRAMES> _inputBuffers;
 static RetroFrameGraphParams m_fg_params;
 static bool m_fg_need_reconfig;
 static RNDR::R_State* mpr_state;
+static uint32_t m_framesInFlight = 2;
+static R_HW::GfxPresentMode m_presentMode = R_HW::GfxPresentMode::MAILBOX;
+static bool m_presentModeChanged;
+//BeginFrame got an image, nothing is drawn otherwise
+static bool m_frameAcquired;
+
+static const std::pair<const char*, R_HW::GfxPresentMode> m_presentModeNames[] = {
+	{ "fifo", R_HW::GfxPresentMode::FIFO },
+	{ "fifo_relaxed", R_HW::GfxPresentMode::FIFO_RELAXED },
+	{ "mailbox", R_HW::GfxPresentMode::MAILBOX },
+	{ "immediate", R_HW::GfxPresentMode::IMMEDIATE },
+};
+
+constexpr float CAMERA_Z_NEAR = 0.1f;
+constexpr float CAMERA_Z_FAR = 300.0f;
+constexpr float CAMERA_FOV_Y_DEGREES = 45.0f;
+//Screen space error allowed when picking the LOD of an instance
+constexpr float LOD_MAX_PIXEL_ERROR = 1.0f;
+
+static BoundingSpheresSoA m_instanceBounds;
+static std::vector<uint8_t> m_cameraVisibility;
+static std::vector<uint8_t> m_lightVisibility;
+static std::vector<uint8_t> m_shadowVisibility;
+static std::vector<GfxAssetInstance> m_visibleDrawList;
+static std::vector<uint8_t> m_visibleCastsShadows;
+//Visible instances that didn't fit in the instance buffers, shown on the overlay
+static uint32_t m_droppedInstancesCount;
+
+static BindlessTexturesState* m_bindlessTexturesState;
+//Version of the bindless textures last set in the input data of each frame
+static std::array<uint32_t, SIMULTANEOUS_FRAMES> m_bindlessTexturesVersions;
 
 /*
 	Update Stuff
@@ -37,48 +74,272 @@ static void UpdateLightUniformBuffer( const SceneMatricesUniform* shadowSceneMat
 	UpdateShadowUniformBuffers( shadowSceneUniformBuffer, shadowSceneMatrices);
 }
 
-static void UpdateSceneUniformBuffer(const glm::mat4& world_view_matrix, VkExtent2D extent, R_HW::GpuBuffer* sceneUniformBuffer)
+static void UpdateSceneUniformBuffer(const glm::mat4& world_view_matrix, VkExtent2D extent, R_HW::GpuBuffer* sceneUniformBuffer, SceneMatricesUniform* o_sceneMatrices )
 {
-	const float zFar = 300.0f;
-	const float zNear = 0.1f;
 	SceneMatricesUniform sceneMatrices = {};
 	sceneMatrices.view = world_view_matrix;
-	sceneMatrices.proj = glm::perspective( glm::radians( 45.0f ), extent.width / ( float )extent.height, zNear, zFar );
+	sceneMatrices.proj = glm::perspective( glm::radians( CAMERA_FOV_Y_DEGREES ), extent.width / ( float )extent.height, CAMERA_Z_NEAR, CAMERA_Z_FAR );
 	sceneMatrices.proj[1][1] *= -1;//Compensate for OpenGL Y coordinate being inverted
 	UpdateGpuBuffer( sceneUniformBuffer, &sceneMatrices, sizeof( sceneMatrices ), 0 );
+	*o_sceneMatrices = sceneMatrices;
 }
 
-static void UpdateGfxInstanceData( const GfxAssetInstance& assetInstance, SceneInstanceSet* sceneInstanceDescriptorSet, BufferAllocator* allocator )
+//Keeps the instances seen by the camera and the shadow casters, o_castsShadows follows the visible draw list.
+//A caster has to be in the light frustum and its shadow, the bounds swept away from the light, has to reach the camera frustum.
+static void CullDrawList( const std::vector<GfxAssetInstance>& drawList, const glm::mat4& cameraViewProj, const glm::mat4& shadowViewProj, const glm::vec3& lightPosition,
+	std::vector<GfxAssetInstance>* o_visibleDrawList, std::vector<uint8_t>* o_castsShadows )
 {
-	GfxInstanceData instanceMatrices = {};
-	instanceMatrices.model = ComputeSceneInstanceModelMatrix( assetInstance.instanceData );
-	for( uint32_t i = 0; i < assetInstance.asset->textureIndices.size(); ++i )
-		instanceMatrices.texturesIndexes[i] = assetInstance.asset->textureIndices[i];
+	const size_t instancesCount = drawList.size();
+	m_instanceBounds.Resize( instancesCount );
+	for( size_t i = 0; i < instancesCount; ++i )
+	{
+		const GfxModel* model = drawList[i].asset->modelAsset;
+		const glm::mat4 modelMatrix = ComputeSceneInstanceModelMatrix( drawList[i].instanceData );
+		const glm::vec3 center = modelMatrix * glm::vec4( model->boundingSphereCenter, 1.0f );
+		const float scale = sqrtf( std::max( { glm::dot( glm::vec3( modelMatrix[0] ), glm::vec3( modelMatrix[0] ) ),
+			glm::dot( glm::vec3( modelMatrix[1] ), glm::vec3( modelMatrix[1] ) ),
+			glm::dot( glm::vec3( modelMatrix[2] ), glm::vec3( modelMatrix[2] ) ) } ) );
+
+		m_instanceBounds.centerX[i] = center.x;
+		m_instanceBounds.centerY[i] = center.y;
+		m_instanceBounds.centerZ[i] = center.z;
+		//Models without bounds are always kept
+		m_instanceBounds.radius[i] = model->boundingSphereRadius > 0.0f ? model->boundingSphereRadius * scale : std::numeric_limits<float>::max();
+	}
+
+	glm::vec4 cameraPlanes[FRUSTUM_PLANES_COUNT];
+	glm::vec4 lightPlanes[FRUSTUM_PLANES_COUNT];
+	ExtractFrustumPlanes( cameraViewProj, cameraPlanes );
+	ExtractFrustumPlanes( shadowViewProj, lightPlanes );
+
+	m_cameraVisibility.assign( instancesCount, 0 );
+	m_lightVisibility.assign( instancesCount, 0 );
+	m_shadowVisibility.assign( instancesCount, 0 );
+	CullSpheres( cameraPlanes, m_instanceBounds, m_cameraVisibility.data() );
+	CullSpheres( lightPlanes, m_instanceBounds, m_lightVisibility.data() );
+	CullSweptSpheres( cameraPlanes, lightPosition, SHADOW_FAR_PLANE, m_instanceBounds, m_shadowVisibility.data() );
+
+	o_visibleDrawList->clear();
+	o_castsShadows->clear();
+	for( size_t i = 0; i < instancesCount; ++i )
+	{
+		const bool castsShadow = drawList[i].asset->castsShadows && m_lightVisibility[i] && m_shadowVisibility[i];
+		if( m_cameraVisibility[i] || castsShadow )
+		{
+			o_visibleDrawList->push_back( drawList[i] );
+			o_castsShadows->push_back( castsShadow );
+		}
+	}
+}
+
+//LOD from the projected size of the model error at the closest point of the instance bounds.
+//pixelsPerUnitAtOne is the size on screen of one world unit at a distance of one
+static uint32_t SelectInstanceLod( const GfxModel& model, const glm::mat4& modelMatrix, const glm::mat4& viewMatrix, float pixelsPerUnitAtOne )
+{
+	if( model.lodCount < 2 || model.boundingSphereRadius <= 0.0f )
+		return 0;
+
+	const float scale = sqrtf( std::max( { glm::dot( glm::vec3( modelMatrix[0] ), glm::vec3( modelMatrix[0] ) ),
+		glm::dot( glm::vec3( modelMatrix[1] ), glm::vec3( modelMatrix[1] ) ),
+		glm::dot( glm::vec3( modelMatrix[2] ), glm::vec3( modelMatrix[2] ) ) } ) );
+	const glm::vec3 center = viewMatrix * modelMatrix * glm::vec4( model.boundingSphereCenter, 1.0f );
+	const float distance = std::max( glm::length( center ) - model.boundingSphereRadius * scale, CAMERA_Z_NEAR );
+	return SelectModelLod( model, pixelsPerUnitAtOne * scale / distance, LOD_MAX_PIXEL_ERROR );
+}
+
+//Sort key fields of the Retro passes, in execution order
+enum eDrawPass : uint32_t
+{
+	DRAW_PASS_SHADOW = 0,
+	DRAW_PASS_OPAQUE,
+};
+
+enum eDrawPipeline : uint32_t
+{
+	DRAW_PIPELINE_SHADOW = 0,
+	DRAW_PIPELINE_OPAQUE,
+};
 
-	size_t allocationSize = sizeof( GfxInstanceData );
-	size_t memoryOffset = AllocateGpuBufferSlot( allocator, allocationSize );
+constexpr uint32_t NO_DRAW_INDEX = ~0u;
 
-	sceneInstanceDescriptorSet->geometryBufferOffsets = memoryOffset;
-	UpdateGpuBuffer( allocator->buffer, &instanceMatrices, allocationSize, memoryOffset );
+//Groups the included instances by asset and LOD, each group is drawn once with all its instances.
+//Batches are sorted by draw key: closest first for early depth rejection, then by material and geometry.
+//The ranges of the batches follow each other from 0, o_drawIndices is NO_DRAW_INDEX for the instances left out
+static void BuildDrawBatches( const std::vector<GfxAssetInstance>& drawList, uint32_t instancesCount, const std::vector<uint32_t>& lods, const std::vector<float>& depths, const std::vector<uint8_t>* includedInstances,
+	eDrawPass drawPass, eDrawPipeline pipeline, std::vector<DrawBatch>* o_drawBatches, std::vector<uint32_t>* o_drawIndices )
+{
+	std::vector<DrawBatch> batches;
+	std::vector<float> batchesDepth;
+	std::vector<uint32_t> instancesBatch( instancesCount, NO_DRAW_INDEX );
+	std::map<std::pair<const GfxAsset*, uint32_t>, uint32_t> batchIndices;
+	for( uint32_t i = 0; i < instancesCount; ++i )
+	{
+		if( includedInstances && !( *includedInstances )[i] )
+			continue;
+
+		const std::pair<const GfxAsset*, uint32_t> batchKey( drawList[i].asset, lods[i] );
+		auto it = batchIndices.find( batchKey );
+		uint32_t batchIndex;
+		if( it == batchIndices.end() )
+		{
+			batchIndex = static_cast< uint32_t >( batches.size() );
+			batchIndices[batchKey] = batchIndex;
+			batches.push_back( { drawList[i].asset, 0, 0, lods[i] } );
+			batchesDepth.push_back( depths[i] );
+		}
+		else
+			batchIndex = it->second;
+
+		instancesBatch[i] = batchIndex;
+		++batches[batchIndex].instanceCount;
+		batchesDepth[batchIndex] = std::min( batchesDepth[batchIndex], depths[i] );
+	}
+
+	//Ids are given in order of appearance so they fit in the key whatever the size of the tables
+	std::unordered_map<const GfxModel*, uint32_t> geometryIds;
+	std::unordered_map<uint32_t, uint32_t> materialIds;
+	std::vector<uint64_t> keys( batches.size() );
+	std::vector<uint32_t> order( batches.size() );
+	for( uint32_t i = 0; i < batches.size(); ++i )
+	{
+		const uint32_t geometryId = geometryIds.emplace( batches[i].asset->modelAsset, static_cast< uint32_t >( geometryIds.size() ) ).first->second;
+		const uint32_t materialId = materialIds.emplace( batches[i].asset->materialIndex, static_cast< uint32_t >( materialIds.size() ) ).first->second;
+		keys[i] = MakeDrawKey( drawPass, pipeline, batchesDepth[i], materialId, geometryId );
+		order[i] = i;
+	}
+	RadixSortDrawKeys( &keys, &order );
+
+	//The draw index of a batch is its position once sorted
+	std::vector<uint32_t> batchDrawIndices( batches.size() );
+	o_drawBatches->clear();
+	uint32_t firstInstance = 0;
+	for( uint32_t drawIndex = 0; drawIndex < order.size(); ++drawIndex )
+	{
+		DrawBatch batch = batches[order[drawIndex]];
+		batch.firstInstance = firstInstance;
+		firstInstance += batch.instanceCount;
+		batchDrawIndices[order[drawIndex]] = drawIndex;
+		o_drawBatches->push_back( batch );
+	}
+
+	o_drawIndices->assign( instancesCount, NO_DRAW_INDEX );
+	for( uint32_t i = 0; i < instancesCount; ++i )
+		if( instancesBatch[i] != NO_DRAW_INDEX )
+			( *o_drawIndices )[i] = batchDrawIndices[instancesBatch[i]];
+}
+
+//The instance data follows the order of the opaque batches. The shadow casters also get a shadow batch, sorted from the light
+//with its LOD picked from the shadow map resolution
+static void UpdateGfxInstanceData( const std::vector<GfxAssetInstance>& drawList, const std::vector<uint8_t>& castsShadows, const glm::mat4& viewMatrix, const glm::mat4& shadowViewMatrix,
+	float pixelsPerUnitAtOne, float shadowPixelsPerUnitAtOne, R_HW::GpuBuffer* instanceBuffer, std::vector<DrawBatch>* o_drawBatches, std::vector<DrawBatch>* o_shadowDrawBatches )
+{
+	const uint32_t instancesCount = std::min( static_cast< uint32_t >( drawList.size() ), maxInstancesCount );
+
+	std::vector<glm::mat4> instancesModel( instancesCount );
+	std::vector<uint32_t> lods( instancesCount );
+	std::vector<uint32_t> shadowLods( instancesCount, 0 );
+	std::vector<float> depths( instancesCount );
+	std::vector<float> shadowDepths( instancesCount );
+	for( uint32_t i = 0; i < instancesCount; ++i )
+	{
+		instancesModel[i] = ComputeSceneInstanceModelMatrix( drawList[i].instanceData );
+		lods[i] = SelectInstanceLod( *drawList[i].asset->modelAsset, instancesModel[i], viewMatrix, pixelsPerUnitAtOne );
+		depths[i] = ( viewMatrix * instancesModel[i][3] ).z / CAMERA_Z_FAR;
+		shadowDepths[i] = ( shadowViewMatrix * instancesModel[i][3] ).z / SHADOW_FAR_PLANE;
+		if( castsShadows[i] )
+			shadowLods[i] = SelectInstanceLod( *drawList[i].asset->modelAsset, instancesModel[i], shadowViewMatrix, shadowPixelsPerUnitAtOne );
+	}
+
+	std::vector<uint32_t> drawIndices;
+	std::vector<uint32_t> shadowDrawIndices;
+	BuildDrawBatches( drawList, instancesCount, lods, depths, nullptr, DRAW_PASS_OPAQUE, DRAW_PIPELINE_OPAQUE, o_drawBatches, &drawIndices );
+	BuildDrawBatches( drawList, instancesCount, shadowLods, shadowDepths, &castsShadows, DRAW_PASS_SHADOW, DRAW_PIPELINE_SHADOW, o_shadowDrawBatches, &shadowDrawIndices );
+
+	std::vector<uint32_t> batchesFilled( o_drawBatches->size(), 0 );
+	std::vector<GfxInstanceData> instancesData( instancesCount );
+	for( uint32_t i = 0; i < instancesCount; ++i )
+	{
+		const GfxAssetInstance& assetInstance = drawList[i];
+		const uint32_t drawIndex = drawIndices[i];
+		const DrawBatch& batch = ( *o_drawBatches )[drawIndex];
+
+		GfxInstanceData& instanceData = instancesData[batch.firstInstance + batchesFilled[drawIndex]++];
+		instanceData = {};
+		//Quantized positions are brought back in model space by the instance matrix
+		instanceData.model = instancesModel[i] * GetPositionDequantMatrix( *assetInstance.asset->modelAsset );
+		instanceData.drawIndex = drawIndex;
+		instanceData.castsShadow = castsShadows[i];
+		instanceData.shadowDrawIndex = shadowDrawIndices[i];
+		instanceData.materialIndex = assetInstance.asset->materialIndex;
+	}
+
+	if( instancesCount > 0 )
+		UpdateGpuBuffer( instanceBuffer, instancesData.data(), instancesCount * sizeof( GfxInstanceData ), 0 );
+}
+
+//The culling shader fills the instance counts
+static void UpdateDrawCommands( const std::vector<DrawBatch>& drawBatches, R_HW::GpuBuffer* drawCommandsBuffer )
+{
+	if( drawBatches.empty() )
+		return;
+
+	std::vector<GpuDrawCommand> drawCommands( drawBatches.size() );
+	for( uint32_t i = 0; i < drawBatches.size(); ++i )
+	{
+		const GfxModel* model = drawBatches[i].asset->modelAsset;
+		GpuDrawCommand& drawCommand = drawCommands[i];
+		drawCommand = {};
+		GetModelLodRange( *model, drawBatches[i].lod, &drawCommand.firstIndex, &drawCommand.indexCount );
+		drawCommand.vertexOffset = model->vertexOffset;
+		drawCommand.firstInstance = drawBatches[i].firstInstance;
+		//Models created without their positions have no bounds, the shader never culls them
+		//The instance matrices include the position dequantization, the sphere has to be in quantized space
+		const glm::vec4 boundingSphere = GetQuantizedBoundingSphere( *model );
+		drawCommand.boundingSphere = glm::vec4( glm::vec3( boundingSphere ), boundingSphere.w > 0.0f ? boundingSphere.w : -1.0f );
+	}
+
+	UpdateGpuBuffer( drawCommandsBuffer, drawCommands.data(), drawCommands.size() * sizeof( GpuDrawCommand ), 0 );
+}
+
+static void UpdateCullingUniformBuffer( const SceneMatricesUniform& sceneMatrices, uint32_t instanceCount, R_HW::GpuBuffer* cullingUniformBuffer )
+{
+	CullingUniform cullingUniform = {};
+	ExtractFrustumPlanes( sceneMatrices.proj * sceneMatrices.view, cullingUniform.cameraPlanes );
+	cullingUniform.instanceCount = instanceCount;
+	UpdateGpuBuffer( cullingUniformBuffer, &cullingUniform, sizeof( CullingUniform ), 0 );
+}
+
+static const char* GetPresentModeName( R_HW::GfxPresentMode presentMode )
+{
+	for( const auto& presentModeName : m_presentModeNames )
+	{
+		if( presentModeName.second == presentMode )
+			return presentModeName.first;
+	}
+	return "unknown";
 }
 
 static void updateTextOverlayBuffer( uint32_t currentFrame )
 {
-	float miliseconds = GetTimestampsDelta( Timestamp::COMMAND_BUFFER_START, Timestamp::COMMAND_BUFFER_END, abs( static_cast< int64_t >(currentFrame) - 1ll ) );
+	//Timestamps of the frame recorded before this one
+	const uint32_t previousFrame = ( currentFrame + g_gfx.framesInFlight - 1 ) % g_gfx.framesInFlight;
+	float miliseconds = GetTimestampsDelta( Timestamp::COMMAND_BUFFER_START, Timestamp::COMMAND_BUFFER_END, previousFrame );
 	char textBuffer[256];
-	int charCount = sprintf_s( textBuffer, 256, "GPU: %4.4fms", miliseconds );
+	int charCount = sprintf_s( textBuffer, 256, "GPU: %4.4fms Latency: %4.1fms %s", miliseconds, GetInputToPresentLatency( mpr_state ), GetPresentModeName( GetPresentMode( mpr_state ) ) );
+	if( m_droppedInstancesCount > 0 )
+		sprintf_s( textBuffer + charCount, 256 - charCount, " Dropped instances: %u/%u", m_droppedInstancesCount, m_droppedInstancesCount + maxInstancesCount );
 	size_t textZonesCount = 1;
 	TextZone textZones[2] = { -1.0f, -1.0f, std::string( textBuffer ) };
 	if( ConCom::isOpen() ) {
 		textZones[1] = { -1.0f, 0.0f, ConCom::GetViewableString() };
 		++textZonesCount;
 	}
-	UpdateText( textZones, textZonesCount, get_backbuffer_size( mpr_state ) );
+	UpdateText( currentFrame, textZones, textZonesCount, get_backbuffer_size( mpr_state ) );
 }
 
 //TODO seperate the buffer update and computation of frame data
 //TODO Make light Uniform const
-static void updateUniformBuffer( uint32_t currentFrame, const SceneInstance* cameraSceneInstance, LightUniform* light, const std::vector<GfxAssetInstance>& drawList, std::vector<DrawListEntry>& o_drawlist )
+static void updateUniformBuffer( uint32_t currentFrame, const SceneInstance* cameraSceneInstance, LightUniform* light, const std::vector<GfxAssetInstance>& drawList, SceneFrameData* o_frameData )
 {
 	glm::mat4 world_view_matrix = ComputeCameraSceneInstanceViewMatrix( *cameraSceneInstance );
 
@@ -86,20 +347,30 @@ static void updateUniformBuffer( uint32_t currentFrame, const SceneInstance* cam
 
 	GpuInputData currentGpuInputData = _inputBuffers[currentFrame];
 
-	BufferAllocator allocator { GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::INSTANCE_DATA ) };
-	for( uint32_t i = 0; i < drawList.size(); ++i )
-	{
-		SceneInstanceSet instanceDescSet;
-		UpdateGfxInstanceData( drawList[i], &instanceDescSet, &allocator );
-
-		o_drawlist[i] = { drawList[i].asset, instanceDescSet };
-	}
-
-	UpdateSceneUniformBuffer( world_view_matrix, swapChainExtent, GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::SCENE_DATA ) );
+	SceneMatricesUniform sceneMatrices;
+	UpdateSceneUniformBuffer( world_view_matrix, swapChainExtent, GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::SCENE_DATA ), &sceneMatrices );
 
 	SceneMatricesUniform shadowSceneMatrices;
 	computeShadowMatrix( light->position, &shadowSceneMatrices.view, &shadowSceneMatrices.proj );
 
+	CullDrawList( drawList, sceneMatrices.proj * sceneMatrices.view, shadowSceneMatrices.proj * shadowSceneMatrices.view, light->position, &m_visibleDrawList, &m_visibleCastsShadows );
+
+	const float pixelsPerUnitAtOne = swapChainExtent.height / ( 2.0f * tanf( glm::radians( CAMERA_FOV_Y_DEGREES ) * 0.5f ) );
+	const float shadowPixelsPerUnitAtOne = RT_EXTENT_SHADOW.height / ( 2.0f * tanf( glm::radians( SHADOW_FOV_Y_DEGREES ) * 0.5f ) );
+	UpdateGfxInstanceData( m_visibleDrawList, m_visibleCastsShadows, sceneMatrices.view, shadowSceneMatrices.view, pixelsPerUnitAtOne, shadowPixelsPerUnitAtOne, GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::INSTANCE_DATA ),
+		&o_frameData->drawBatches, &o_frameData->shadowDrawBatches );
+	o_frameData->instanceCount = std::min( static_cast< uint32_t >( m_visibleDrawList.size() ), maxInstancesCount );
+	m_droppedInstancesCount = static_cast< uint32_t >( m_visibleDrawList.size() ) - o_frameData->instanceCount;
+
+	R_HW::GpuBuffer* drawCommandsBuffer = GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::DRAW_COMMANDS );
+	R_HW::GpuBuffer* shadowDrawCommandsBuffer = GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::SHADOW_DRAW_COMMANDS );
+	UpdateDrawCommands( o_frameData->drawBatches, drawCommandsBuffer );
+	UpdateDrawCommands( o_frameData->shadowDrawBatches, shadowDrawCommandsBuffer );
+	o_frameData->drawCommands = drawCommandsBuffer;
+	o_frameData->shadowDrawCommands = shadowDrawCommandsBuffer;
+
+	UpdateCullingUniformBuffer( sceneMatrices, o_frameData->instanceCount, GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::CULLING_DATA ) );
+
 	UpdateLightUniformBuffer( &shadowSceneMatrices, light, GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::LIGHT_DATA ), GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::SHADOW_DATA ) );
 
 	UpdateSkyboxUniformBuffers( GetBuffer( &currentGpuInputData, eTechniqueDataEntryName::SKYBOX_DATA ), world_view_matrix );
@@ -112,8 +383,7 @@ static void updateUniformBuffer( uint32_t currentFrame, const SceneInstance* cam
 
 static void PrepareSceneFrameData( SceneFrameData* frameData, uint32_t currentFrame, const SceneInstance* cameraSceneInstance, LightUniform* light, const std::vector<GfxAssetInstance>& drawList )
 {
-	frameData->drawList.resize( drawList.size() );
-	updateUniformBuffer( currentFrame, cameraSceneInstance, light, drawList, frameData->drawList );
+	updateUniformBuffer( currentFrame, cameraSceneInstance, light, drawList, frameData );
 }
 
 R_HW::GfxImageSamplerCombined textTextures[1];
@@ -121,7 +391,7 @@ R_HW::GfxImageSamplerCombined skyboxImages[1];
 
 void CreateBtDebudModels();
 
-static void CreateBuffers( BindlessTexturesState* bindlessTexturesState, const R_HW::GfxImage* skyboxImage )
+static void CreateBuffers( BindlessTexturesState* bindlessTexturesState, MaterialTable* materialTable, const R_HW::GfxImage* skyboxImage )
 {
 	CreateTextVertexBuffer( 256 );
 	CreateBtDebudModels();
@@ -131,12 +401,15 @@ static void CreateBuffers( BindlessTexturesState* bindlessTexturesState, const R
 	textTextures[0] = { const_cast< R_HW::GfxImage*>(GetTextImage()), sampler };
 	skyboxImages[0] = { const_cast< R_HW::GfxImage* >(skyboxImage), sampler };
 	
-	for( size_t i = 0; i < SIMULTANEOUS_FRAMES; ++i )
+	m_bindlessTexturesState = bindlessTexturesState;
+	for( size_t i = 0; i < g_gfx.framesInFlight; ++i )
 	{
 		SetImages( &_inputBuffers[i], eTechniqueDataEntryImageName::BINDLESS_TEXTURES, bindlessTexturesState->_bindlessTextures, bindlessTexturesState->_bindlessTexturesCount );
+		m_bindlessTexturesVersions[i] = bindlessTexturesState->_version;
 		SetImages( &_inputBuffers[i], eTechniqueDataEntryImageName::TEXT, textTextures, 1 );
 		SetImages( &_inputBuffers[i], eTechniqueDataEntryImageName::SKYBOX, skyboxImages, 1 );
 		SetSamplers( &_inputBuffers[i], eTechniqueDataEntryName::SAMPLERS, GetSamplers(), 2 );
+		SetBuffers( &_inputBuffers[i], eTechniqueDataEntryName::MATERIALS, &materialTable->buffer, 1 );
 	}
 }
 
@@ -147,59 +420,50 @@ static bool NeedResize()
 	return value;
 }
 
+void SetFramesInFlight( uint32_t framesInFlight )
+{
+	m_framesInFlight = framesInFlight;
+}
+
+void SetPresentMode( R_HW::GfxPresentMode presentMode )
+{
+	m_presentMode = presentMode;
+	if( mpr_state )
+	{
+		RNDR::SetPresentMode( mpr_state, presentMode );
+		m_presentModeChanged = true;
+	}
+}
+
+bool ParsePresentMode( const char* name, R_HW::GfxPresentMode* o_presentMode )
+{
+	for( const auto& presentModeName : m_presentModeNames )
+	{
+		if( strcmp( presentModeName.first, name ) == 0 )
+		{
+			*o_presentMode = presentModeName.second;
+			return true;
+		}
+	}
+	return false;
+}
+
 void InitRendererImp( const VkSurfaceKHR* swapchainSurface )
 {
 	uint64_t width, height;
 	WH::GetFramebufferSize( &width, &height );
 	m_swapchainSurface = swapchainSurface;
 
-	mpr_state = RNDR::CreateRenderer( *swapchainSurface, width, height );
+	mpr_state = RNDR::CreateRenderer( *swapchainSurface, width, height, m_framesInFlight, m_presentMode );
 
 	LoadFontTexture();
 	CreateTextVertexBuffer( 256 );
 }
 
-static R_HW::GfxDescriptorPool CreateDescriptorPool_BAD()
+void CompileScene( BindlessTexturesState* bindlessTexturesState, MaterialTable* materialTable, const R_HW::GfxImage* skyboxImage )
 {
-	const uint32_t geometryDescriptorSets = 2 * SIMULTANEOUS_FRAMES;
-	const uint32_t geometryBuffersCount = 2 * SIMULTANEOUS_FRAMES;
-	const uint32_t geometryImageCount = 20 * SIMULTANEOUS_FRAMES;
-	const uint32_t geomtryDynamicBuffersCount = 1 * SIMULTANEOUS_FRAMES;
-
-	const uint32_t shadowDescriptorSets = 2 * SIMULTANEOUS_FRAMES;
-	const uint32_t shadowBuffersCount = 2 * SIMULTANEOUS_FRAMES;
-	const uint32_t shadowDynamicBuffersCount = 1 * SIMULTANEOUS_FRAMES;
-
-	const uint32_t skyboxDescriptorSetsCount = 2 * SIMULTANEOUS_FRAMES;
-	const uint32_t skyboxBuffersCount = 2 * SIMULTANEOUS_FRAMES;
-	const uint32_t skyboxImageCount = 2 * SIMULTANEOUS_FRAMES;
-
-	const uint32_t textDescriptorSetsCount = 2;
-	const uint32_t textImageCount = 2;
-
-	const uint32_t uniformBuffersCount = geometryBuffersCount + shadowBuffersCount + skyboxBuffersCount;
-	const uint32_t imageSamplersCount = geometryImageCount + skyboxImageCount + textImageCount;
-	const uint32_t storageImageCount = 1;
-	const uint32_t uniformBuffersDynamicCount = geomtryDynamicBuffersCount + shadowDynamicBuffersCount;
-	const uint32_t sampledImageCount = 6;
-
-	const uint32_t maxSets = geometryDescriptorSets + shadowDescriptorSets + skyboxDescriptorSetsCount + textDescriptorSetsCount;
-
-	R_HW::GfxDescriptorPool descriptorPool;
-	R_HW::CreateDescriptorPool( uniformBuffersCount, uniformBuffersDynamicCount, imageSamplersCount, storageImageCount, sampledImageCount, maxSets, &descriptorPool );
-
-	return descriptorPool;
-}
+	CreateBuffers( bindlessTexturesState, materialTable, skyboxImage );
 
-void CompileScene( BindlessTexturesState* bindlessTexturesState, const R_HW::GfxImage* skyboxImage )
-{
-	if( descriptorPool )
-		R_HW::Destroy( &descriptorPool );
-	descriptorPool = CreateDescriptorPool_BAD();
-
-	CreateBuffers( bindlessTexturesState, skyboxImage );
-
-	m_fg_params._descriptorPool = descriptorPool;
 	m_fg_params._pInputBuffers = &_inputBuffers;
 
 	CompileFrameGraph( mpr_state, InitializeScript, &m_fg_params );
@@ -209,30 +473,67 @@ void CleanupRendererImp()
 {
 	CleanupTextRenderPass();
 	Destroy( &mpr_state );
-	R_HW::Destroy( &descriptorPool );
 }
 
-void DrawFrame( uint32_t currentFrame, const SceneInstance* cameraSceneInstance, LightUniform* light, const std::vector<GfxAssetInstance>& drawList )
+static void RecreateSwapchain()
 {
-	WaitForFrame( mpr_state, currentFrame );
-
-	SceneFrameData frameData;
-	PrepareSceneFrameData(&frameData, currentFrame, cameraSceneInstance, light, drawList);
+	uint64_t frameBufferWidth, frameBufferHeight;
+	WH::GetFramebufferSize( &frameBufferWidth, &frameBufferHeight );
+	recreate_swap_chain( mpr_state, *m_swapchainSurface, frameBufferWidth, frameBufferHeight, ResizeScript, &m_fg_params );
+}
 
+void BeginFrame( uint32_t currentFrame )
+{
+	//Before an image is acquired, recompiling the graph waits for the device
+#ifndef NDEBUG
+	ReloadChangedShaders( mpr_state );
+#endif
 	if( m_fg_need_reconfig )
 	{
 		CompileFrameGraph( mpr_state, InitializeScript, &m_fg_params );
 		m_fg_need_reconfig = false;
 	}
-	else
-	if( NeedResize() || draw_frame( mpr_state, currentFrame, &frameData ) == RNDR::eRenderError::NEED_FRAMEBUFFER_RESIZE )
+
+	const bool presentModeChanged = m_presentModeChanged;
+	m_presentModeChanged = false;
+	if( NeedResize() || presentModeChanged )
+		RecreateSwapchain();
+
+	m_frameAcquired = RNDR::BeginFrame( mpr_state, currentFrame ) == RNDR::eRenderError::SUCCESS;
+	if( !m_frameAcquired )
 	{
-		uint64_t frameBufferWidth, frameBufferHeight;
-		WH::GetFramebufferSize( &frameBufferWidth, &frameBufferHeight );
-		recreate_swap_chain( mpr_state, *m_swapchainSurface, frameBufferWidth, frameBufferHeight, InitializeScript, &m_fg_params );
+		RecreateSwapchain();
+		m_frameAcquired = RNDR::BeginFrame( mpr_state, currentFrame ) == RNDR::eRenderError::SUCCESS;
 	}
 }
 
+void MarkInputSampled( uint32_t currentFrame )
+{
+	RNDR::MarkInputSampled( mpr_state, currentFrame );
+}
+
+void DrawFrame( uint32_t currentFrame, const SceneInstance* cameraSceneInstance, LightUniform* light, const std::vector<GfxAssetInstance>& drawList )
+{
+	//The window can't present right now, minimized for example
+	if( !m_frameAcquired )
+		return;
+
+	RecycleBindlessTextures( m_bindlessTexturesState );
+	if( m_bindlessTexturesVersions[currentFrame] != m_bindlessTexturesState->_version )
+	{
+		SetImages( &_inputBuffers[currentFrame], eTechniqueDataEntryImageName::BINDLESS_TEXTURES, m_bindlessTexturesState->_bindlessTextures, m_bindlessTexturesState->_bindlessTexturesCount );
+		m_bindlessTexturesVersions[currentFrame] = m_bindlessTexturesState->_version;
+	}
+	UpdateDescriptorTables( mpr_state, _inputBuffers[currentFrame], currentFrame );
+
+	SceneFrameData frameData;
+	PrepareSceneFrameData(&frameData, currentFrame, cameraSceneInstance, light, drawList);
+
+	m_frameAcquired = false;
+	if( draw_frame( mpr_state, currentFrame, &frameData ) == RNDR::eRenderError::NEED_FRAMEBUFFER_RESIZE )
+		RecreateSwapchain();
+}
+
 void SetBtDebugDraw( bool value )
 {
 	if( m_fg_params.d_btDrawDebug != value )
@@ -3,6 +3,7 @@
 #include "vk_globals.h"
 #include "gfx_image.h"
 #include "bindless_textures.h"
+#include "material_table.h"
 #include "gfx_instance.h"
 
 struct LightUniform {
@@ -11,9 +12,18 @@ struct LightUniform {
 	float intensity;
 };
 
-void CompileScene( BindlessTexturesState* bindlessTexturesState, const R_HW::GfxImage* skyboxImage );
+void CompileScene( BindlessTexturesState* bindlessTexturesState, MaterialTable* materialTable, const R_HW::GfxImage* skyboxImage );
+//Waits for the frame slot and acquires its image, sample the input and simulate between BeginFrame and DrawFrame
+void BeginFrame( uint32_t currentFrame );
+void MarkInputSampled( uint32_t currentFrame );
 void DrawFrame( uint32_t currentFrame, const SceneInstance* cameraSceneInstance, LightUniform* light, const std::vector<GfxAssetInstance>& drawList );
 
+//Call it before InitRendererImp, 2 by default. More frames in flight give more throughput and more latency
+void SetFramesInFlight( uint32_t framesInFlight );
+//MAILBOX by default, falls back to FIFO when not supported. Recreates the swapchain when called after InitRendererImp
+void SetPresentMode( R_HW::GfxPresentMode presentMode );
+//fifo, fifo_relaxed, mailbox or immediate
+bool ParsePresentMode( const char* name, R_HW::GfxPresentMode* o_presentMode );
 void InitRendererImp( const R_HW::DisplaySurface* swapchainSurface );
 void CleanupRendererImp();
 
@@ -1,8 +1,10 @@
 #include "shadow_renderpass.h"
 #include "..\shaders\shadersCommon.h"
 
-#include "file_system.h"
+#include "shader_library.h"
 #include "renderer.h"
+#include "culling_pass.h"
+#include "vertex_quantization.h"
 
 #include "glm/gtc/matrix_transform.hpp"
 
@@ -10,7 +12,7 @@ void computeShadowMatrix(const glm::vec3& light_location, glm::mat4* view, glm::
 {
 	*view = glm::lookAt(light_location, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
 	//TODO: encapsulate projection computation
-	*projection = glm::perspective(glm::radians(65.0f), 1.0f, 0.1f, 100.0f);
+	*projection = glm::perspective(glm::radians(SHADOW_FOV_Y_DEGREES), 1.0f, 0.1f, SHADOW_FAR_PLANE);
 	(*projection)[1][1] *= -1;//Compensate for OpenGL Y coordinate being inverted
 
 	//return light_projection_matrix * light_view_matrix;
@@ -32,10 +34,10 @@ R_HW::GpuPipelineLayout GetShadowPipelineLayout()
 R_HW::GpuPipelineStateDesc GetShadowPipelineState()
 {
 	R_HW::GpuPipelineStateDesc gpuPipelineState = {};
-	uint32_t bindingCount = GetBindingDescription( VIBindingsMeshOnly, &gpuPipelineState.viState );
+	uint32_t bindingCount = GetInterleavedBindingDescription( VIBindingsQuantizedModel, VIBindingsQuantizedMeshOnly, &gpuPipelineState.viState );
 
 	gpuPipelineState.shaders = {
-		{ FS::readFile( "shaders/shadows.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT }, };
+		{ LoadShader( "shaders/shadows.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT }, };
 
 	gpuPipelineState.rasterizationState.backFaceCulling = true;
 	gpuPipelineState.rasterizationState.depthBiased = true;
@@ -64,14 +66,10 @@ static void CmdBeginShadowPass( R_HW::GfxCommandBuffer commandBuffer, size_t cur
 	BeginTechnique( commandBuffer, technique, currentFrame );
 }
 
-static void CmdDrawModel( R_HW::GfxCommandBuffer commandBuffer, const DrawListEntry* drawModel, uint32_t currentFrame, const Technique * technique )
+static void CmdDrawModel( R_HW::GfxCommandBuffer commandBuffer, const DrawBatch* drawBatch, const R_HW::GpuBuffer* drawCommands, uint32_t drawIndex, uint32_t drawCount, GeometryBindState* bindState )
 {
-	const SceneInstanceSet* instanceSet = &drawModel->descriptorSet;
-	const GfxModel* modelAsset = drawModel->asset->modelAsset;
-	R_HW::CmdBindRootDescriptor( commandBuffer, R_HW::GfxPipelineBindPoint::GRAPHICS, technique->pipelineLayout, INSTANCE_SET, technique->descriptor_sets[INSTANCE_SET].hw_descriptorSets[currentFrame],
-		instanceSet->geometryBufferOffsets );
-
-	CmdDrawIndexed( commandBuffer, VIBindingsMeshOnly, *modelAsset );
+	const GfxModel* modelAsset = drawBatch->asset->modelAsset;
+	CmdDrawIndexedIndirect( commandBuffer, VIBindingsQuantizedMeshOnly, *modelAsset, *drawCommands, drawIndex * sizeof( GpuDrawCommand ), drawCount, sizeof( GpuDrawCommand ), bindState );
 }
 
 static void CmdEndShadowPass( R_HW::GfxCommandBuffer commandBuffer )
@@ -83,12 +81,21 @@ static void CmdEndShadowPass( R_HW::GfxCommandBuffer commandBuffer )
 void ShadowRecordDrawCommandsBuffer( R_HW::GfxCommandBuffer graphicsCommandBuffer, const FG::TaskInputData& inputData )
 {
 	const SceneFrameData* frameData = static_cast< const SceneFrameData* >(inputData.userData);
-	CmdBeginShadowPass( graphicsCommandBuffer, inputData.currentFrame, inputData.renderpass, inputData.technique );
-
-	for (size_t i = 0; i < frameData->drawList.size(); ++i)
+	const Technique* technique = inputData.technique;
+	CmdBeginShadowPass( graphicsCommandBuffer, inputData.currentFrame, inputData.renderpass, technique );
+	R_HW::CmdBindDescriptorTable( graphicsCommandBuffer, R_HW::GfxPipelineBindPoint::GRAPHICS, technique->pipelineLayout, INSTANCE_SET, technique->descriptor_sets[INSTANCE_SET].hw_descriptorSets[inputData.currentFrame] );
+
+	//Batches are sorted, consecutive batches sharing their geometry buffers are drawn with one indirect draw
+	GeometryBindState bindState;
+	const std::vector<DrawBatch>& drawBatches = frameData->shadowDrawBatches;
+	size_t runStart = 0;
+	while( runStart < drawBatches.size() )
 	{
-		const DrawListEntry* renderable = &frameData->drawList[i];
-		CmdDrawModel(graphicsCommandBuffer, renderable, inputData.currentFrame, inputData.technique);
+		size_t runEnd = runStart + 1;
+		while( runEnd < drawBatches.size() && SharesGeometryBuffers( *drawBatches[runStart].asset->modelAsset, *drawBatches[runEnd].asset->modelAsset ) )
+			++runEnd;
+		CmdDrawModel( graphicsCommandBuffer, &drawBatches[runStart], frameData->shadowDrawCommands, static_cast< uint32_t >( runStart ), static_cast< uint32_t >( runEnd - runStart ), &bindState );
+		runStart = runEnd;
 	}
 	CmdEndShadowPass(graphicsCommandBuffer);
 }
\ No newline at end of file
@@ -7,6 +7,10 @@
 #include "material.h"
 #include "frame_graph.h"
 
+//Also how far shadows are considered to reach when culling casters
+constexpr float SHADOW_FAR_PLANE = 100.0f;
+constexpr float SHADOW_FOV_Y_DEGREES = 65.0f;
+
 R_HW::GpuPipelineLayout GetShadowPipelineLayout();
 R_HW::GpuPipelineStateDesc GetShadowPipelineState();
 
@@ -1,6 +1,6 @@
 #include "skybox.h"
 
-#include "file_system.h"
+#include "shader_library.h"
 #include "renderer.h"
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -14,8 +14,8 @@ R_HW::GpuPipelineStateDesc GetSkyboxPipelineState()
 {
 	R_HW::GpuPipelineStateDesc gpuPipelineState = {};
 	gpuPipelineState.shaders = {
-		{ FS::readFile( "shaders/skybox.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
-		{ FS::readFile( "shaders/skybox.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
+		{ LoadShader( "shaders/skybox.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
+		{ LoadShader( "shaders/skybox.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
 
 	gpuPipelineState.rasterizationState.backFaceCulling = false;
 	gpuPipelineState.rasterizationState.depthBiased = false;
@@ -1,15 +1,28 @@
 #include "text_overlay.h"
 
-#include "file_system.h"
+#include "shader_library.h"
 #include "renderer.h"
 #include "gfx_heaps_batched_allocator.h"
 #include "gfx_model.h"
+#include "allocators.h"
 #include "stb_font_consolas_24_latin1.inl"
 #include "../shaders/shadersCommon.h"
 
-GfxModel textModel;
+#include <algorithm>
+
+//Text is rebuilt every frame, its geometry is written straight in a persistently mapped ring
+struct TextFrameGeometry
+{
+	R_HW::GfxDeviceSize positionsOffset;
+	R_HW::GfxDeviceSize colorsOffset;
+	R_HW::GfxDeviceSize uvsOffset;
+	R_HW::GfxDeviceSize indicesOffset;
+	uint32_t charCount;
+};
+
+GpuRingAllocator textRingAllocator;
+TextFrameGeometry textFrames[SIMULTANEOUS_FRAMES];
 uint32_t maxTextCharCount = 0;
-uint32_t currentTextCharCount = 0;
 
 stb_fontchar stbFontData[STB_FONT_consolas_24_latin1_NUM_CHARS];
 R_HW::GfxImage g_fontImage;
@@ -18,6 +31,7 @@ typedef uint32_t Index_t;
 
 const uint32_t verticesPerChar = 4;
 const uint32_t indexesPerChar = 6;
+const size_t textAllocationAlignment = 16;
 
 const R_HW::GfxImage* GetTextImage()
 {
@@ -35,8 +49,8 @@ R_HW::GpuPipelineStateDesc GetTextPipelineState()
 	GetBindingDescription( VIBindings_PosColUV, &gpuPipelineState.viState );
 
 	gpuPipelineState.shaders = {
-		{ FS::readFile( "shaders/text.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
-		{ FS::readFile( "shaders/text.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
+		{ LoadShader( "shaders/text.vert.spv" ), "main", R_HW::GFX_SHADER_STAGE_VERTEX_BIT },
+		{ LoadShader( "shaders/text.frag.spv" ), "main", R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT } };
 
 	gpuPipelineState.rasterizationState.backFaceCulling = false;
 	gpuPipelineState.rasterizationState.depthBiased = false;
@@ -59,31 +73,44 @@ static void CmdDrawText( R_HW::GfxCommandBuffer commandBuffer, VkExtent2D extent
 	R_HW::CmdBindPipeline( commandBuffer, R_HW::GfxPipelineBindPoint::GRAPHICS, technique->pipeline );
 	R_HW::CmdBindDescriptorTable( commandBuffer, R_HW::GfxPipelineBindPoint::GRAPHICS, technique->pipelineLayout, RENDERPASS_SET, technique->descriptor_sets[RENDERPASS_SET].hw_descriptorSets[0] );
 
-	CmdDrawIndexed( commandBuffer, VIBindings_PosColUV, textModel, currentTextCharCount * indexesPerChar );
+	const TextFrameGeometry& textFrame = textFrames[frameIndex];
+	if( textFrame.charCount > 0 )
+	{
+		R_HW::GfxApiBuffer vertexBuffers[] = { textRingAllocator.buffer.buffer, textRingAllocator.buffer.buffer, textRingAllocator.buffer.buffer };
+		R_HW::GfxDeviceSize offsets[] = { textFrame.positionsOffset, textFrame.colorsOffset, textFrame.uvsOffset };
+		R_HW::CmdBindVertexInputs( commandBuffer, vertexBuffers, 0, 3, offsets );
+		R_HW::CmdBindIndexBuffer( commandBuffer, textRingAllocator.buffer.buffer, textFrame.indicesOffset, R_HW::GfxIndexType::UINT32 );
+		R_HW::CmdDrawIndexed( commandBuffer, textFrame.charCount * indexesPerChar, 1, 0, 0, 0 );
+	}
 
 	R_HW::EndRenderPass( commandBuffer );
 	R_HW::CmdEndLabel( commandBuffer );
 }
 
-void UpdateText( const TextZone * textZones, size_t textZonesCount, VkExtent2D surfaceExtent )
+void UpdateText( uint32_t currentFrame, const TextZone * textZones, size_t textZonesCount, VkExtent2D surfaceExtent )
 {
 	const float charW = 1.5f / surfaceExtent.width;
 	const float charH = 1.5f / surfaceExtent.height;
 
-	std::vector<glm::vec3> text_vertex_positions;
-	std::vector<glm::vec3> text_vertex_color;
-	std::vector<glm::vec2> text_vertex_uv;
-	std::vector<Index_t>	text_indices;
 	size_t totalCharCount = 0;
 	for( size_t i = 0; i < textZonesCount; ++i )
 		totalCharCount += textZones[i].text.size();
 
 	assert( totalCharCount < maxTextCharCount );
-	text_vertex_positions.resize( verticesPerChar * totalCharCount );
-	text_vertex_color.resize( verticesPerChar * totalCharCount );
-	text_vertex_uv.resize( verticesPerChar * totalCharCount );
-	text_indices.resize( indexesPerChar * totalCharCount );
-	currentTextCharCount = totalCharCount;
+	totalCharCount = std::min<size_t>( totalCharCount, maxTextCharCount );
+
+	BeginFrame( &textRingAllocator, currentFrame );
+	const size_t vertexCount = verticesPerChar * totalCharCount;
+	const GpuRingAllocation positions = AllocateGpuRingSlot( &textRingAllocator, sizeof( glm::vec3 ) * vertexCount, textAllocationAlignment );
+	const GpuRingAllocation colors = AllocateGpuRingSlot( &textRingAllocator, sizeof( glm::vec3 ) * vertexCount, textAllocationAlignment );
+	const GpuRingAllocation uvs = AllocateGpuRingSlot( &textRingAllocator, sizeof( glm::vec2 ) * vertexCount, textAllocationAlignment );
+	const GpuRingAllocation indices = AllocateGpuRingSlot( &textRingAllocator, sizeof( Index_t ) * indexesPerChar * totalCharCount, textAllocationAlignment );
+	textFrames[currentFrame] = { positions.offset, colors.offset, uvs.offset, indices.offset, static_cast< uint32_t >( totalCharCount ) };
+
+	glm::vec3* text_vertex_positions = static_cast< glm::vec3* >( positions.data );
+	glm::vec3* text_vertex_color = static_cast< glm::vec3* >( colors.data );
+	glm::vec2* text_vertex_uv = static_cast< glm::vec2* >( uvs.data );
+	Index_t* text_indices = static_cast< Index_t* >( indices.data );
 
 	size_t currentCharCount = 0;
 	for( size_t i = 0; i < textZonesCount; ++i )
@@ -91,7 +118,7 @@ void UpdateText( const TextZone * textZones, size_t textZonesCount, VkExtent2D s
 		const TextZone * textZone = &textZones[i];
 		float x = textZone->x;
 		float y = textZone->y;
-		for( size_t j = 0; j < textZone->text.size(); ++j, ++currentCharCount )
+		for( size_t j = 0; j < textZone->text.size() && currentCharCount < totalCharCount; ++j, ++currentCharCount )
 		{
 			const uint32_t firstChar = STB_FONT_consolas_24_latin1_FIRST_CHAR;
 			const uint32_t vertexOffet = verticesPerChar * currentCharCount;
@@ -125,35 +152,22 @@ void UpdateText( const TextZone * textZones, size_t textZonesCount, VkExtent2D s
 		}
 	}
 
-	R_HW::GfxDeviceSize bufferSize = sizeof( text_vertex_positions[0] ) * text_vertex_positions.size();
-	UpdateGpuBuffer( &GetVertexInput( textModel, eVIDataType::POSITION )->buffer, text_vertex_positions.data(), bufferSize, 0 );
-
-	bufferSize = sizeof( text_vertex_color[0] ) * text_vertex_color.size();
-	UpdateGpuBuffer( &GetVertexInput( textModel, eVIDataType::COLOR )->buffer, text_vertex_color.data(), bufferSize, 0 );
-
-	bufferSize = sizeof( text_vertex_uv[0] ) * text_vertex_uv.size();
-	UpdateGpuBuffer( &GetVertexInput( textModel, eVIDataType::TEX_COORD )->buffer, text_vertex_uv.data(), bufferSize, 0 );
-
-	bufferSize = sizeof( text_indices[0] ) * text_indices.size();
-	UpdateGpuBuffer( &textModel.indexBuffer, text_indices.data(), bufferSize, 0 );
-
-	//textModel.indexCount = currentTextCharCount * indexesPerChar;
+	FlushFrame( &textRingAllocator );
 }
 
 void CreateTextVertexBuffer( size_t maxCharCount )
 {
 	maxTextCharCount = static_cast< uint32_t >(maxCharCount);
 
-	uint32_t maxVertices = maxCharCount * verticesPerChar;
-	uint32_t maxIndices = maxCharCount * indexesPerChar;
-
-	std::vector<R_HW::VIDesc> modelVIDescs = {
-		{ (R_HW::VIDataType )eVIDataType::POSITION, R_HW::eVIDataElementType::FLOAT, 3 },
-		{ (R_HW::VIDataType )eVIDataType::COLOR, R_HW::eVIDataElementType::FLOAT, 3 },
-		{ (R_HW::VIDataType )eVIDataType::TEX_COORD, R_HW::eVIDataElementType::FLOAT, 2 },
-	};
+	const size_t maxVertices = maxCharCount * verticesPerChar;
+	const size_t maxIndices = maxCharCount * indexesPerChar;
+	const size_t frameSize = maxVertices * ( 2 * sizeof( glm::vec3 ) + sizeof( glm::vec2 ) ) + maxIndices * sizeof( Index_t ) + 4 * textAllocationAlignment;
 
-	textModel = CreateGfxModel( modelVIDescs, maxVertices, maxIndices, sizeof( uint32_t ) );
+	if( textRingAllocator.buffer.buffer != VK_NULL_HANDLE )
+		Destroy( &textRingAllocator );
+	CreateGpuRingAllocator( frameSize, R_HW::GFX_BUFFER_USAGE_VERTEX_BUFFER_BIT | R_HW::GFX_BUFFER_USAGE_INDEX_BUFFER_BIT, &textRingAllocator );
+	for( TextFrameGeometry& textFrame : textFrames )
+		textFrame = {};
 }
 
 void LoadFontTexture()
@@ -173,7 +187,7 @@ void LoadFontTexture()
 void CleanupTextRenderPass()
 {
 	DestroyImage( &g_fontImage );
-	DestroyGfxModel( textModel );
+	Destroy( &textRingAllocator );
 }
 
 void TextRecordDrawCommandsBuffer( R_HW::GfxCommandBuffer graphicsCommandBuffer, const FG::TaskInputData& inputData )
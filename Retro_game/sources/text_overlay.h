@@ -19,6 +19,6 @@ R_HW::GpuPipelineStateDesc GetTextPipelineState();
 void CleanupTextRenderPass();
 void TextRecordDrawCommandsBuffer( R_HW::GfxCommandBuffer graphicsCommandBuffer, const FG::TaskInputData& inputData );
 void CreateTextVertexBuffer( size_t maxCharCount );
-void UpdateText( const TextZone * textZones, size_t textZonesCount, VkExtent2D surfaceExtent );
+void UpdateText( uint32_t currentFrame, const TextZone * textZones, size_t textZonesCount, VkExtent2D surfaceExtent );
 void LoadFontTexture();
 const R_HW::GfxImage* GetTextImage();
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "draw_key.h"
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace
+{
+	void TestKeyOrder()
+	{
+		//Most significant field first
+		CHECK( MakeDrawKey( 0, 9, 1.0f, 9, 9 ) < MakeDrawKey( 1, 0, 0.0f, 0, 0 ) );
+		CHECK( MakeDrawKey( 1, 0, 1.0f, 9, 9 ) < MakeDrawKey( 1, 1, 0.0f, 0, 0 ) );
+		CHECK( MakeDrawKey( 1, 1, 0.25f, 9, 9 ) < MakeDrawKey( 1, 1, 0.5f, 0, 0 ) );
+		CHECK( MakeDrawKey( 1, 1, 0.5f, 2, 9 ) < MakeDrawKey( 1, 1, 0.5f, 3, 0 ) );
+		CHECK( MakeDrawKey( 1, 1, 0.5f, 3, 4 ) < MakeDrawKey( 1, 1, 0.5f, 3, 5 ) );
+
+		//Depth is clamped, it doesn't overflow in the other fields
+		CHECK( MakeDrawKey( 0, 0, 2.0f, 0, 0 ) == MakeDrawKey( 0, 0, 1.0f, 0, 0 ) );
+		CHECK( MakeDrawKey( 0, 0, -1.0f, 0, 0 ) == MakeDrawKey( 0, 0, 0.0f, 0, 0 ) );
+		CHECK( MakeDrawKey( 0, 0, 1.0f, 0, 0 ) < MakeDrawKey( 0, 1, 0.0f, 0, 0 ) );
+	}
+
+	std::vector<uint64_t> CreateKeys( uint32_t count, uint32_t seed )
+	{
+		std::mt19937 generator( seed );
+		std::uniform_int_distribution<uint32_t> pass( 0, 2 );
+		std::uniform_int_distribution<uint32_t> pipeline( 0, 15 );
+		std::uniform_real_distribution<float> depth( 0.0f, 1.0f );
+		std::uniform_int_distribution<uint32_t> material( 0, 255 );
+		std::uniform_int_distribution<uint32_t> geometry( 0, 1023 );
+
+		std::vector<uint64_t> keys( count );
+		for( uint64_t& key : keys )
+			key = MakeDrawKey( pass( generator ), pipeline( generator ), depth( generator ), material( generator ), geometry( generator ) );
+		return keys;
+	}
+
+	//Same result as a stable sort, the values follow their keys
+	void TestRadixSort()
+	{
+		for( uint32_t count : { 0u, 1u, 2u, 17u, 1000u, 100000u } )
+		{
+			std::vector<uint64_t> keys = CreateKeys( count, count );
+			std::vector<uint32_t> values( count );
+			std::iota( values.begin(), values.end(), 0 );
+
+			std::vector<uint32_t> expected = values;
+			const std::vector<uint64_t> originalKeys = keys;
+			std::stable_sort( expected.begin(), expected.end(), [&]( uint32_t a, uint32_t b ) { return originalKeys[a] < originalKeys[b]; } );
+
+			RadixSortDrawKeys( &keys, &values );
+			CHECK( values == expected );
+			CHECK( std::is_sorted( keys.begin(), keys.end() ) );
+		}
+
+		//Only the depth differs, the bytes shared by all the keys are skipped
+		std::vector<uint64_t> keys = { MakeDrawKey( 1, 2, 0.75f, 3, 4 ), MakeDrawKey( 1, 2, 0.25f, 3, 4 ), MakeDrawKey( 1, 2, 0.5f, 3, 4 ) };
+		std::vector<uint32_t> values = { 0, 1, 2 };
+		RadixSortDrawKeys( &keys, &values );
+		CHECK( ( values == std::vector<uint32_t>{ 1, 2, 0 } ) );
+	}
+
+	void BenchmarkSort()
+	{
+		constexpr uint32_t ITERATIONS = 20;
+		for( uint32_t count : { 1000u, 100000u } )
+		{
+			const std::vector<uint64_t> sourceKeys = CreateKeys( count, 7 );
+			std::vector<uint32_t> sourceValues( count );
+			std::iota( sourceValues.begin(), sourceValues.end(), 0 );
+
+			std::vector<uint64_t> keys;
+			std::vector<uint32_t> values;
+			const double radixTime = TEST::MeasureMicroseconds( ITERATIONS, [&]()
+				{
+					keys = sourceKeys;
+					values = sourceValues;
+					RadixSortDrawKeys( &keys, &values );
+				} );
+			const double stdTime = TEST::MeasureMicroseconds( ITERATIONS, [&]()
+				{
+					values = sourceValues;
+					std::sort( values.begin(), values.end(), [&]( uint32_t a, uint32_t b ) { return sourceKeys[a] < sourceKeys[b]; } );
+				} );
+			printf( "Sort %u draw keys: RadixSortDrawKeys %.1fus, std::sort %.1fus\n", count, radixTime, stdTime );
+		}
+	}
+}
+
+int main()
+{
+	TestKeyOrder();
+	TestRadixSort();
+	BenchmarkSort();
+	return TEST::Result( "draw_key_test" );
+}
@@ -0,0 +1,403 @@
+#include "frame_graph_compiler.h"
+
+#include "test_utils.h"
+
+#include "../Renderer/shaders/shadersCommon.h"
+
+#include <algorithm>
+
+//The graphs of the games are rebuilt here with their resources and accesses only, the pipelines need a device
+namespace
+{
+	using namespace FG;
+
+	constexpr R_HW::GfxShaderStageFlags VS = R_HW::GFX_SHADER_STAGE_VERTEX_BIT;
+	constexpr R_HW::GfxShaderStageFlags FS = R_HW::GFX_SHADER_STAGE_FRAGMENT_BIT;
+	constexpr R_HW::GfxShaderStageFlags CS = R_HW::GFX_SHADER_STAGE_COMPUTE_BIT;
+	constexpr VkExtent2D EXTENT = { 1280, 720 };
+
+	struct TestGraph
+	{
+		std::vector<RenderPassCreationData> passes;
+		std::vector<DataEntry> resources;
+
+		fg_handle_t AddResource( const DataEntry& resourceDesc )
+		{
+			resources.push_back( resourceDesc );
+			return static_cast< fg_handle_t >( resources.size() - 1 );
+		}
+
+		fg_handle_t AddColor( bool external )
+		{
+			return AddResource( CREATE_IMAGE_COLOR( resources.size(), R_HW::GfxFormat::B8G8R8A8_UNORM, EXTENT, 0, external ? eDataEntryFlags::EXTERNAL : eDataEntryFlags::NONE ) );
+		}
+
+		fg_handle_t AddDepth()
+		{
+			return AddResource( CREATE_IMAGE_DEPTH( resources.size(), R_HW::GfxFormat::D32_SFLOAT, EXTENT, 0 ) );
+		}
+
+		fg_handle_t AddBuffer()
+		{
+			return AddResource( CREATE_BUFFER( resources.size(), 64 ) );
+		}
+
+		fg_handle_t AddStorageBuffer()
+		{
+			return AddResource( CREATE_BUFFER_STORAGE( resources.size(), 16, 1024 ) );
+		}
+
+		fg_handle_t AddExternalImage()
+		{
+			return AddResource( CREATE_IMAGE_SAMPLER_EXTERNAL( resources.size(), 1 ) );
+		}
+
+		FrameGraphNode* AddPass( const char* name )
+		{
+			passes.push_back( RenderPassCreationData() );
+			passes.back().name = name;
+			return &passes.back().frame_graph_node;
+		}
+	};
+
+	void Bind( FrameGraphNode* node, fg_handle_t resource, R_HW::eDescriptorAccess access, R_HW::GfxShaderStageFlags stages )
+	{
+		if( node->descriptorSets.empty() )
+			node->descriptorSets.push_back( { RENDERPASS_SET, {} } );
+		DescriptorTableDesc& set = node->descriptorSets.back();
+		set.dataBindings.push_back( { resource, { static_cast< uint32_t >( set.dataBindings.size() ), access, stages } } );
+	}
+
+	struct CompileResult
+	{
+		bool compiled;
+		bool valid;
+		std::string error;
+		CompiledGraph graph;
+	};
+
+	CompileResult Compile( TestGraph* graph )
+	{
+		CompileResult result;
+		FrameGraphCompiler compiler;
+		result.compiled = compiler.Compile( &graph->passes, graph->resources, &result.graph, &result.error );
+		result.valid = result.compiled && ValidateCompiledGraph( graph->passes, graph->resources, result.graph, &result.error );
+		if( !result.valid )
+			printf( "%s\n", result.error.c_str() );
+		return result;
+	}
+
+	const PlannedBarrier* FindBarrier( const CompiledGraph& graph, fg_handle_t resource, uint32_t srcPass, uint32_t dstPass )
+	{
+		for( const PlannedBarrier& barrier : graph.barriers )
+			if( barrier.resourceHandle == resource && barrier.srcPass == srcPass && barrier.dstPass == dstPass )
+				return &barrier;
+		return nullptr;
+	}
+
+	const PlannedBufferBarrier* FindBufferBarrier( const CompiledGraph& graph, fg_handle_t resource, uint32_t srcPass, uint32_t dstPass )
+	{
+		for( const PlannedBufferBarrier& barrier : graph.bufferBarriers )
+			if( barrier.resourceHandle == resource && barrier.srcPass == srcPass && barrier.dstPass == dstPass )
+				return &barrier;
+		return nullptr;
+	}
+
+	bool LifetimesOverlap( const ResourceLifetime& a, const ResourceLifetime& b )
+	{
+		return a.firstUse <= b.lastUse && b.firstUse <= a.lastUse;
+	}
+
+	void TestClassic2DGraph()
+	{
+		TestGraph graph;
+		const fg_handle_t sceneData = graph.AddBuffer();
+		const fg_handle_t instanceData = graph.AddResource( CREATE_BUFFER_DYNAMIC( graph.resources.size(), 64, 256 ) );
+		const fg_handle_t bindlessTextures = graph.AddExternalImage();
+		const fg_handle_t textTexture = graph.AddExternalImage();
+		const fg_handle_t sceneDepth = graph.AddDepth();
+		const fg_handle_t sceneColor = graph.AddResource( CREATE_IMAGE_COLOR_SAMPLER( graph.resources.size(), R_HW::GfxFormat::B8G8R8A8_UNORM, EXTENT, R_HW::GfxImageUsageFlagBits::SAMPLED, eSamplers::Point ) );
+		const fg_handle_t backbuffer = graph.AddColor( true );
+
+		FrameGraphNode* geometry = graph.AddPass( "geometry_pass" );
+		Bind( geometry, sceneData, R_HW::eDescriptorAccess::READ, VS | FS );
+		Bind( geometry, bindlessTextures, R_HW::eDescriptorAccess::READ, FS );
+		Bind( geometry, instanceData, R_HW::eDescriptorAccess::READ, VS );
+		geometry->renderTargetRefs.push_back( { sceneColor, FG_RENDERTARGET_REF_CLEAR_BIT } );
+		geometry->renderTargetRefs.push_back( { sceneDepth, FG_RENDERTARGET_REF_CLEAR_BIT } );
+
+		FrameGraphNode* text = graph.AddPass( "text_pass" );
+		Bind( text, textTexture, R_HW::eDescriptorAccess::READ, FS );
+		text->renderTargetRefs.push_back( { sceneColor, 0 } );
+
+		FrameGraphNode* copy = graph.AddPass( "copy_pass" );
+		Bind( copy, sceneColor, R_HW::eDescriptorAccess::READ, FS );
+		copy->renderTargetRefs.push_back( { backbuffer, 0 } );
+		copy->renderTargetRefs.push_back( { sceneColor, FG_RENDERTARGET_REF_READ_BIT } );
+
+		const CompileResult result = Compile( &graph );
+		CHECK( result.valid );
+		CHECK( ( result.graph.passOrder == std::vector<uint32_t>{ 0, 1, 2 } ) );
+
+		//The text pass loads what the geometry pass drew and the copy samples the result
+		CHECK( graph.passes[1].descriptions[0].loadOp == R_HW::GfxLoadOp::LOAD );
+		const PlannedBarrier* toRead = FindBarrier( result.graph, sceneColor, 1, 2 );
+		CHECK( toRead && toRead->newAccess == R_HW::GfxAccess::READ );
+		CHECK( result.graph.lifetimes[sceneDepth].firstUse == 0 && result.graph.lifetimes[sceneDepth].lastUse == 0 );
+	}
+
+	void TestPbrGraph()
+	{
+		TestGraph graph;
+		const fg_handle_t instanceData = graph.AddResource( CREATE_BUFFER_DYNAMIC( graph.resources.size(), 64, 256 ) );
+		const fg_handle_t sceneData = graph.AddBuffer();
+		const fg_handle_t shadowData = graph.AddBuffer();
+		const fg_handle_t lightData = graph.AddBuffer();
+		const fg_handle_t skyboxData = graph.AddBuffer();
+		const fg_handle_t bindlessTextures = graph.AddResource( CREATE_IMAGE_EXTERNAL( graph.resources.size(), 64 ) );
+		const fg_handle_t textTexture = graph.AddExternalImage();
+		const fg_handle_t skyboxTexture = graph.AddExternalImage();
+		const fg_handle_t sceneDepth = graph.AddDepth();
+		const fg_handle_t shadowMap = graph.AddResource( CREATE_IMAGE_DEPTH_SAMPLER( graph.resources.size(), R_HW::GfxFormat::D32_SFLOAT, EXTENT, R_HW::GfxImageUsageFlagBits::SAMPLED, eSamplers::Shadow ) );
+		const fg_handle_t sceneColor = graph.AddColor( true );
+
+		FrameGraphNode* shadow = graph.AddPass( "shadow_pass" );
+		Bind( shadow, shadowData, R_HW::eDescriptorAccess::READ, VS );
+		Bind( shadow, instanceData, R_HW::eDescriptorAccess::READ, VS );
+		shadow->renderTargetRefs.push_back( { shadowMap, FG_RENDERTARGET_REF_CLEAR_BIT } );
+
+		FrameGraphNode* geometry = graph.AddPass( "geometry_pass" );
+		Bind( geometry, sceneData, R_HW::eDescriptorAccess::READ, VS | FS );
+		Bind( geometry, lightData, R_HW::eDescriptorAccess::READ, VS | FS );
+		Bind( geometry, bindlessTextures, R_HW::eDescriptorAccess::READ, FS );
+		Bind( geometry, shadowMap, R_HW::eDescriptorAccess::READ, FS );
+		Bind( geometry, instanceData, R_HW::eDescriptorAccess::READ, VS );
+		geometry->renderTargetRefs.push_back( { sceneColor, FG_RENDERTARGET_REF_CLEAR_BIT } );
+		geometry->renderTargetRefs.push_back( { sceneDepth, FG_RENDERTARGET_REF_CLEAR_BIT } );
+		geometry->renderTargetRefs.push_back( { shadowMap, FG_RENDERTARGET_REF_READ_BIT } );
+
+		FrameGraphNode* skybox = graph.AddPass( "skybox_pass" );
+		Bind( skybox, skyboxData, R_HW::eDescriptorAccess::READ, VS );
+		Bind( skybox, skyboxTexture, R_HW::eDescriptorAccess::READ, FS );
+		skybox->renderTargetRefs.push_back( { sceneColor, 0 } );
+		skybox->renderTargetRefs.push_back( { sceneDepth, FG_RENDERTARGET_REF_DEPTH_READ } );
+
+		FrameGraphNode* text = graph.AddPass( "text_pass" );
+		Bind( text, textTexture, R_HW::eDescriptorAccess::READ, FS );
+		text->renderTargetRefs.push_back( { sceneColor, 0 } );
+
+		const CompileResult result = Compile( &graph );
+		CHECK( result.valid );
+		CHECK( ( result.graph.passOrder == std::vector<uint32_t>{ 0, 1, 2, 3 } ) );
+
+		const PlannedBarrier* shadowToRead = FindBarrier( result.graph, shadowMap, 0, 1 );
+		CHECK( shadowToRead && shadowToRead->oldLayout == R_HW::GfxLayout::DEPTH_STENCIL && shadowToRead->newAccess == R_HW::GfxAccess::READ );
+		//The skybox tests against the depth without writing it
+		CHECK( graph.passes[2].descriptions[1].access == R_HW::GfxAccess::READ );
+		//Only written by the CPU, no barrier between passes
+		CHECK( result.graph.bufferBarriers.empty() );
+		CHECK( !LifetimesOverlap( result.graph.lifetimes[shadowData], result.graph.lifetimes[skyboxData] ) );
+	}
+
+	void TestRetroGraph( bool btDrawDebug )
+	{
+		TestGraph graph;
+		const fg_handle_t instanceData = graph.AddStorageBuffer();
+		const fg_handle_t sceneData = graph.AddBuffer();
+		const fg_handle_t shadowData = graph.AddBuffer();
+		const fg_handle_t lightData = graph.AddBuffer();
+		const fg_handle_t skyboxData = graph.AddBuffer();
+		const fg_handle_t cullingData = graph.AddBuffer();
+		const fg_handle_t drawCommands = graph.AddResource( CREATE_BUFFER_INDIRECT( graph.resources.size(), 20, 1024 ) );
+		const fg_handle_t shadowDrawCommands = graph.AddResource( CREATE_BUFFER_INDIRECT( graph.resources.size(), 20, 1024 ) );
+		const fg_handle_t visibleInstances = graph.AddStorageBuffer();
+		const fg_handle_t shadowVisibleInstances = graph.AddStorageBuffer();
+		const fg_handle_t bindlessTextures = graph.AddResource( CREATE_IMAGE_BINDLESS( graph.resources.size(), BINDLESS_TEXTURES_MAX ) );
+		const fg_handle_t textTexture = graph.AddExternalImage();
+		const fg_handle_t skyboxTexture = graph.AddExternalImage();
+		const fg_handle_t samplers = graph.AddResource( CREATE_SAMPLER_EXTERNAL( graph.resources.size(), SAMPLERS_MAX ) );
+		const fg_handle_t materials = graph.AddResource( CREATE_BUFFER_STORAGE_EXTERNAL( graph.resources.size() ) );
+		const fg_handle_t sceneDepth = graph.AddResource( CREATE_IMAGE_DEPTH_SWAPCHAIN_SIZED( graph.resources.size(), R_HW::GfxFormat::D32_SFLOAT, EXTENT, 0 ) );
+		const fg_handle_t shadowMap = graph.AddResource( CREATE_IMAGE_DEPTH_SAMPLER( graph.resources.size(), R_HW::GfxFormat::D32_SFLOAT, EXTENT, R_HW::GfxImageUsageFlagBits::SAMPLED, eSamplers::Shadow ) );
+		const fg_handle_t sceneColor = graph.AddColor( true );
+
+		FrameGraphNode* culling = graph.AddPass( "culling_pass" );
+		culling->isCompute = true;
+		Bind( culling, cullingData, R_HW::eDescriptorAccess::READ, CS );
+		Bind( culling, instanceData, R_HW::eDescriptorAccess::READ, CS );
+		Bind( culling, drawCommands, R_HW::eDescriptorAccess::WRITE, CS );
+		Bind( culling, visibleInstances, R_HW::eDescriptorAccess::WRITE, CS );
+		Bind( culling, shadowDrawCommands, R_HW::eDescriptorAccess::WRITE, CS );
+		Bind( culling, shadowVisibleInstances, R_HW::eDescriptorAccess::WRITE, CS );
+
+		FrameGraphNode* shadow = graph.AddPass( "shadow_pass" );
+		Bind( shadow, shadowData, R_HW::eDescriptorAccess::READ, VS );
+		Bind( shadow, instanceData, R_HW::eDescriptorAccess::READ, VS );
+		Bind( shadow, shadowVisibleInstances, R_HW::eDescriptorAccess::READ, VS );
+		shadow->renderTargetRefs.push_back( { shadowMap, FG_RENDERTARGET_REF_CLEAR_BIT } );
+		shadow->indirectBufferRefs.push_back( shadowDrawCommands );
+
+		FrameGraphNode* opaque = graph.AddPass( "opaque_pass" );
+		Bind( opaque, sceneData, R_HW::eDescriptorAccess::READ, VS | FS );
+		Bind( opaque, lightData, R_HW::eDescriptorAccess::READ, VS | FS );
+		Bind( opaque, bindlessTextures, R_HW::eDescriptorAccess::READ, FS );
+		Bind( opaque, samplers, R_HW::eDescriptorAccess::READ, VS | FS );
+		Bind( opaque, shadowMap, R_HW::eDescriptorAccess::READ, FS );
+		Bind( opaque, materials, R_HW::eDescriptorAccess::READ, FS );
+		Bind( opaque, instanceData, R_HW::eDescriptorAccess::READ, VS );
+		Bind( opaque, visibleInstances, R_HW::eDescriptorAccess::READ, VS );
+		opaque->renderTargetRefs.push_back( { sceneColor, FG_RENDERTARGET_REF_CLEAR_BIT } );
+		opaque->renderTargetRefs.push_back( { sceneDepth, FG_RENDERTARGET_REF_CLEAR_BIT } );
+		opaque->renderTargetRefs.push_back( { shadowMap, FG_RENDERTARGET_REF_READ_BIT } );
+		opaque->indirectBufferRefs.push_back( drawCommands );
+
+		FrameGraphNode* skybox = graph.AddPass( "skybox_pass" );
+		Bind( skybox, skyboxData, R_HW::eDescriptorAccess::READ, VS );
+		Bind( skybox, skyboxTexture, R_HW::eDescriptorAccess::READ, FS );
+		skybox->renderTargetRefs.push_back( { sceneColor, 0 } );
+		skybox->renderTargetRefs.push_back( { sceneDepth, FG_RENDERTARGET_REF_DEPTH_READ } );
+
+		if( btDrawDebug )
+		{
+			FrameGraphNode* btDebug = graph.AddPass( "bullet_debug_pass" );
+			Bind( btDebug, sceneData, R_HW::eDescriptorAccess::READ, VS | FS );
+			btDebug->renderTargetRefs.push_back( { sceneColor, 0 } );
+		}
+
+		FrameGraphNode* text = graph.AddPass( "text_pass" );
+		Bind( text, textTexture, R_HW::eDescriptorAccess::READ, FS );
+		text->renderTargetRefs.push_back( { sceneColor, 0 } );
+
+		const CompileResult result = Compile( &graph );
+		CHECK( result.valid );
+		CHECK( result.graph.passOrder.size() == graph.passes.size() );
+		CHECK( std::is_sorted( result.graph.passOrder.begin(), result.graph.passOrder.end() ) );
+
+		//The culling outputs are consumed as indirect arguments and in the vertex shaders
+		const PlannedBufferBarrier* shadowCommands = FindBufferBarrier( result.graph, shadowDrawCommands, 0, 1 );
+		CHECK( shadowCommands && shadowCommands->srcStages == R_HW::GFX_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+		CHECK( shadowCommands && shadowCommands->dstStages == R_HW::GFX_PIPELINE_STAGE_DRAW_INDIRECT_BIT && shadowCommands->dstAccess == R_HW::GFX_ACCESS_INDIRECT_COMMAND_READ_BIT );
+		const PlannedBufferBarrier* commands = FindBufferBarrier( result.graph, drawCommands, 0, 2 );
+		CHECK( commands && commands->dstAccess == R_HW::GFX_ACCESS_INDIRECT_COMMAND_READ_BIT );
+		const PlannedBufferBarrier* visible = FindBufferBarrier( result.graph, visibleInstances, 0, 2 );
+		CHECK( visible && visible->dstStages == R_HW::GFX_PIPELINE_STAGE_VERTEX_SHADER_BIT && visible->dstAccess == R_HW::GFX_ACCESS_SHADER_READ_BIT );
+		CHECK( FindBufferBarrier( result.graph, shadowVisibleInstances, 0, 1 ) );
+		CHECK( result.graph.bufferBarriers.size() == 4 );
+
+		const PlannedBarrier* shadowToRead = FindBarrier( result.graph, shadowMap, 1, 2 );
+		CHECK( shadowToRead && shadowToRead->newAccess == R_HW::GfxAccess::READ );
+
+		//The shadow outputs are dead after the opaque pass, the skybox data could share their memory
+		CHECK( result.graph.lifetimes[shadowMap].lastUse == 2 );
+		CHECK( !LifetimesOverlap( result.graph.lifetimes[shadowVisibleInstances], result.graph.lifetimes[skyboxData] ) );
+		CHECK( LifetimesOverlap( result.graph.lifetimes[sceneColor], result.graph.lifetimes[textTexture] ) );
+	}
+
+	//Pass i samples the target of pass i - 1 and renders into its own, the last target is presented
+	TestGraph CreateChainGraph( uint32_t passCount )
+	{
+		TestGraph graph;
+		std::vector<fg_handle_t> targets;
+		for( uint32_t i = 0; i < passCount; ++i )
+			targets.push_back( graph.AddColor( i == passCount - 1 ) );
+
+		for( uint32_t i = 0; i < passCount; ++i )
+		{
+			FrameGraphNode* node = graph.AddPass( nullptr );
+			node->renderTargetRefs.push_back( { targets[i], FG_RENDERTARGET_REF_CLEAR_BIT } );
+			if( i > 0 )
+				node->renderTargetRefs.push_back( { targets[i - 1], FG_RENDERTARGET_REF_READ_BIT } );
+		}
+		return graph;
+	}
+
+	//Every other pass renders into a target nobody reads and gets culled
+	TestGraph CreateGraphWithDeadPasses( uint32_t passCount )
+	{
+		TestGraph graph;
+		const fg_handle_t sceneColor = graph.AddColor( true );
+		const fg_handle_t sceneData = graph.AddBuffer();
+		for( uint32_t i = 0; i < passCount; ++i )
+		{
+			FrameGraphNode* node = graph.AddPass( nullptr );
+			Bind( node, sceneData, R_HW::eDescriptorAccess::READ, VS );
+			if( i % 2 == 0 )
+				node->renderTargetRefs.push_back( { sceneColor, i == 0 ? FG_RENDERTARGET_REF_CLEAR_BIT : 0u } );
+			else
+				node->renderTargetRefs.push_back( { graph.AddColor( false ), FG_RENDERTARGET_REF_CLEAR_BIT } );
+		}
+		return graph;
+	}
+
+	void TestSyntheticGraphs()
+	{
+		constexpr uint32_t PASS_COUNT = 100;
+
+		TestGraph chain = CreateChainGraph( PASS_COUNT );
+		const CompileResult chainResult = Compile( &chain );
+		CHECK( chainResult.valid );
+		CHECK( chainResult.graph.passOrder.size() == PASS_COUNT );
+		CHECK( chainResult.graph.barriers.size() == PASS_COUNT - 1 );
+		for( uint32_t i = 0; i + 1 < PASS_COUNT; ++i )
+		{
+			const PlannedBarrier* barrier = FindBarrier( chainResult.graph, i, i, i + 1 );
+			CHECK( barrier && barrier->oldAccess == R_HW::GfxAccess::WRITE && barrier->newAccess == R_HW::GfxAccess::READ );
+		}
+		//Only neighbours are alive at the same time, two targets are enough for the whole chain
+		for( uint32_t i = 0; i + 2 < PASS_COUNT; ++i )
+		{
+			CHECK( LifetimesOverlap( chainResult.graph.lifetimes[i], chainResult.graph.lifetimes[i + 1] ) );
+			CHECK( !LifetimesOverlap( chainResult.graph.lifetimes[i], chainResult.graph.lifetimes[i + 2] ) );
+		}
+
+		TestGraph dead = CreateGraphWithDeadPasses( PASS_COUNT );
+		const CompileResult deadResult = Compile( &dead );
+		CHECK( deadResult.valid );
+		CHECK( deadResult.graph.passOrder.size() == PASS_COUNT / 2 );
+		CHECK( std::count( deadResult.graph.culledPasses.begin(), deadResult.graph.culledPasses.end(), true ) == PASS_COUNT / 2 );
+		for( uint32_t passIndex : deadResult.graph.passOrder )
+			CHECK( passIndex % 2 == 0 );
+		CHECK( deadResult.graph.barriers.empty() );
+
+		//A pass reading a target before it is written is refused
+		TestGraph invalid = CreateChainGraph( 3 );
+		std::swap( invalid.passes[0], invalid.passes[1] );
+		FrameGraphCompiler compiler;
+		CompiledGraph compiledGraph;
+		std::string error;
+		CHECK( !compiler.Compile( &invalid.passes, invalid.resources, &compiledGraph, &error ) && !error.empty() );
+	}
+
+	void BenchmarkCompile()
+	{
+		constexpr uint32_t ITERATIONS = 200;
+		const TestGraph chain = CreateChainGraph( 100 );
+		const TestGraph dead = CreateGraphWithDeadPasses( 100 );
+
+		FrameGraphCompiler compiler;
+		CompiledGraph compiledGraph;
+		std::string error;
+		const double chainTime = TEST::MeasureMicroseconds( ITERATIONS, [&]()
+			{
+				TestGraph graph = chain;
+				compiler.Compile( &graph.passes, graph.resources, &compiledGraph, &error );
+			} );
+		const double deadTime = TEST::MeasureMicroseconds( ITERATIONS, [&]()
+			{
+				TestGraph graph = dead;
+				compiler.Compile( &graph.passes, graph.resources, &compiledGraph, &error );
+			} );
+		printf( "Compile 100 passes chain: %.1fus, with 50 culled passes: %.1fus\n", chainTime, deadTime );
+	}
+}
+
+int main()
+{
+	TestClassic2DGraph();
+	TestPbrGraph();
+	TestRetroGraph( false );
+	TestRetroGraph( true );
+	TestSyntheticGraphs();
+	BenchmarkCompile();
+	return TEST::Result( "frame_graph_compiler_test" );
+}
@@ -0,0 +1,122 @@
+#include "frustum.h"
+
+#include "test_utils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	constexpr uint32_t INSTANCES_COUNT = 100000;
+
+	//Spheres spread in a cube around the camera, about one in ten is visible
+	BoundingSpheresSoA CreateSpheres( uint32_t count )
+	{
+		std::mt19937 generator( 42 );
+		std::uniform_real_distribution<float> position( -200.0f, 200.0f );
+		std::uniform_real_distribution<float> radius( 0.1f, 5.0f );
+
+		BoundingSpheresSoA spheres;
+		spheres.Resize( count );
+		for( uint32_t i = 0; i < count; ++i )
+		{
+			spheres.centerX[i] = position( generator );
+			spheres.centerY[i] = position( generator );
+			spheres.centerZ[i] = position( generator );
+			spheres.radius[i] = radius( generator );
+		}
+		return spheres;
+	}
+
+	glm::mat4 CreateViewProj( const glm::vec3& eye, const glm::vec3& target, float farPlane )
+	{
+		const glm::mat4 proj = glm::perspective( glm::radians( 60.0f ), 16.0f / 9.0f, 0.1f, farPlane );
+		return proj * glm::lookAt( eye, target, glm::vec3( 0.0f, 1.0f, 0.0f ) );
+	}
+
+	void TestPlanes()
+	{
+		glm::vec4 planes[FRUSTUM_PLANES_COUNT];
+		ExtractFrustumPlanes( CreateViewProj( glm::vec3( 0.0f ), glm::vec3( 0.0f, 0.0f, 1.0f ), 100.0f ), planes );
+
+		CHECK( IsSphereInFrustum( planes, glm::vec3( 0.0f, 0.0f, 10.0f ), 0.5f ) );
+		CHECK( !IsSphereInFrustum( planes, glm::vec3( 0.0f, 0.0f, -10.0f ), 0.5f ) );
+		CHECK( !IsSphereInFrustum( planes, glm::vec3( 0.0f, 0.0f, 150.0f ), 0.5f ) );
+		CHECK( IsSphereInFrustum( planes, glm::vec3( 0.0f, 0.0f, 101.0f ), 2.0f ) );
+		CHECK( !IsSphereInFrustum( planes, glm::vec3( 100.0f, 0.0f, 10.0f ), 1.0f ) );
+	}
+
+	//The SIMD loops must give the same result as the scalar tests, including the tail after the last group of 4
+	void TestCullingMatchesScalar()
+	{
+		const BoundingSpheresSoA spheres = CreateSpheres( INSTANCES_COUNT + 3 );
+		glm::vec4 planes[FRUSTUM_PLANES_COUNT];
+		ExtractFrustumPlanes( CreateViewProj( glm::vec3( 0.0f ), glm::vec3( 1.0f, 0.2f, 1.0f ), 300.0f ), planes );
+
+		std::vector<uint8_t> visible( spheres.radius.size(), 0 );
+		CullSpheres( planes, spheres, visible.data() );
+
+		uint32_t mismatchCount = 0;
+		uint32_t visibleCount = 0;
+		for( size_t i = 0; i < spheres.radius.size(); ++i )
+		{
+			const bool expected = IsSphereInFrustum( planes, glm::vec3( spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i] ), spheres.radius[i] );
+			mismatchCount += expected != ( visible[i] != 0 );
+			visibleCount += visible[i];
+		}
+		CHECK( mismatchCount == 0 );
+		CHECK( visibleCount > 0 && visibleCount < spheres.radius.size() );
+
+		//Calls for several frusta add up, the swept spheres contain the spheres
+		const glm::vec3 lightPosition( 0.0f, 300.0f, 0.0f );
+		std::vector<uint8_t> sweptVisible( spheres.radius.size(), 0 );
+		CullSweptSpheres( planes, lightPosition, 500.0f, spheres, sweptVisible.data() );
+		uint32_t lostCount = 0;
+		uint32_t sweptCount = 0;
+		for( size_t i = 0; i < spheres.radius.size(); ++i )
+		{
+			lostCount += visible[i] && !sweptVisible[i];
+			sweptCount += sweptVisible[i];
+		}
+		CHECK( lostCount == 0 );
+		CHECK( sweptCount >= visibleCount );
+	}
+
+	void BenchmarkCulling()
+	{
+		constexpr uint32_t ITERATIONS = 50;
+		const BoundingSpheresSoA spheres = CreateSpheres( INSTANCES_COUNT );
+		glm::vec4 planes[FRUSTUM_PLANES_COUNT];
+		ExtractFrustumPlanes( CreateViewProj( glm::vec3( 0.0f ), glm::vec3( 1.0f, 0.2f, 1.0f ), 300.0f ), planes );
+
+		std::vector<uint8_t> visible( INSTANCES_COUNT );
+		uint32_t scalarVisibleCount = 0;
+		const double scalarTime = TEST::MeasureMicroseconds( ITERATIONS, [&]()
+			{
+				scalarVisibleCount = 0;
+				for( uint32_t i = 0; i < INSTANCES_COUNT; ++i )
+					scalarVisibleCount += IsSphereInFrustum( planes, glm::vec3( spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i] ), spheres.radius[i] );
+			} );
+		const double simdTime = TEST::MeasureMicroseconds( ITERATIONS, [&]()
+			{
+				std::fill( visible.begin(), visible.end(), 0 );
+				CullSpheres( planes, spheres, visible.data() );
+			} );
+		const double sweptTime = TEST::MeasureMicroseconds( ITERATIONS, [&]()
+			{
+				std::fill( visible.begin(), visible.end(), 0 );
+				CullSweptSpheres( planes, glm::vec3( 0.0f, 300.0f, 0.0f ), 500.0f, spheres, visible.data() );
+			} );
+		printf( "Cull %u spheres: scalar %.1fus, CullSpheres %.1fus, CullSweptSpheres %.1fus, %u visible\n", INSTANCES_COUNT, scalarTime, simdTime, sweptTime, scalarVisibleCount );
+	}
+}
+
+int main()
+{
+	TestPlanes();
+	TestCullingMatchesScalar();
+	BenchmarkCulling();
+	return TEST::Result( "frustum_culling_test" );
+}
@@ -0,0 +1,127 @@
+#include "mesh_optimizer.h"
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <tuple>
+
+namespace
+{
+	constexpr uint32_t GRID_SIZE = 100;
+
+	//Indexed grid of GRID_SIZE x GRID_SIZE quads with the triangles in a random order
+	void BuildShuffledGrid( std::vector<glm::vec3>* o_positions, std::vector<uint32_t>* o_indices )
+	{
+		const uint32_t rowSize = GRID_SIZE + 1;
+		o_positions->clear();
+		for( uint32_t y = 0; y < rowSize; ++y )
+			for( uint32_t x = 0; x < rowSize; ++x )
+				o_positions->push_back( glm::vec3( x, y, 0.0f ) );
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for( uint32_t y = 0; y < GRID_SIZE; ++y )
+		{
+			for( uint32_t x = 0; x < GRID_SIZE; ++x )
+			{
+				const uint32_t i = y * rowSize + x;
+				triangles.push_back( { i, i + 1, i + rowSize } );
+				triangles.push_back( { i + 1, i + rowSize + 1, i + rowSize } );
+			}
+		}
+		std::shuffle( triangles.begin(), triangles.end(), std::mt19937( 1 ) );
+
+		o_indices->clear();
+		for( const std::array<uint32_t, 3>& triangle : triangles )
+			o_indices->insert( o_indices->end(), triangle.begin(), triangle.end() );
+	}
+
+	//Triangles as sorted position triplets, to compare meshes whatever their vertex and triangle order
+	std::vector<std::array<glm::vec3, 3>> GetTriangleSet( const glm::vec3* positions, const std::vector<uint32_t>& indices )
+	{
+		auto lessPosition = []( const glm::vec3& a, const glm::vec3& b ) { return std::tie( a.x, a.y, a.z ) < std::tie( b.x, b.y, b.z ); };
+		std::vector<std::array<glm::vec3, 3>> triangles;
+		for( size_t i = 0; i < indices.size(); i += 3 )
+		{
+			std::array<glm::vec3, 3> triangle = { positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]] };
+			std::sort( triangle.begin(), triangle.end(), lessPosition );
+			triangles.push_back( triangle );
+		}
+		std::sort( triangles.begin(), triangles.end(), [&]( const std::array<glm::vec3, 3>& a, const std::array<glm::vec3, 3>& b ) {
+			return std::lexicographical_compare( a.begin(), a.end(), b.begin(), b.end(), lessPosition );
+		} );
+		return triangles;
+	}
+
+	void TestVertexCache()
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		BuildShuffledGrid( &positions, &indices );
+
+		const std::vector<uint32_t> originalIndices = indices;
+		const float acmrBefore = ComputeACMR( indices.data(), indices.size(), VERTEX_CACHE_SIZE );
+		OptimizeVertexCache( indices.data(), indices.size(), positions.size() );
+		const float acmrAfter = ComputeACMR( indices.data(), indices.size(), VERTEX_CACHE_SIZE );
+
+		//A regular grid is around 0.6 once sorted, random order is close to the worst case of 3
+		CHECK( acmrBefore > 2.0f );
+		CHECK( acmrAfter < 0.8f );
+		CHECK( GetTriangleSet( positions.data(), indices ) == GetTriangleSet( positions.data(), originalIndices ) );
+	}
+
+	//The whole pipeline on an unindexed mesh: vertices get merged and the ACMR drops
+	void TestOptimizeMesh()
+	{
+		std::vector<glm::vec3> gridPositions;
+		std::vector<uint32_t> gridIndices;
+		BuildShuffledGrid( &gridPositions, &gridIndices );
+
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		for( uint32_t index : gridIndices )
+		{
+			indices.push_back( static_cast< uint32_t >(positions.size()) );
+			positions.push_back( gridPositions[index] );
+		}
+		std::vector<glm::vec3> normals( positions.size(), glm::vec3( 0.0f, 0.0f, 1.0f ) );
+
+		const std::vector<MeshStream> streams = { { positions.data(), sizeof( glm::vec3 ) }, { normals.data(), sizeof( glm::vec3 ) } };
+		size_t vertexCount = positions.size();
+		const MeshOptimizationStats stats = OptimizeMesh( streams, 1, &vertexCount, &indices );
+
+		CHECK( stats.triangleCount == gridIndices.size() / 3 );
+		CHECK( stats.vertexCountBefore == gridIndices.size() );
+		CHECK( vertexCount == gridPositions.size() );
+		CHECK( stats.vertexCountAfter == vertexCount );
+		CHECK( stats.acmrBefore == 3.0f );
+		CHECK( stats.acmrAfter < 0.8f );
+		CHECK( stats.acmrAfter == ComputeACMR( indices.data(), indices.size(), VERTEX_CACHE_SIZE ) );
+		CHECK( std::all_of( indices.begin(), indices.end(), [&]( uint32_t index ) { return index < vertexCount; } ) );
+		CHECK( GetTriangleSet( positions.data(), indices ) == GetTriangleSet( gridPositions.data(), gridIndices ) );
+	}
+
+	//Scene totals: the counts add up and the ACMRs are weighted by the triangles
+	void TestAddStats()
+	{
+		MeshOptimizationStats total = {};
+		AddMeshOptimizationStats( { 100, 300, 60, 3.0f, 1.0f }, &total );
+		AddMeshOptimizationStats( { 300, 900, 160, 2.0f, 0.6f }, &total );
+
+		CHECK( total.triangleCount == 400 );
+		CHECK( total.vertexCountBefore == 1200 );
+		CHECK( total.vertexCountAfter == 220 );
+		CHECK( std::abs( total.acmrBefore - 2.25f ) < 1e-5f );
+		CHECK( std::abs( total.acmrAfter - 0.7f ) < 1e-5f );
+	}
+}
+
+int main()
+{
+	TestVertexCache();
+	TestOptimizeMesh();
+	TestAddStats();
+	return TEST::Result( "mesh_optimizer_test" );
+}
@@ -0,0 +1,166 @@
+#include "mesh_simplifier.h"
+#include "gfx_model.h"
+
+#include "test_utils.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr uint32_t GRID_SIZE = 64;
+
+	//Closed surface so no vertex is locked on a border: a sphere with bumps of the given height
+	void BuildBumpySphere( float bumpHeight, std::vector<glm::vec3>* o_positions, std::vector<uint32_t>* o_indices )
+	{
+		o_positions->clear();
+		o_indices->clear();
+		const uint32_t rings = GRID_SIZE;
+		const uint32_t segments = GRID_SIZE * 2;
+		const float pi = 3.14159265f;
+
+		auto surfacePoint = [&]( float theta, float phi ) {
+			const glm::vec3 direction( sinf( theta ) * cosf( phi ), sinf( theta ) * sinf( phi ), cosf( theta ) );
+			return direction * ( 1.0f + bumpHeight * sinf( 6.0f * theta ) * sinf( 5.0f * phi ) );
+		};
+
+		o_positions->push_back( surfacePoint( 0.0f, 0.0f ) );
+		for( uint32_t ring = 1; ring < rings; ++ring )
+			for( uint32_t segment = 0; segment < segments; ++segment )
+				o_positions->push_back( surfacePoint( pi * ring / rings, 2.0f * pi * segment / segments ) );
+		o_positions->push_back( surfacePoint( pi, 0.0f ) );
+
+		const uint32_t southPole = static_cast< uint32_t >( o_positions->size() - 1 );
+		auto ringVertex = [&]( uint32_t ring, uint32_t segment ) { return 1 + ( ring - 1 ) * segments + segment % segments; };
+		for( uint32_t segment = 0; segment < segments; ++segment )
+		{
+			o_indices->insert( o_indices->end(), { 0, ringVertex( 1, segment ), ringVertex( 1, segment + 1 ) } );
+			for( uint32_t ring = 1; ring + 1 < rings; ++ring )
+			{
+				const uint32_t a = ringVertex( ring, segment ), b = ringVertex( ring, segment + 1 );
+				const uint32_t c = ringVertex( ring + 1, segment ), d = ringVertex( ring + 1, segment + 1 );
+				o_indices->insert( o_indices->end(), { a, c, b, b, c, d } );
+			}
+			o_indices->insert( o_indices->end(), { ringVertex( rings - 1, segment ), southPole, ringVertex( rings - 1, segment + 1 ) } );
+		}
+	}
+
+	//Largest distance from a vertex of the base mesh to the simplified surface, along its direction from the center.
+	//The simplified sphere stays star shaped around its center, each base vertex is projected on the simplified triangles
+	float MeasureRadialDeviation( const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& simplifiedIndices )
+	{
+		float maxDeviation = 0.0f;
+		for( const glm::vec3& position : positions )
+		{
+			const glm::vec3 direction = glm::normalize( position );
+			float closest = std::numeric_limits<float>::max();
+			for( size_t i = 0; i < simplifiedIndices.size(); i += 3 )
+			{
+				const glm::vec3& p0 = positions[simplifiedIndices[i]];
+				const glm::vec3& p1 = positions[simplifiedIndices[i + 1]];
+				const glm::vec3& p2 = positions[simplifiedIndices[i + 2]];
+				//Ray from the center against the triangle
+				const glm::vec3 edge1 = p1 - p0, edge2 = p2 - p0;
+				const glm::vec3 h = glm::cross( direction, edge2 );
+				const float determinant = glm::dot( edge1, h );
+				if( std::abs( determinant ) < 1e-12f )
+					continue;
+				const glm::vec3 s = -p0;
+				const float u = glm::dot( s, h ) / determinant;
+				const glm::vec3 q = glm::cross( s, edge1 );
+				const float v = glm::dot( direction, q ) / determinant;
+				const float t = glm::dot( edge2, q ) / determinant;
+				if( u < -1e-5f || v < -1e-5f || u + v > 1.0f + 1e-5f || t <= 0.0f )
+					continue;
+				closest = std::min( closest, std::abs( t - glm::length( position ) ) );
+			}
+			maxDeviation = std::max( maxDeviation, closest );
+		}
+		return maxDeviation;
+	}
+
+	//Flat regions collapse for free, curved ones stop at the error asked
+	void TestErrorBound()
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		BuildBumpySphere( 0.05f, &positions, &indices );
+
+		std::vector<uint32_t> simplifiedIndices;
+		const float maxError = 0.01f;
+		const float error = SimplifyMesh( positions.data(), positions.size(), indices.data(), indices.size(), 0, maxError, &simplifiedIndices );
+		CHECK( error > 0.0f );
+		CHECK( error <= maxError );
+		CHECK( simplifiedIndices.size() < indices.size() / 2 );
+		CHECK( std::all_of( simplifiedIndices.begin(), simplifiedIndices.end(), [&]( uint32_t index ) { return index < positions.size(); } ) );
+
+		//The quadric error is an area weighted average of the squared distances to the planes, the surface gets up to about three times further
+		const float deviation = MeasureRadialDeviation( positions, simplifiedIndices );
+		CHECK( deviation <= 4.0f * maxError );
+
+		//A tighter bound keeps more triangles
+		std::vector<uint32_t> tighterIndices;
+		const float tighterError = SimplifyMesh( positions.data(), positions.size(), indices.data(), indices.size(), 0, maxError * 0.1f, &tighterIndices );
+		CHECK( tighterError <= maxError * 0.1f );
+		CHECK( tighterIndices.size() > simplifiedIndices.size() );
+	}
+
+	void TestGenerateLods()
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		BuildBumpySphere( 0.05f, &positions, &indices );
+		const size_t baseIndexCount = indices.size();
+
+		GfxModelLod lods[MAX_MODEL_LODS];
+		const uint32_t lodCount = GenerateMeshLods( positions.data(), positions.size(), &indices, MAX_MODEL_LODS, lods );
+		CHECK( lodCount == MAX_MODEL_LODS );
+		CHECK( lods[0].firstIndex == 0 && lods[0].indexCount == baseIndexCount && lods[0].error == 0.0f );
+		for( uint32_t lod = 1; lod < lodCount; ++lod )
+		{
+			CHECK( lods[lod].firstIndex == lods[lod - 1].firstIndex + lods[lod - 1].indexCount );
+			CHECK( lods[lod].indexCount * 4 <= lods[lod - 1].indexCount * 3 );
+			CHECK( lods[lod].error > lods[lod - 1].error );
+		}
+		CHECK( indices.size() == lods[lodCount - 1].firstIndex + lods[lodCount - 1].indexCount );
+	}
+
+	//Coarsest LOD whose projected error stays under the threshold
+	void TestSelectLod()
+	{
+		GfxModel model = {};
+		const GfxModelLod lods[] = { { 0, 3000, 0.0f }, { 3000, 1500, 0.01f }, { 4500, 600, 0.05f }, { 5100, 300, 0.2f } };
+		SetModelLods( lods, 4, &model );
+		CHECK( model.indexCount == 3000 );
+
+		const float maxPixelError = 1.0f;
+		CHECK( SelectModelLod( model, 1000.0f, maxPixelError ) == 0 );
+		CHECK( SelectModelLod( model, 100.0f, maxPixelError ) == 1 );
+		CHECK( SelectModelLod( model, 20.0f, maxPixelError ) == 2 );
+		CHECK( SelectModelLod( model, 5.0f, maxPixelError ) == 3 );
+		CHECK( SelectModelLod( model, 0.0f, maxPixelError ) == 3 );
+
+		uint32_t firstIndex, indexCount;
+		model.firstIndex = 100;
+		GetModelLodRange( model, 2, &firstIndex, &indexCount );
+		CHECK( firstIndex == 4600 && indexCount == 600 );
+
+		//Models without LODs always draw their whole range
+		GfxModel noLodModel = {};
+		noLodModel.indexCount = 36;
+		CHECK( SelectModelLod( noLodModel, 0.0f, maxPixelError ) == 0 );
+		GetModelLodRange( noLodModel, 0, &firstIndex, &indexCount );
+		CHECK( firstIndex == 0 && indexCount == 36 );
+	}
+}
+
+int main()
+{
+	TestErrorBound();
+	TestGenerateLods();
+	TestSelectLod();
+	return TEST::Result( "mesh_simplifier_test" );
+}
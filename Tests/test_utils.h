@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+//Small harness for the CPU only tests, a failed check is reported and makes the test return non zero
+namespace TEST
+{
+	inline int& FailureCount()
+	{
+		static int failureCount = 0;
+		return failureCount;
+	}
+
+	inline int Result( const char* testName )
+	{
+		if( FailureCount() == 0 )
+			printf( "%s: passed\n", testName );
+		else
+			printf( "%s: %d check(s) failed\n", testName, FailureCount() );
+		return FailureCount() == 0 ? 0 : 1;
+	}
+
+	//Average time of a call to function in microseconds
+	template< typename Function >
+	double MeasureMicroseconds( uint32_t iterations, Function function )
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for( uint32_t i = 0; i < iterations; ++i )
+			function();
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration< double, std::micro >( end - start ).count() / iterations;
+	}
+}
+
+#define CHECK( condition ) \
+	do \
+	{ \
+		if( !( condition ) ) \
+		{ \
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition ); \
+			++TEST::FailureCount(); \
+		} \
+	} while( 0 )
@@ -0,0 +1,120 @@
+#include "vertex_quantization.h"
+
+#include "test_utils.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	constexpr size_t VERTEX_COUNT = 10000;
+
+	glm::vec3 RandomDirection( std::mt19937* generator )
+	{
+		std::normal_distribution<float> distribution;
+		glm::vec3 direction;
+		do
+			direction = glm::vec3( distribution( *generator ), distribution( *generator ), distribution( *generator ) );
+		while( glm::dot( direction, direction ) < 1e-6f );
+		return glm::normalize( direction );
+	}
+
+	void TestOctahedralEncoding()
+	{
+		const glm::vec3 axes[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		for( const glm::vec3& axis : axes )
+			CHECK( glm::dot( OctahedralDecode( OctahedralEncode( axis ) ), axis ) > 0.99999f );
+
+		//A null direction decodes to a valid one
+		CHECK( std::abs( glm::length( OctahedralDecode( OctahedralEncode( glm::vec3( 0.0f ) ) ) ) - 1.0f ) < 1e-5f );
+	}
+
+	//Every attribute comes back within the precision of its encoding
+	void TestRoundTrip()
+	{
+		std::mt19937 generator( 1 );
+		std::uniform_real_distribution<float> position( -50.0f, 150.0f );
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		std::uniform_real_distribution<float> texCoord( -2.0f, 2.0f );
+
+		std::vector<glm::vec3> positions( VERTEX_COUNT ), normals( VERTEX_COUNT ), tangents( VERTEX_COUNT ), colors( VERTEX_COUNT );
+		std::vector<glm::vec2> texCoords( VERTEX_COUNT );
+		for( size_t i = 0; i < VERTEX_COUNT; ++i )
+		{
+			positions[i] = glm::vec3( position( generator ), position( generator ) * 0.1f, position( generator ) );
+			normals[i] = RandomDirection( &generator );
+			tangents[i] = RandomDirection( &generator );
+			colors[i] = glm::vec3( unit( generator ), unit( generator ), unit( generator ) );
+			texCoords[i] = glm::vec2( texCoord( generator ), texCoord( generator ) );
+		}
+
+		glm::vec3 dequantOffset;
+		float dequantScale;
+		ComputePositionDequant( positions.data(), VERTEX_COUNT, &dequantOffset, &dequantScale );
+		std::vector<QuantizedVertex> vertices( VERTEX_COUNT );
+		QuantizeVertices( positions.data(), normals.data(), tangents.data(), colors.data(), texCoords.data(), VERTEX_COUNT, dequantOffset, dequantScale, vertices.data() );
+
+		//Half a step of each encoding, with some room for the float math
+		const float positionTolerance = dequantScale / 32767.0f;
+		const float minDirectionDot = cosf( 1e-3f );
+		const float colorTolerance = 0.5f / 255.0f + 1e-6f;
+		const float texCoordTolerance = 2.0f / 2048.0f;
+
+		float maxPositionError = 0.0f;
+		uint32_t failedCount = 0;
+		for( size_t i = 0; i < VERTEX_COUNT; ++i )
+		{
+			glm::vec3 dequantPosition, normal, tangent, color;
+			glm::vec2 dequantTexCoord;
+			DequantizeVertex( vertices[i], dequantOffset, dequantScale, &dequantPosition, &normal, &tangent, &color, &dequantTexCoord );
+
+			const glm::vec3 positionError = glm::abs( dequantPosition - positions[i] );
+			maxPositionError = std::max( { maxPositionError, positionError.x, positionError.y, positionError.z } );
+			const glm::vec3 colorError = glm::abs( color - colors[i] );
+			const glm::vec2 texCoordError = glm::abs( dequantTexCoord - texCoords[i] );
+
+			const bool valid = glm::dot( normal, normals[i] ) >= minDirectionDot && glm::dot( tangent, tangents[i] ) >= minDirectionDot
+				&& std::max( { colorError.x, colorError.y, colorError.z } ) <= colorTolerance
+				&& std::max( texCoordError.x, texCoordError.y ) <= texCoordTolerance;
+			failedCount += !valid;
+		}
+		CHECK( maxPositionError <= positionTolerance );
+		CHECK( failedCount == 0 );
+
+		//The GPU path: quantized position through the dequantization matrix
+		GfxModel model = {};
+		model.positionDequantOffset = dequantOffset;
+		model.positionDequantScale = dequantScale;
+		const glm::mat4 dequantMatrix = GetPositionDequantMatrix( model );
+		const QuantizedVertex& vertex = vertices[42];
+		const glm::vec4 snorm = glm::vec4( vertex.position[0], vertex.position[1], vertex.position[2], 32767.0f ) / 32767.0f;
+		const glm::vec3 transformed = glm::vec3( dequantMatrix * snorm );
+		CHECK( glm::length( transformed - positions[42] ) <= positionTolerance * 2.0f );
+	}
+
+	void TestMissingAttributes()
+	{
+		const glm::vec3 position( 1.0f, 2.0f, 3.0f );
+		QuantizedVertex vertex;
+		QuantizeVertices( &position, nullptr, nullptr, nullptr, nullptr, 1, position, 1.0f, &vertex );
+
+		glm::vec3 dequantPosition, normal, tangent, color;
+		glm::vec2 texCoord;
+		DequantizeVertex( vertex, position, 1.0f, &dequantPosition, &normal, &tangent, &color, &texCoord );
+		CHECK( glm::length( dequantPosition - position ) < 1e-5f );
+		CHECK( glm::dot( normal, glm::vec3( 0.0f, 0.0f, 1.0f ) ) > 0.9999f );
+		CHECK( glm::dot( tangent, glm::vec3( 1.0f, 0.0f, 0.0f ) ) > 0.9999f );
+		CHECK( color == glm::vec3( 1.0f ) );
+		CHECK( texCoord == glm::vec2( 0.0f ) );
+	}
+}
+
+int main()
+{
+	TestOctahedralEncoding();
+	TestRoundTrip();
+	TestMissingAttributes();
+	return TEST::Result( "vertex_quantization_test" );
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "gfx_image.h"
 #include "gfx_model.h"
+#include "geometry_pool.h"
 #include "gfx_asset.h"
 
 #include "glm/vec4.hpp"
@@ -18,7 +19,7 @@ namespace AL
 	GfxModel* CreateQuad( const char* assetName, float width, float height, R_HW::I_BufferAllocator* allocator );
 
 	GfxModel* Load3DModel(const char* assetName, const char* assetPath, uint32_t hackIndex, R_HW::I_BufferAllocator* allocator );
-	GfxModel* LoadglTf3DModel( const char* assetName, const char* assetPath, R_HW::I_BufferAllocator* allocator );
+	GfxModel* LoadglTf3DModel( const char* assetName, const char* assetPath, R_HW::I_BufferAllocator* allocator, GeometryPool* geometryPool = nullptr );
 	GfxModel* RegisterGfxModel( const char* assetName, GfxModel&& model );
 
 	void* GetAsset(const char* assetName);
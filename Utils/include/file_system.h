@@ -6,4 +6,7 @@
 namespace FS
 {
 	std::vector<char> readFile(const std::string& filename);
+	//Don't throw, return false when the file can't be opened
+	bool tryReadFile( const std::string& filename, std::vector<char>* o_data );
+	bool writeFile( const std::string& filename, const std::vector<char>& data );
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "assimp_loader.h"
 #include "stb_image.h"
 #include "generate_geometry.h"
+#include "cpu_profiler.h"
 
 #include <vector>
 #include <array>
@@ -52,6 +53,7 @@ namespace AL
 
 	R_HW::GfxImage* LoadTexture(const char* assetName, const char* assetPath, I_ImageAlloctor* allocator )
 	{
+		PROFILE_ZONE( "AL::LoadTexture" );
 		R_HW::GfxImage* image = AL_GetImageSlot( assetName );
 		Load2DTextureFromFile( assetPath, image, allocator );
 		return image;
@@ -59,6 +61,7 @@ namespace AL
 
 	R_HW::GfxImage* LoadCubeTexture(const char* assetName, const char* assetPath, I_ImageAlloctor* allocator )
 	{
+		PROFILE_ZONE( "AL::LoadCubeTexture" );
 		R_HW::GfxImage* cubeImage = AL_GetImageSlot( assetName );
 		Load3DTexture( assetPath, cubeImage, allocator );
 
@@ -75,16 +78,18 @@ namespace AL
 
 	GfxModel* Load3DModel (const char* assetName, const char* assetPath, uint32_t hackIndex, R_HW::I_BufferAllocator* allocator )
 	{
+		PROFILE_ZONE( "AL::Load3DModel" );
 		GfxModel* modelAsset = AL_GetModelSlot( assetName );
 		LoadModel_AssImp( assetPath, *modelAsset, hackIndex, allocator );
 
 		return modelAsset;
 	}
 
-	GfxModel* LoadglTf3DModel( const char* assetName, const char* assetPath, R_HW::I_BufferAllocator* allocator )
+	GfxModel* LoadglTf3DModel( const char* assetName, const char* assetPath, R_HW::I_BufferAllocator* allocator, GeometryPool* geometryPool )
 	{
+		PROFILE_ZONE( "AL::LoadglTf3DModel" );
 		GfxModel* modelAsset = AL_GetModelSlot( assetName );
-		glTF_L::LoadMesh( assetPath, modelAsset, allocator );
+		glTF_L::LoadMesh( assetPath, modelAsset, allocator, geometryPool );
 
 		return modelAsset;
 	}
@@ -1,6 +1,7 @@
 #include "console_command.h"
 
 #include "input.h"
+#include "cpu_profiler.h"
 
 #include <map>
 #include <sstream>
@@ -116,10 +117,26 @@ namespace ConCom
 		console_string.clear();
 	}
 
+	static void ProfileDumpCallback(const std::string* params, uint32_t paramsCount)
+	{
+		const char* fileName = paramsCount > 1 ? params[1].c_str() : "profile_trace.json";
+		if (PROF::DumpChromeTrace(fileName))
+			std::cout << "CPU profile written to " << fileName << std::endl;
+		else
+			std::cout << "Failed to write CPU profile to " << fileName << std::endl;
+	}
+
+	static void ProfileClearCallback(const std::string* params, uint32_t paramsCount)
+	{
+		PROF::Clear();
+	}
+
 	void Init()
 	{
 		Cleanup();
 		IH::RegisterCharacterCallback(CharacterReceived);
+		RegisterCommand("profile_dump", &ProfileDumpCallback);
+		RegisterCommand("profile_clear", &ProfileClearCallback);
 	}
 
 	bool isOpen()
@@ -19,4 +19,27 @@ namespace FS
 
 		return buffer;
 	}
+
+	bool tryReadFile( const std::string& filename, std::vector<char>* o_data )
+	{
+		std::ifstream file( filename, std::ios::ate | std::ios::binary );
+		if( !file.is_open() )
+			return false;
+
+		const size_t file_size = static_cast< size_t >( file.tellg() );
+		o_data->resize( file_size );
+		file.seekg( 0 );
+		file.read( o_data->data(), file_size );
+		return file.good();
+	}
+
+	bool writeFile( const std::string& filename, const std::vector<char>& data )
+	{
+		std::ofstream file( filename, std::ios::binary | std::ios::trunc );
+		if( !file.is_open() )
+			return false;
+
+		file.write( data.data(), data.size() );
+		return file.good();
+	}
 }
\ No newline at end of file
@@ -11,13 +11,25 @@
 #undef max
 #undef min
 
-const int SIMULTANEOUS_FRAMES = 2;
+//Max frames in flight, per frame resources are sized for it. The count actually used is g_gfx.framesInFlight
+const int SIMULTANEOUS_FRAMES = 4;
 
 #include <vector> //TODO: remove this, used in some structures
 #include "glm/vec4.hpp"
 
 namespace R_HW
 {
+	constexpr uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ull;
+
+	//FNV-1a, a hash can be continued over several blocks by passing it as the seed of the next one
+	inline uint64_t HashFnv1a( const void* data, size_t size, uint64_t seed = FNV1A_OFFSET_BASIS )
+	{
+		const uint8_t* bytes = static_cast< const uint8_t* >( data );
+		uint64_t hash = seed;
+		for( size_t i = 0; i < size; ++i )
+			hash = ( hash ^ bytes[i] ) * 1099511628211ull;
+		return hash;
+	}
 
 	struct GpuInstance
 	{
@@ -49,6 +61,23 @@ namespace R_HW
 		Queue present_queue;
 		Queue compute_queue;
 		Queue transfer_queue;
+
+		//Limits of the physical device, offsets in buffers bound to descriptors have to respect them
+		GfxDeviceSize minUniformBufferOffsetAlignment = 1;
+		GfxDeviceSize minStorageBufferOffsetAlignment = 1;
+		GfxDeviceSize nonCoherentAtomSize = 1;
+
+		//Used by every pipeline creation, see CreatePipelineCache
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
+		//VK_KHR_maintenance5 is enabled, pipelines take their SPIR-V directly instead of a shader module
+		bool inlineShaderModules = false;
+		//VK_KHR_present_id and VK_KHR_present_wait are enabled, see PresentDone
+		bool presentWait = false;
+		//VK_EXT_calibrated_timestamps is enabled with a host time domain matching std::chrono::steady_clock, see GetCalibratedTimestamps
+		bool calibratedTimestamps = false;
+		//Nanoseconds per GPU timestamp tick
+		float timestampPeriod = 1.0f;
 	};
 
 	enum class GfxFormat
@@ -262,6 +291,21 @@ namespace R_HW
 		GFX_PIPELINE_STAGE_ALL_COMMANDS_BIT = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
 	};
 
+	typedef VkAccessFlags GfxMemoryAccessFlags;
+
+	enum GfxMemoryAccessFlagBits : GfxMemoryAccessFlags {
+		GFX_ACCESS_INDIRECT_COMMAND_READ_BIT = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+		GFX_ACCESS_UNIFORM_READ_BIT = VK_ACCESS_UNIFORM_READ_BIT,
+		GFX_ACCESS_SHADER_READ_BIT = VK_ACCESS_SHADER_READ_BIT,
+		GFX_ACCESS_SHADER_WRITE_BIT = VK_ACCESS_SHADER_WRITE_BIT,
+		GFX_ACCESS_TRANSFER_READ_BIT = VK_ACCESS_TRANSFER_READ_BIT,
+		GFX_ACCESS_TRANSFER_WRITE_BIT = VK_ACCESS_TRANSFER_WRITE_BIT,
+		GFX_ACCESS_HOST_WRITE_BIT = VK_ACCESS_HOST_WRITE_BIT,
+	};
+
+	//Global memory barrier, used for buffers written by a shader and read later in the frame
+	void GfxMemoryBarrier( GfxCommandBuffer commandBuffer, GfxPipelineStageFlag srcStages, GfxMemoryAccessFlags srcAccess, GfxPipelineStageFlag dstStages, GfxMemoryAccessFlags dstAccess );
+
 	typedef VkQueryPool GfxTimeStampQueryPool;
 
 	GfxTimeStampQueryPool GfxApiCreateTimeStampsQueryPool( uint32_t queriesCount );
@@ -270,6 +314,15 @@ namespace R_HW
 	void GfxApiGetTimeStampResults( GfxTimeStampQueryPool timeStampQueryPool, uint32_t firstQueryId, uint32_t count, uint64_t* values );
 	void GfxApiCmdWriteTimestamp( GfxCommandBuffer commandBuffer, GfxTimeStampQueryPool timeStampQueryPool, GfxPipelineStageFlagBits stageBits, uint32_t queryId );
 
+	//Clock behind std::chrono::steady_clock
+#ifdef _WIN32
+	constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+	constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+	//A GPU timestamp and the steady clock, in nanoseconds since its epoch, sampled at the same time. Needs g_gfx.device.calibratedTimestamps
+	void GetCalibratedTimestamps( uint64_t* o_gpuTimestamp, uint64_t* o_hostNanoseconds );
+
 	inline VkFilter ToVkFilter( GfxFilter filter )
 	{
 		return static_cast< VkFilter >(filter);
@@ -321,13 +374,17 @@ namespace R_HW
 		IMAGE,
 		SAMPLER,
 		IMAGE_SAMPLER,
+		BUFFER_STORAGE,
 	};
 
 	inline bool IsBufferType( eDescriptorType type )
 	{
-		return type == eDescriptorType::BUFFER || type == eDescriptorType::BUFFER_DYNAMIC;
+		return type == eDescriptorType::BUFFER || type == eDescriptorType::BUFFER_DYNAMIC || type == eDescriptorType::BUFFER_STORAGE;
 	}
 
+	//Alignment of the offsets of a buffer bound as type, dynamic buffers are read as uniform buffers
+	GfxDeviceSize GetMinBufferOffsetAlignment( eDescriptorType type );
+
 	//TODO: Remove in favor of GfxAccess?
 	enum eDescriptorAccess
 	{
@@ -338,6 +395,13 @@ namespace R_HW
 	VkDescriptorType DescriptorTypeToVkType( eDescriptorType type, eDescriptorAccess access );
 
 	typedef VkDescriptorSetLayoutBinding GfxDescriptorTableLayoutBinding;
+
+	enum GfxDescriptorBindingFlagBits
+	{
+		//Array written while in use whose elements don't all have to be valid, only what is sampled has to be
+		GFX_DESCRIPTOR_BINDING_BINDLESS = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT,
+	};
+	typedef GfxFlags GfxDescriptorBindingFlags;
 	typedef VkDescriptorSetLayout GfxDescriptorTableLayout;
 	typedef VkDescriptorSet GfxDescriptorTable;
 	typedef VkDescriptorSet GfxRootDescriptor;
@@ -386,6 +450,7 @@ namespace R_HW
 	struct WriteDescriptor
 	{
 		uint32_t				dstBinding;
+		uint32_t				dstArrayElement;
 		uint32_t				count;
 		VkDescriptorType		type;
 		union {
@@ -408,6 +473,11 @@ namespace R_HW
 		GfxDeviceSize offset;
 		GfxDeviceSize size;
 		bool is_parent_pool;
+		//Host visible memory stays mapped for its whole life, points to offset in the mapping
+		void* mappedData;
+		bool hostCoherent;
+		//Size of the whole VkDeviceMemory, flushes can't go past it
+		GfxDeviceSize memorySize;
 	};
 
 	struct GfxImage {
@@ -447,6 +517,8 @@ namespace R_HW
 	public:
 		virtual bool Allocate( GfxApiBuffer buffer, GfxMemAlloc* o_gfx_mem_alloc ) = 0;
 		virtual bool UploadData( const GpuBuffer& buffer, const void* data ) = 0;
+		//Uploads size bytes at offset in the buffer
+		virtual bool UploadData( const GpuBuffer& buffer, const void* data, GfxDeviceSize size, GfxDeviceSize offset ) = 0;
 	};
 
 	void CreateCommitedGpuBuffer( GfxDeviceSize size, GfxBufferUsageFlags bufferUsageFlags, GfxMemoryPropertyFlags memoryProperties, GpuBuffer* o_buffer );
@@ -459,32 +531,73 @@ namespace R_HW
 		return buffer.buffer != VK_NULL_HANDLE;
 	}
 
+	//Writes to any number of tables, all submitted in a single update. firstElement is the first element of an array binding that is written
 	class BatchDescriptorsUpdater
 	{
 	private:
-		static constexpr size_t MAX_DESCRIPTOR_PER_UPDATE = 64;
-		WriteDescriptor writeDescriptors[8];
-		uint32_t writeDescriptorsCount = 0;
-
-		VkDescriptorBufferInfo descriptorBuffersInfos[MAX_DESCRIPTOR_PER_UPDATE];
-		uint32_t descriptorBuffersInfosCount = 0;
-		VkDescriptorImageInfo descriptorImagesInfos[MAX_DESCRIPTOR_PER_UPDATE];
-		uint32_t descriptorImagesInfosCount = 0;
+		struct PendingWrite
+		{
+			GfxDescriptorTable table;
+			uint32_t binding;
+			uint32_t firstElement;
+			uint32_t count;
+			VkDescriptorType type;
+			//In descriptorBuffersInfos or descriptorImagesInfos depending on the type, the vectors can still grow
+			size_t firstInfo;
+			bool isBuffer;
+		};
+		std::vector<PendingWrite> writes;
+		std::vector<VkDescriptorBufferInfo> descriptorBuffersInfos;
+		std::vector<VkDescriptorImageInfo> descriptorImagesInfos;
 
 	public:
-		void AddImagesBinding( const GfxImageSamplerCombined* images, uint32_t count, uint32_t bindingSlot, eDescriptorType type, eDescriptorAccess access );
-		void AddBuffersBinding( const GpuBuffer* buffers, uint32_t count, uint32_t bindingSlot, eDescriptorType type, eDescriptorAccess access );
-		void AddSamplersBinding( const GfxApiSampler* samplers, uint32_t count, uint32_t bindingSlot );
+		void AddImagesBinding( GfxDescriptorTable table, const GfxImageSamplerCombined* images, uint32_t count, uint32_t bindingSlot, uint32_t firstElement, eDescriptorType type, eDescriptorAccess access );
+		void AddBuffersBinding( GfxDescriptorTable table, const GpuBuffer* buffers, uint32_t count, uint32_t bindingSlot, uint32_t firstElement, eDescriptorType type, eDescriptorAccess access );
+		void AddSamplersBinding( GfxDescriptorTable table, const GfxApiSampler* samplers, uint32_t count, uint32_t bindingSlot, uint32_t firstElement );
 		//TODO: I could maybe use the union GpuInputDataEntry instead of void* ...
-		void AddBinding( const void* data, uint32_t count, uint32_t binding, eDescriptorType type, eDescriptorAccess access );
-		void Submit( GfxDescriptorTable descriptorTable );
+		void AddBinding( GfxDescriptorTable table, const void* data, uint32_t count, uint32_t binding, uint32_t firstElement, eDescriptorType type, eDescriptorAccess access );
+		void Submit();
 	};
 
 	void CreateDescriptorPool( uint32_t uniformBuffersCount, uint32_t uniformBufferDynamicCount, uint32_t combinedImageSamplerCount, uint32_t storageImageCount, uint32_t sampledImageCount, uint32_t maxSets, VkDescriptorPool * o_descriptorPool );
+	void CreateDescriptorPool( uint32_t uniformBuffersCount, uint32_t uniformBufferDynamicCount, uint32_t combinedImageSamplerCount, uint32_t storageImageCount, uint32_t sampledImageCount, uint32_t storageBuffersCount, uint32_t maxSets, VkDescriptorPool * o_descriptorPool );
+
+	constexpr uint32_t DESCRIPTOR_TYPE_COUNT = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT + 1;
+	//Exact room for a known set of tables, see AddDescriptorTables
+	struct DescriptorPoolSizes
+	{
+		uint32_t descriptorCounts[DESCRIPTOR_TYPE_COUNT] = {};
+		uint32_t maxTables = 0;
+		//Needed as soon as one of the tables has a GFX_DESCRIPTOR_BINDING_BINDLESS binding
+		bool updateAfterBind = false;
+	};
+	void AddDescriptorTables( const GfxDescriptorTableLayoutBinding* bindings, uint32_t bindingCount, uint32_t tableCount, DescriptorPoolSizes* io_sizes );
+	//Tables of this pool can't be freed one by one, they all go away with the pool
+	void CreateDescriptorPool( const DescriptorPoolSizes& sizes, GfxDescriptorPool* o_descriptorPool );
 	void CreateDesciptorTableLayout( const VkDescriptorSetLayoutBinding* bindings, uint32_t count, GfxDescriptorTableLayout* o_layout );
+	//bindingFlags has one entry per binding
+	void CreateDesciptorTableLayout( const VkDescriptorSetLayoutBinding* bindings, const GfxDescriptorBindingFlags* bindingFlags, uint32_t count, GfxDescriptorTableLayout* o_layout );
 	void CreateDescriptorTables( GfxDescriptorPool descriptorPool, uint32_t count, GfxDescriptorTableLayout * descriptorSetLayouts, GfxDescriptorTable* o_descriptorTables );
 	void UpdateDescriptorTables( size_t writeDescriptorTableCount, const WriteDescriptorTable* writeDescriptorTable, GfxDescriptorTable* descriptorTable );
 
+	//Writes every binding of a table in a single call from one block of packed descriptors, see PackDescriptors
+	struct GfxDescriptorUpdateTemplate
+	{
+		VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+		//Where the descriptors of each binding start in the packed data, in the order of the bindings the template was created with. NOT_IN_TEMPLATE for bindless bindings
+		std::vector<uint32_t> bindingOffsets;
+		std::vector<VkDescriptorType> bindingTypes;
+		uint32_t dataSize = 0;
+
+		static constexpr uint32_t NOT_IN_TEMPLATE = UINT32_MAX;
+	};
+	//GFX_DESCRIPTOR_BINDING_BINDLESS bindings are left out, they are written element by element. No template is created if that leaves nothing
+	void CreateDescriptorUpdateTemplate( const GfxDescriptorTableLayoutBinding* bindings, const GfxDescriptorBindingFlags* bindingFlags, uint32_t count, GfxDescriptorTableLayout layout, GfxDescriptorUpdateTemplate* o_updateTemplate );
+	//Same data as BatchDescriptorsUpdater::AddBinding, written in io_packedData for the elements [firstElement, firstElement + count) of the binding bindingIndex
+	void PackDescriptors( const GfxDescriptorUpdateTemplate& updateTemplate, uint32_t bindingIndex, uint32_t firstElement, const void* data, uint32_t count, uint8_t* io_packedData );
+	void UpdateDescriptorTable( GfxDescriptorTable table, const GfxDescriptorUpdateTemplate& updateTemplate, const uint8_t* packedData );
+	void Destroy( GfxDescriptorUpdateTemplate* updateTemplate );
+
 	void Destroy( GfxDescriptorPool* descriptorPool );
 
 	constexpr uint32_t VI_STATE_MAX_DESCRIPTIONS = 5;
@@ -496,9 +609,21 @@ namespace R_HW
 		uint32_t visDescriptionsCount;
 	};
 
+	//SPIR-V of one shader, the shader modules are shared by every pipeline using the same code and looked up by hash
+	struct ShaderCode
+	{
+		std::vector<uint32_t> words;
+		uint64_t hash;
+	};
+
+	ShaderCode CreateShaderCode( const char* spirv, size_t size );
+	//Modules live until this is called, pipelines created from them don't need them anymore
+	void DestroyShaderModules();
+	void DestroyShaderModule( const ShaderCode& code );
+
 	struct ShaderCreation
 	{
-		std::vector<char> code;
+		const ShaderCode* code;
 		const char* entryPoint;
 		GfxShaderStageFlagBits flags;
 	};
@@ -591,6 +716,10 @@ namespace R_HW
 	typedef VkSemaphore GfxSemaphore;
 	bool CreateGfxSemaphore( GfxSemaphore* pSemaphore );
 	void DestroyGfxSemaphore( GfxSemaphore* pSemaphore );
+	//Timeline semaphores hold a counter the gpu increases, the cpu can wait on a value without a fence per frame
+	bool CreateGfxTimelineSemaphore( uint64_t initialValue, GfxSemaphore* pSemaphore );
+	void WaitForSemaphoreValue( GfxSemaphore timelineSemaphore, uint64_t value );
+	uint64_t GetSemaphoreValue( GfxSemaphore timelineSemaphore );
 
 	typedef VkFence GfxFence;
 	bool CreateGfxFence( GfxFence* pFence );
@@ -600,6 +729,8 @@ namespace R_HW
 	void WaitForFence( const GfxFence* pFences, uint32_t fenceCount );
 
 	bool QueueSubmit( VkQueue queue, GfxCommandBuffer* commandBuffers, uint32_t commandBuffersCount, GfxSemaphore* pWaitSemaphores, GfxPipelineStageFlag* waitDstStageMask, uint32_t waitSemaphoresCount, GfxSemaphore* pSignalSemaphores, uint32_t signalSemaphoresCount, GfxFence signalFence );
+	//Also sets timelineSemaphore to timelineValue once the command buffers are done
+	bool QueueSubmit( VkQueue queue, GfxCommandBuffer* commandBuffers, uint32_t commandBuffersCount, GfxSemaphore* pWaitSemaphores, GfxPipelineStageFlag* waitDstStageMask, uint32_t waitSemaphoresCount, GfxSemaphore* pSignalSemaphores, uint32_t signalSemaphoresCount, GfxSemaphore timelineSemaphore, uint64_t timelineValue );
 
 	typedef VkSwapchainKHR GfxSwapchain;
 	typedef VkResult GfxSwapchainOperationResult;
@@ -610,12 +741,20 @@ namespace R_HW
 	};
 
 	bool SwapchainImageIsValid( GfxSwapchainOperationResult result );
+	//The image can still be used and its semaphore is signaled, even if the swapchain is suboptimal
+	bool SwapchainImageAcquired( GfxSwapchainOperationResult result );
 	GfxSwapchainOperationResult AcquireNextSwapchainImage( GfxSwapchain swapchain, GfxSemaphore signalSemaphore, GfxSwapchainImage* swapchainImage );
 	GfxSwapchainOperationResult QueuePresent( VkQueue presentQueue, const GfxSwapchainImage& swapchainImage, GfxSemaphore* pWaitSemaphores, uint32_t waitSemaphoresCount );
+	//presentId has to increase with each present of the swapchain, it is ignored without g_gfx.device.presentWait
+	GfxSwapchainOperationResult QueuePresent( VkQueue presentQueue, const GfxSwapchainImage& swapchainImage, GfxSemaphore* pWaitSemaphores, uint32_t waitSemaphoresCount, uint64_t presentId );
+	//Doesn't block, true once the present with presentId is visible. Needs g_gfx.device.presentWait
+	bool PresentDone( GfxSwapchain swapchain, uint64_t presentId );
 
 	void CmdBindVertexInputs( GfxCommandBuffer commandBuffer, GfxApiBuffer* pVertexBuffers, uint32_t firstBinding, uint32_t vertexBuffersCount, GfxDeviceSize* pBufferOffsets );
 	void CmdBindIndexBuffer( GfxCommandBuffer commandBuffer, GfxApiBuffer buffer, GfxDeviceSize bufferOffset, GfxIndexType indexType );
 	void CmdDrawIndexed( GfxCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance );
+	void CmdDrawIndexedIndirect( GfxCommandBuffer commandBuffer, GfxApiBuffer buffer, GfxDeviceSize offset, uint32_t drawCount, uint32_t stride );
+	void CmdDispatch( GfxCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ );
 
 	void DeviceWaitIdle( GfxDevice device );
 
@@ -626,6 +765,10 @@ namespace R_HW
 	Device create_logical_device( DisplaySurface swapchainSurface, PhysicalDevice physicalDevice, bool enableValidationLayers );
 	void Destroy( Device* device );
 
+	//savedData comes from GetPipelineCacheData, it's ignored when it was saved by another device or driver or is corrupted
+	void CreatePipelineCache( PhysicalDevice physicalDevice, const std::vector<char>& savedData, Device* device );
+	std::vector<char> GetPipelineCacheData( PhysicalDevice physicalDevice, const Device& device );
+
 	GpuInstance CreateInstance( bool useValidationLayer );
 	void Destroy( GpuInstance* gpuInstance );
 
@@ -638,9 +781,13 @@ namespace R_HW
 		UNSIGNED_SHORT,
 		UNSIGNED_INT,
 		FLOAT,
+		//Read as floats by the shaders
+		HALF_FLOAT,
+		SNORM_SHORT,
+		UNORM_BYTE,
 		ELEMENT_TYPE_COUNT
 	};
-	static const uint8_t COMPONENT_TYPE_SIZES[] = { 1, 1, 2, 2, 4, 4 };
+	static const uint8_t COMPONENT_TYPE_SIZES[] = { 1, 1, 2, 2, 4, 4, 2, 2, 1 };
 
 	struct VIDesc
 	{
@@ -664,7 +811,11 @@ namespace R_HW
 
 	uint32_t GetBindingSize( const VIDesc* binding );
 	uint32_t GetBindingDescription( const std::vector<VIBinding>& VIBindings, VIState* o_viState );
+	//Every attribute in one buffer, packed in the order of vertexLayout. VIBindings can be a subset of vertexLayout
+	uint32_t GetInterleavedStride( const std::vector<VIBinding>& vertexLayout );
+	uint32_t GetInterleavedBindingDescription( const std::vector<VIBinding>& vertexLayout, const std::vector<VIBinding>& VIBindings, VIState* o_viState );
 	void CreatePipeline( const GpuPipelineStateDesc& gpuPipelineDesc, const RenderPass& renderPass, GfxPipelineLayout pipelineLayout, GfxPipeline* o_pipeline );
+	void CreateComputePipeline( const ShaderCreation& shader, GfxPipelineLayout pipelineLayout, GfxPipeline* o_pipeline );
 
 	void MarkGfxObject( GfxApiImage image, const char * name );
 	void MarkGfxObject( GfxImageView imageView, const char * name );
@@ -697,10 +848,6 @@ namespace R_HW
 	GfxHeap create_gfx_heap( GfxDeviceSize size, GfxMemoryPropertyFlags properties );
 	void destroy( GfxHeap* gfxHeap );
 
-	/************** Gpu Synchronization *****************/
-	void unsignalSemaphore( VkSemaphore semaphore );
-
-
 	/************************ Render passes **************************/
 	struct AttachementDescription
 	{
@@ -726,16 +873,30 @@ namespace R_HW
 
 	/******** Swapchain ********/
 
+	enum class GfxPresentMode
+	{
+		//Tears, lowest latency
+		IMMEDIATE = VK_PRESENT_MODE_IMMEDIATE_KHR,
+		//Doesn't tear, the newest image replaces the one waiting for the vertical blank
+		MAILBOX = VK_PRESENT_MODE_MAILBOX_KHR,
+		//Doesn't tear, presents queue up and throttle the cpu. Always supported
+		FIFO = VK_PRESENT_MODE_FIFO_KHR,
+		//Like FIFO but a late image is shown right away and tears
+		FIFO_RELAXED = VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+	};
+
 	struct Swapchain {
 		std::vector<GfxImage> images;
 		uint32_t imageCount;
 		GfxSwapchain swapchain;
 		GfxSurfaceFormat surfaceFormat;
-		VkPresentModeKHR presentMode;
+		GfxPresentMode presentMode;
 		VkExtent2D extent;
 	};
 
-	void CreateSwapChain( DisplaySurface vkSurface, uint32_t maxWidth, uint32_t maxHeight, Swapchain& o_swapchain );
+	//The swapchain gets at least minImageCount images. oldSwapchain, or VK_NULL_HANDLE, is retired but can still present the images already acquired
+	//Falls back to FIFO when the surface doesn't support presentMode, o_swapchain.presentMode is the mode used
+	void CreateSwapChain( DisplaySurface vkSurface, uint32_t maxWidth, uint32_t maxHeight, uint32_t minImageCount, GfxPresentMode presentMode, GfxSwapchain oldSwapchain, Swapchain& o_swapchain );
 	void Destroy( Swapchain* Swapchain );
 
 	/******************** memory *********************/
@@ -745,6 +906,13 @@ namespace R_HW
 	void* MapGpuMemory( const GfxMemAlloc& dstMemory, GfxDeviceSize size, GfxDeviceSize offset );
 	void UnmapMemory( const GfxMemAlloc& dstMemory );
 	void UpdateGpuMemory( const GfxMemAlloc* dstMemory, const void* src, GfxDeviceSize size, GfxDeviceSize offset );
+	//Makes host writes visible to the device, does nothing on coherent memory
+	void FlushGpuMemory( const GfxMemAlloc& dstMemory, GfxDeviceSize size, GfxDeviceSize offset );
+
+	inline GfxDeviceSize AlignUp( GfxDeviceSize value, GfxDeviceSize alignment )
+	{
+		return ( ( value + alignment - 1 ) / alignment ) * alignment;
+	}
 
 	inline bool IsValid( const GfxMemAlloc& mem_alloc )
 	{
@@ -794,6 +962,8 @@ struct Gfx_Globals {
 	R_HW::PhysicalDevice physicalDevice = VK_NULL_HANDLE;
 	R_HW::Device device = {};
 	R_HW::GfxCommandPool graphicsSingleUseCommandPool = VK_NULL_HANDLE;
+	//Frames the cpu records ahead of the gpu, chosen when the renderer is created
+	uint32_t framesInFlight = 2;
 };
 
 extern Gfx_Globals g_gfx;
\ No newline at end of file
@@ -10,21 +10,31 @@ namespace R_HW
 {
 	void CreateDescriptorPool( uint32_t uniformBuffersCount, uint32_t uniformBufferDynamicCount, uint32_t combinedImageSamplerCount, uint32_t storageImageCount, uint32_t sampledImageCount, uint32_t maxSets, VkDescriptorPool * o_descriptorPool )
 	{
-		std::array<VkDescriptorPoolSize, 5> poolSizes = {};
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = uniformBuffersCount;
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[1].descriptorCount = combinedImageSamplerCount;
-		poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		poolSizes[2].descriptorCount = storageImageCount;
-		poolSizes[3].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-		poolSizes[3].descriptorCount = uniformBufferDynamicCount;
-		poolSizes[4].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		poolSizes[4].descriptorCount = sampledImageCount;
+		CreateDescriptorPool( uniformBuffersCount, uniformBufferDynamicCount, combinedImageSamplerCount, storageImageCount, sampledImageCount, 0, maxSets, o_descriptorPool );
+	}
+
+	void CreateDescriptorPool( uint32_t uniformBuffersCount, uint32_t uniformBufferDynamicCount, uint32_t combinedImageSamplerCount, uint32_t storageImageCount, uint32_t sampledImageCount, uint32_t storageBuffersCount, uint32_t maxSets, VkDescriptorPool * o_descriptorPool )
+	{
+		const std::array<VkDescriptorPoolSize, 6> requestedSizes = { {
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uniformBuffersCount },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, combinedImageSamplerCount },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storageImageCount },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, uniformBufferDynamicCount },
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, sampledImageCount },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffersCount } } };
+
+		//A pool size with no descriptors is invalid
+		std::array<VkDescriptorPoolSize, 6> poolSizes = {};
+		uint32_t poolSizeCount = 0;
+		for( const VkDescriptorPoolSize& size : requestedSizes )
+		{
+			if( size.descriptorCount > 0 )
+				poolSizes[poolSizeCount++] = size;
+		}
 
 		VkDescriptorPoolCreateInfo poolInfo = {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast< uint32_t >(poolSizes.size());
+		poolInfo.poolSizeCount = poolSizeCount;
 		poolInfo.pPoolSizes = poolSizes.data();
 		poolInfo.maxSets = maxSets;
 		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
@@ -33,6 +43,43 @@ namespace R_HW
 			throw std::runtime_error( "failed to create descriptor pool!" );
 	}
 
+	void AddDescriptorTables( const GfxDescriptorTableLayoutBinding* bindings, uint32_t bindingCount, uint32_t tableCount, DescriptorPoolSizes* io_sizes )
+	{
+		for( uint32_t i = 0; i < bindingCount; ++i )
+		{
+			assert( bindings[i].descriptorType < DESCRIPTOR_TYPE_COUNT );
+			io_sizes->descriptorCounts[bindings[i].descriptorType] += bindings[i].descriptorCount * tableCount;
+		}
+		io_sizes->maxTables += tableCount;
+	}
+
+	void CreateDescriptorPool( const DescriptorPoolSizes& sizes, GfxDescriptorPool* o_descriptorPool )
+	{
+		assert( sizes.maxTables > 0 );
+
+		std::array<VkDescriptorPoolSize, DESCRIPTOR_TYPE_COUNT> poolSizes = {};
+		uint32_t poolSizeCount = 0;
+		for( uint32_t type = 0; type < DESCRIPTOR_TYPE_COUNT; ++type )
+		{
+			if( sizes.descriptorCounts[type] == 0 )
+				continue;
+			poolSizes[poolSizeCount].type = static_cast< VkDescriptorType >( type );
+			poolSizes[poolSizeCount].descriptorCount = sizes.descriptorCounts[type];
+			++poolSizeCount;
+		}
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = poolSizeCount;
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = sizes.maxTables;
+		if( sizes.updateAfterBind )
+			poolInfo.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+
+		if( vkCreateDescriptorPool( g_gfx.device.device, &poolInfo, nullptr, o_descriptorPool ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to create descriptor pool!" );
+	}
+
 	void CreateDescriptorTables( GfxDescriptorPool descriptorPool, uint32_t count, GfxDescriptorTableLayout * descriptorSetLayouts, GfxDescriptorTable* o_descriptorSets )
 	{
 		VkDescriptorSetAllocateInfo allocInfo = {};
@@ -59,7 +106,7 @@ namespace R_HW
 				writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 				writeDescriptorSet.dstSet = descriptorSet;
 				writeDescriptorSet.dstBinding = writeDescriptor->dstBinding;
-				writeDescriptorSet.dstArrayElement = 0;
+				writeDescriptorSet.dstArrayElement = writeDescriptor->dstArrayElement;
 				writeDescriptorSet.descriptorType = writeDescriptor->type;
 				writeDescriptorSet.descriptorCount = writeDescriptor->count;
 				writeDescriptorSet.pBufferInfo = writeDescriptor->pBufferInfos;
@@ -74,12 +121,37 @@ namespace R_HW
 	}
 
 	void CreateDesciptorTableLayout( const VkDescriptorSetLayoutBinding* bindings, uint32_t count, GfxDescriptorTableLayout* o_layout )
+	{
+		CreateDesciptorTableLayout( bindings, nullptr, count, o_layout );
+	}
+
+	void CreateDesciptorTableLayout( const VkDescriptorSetLayoutBinding* bindings, const GfxDescriptorBindingFlags* bindingFlags, uint32_t count, GfxDescriptorTableLayout* o_layout )
 	{
 		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 		layoutInfo.bindingCount = count;
 		layoutInfo.pBindings = bindings;
 
+		std::array<VkDescriptorBindingFlagsEXT, 16> vkBindingFlags = {};
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+		if( bindingFlags )
+		{
+			assert( count <= vkBindingFlags.size() );
+			bool updateAfterBind = false;
+			for( uint32_t i = 0; i < count; ++i )
+			{
+				vkBindingFlags[i] = static_cast< VkDescriptorBindingFlagsEXT >( bindingFlags[i] );
+				updateAfterBind |= (vkBindingFlags[i] & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT) != 0;
+			}
+
+			bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+			bindingFlagsInfo.bindingCount = count;
+			bindingFlagsInfo.pBindingFlags = vkBindingFlags.data();
+			layoutInfo.pNext = &bindingFlagsInfo;
+			if( updateAfterBind )
+				layoutInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		}
+
 		//Describe complete set of resources available (image, sampler, ubo, constants, ...)
 		if( vkCreateDescriptorSetLayout( g_gfx.device.device, &layoutInfo, nullptr, o_layout ) != VK_SUCCESS )
 			throw std::runtime_error( "failed to create descriptor set layout!" );
@@ -107,6 +179,8 @@ namespace R_HW
 			return write ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		case eDescriptorType::BUFFER_DYNAMIC:
 			return write ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		case eDescriptorType::BUFFER_STORAGE:
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 		case eDescriptorType::IMAGE:
 			return write ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
 		case eDescriptorType::SAMPLER:
@@ -120,6 +194,101 @@ namespace R_HW
 		}
 	}
 
+	static bool IsBufferVkType( VkDescriptorType type )
+	{
+		return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER || type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	}
+
+	static uint32_t GetPackedDescriptorSize( VkDescriptorType type )
+	{
+		return IsBufferVkType( type ) ? sizeof( VkDescriptorBufferInfo ) : sizeof( VkDescriptorImageInfo );
+	}
+
+	void CreateDescriptorUpdateTemplate( const GfxDescriptorTableLayoutBinding* bindings, const GfxDescriptorBindingFlags* bindingFlags, uint32_t count, GfxDescriptorTableLayout layout, GfxDescriptorUpdateTemplate* o_updateTemplate )
+	{
+		std::array<VkDescriptorUpdateTemplateEntry, 16> entries;
+		assert( count <= entries.size() );
+
+		o_updateTemplate->bindingOffsets.resize( count );
+		o_updateTemplate->bindingTypes.resize( count );
+		uint32_t offset = 0;
+		uint32_t entryCount = 0;
+		for( uint32_t i = 0; i < count; ++i )
+		{
+			const GfxDescriptorTableLayoutBinding& binding = bindings[i];
+			o_updateTemplate->bindingTypes[i] = binding.descriptorType;
+			if( bindingFlags[i] & GFX_DESCRIPTOR_BINDING_BINDLESS )
+			{
+				o_updateTemplate->bindingOffsets[i] = GfxDescriptorUpdateTemplate::NOT_IN_TEMPLATE;
+				continue;
+			}
+
+			const uint32_t stride = GetPackedDescriptorSize( binding.descriptorType );
+			VkDescriptorUpdateTemplateEntry& entry = entries[entryCount++];
+			entry.dstBinding = binding.binding;
+			entry.dstArrayElement = 0;
+			entry.descriptorCount = binding.descriptorCount;
+			entry.descriptorType = binding.descriptorType;
+			entry.offset = offset;
+			entry.stride = stride;
+
+			o_updateTemplate->bindingOffsets[i] = offset;
+			offset += stride * binding.descriptorCount;
+		}
+		o_updateTemplate->dataSize = offset;
+		if( entryCount == 0 )
+			return;
+
+		VkDescriptorUpdateTemplateCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		createInfo.descriptorUpdateEntryCount = entryCount;
+		createInfo.pDescriptorUpdateEntries = entries.data();
+		createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		createInfo.descriptorSetLayout = layout;
+
+		if( vkCreateDescriptorUpdateTemplate( g_gfx.device.device, &createInfo, nullptr, &o_updateTemplate->updateTemplate ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to create descriptor update template!" );
+	}
+
+	void PackDescriptors( const GfxDescriptorUpdateTemplate& updateTemplate, uint32_t bindingIndex, uint32_t firstElement, const void* data, uint32_t count, uint8_t* io_packedData )
+	{
+		assert( updateTemplate.bindingOffsets[bindingIndex] != GfxDescriptorUpdateTemplate::NOT_IN_TEMPLATE );
+		const VkDescriptorType type = updateTemplate.bindingTypes[bindingIndex];
+		uint8_t* dst = io_packedData + updateTemplate.bindingOffsets[bindingIndex] + firstElement * GetPackedDescriptorSize( type );
+		if( IsBufferVkType( type ) )
+		{
+			const GpuBuffer* buffers = reinterpret_cast< const GpuBuffer* >(data);
+			VkDescriptorBufferInfo* bufferInfos = reinterpret_cast< VkDescriptorBufferInfo* >(dst);
+			for( uint32_t i = 0; i < count; ++i )
+				bufferInfos[i] = { buffers[i].buffer, 0, VK_WHOLE_SIZE };
+		}
+		else if( type == VK_DESCRIPTOR_TYPE_SAMPLER )
+		{
+			const GfxApiSampler* samplers = reinterpret_cast< const GfxApiSampler* >(data);
+			VkDescriptorImageInfo* imageInfos = reinterpret_cast< VkDescriptorImageInfo* >(dst);
+			for( uint32_t i = 0; i < count; ++i )
+				imageInfos[i] = { samplers[i], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+		}
+		else
+		{
+			const GfxImageSamplerCombined* images = reinterpret_cast< const GfxImageSamplerCombined* >(data);
+			VkDescriptorImageInfo* imageInfos = reinterpret_cast< VkDescriptorImageInfo* >(dst);
+			for( uint32_t i = 0; i < count; ++i )
+				imageInfos[i] = { images[i].sampler, images[i].image->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		}
+	}
+
+	void UpdateDescriptorTable( GfxDescriptorTable table, const GfxDescriptorUpdateTemplate& updateTemplate, const uint8_t* packedData )
+	{
+		vkUpdateDescriptorSetWithTemplate( g_gfx.device.device, table, updateTemplate.updateTemplate, packedData );
+	}
+
+	void Destroy( GfxDescriptorUpdateTemplate* updateTemplate )
+	{
+		vkDestroyDescriptorUpdateTemplate( g_gfx.device.device, updateTemplate->updateTemplate, nullptr );
+		updateTemplate->updateTemplate = VK_NULL_HANDLE;
+	}
+
 	void Destroy( GfxDescriptorTableLayout* layout )
 	{
 		vkDestroyDescriptorSetLayout( g_gfx.device.device, *layout, nullptr );
@@ -25,6 +25,14 @@ namespace R_HW
 		*o_buffer = bind_gfx_buffer_mem( buffer, gfx_mem );
 	}
 
+	GfxDeviceSize GetMinBufferOffsetAlignment( eDescriptorType type )
+	{
+		assert( IsBufferType( type ) );
+		if( type == eDescriptorType::BUFFER_STORAGE )
+			return g_gfx.device.minStorageBufferOffsetAlignment;
+		return g_gfx.device.minUniformBufferOffsetAlignment;
+	}
+
 	void UpdateGpuBuffer( const GpuBuffer* buffer, const void* src, GfxDeviceSize size, GfxDeviceSize offset )
 	{
 		UpdateGpuMemory( &buffer->gpuMemory, src, size, offset );
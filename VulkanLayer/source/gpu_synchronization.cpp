@@ -4,35 +4,50 @@
 
 namespace R_HW
 {
-	void unsignalSemaphore( VkSemaphore semaphore )
+	bool CreateGfxSemaphore( GfxSemaphore* pSemaphore )
 	{
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-		VkSemaphore waitSemaphores[] = { semaphore };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
-		submitInfo.commandBufferCount = 0;
-		submitInfo.pCommandBuffers = VK_NULL_HANDLE;
-
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = VK_NULL_HANDLE;
-
-		if( vkQueueSubmit( g_gfx.device.graphics_queue.queue, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS ) {
-			throw std::runtime_error( "failed to submit draw command buffer!" );
-		}
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		return vkCreateSemaphore( g_gfx.device.device, &semaphoreInfo, nullptr, pSemaphore ) == VK_SUCCESS;
 	}
 
-	bool CreateGfxSemaphore( GfxSemaphore* pSemaphore )
+	bool CreateGfxTimelineSemaphore( uint64_t initialValue, GfxSemaphore* pSemaphore )
 	{
+		VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		typeInfo.initialValue = initialValue;
+
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
 
 		return vkCreateSemaphore( g_gfx.device.device, &semaphoreInfo, nullptr, pSemaphore ) == VK_SUCCESS;
 	}
 
+	void WaitForSemaphoreValue( GfxSemaphore timelineSemaphore, uint64_t value )
+	{
+		VkSemaphoreWaitInfoKHR waitInfo = {};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &timelineSemaphore;
+		waitInfo.pValues = &value;
+
+		//Extension functions aren't exported by the loader
+		static const PFN_vkWaitSemaphoresKHR waitSemaphores = ( PFN_vkWaitSemaphoresKHR )vkGetDeviceProcAddr( g_gfx.device.device, "vkWaitSemaphoresKHR" );
+		if( waitSemaphores( g_gfx.device.device, &waitInfo, std::numeric_limits<uint64_t>::max() ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to wait for timeline semaphore!" );
+	}
+
+	uint64_t GetSemaphoreValue( GfxSemaphore timelineSemaphore )
+	{
+		static const PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue = ( PFN_vkGetSemaphoreCounterValueKHR )vkGetDeviceProcAddr( g_gfx.device.device, "vkGetSemaphoreCounterValueKHR" );
+		uint64_t value = 0;
+		getSemaphoreCounterValue( g_gfx.device.device, timelineSemaphore, &value );
+		return value;
+	}
+
 	void DestroyGfxSemaphore( GfxSemaphore* pSemaphore )
 	{
 		vkDestroySemaphore( g_gfx.device.device, *pSemaphore, nullptr );
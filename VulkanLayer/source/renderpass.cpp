@@ -26,6 +26,21 @@ namespace R_HW
 		render_pass_info.pClearValues = clearValues;
 
 		vkCmdBeginRenderPass( commandBuffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
+
+		//Pipelines have a dynamic viewport covering the framebuffer
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast< float >(framebuffer.extent.width);
+		viewport.height = static_cast< float >(framebuffer.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport( commandBuffer, 0, 1, &viewport );
+
+		VkRect2D scissor = {};
+		scissor.offset = { 0, 0 };
+		scissor.extent = framebuffer.extent;
+		vkCmdSetScissor( commandBuffer, 0, 1, &scissor );
 	}
 
 	void EndRenderPass( GfxCommandBuffer commandBuffer )
@@ -22,9 +22,9 @@ namespace R_HW
 		throw std::runtime_error( "Fuck this, this should be enougth for now." );
 	}
 
-	VkPresentModeKHR choose_swap_present_mode( const std::vector<VkPresentModeKHR> available_present_modes ) {
+	VkPresentModeKHR choose_swap_present_mode( const std::vector<VkPresentModeKHR>& available_present_modes, GfxPresentMode requested_present_mode ) {
 		for( const auto& available_present_mode : available_present_modes ) {
-			if( available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR ) {
+			if( available_present_mode == static_cast< VkPresentModeKHR >( requested_present_mode ) ) {
 				return available_present_mode;
 			}
 		}
@@ -45,17 +45,19 @@ namespace R_HW
 		}
 	}
 
-	void CreateSwapChain( DisplaySurface vkSurface, uint32_t maxWidth, uint32_t maxHeight, Swapchain& o_swapchain )
+	void CreateSwapChain( DisplaySurface vkSurface, uint32_t maxWidth, uint32_t maxHeight, uint32_t minImageCount, GfxPresentMode requestedPresentMode, GfxSwapchain oldSwapchain, Swapchain& o_swapchain )
 	{
 		SwapChainSupportDetails swapChainSupport = query_swap_chain_support( g_gfx.physicalDevice, vkSurface );
 
 		VkSurfaceFormatKHR surfaceFormat = choose_swap_surface_format( swapChainSupport.formats );
-		VkPresentModeKHR presentMode = choose_swap_present_mode( swapChainSupport.present_modes );
+		VkPresentModeKHR presentMode = choose_swap_present_mode( swapChainSupport.present_modes, requestedPresentMode );
 		VkExtent2D extent = choose_swap_extent( swapChainSupport.capabilities, maxWidth, maxHeight );
 
-		uint32_t image_count = swapChainSupport.capabilities.minImageCount + 1;
+		uint32_t image_count = std::max( swapChainSupport.capabilities.minImageCount + 1, minImageCount );
 		if( swapChainSupport.capabilities.maxImageCount > 0 && image_count > swapChainSupport.capabilities.maxImageCount )
 			image_count = swapChainSupport.capabilities.maxImageCount;
+		if( image_count < minImageCount )
+			throw std::runtime_error( "the surface doesn't support enough swapchain images!" );
 
 		VkSwapchainCreateInfoKHR create_info = {};
 		create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -84,7 +86,7 @@ namespace R_HW
 		create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		create_info.presentMode = presentMode;
 		create_info.clipped = VK_TRUE;
-		create_info.oldSwapchain = VK_NULL_HANDLE;
+		create_info.oldSwapchain = oldSwapchain;
 
 		if( vkCreateSwapchainKHR( g_gfx.device.device, &create_info, nullptr, &o_swapchain.swapchain ) != VK_SUCCESS )
 			throw std::runtime_error( "failed to create swap chain!" );
@@ -99,7 +101,7 @@ namespace R_HW
 		o_swapchain.images.resize( image_count );
 		o_swapchain.imageCount = image_count;
 		o_swapchain.extent = extent;
-		o_swapchain.presentMode = presentMode;
+		o_swapchain.presentMode = static_cast< GfxPresentMode >( presentMode );
 		o_swapchain.surfaceFormat = surfaceFormat;
 		for( size_t i = 0; i < image_count; ++i )
 		{
@@ -75,4 +75,18 @@ namespace R_HW
 	{
 		GfxImageBarrier( commandBuffer, image, oldLayout, oldAccess, newLayout, newAccess, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS );
 	}
+
+	void GfxMemoryBarrier( GfxCommandBuffer commandBuffer, GfxPipelineStageFlag srcStages, GfxMemoryAccessFlags srcAccess, GfxPipelineStageFlag dstStages, GfxMemoryAccessFlags dstAccess )
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+
+		vkCmdPipelineBarrier( commandBuffer,
+			srcStages, dstStages, 0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr );
+	}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "vk_globals.h"
 
 #include <stdexcept>
+#include <cassert>
+#include <algorithm>
 
 namespace R_HW
 {
@@ -120,6 +122,7 @@ namespace R_HW
 
 	void CmdBindRootDescriptor( GfxCommandBuffer commandBuffer, GfxPipelineBindPoint pipelineBindPoint, GfxPipelineLayout pipelineLayout, uint32_t rootBindingPoint, GfxRootDescriptor rootDescriptor, uint32_t bufferOffset )
 	{
+		assert( bufferOffset % GetMinBufferOffsetAlignment( eDescriptorType::BUFFER_DYNAMIC ) == 0 );
 		vkCmdBindDescriptorSets( commandBuffer, ToVkPipelineBindPoint( pipelineBindPoint ), pipelineLayout, rootBindingPoint, 1,
 			&rootDescriptor, 1, &bufferOffset );
 	}
@@ -151,6 +154,39 @@ namespace R_HW
 		return vkQueueSubmit( queue, 1, &graphicsSubmitInfo, signalFence ) == VK_SUCCESS;
 	}
 
+	bool QueueSubmit( VkQueue queue, GfxCommandBuffer* commandBuffers, uint32_t commandBuffersCount, GfxSemaphore* pWaitSemaphores, GfxPipelineStageFlag* waitDstStageMask, uint32_t waitSemaphoresCount, GfxSemaphore* pSignalSemaphores, uint32_t signalSemaphoresCount, GfxSemaphore timelineSemaphore, uint64_t timelineValue )
+	{
+		constexpr uint32_t MAX_SIGNAL_SEMAPHORES = 8;
+		assert( signalSemaphoresCount < MAX_SIGNAL_SEMAPHORES );
+
+		//The timeline semaphore goes last, the values of binary semaphores are ignored
+		GfxSemaphore signalSemaphores[MAX_SIGNAL_SEMAPHORES];
+		uint64_t signalValues[MAX_SIGNAL_SEMAPHORES] = {};
+		std::copy( pSignalSemaphores, pSignalSemaphores + signalSemaphoresCount, signalSemaphores );
+		signalSemaphores[signalSemaphoresCount] = timelineSemaphore;
+		signalValues[signalSemaphoresCount] = timelineValue;
+
+		VkTimelineSemaphoreSubmitInfoKHR timelineSubmitInfo = {};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+		timelineSubmitInfo.signalSemaphoreValueCount = signalSemaphoresCount + 1;
+		timelineSubmitInfo.pSignalSemaphoreValues = signalValues;
+
+		VkSubmitInfo graphicsSubmitInfo = {};
+		graphicsSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		graphicsSubmitInfo.pNext = &timelineSubmitInfo;
+
+		graphicsSubmitInfo.waitSemaphoreCount = waitSemaphoresCount;
+		graphicsSubmitInfo.pWaitSemaphores = pWaitSemaphores;
+		graphicsSubmitInfo.pWaitDstStageMask = waitDstStageMask;
+		graphicsSubmitInfo.commandBufferCount = commandBuffersCount;
+		graphicsSubmitInfo.pCommandBuffers = commandBuffers;
+
+		graphicsSubmitInfo.signalSemaphoreCount = signalSemaphoresCount + 1;
+		graphicsSubmitInfo.pSignalSemaphores = signalSemaphores;
+
+		return vkQueueSubmit( queue, 1, &graphicsSubmitInfo, VK_NULL_HANDLE ) == VK_SUCCESS;
+	}
+
 	GfxSwapchainOperationResult AcquireNextSwapchainImage( GfxSwapchain swapchain, GfxSemaphore signalSemaphore, GfxSwapchainImage* swapchainImage )
 	{
 		swapchainImage->swapchain = swapchain;
@@ -165,6 +201,11 @@ namespace R_HW
 		return result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ? false : true;
 	}
 
+	bool SwapchainImageAcquired( GfxSwapchainOperationResult result )
+	{
+		return result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+	}
+
 	GfxSwapchainOperationResult QueuePresent( VkQueue presentQueue, const GfxSwapchainImage& swapchainImage, GfxSemaphore* pWaitSemaphores, uint32_t waitSemaphoresCount )
 	{
 		VkPresentInfoKHR presentInfo = {};
@@ -181,6 +222,38 @@ namespace R_HW
 		return vkQueuePresentKHR( presentQueue, &presentInfo );
 	}
 
+	GfxSwapchainOperationResult QueuePresent( VkQueue presentQueue, const GfxSwapchainImage& swapchainImage, GfxSemaphore* pWaitSemaphores, uint32_t waitSemaphoresCount, uint64_t presentId )
+	{
+		if( !g_gfx.device.presentWait )
+			return QueuePresent( presentQueue, swapchainImage, pWaitSemaphores, waitSemaphoresCount );
+
+		VkPresentIdKHR presentIdInfo = {};
+		presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+		presentIdInfo.swapchainCount = 1;
+		presentIdInfo.pPresentIds = &presentId;
+
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.pNext = &presentIdInfo;
+
+		presentInfo.waitSemaphoreCount = waitSemaphoresCount;
+		presentInfo.pWaitSemaphores = pWaitSemaphores;
+
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &swapchainImage.swapchain;
+		presentInfo.pImageIndices = &swapchainImage.imageIndex;
+
+		return vkQueuePresentKHR( presentQueue, &presentInfo );
+	}
+
+	bool PresentDone( GfxSwapchain swapchain, uint64_t presentId )
+	{
+		assert( g_gfx.device.presentWait );
+		//Extension functions aren't exported by the loader
+		static const PFN_vkWaitForPresentKHR waitForPresent = ( PFN_vkWaitForPresentKHR )vkGetDeviceProcAddr( g_gfx.device.device, "vkWaitForPresentKHR" );
+		return waitForPresent( g_gfx.device.device, swapchain, presentId, 0 ) == VK_SUCCESS;
+	}
+
 	void CmdBindVertexInputs( GfxCommandBuffer commandBuffer, GfxApiBuffer* pVertexBuffers, uint32_t firstBinding, uint32_t vertexBuffersCount, GfxDeviceSize* pBufferOffsets )
 	{
 		vkCmdBindVertexBuffers( commandBuffer, firstBinding, vertexBuffersCount, pVertexBuffers, pBufferOffsets );
@@ -196,6 +269,16 @@ namespace R_HW
 		vkCmdDrawIndexed( commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance );
 	}
 
+	void CmdDrawIndexedIndirect( GfxCommandBuffer commandBuffer, GfxApiBuffer buffer, GfxDeviceSize offset, uint32_t drawCount, uint32_t stride )
+	{
+		vkCmdDrawIndexedIndirect( commandBuffer, buffer, offset, drawCount, stride );
+	}
+
+	void CmdDispatch( GfxCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ )
+	{
+		vkCmdDispatch( commandBuffer, groupCountX, groupCountY, groupCountZ );
+	}
+
 	bool CreateCommandBuffers( GfxCommandPool commandPool, GfxCommandBuffer* pCommandBuffers, uint32_t count )
 	{
 		VkCommandBufferAllocateInfo allocInfo = {};
@@ -5,53 +5,44 @@
 namespace R_HW
 {
 	//TODO I could infer what type to use with "type" (image, buffer, etc ...)"
-	void BatchDescriptorsUpdater::AddImagesBinding( const GfxImageSamplerCombined* images, uint32_t count, uint32_t binding, eDescriptorType type, eDescriptorAccess access )
+	void BatchDescriptorsUpdater::AddImagesBinding( GfxDescriptorTable table, const GfxImageSamplerCombined* images, uint32_t count, uint32_t binding, uint32_t firstElement, eDescriptorType type, eDescriptorAccess access )
 	{
-		uint32_t bufferStart = descriptorImagesInfosCount;
+		const size_t bufferStart = descriptorImagesInfos.size();
 		for( uint32_t descriptorIndex = 0; descriptorIndex < count; ++descriptorIndex )
-		{
-			assert( descriptorImagesInfosCount < MAX_DESCRIPTOR_PER_UPDATE );
-			descriptorImagesInfos[descriptorImagesInfosCount++] = { images[descriptorIndex].sampler, images[descriptorIndex].image->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
-		}
+			descriptorImagesInfos.push_back( { images[descriptorIndex].sampler, images[descriptorIndex].image->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } );
 		//TODO: type could probably be infered
-		writeDescriptors[writeDescriptorsCount++] = { binding, count, DescriptorTypeToVkType( type, access ), reinterpret_cast< VkDescriptorBufferInfo* >(&descriptorImagesInfos[bufferStart]) };
+		writes.push_back( { table, binding, firstElement, count, DescriptorTypeToVkType( type, access ), bufferStart, false } );
 	}
 
-	void BatchDescriptorsUpdater::AddBuffersBinding( const GpuBuffer* buffers, uint32_t count, uint32_t binding, eDescriptorType type, eDescriptorAccess access )
+	void BatchDescriptorsUpdater::AddBuffersBinding( GfxDescriptorTable table, const GpuBuffer* buffers, uint32_t count, uint32_t binding, uint32_t firstElement, eDescriptorType type, eDescriptorAccess access )
 	{
-		uint32_t bufferStart = descriptorBuffersInfosCount;
+		const size_t bufferStart = descriptorBuffersInfos.size();
 		for( uint32_t descriptorIndex = 0; descriptorIndex < count; ++descriptorIndex )
-		{
-			assert( descriptorBuffersInfosCount < MAX_DESCRIPTOR_PER_UPDATE );
-			descriptorBuffersInfos[descriptorBuffersInfosCount++] = { buffers[descriptorIndex].buffer, 0, VK_WHOLE_SIZE };
-		}
-		writeDescriptors[writeDescriptorsCount++] = { binding, count, DescriptorTypeToVkType( type, access ), &descriptorBuffersInfos[bufferStart], };
+			descriptorBuffersInfos.push_back( { buffers[descriptorIndex].buffer, 0, VK_WHOLE_SIZE } );
+		writes.push_back( { table, binding, firstElement, count, DescriptorTypeToVkType( type, access ), bufferStart, true } );
 	}
 
-	void BatchDescriptorsUpdater::AddSamplersBinding( const GfxApiSampler* samplers, uint32_t count, uint32_t binding )
+	void BatchDescriptorsUpdater::AddSamplersBinding( GfxDescriptorTable table, const GfxApiSampler* samplers, uint32_t count, uint32_t binding, uint32_t firstElement )
 	{
-		uint32_t bufferStart = descriptorImagesInfosCount;
+		const size_t bufferStart = descriptorImagesInfos.size();
 		for( uint32_t descriptorIndex = 0; descriptorIndex < count; ++descriptorIndex )
-		{
-			assert( descriptorImagesInfosCount < MAX_DESCRIPTOR_PER_UPDATE );
-			descriptorImagesInfos[descriptorImagesInfosCount++] = { samplers[descriptorIndex], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
-		}
-		writeDescriptors[writeDescriptorsCount++] = { binding, count, DescriptorTypeToVkType( eDescriptorType::SAMPLER, eDescriptorAccess::READ ), reinterpret_cast< VkDescriptorBufferInfo* >(&descriptorImagesInfos[bufferStart]) };
+			descriptorImagesInfos.push_back( { samplers[descriptorIndex], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED } );
+		writes.push_back( { table, binding, firstElement, count, DescriptorTypeToVkType( eDescriptorType::SAMPLER, eDescriptorAccess::READ ), bufferStart, false } );
 	}
 
-	void BatchDescriptorsUpdater::AddBinding( const void* data, uint32_t count, uint32_t binding, eDescriptorType type, eDescriptorAccess access )
+	void BatchDescriptorsUpdater::AddBinding( GfxDescriptorTable table, const void* data, uint32_t count, uint32_t binding, uint32_t firstElement, eDescriptorType type, eDescriptorAccess access )
 	{
 		if( IsBufferType( type ) )//Buffers
 		{
-			AddBuffersBinding( reinterpret_cast< const GpuBuffer* >(data), count, binding, type, access );
+			AddBuffersBinding( table, reinterpret_cast< const GpuBuffer* >(data), count, binding, firstElement, type, access );
 		}
 		else if( type == eDescriptorType::IMAGE_SAMPLER || type == eDescriptorType::IMAGE )
 		{
-			AddImagesBinding( reinterpret_cast< const GfxImageSamplerCombined* >(data), count, binding, type, access );
+			AddImagesBinding( table, reinterpret_cast< const GfxImageSamplerCombined* >(data), count, binding, firstElement, type, access );
 		}
 		else if( type == eDescriptorType::SAMPLER )
 		{
-			AddSamplersBinding( reinterpret_cast< const GfxApiSampler* >(data), count, binding );
+			AddSamplersBinding( table, reinterpret_cast< const GfxApiSampler* >(data), count, binding, firstElement );
 		}
 		else
 		{
@@ -60,10 +51,32 @@ namespace R_HW
 		}
 	}
 
-	void BatchDescriptorsUpdater::Submit( GfxDescriptorTable descriptorSet )
+	void BatchDescriptorsUpdater::Submit()
 	{
-		WriteDescriptorTable writeDescriptorSet = { writeDescriptors, writeDescriptorsCount };
-		UpdateDescriptorTables( 1, &writeDescriptorSet, &descriptorSet );
+		if( writes.empty() )
+			return;
+
+		std::vector<VkWriteDescriptorSet> vkWriteDescriptorSets( writes.size() );
+		for( size_t i = 0; i < writes.size(); ++i )
+		{
+			const PendingWrite& write = writes[i];
+			VkWriteDescriptorSet& writeDescriptorSet = vkWriteDescriptorSets[i];
+			writeDescriptorSet = {};
+			writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSet.dstSet = write.table;
+			writeDescriptorSet.dstBinding = write.binding;
+			writeDescriptorSet.dstArrayElement = write.firstElement;
+			writeDescriptorSet.descriptorType = write.type;
+			writeDescriptorSet.descriptorCount = write.count;
+			writeDescriptorSet.pBufferInfo = write.isBuffer ? &descriptorBuffersInfos[write.firstInfo] : nullptr;
+			writeDescriptorSet.pImageInfo = write.isBuffer ? nullptr : &descriptorImagesInfos[write.firstInfo];
+		}
+
+		vkUpdateDescriptorSets( g_gfx.device.device, static_cast< uint32_t >(vkWriteDescriptorSets.size()), vkWriteDescriptorSets.data(), 0, nullptr );
+
+		writes.clear();
+		descriptorBuffersInfos.clear();
+		descriptorImagesInfos.clear();
 	}
 
 }
\ No newline at end of file
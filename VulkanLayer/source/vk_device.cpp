@@ -2,6 +2,7 @@
 #include "swapchain.h"
 #include "vk_debug.h"
 
+#include <algorithm>
 #include <optional>
 #include <string>
 #include <set>
@@ -17,6 +18,11 @@ namespace R_HW
 
 	void Destroy( Device* device )
 	{
+		if( device->pipelineCache != VK_NULL_HANDLE )
+		{
+			vkDestroyPipelineCache( device->device, device->pipelineCache, nullptr );
+			device->pipelineCache = VK_NULL_HANDLE;
+		}
 		vkDestroyDevice( device->device, nullptr );
 		device->device = VK_NULL_HANDLE;
 		device->compute_queue.queue = VK_NULL_HANDLE;
@@ -38,6 +44,29 @@ namespace R_HW
 
 	const std::vector<const char*> required_device_extensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+		//Bindless textures, see GFX_DESCRIPTOR_BINDING_BINDLESS
+		VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+		//Frame pacing, see RNDR::BeginFrame
+		VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+	};
+
+	//Optional, VK_KHR_maintenance5 and what it depends on in Vulkan 1.1
+	const std::vector<const char*> maintenance5_device_extensions = {
+		VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+		VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+		VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+		VK_KHR_MAINTENANCE_5_EXTENSION_NAME,
+	};
+
+	//Optional, tells when a present reached the screen for the latency stats
+	const std::vector<const char*> present_wait_device_extensions = {
+		VK_KHR_PRESENT_ID_EXTENSION_NAME,
+		VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+	};
+
+	//Optional, puts the GPU timestamps on the CPU clock for the latency stats
+	const std::vector<const char*> calibrated_timestamps_device_extensions = {
+		VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
 	};
 
 #define TIMESTAMP_REQUIRED_BITS 64
@@ -85,14 +114,14 @@ namespace R_HW
 		return indices;
 	}
 
-	static bool check_device_extension_support( VkPhysicalDevice device ) {
+	static bool check_device_extension_support( VkPhysicalDevice device, const std::vector<const char*>& extensions ) {
 		uint32_t extension_count;
 		vkEnumerateDeviceExtensionProperties( device, nullptr, &extension_count, nullptr );
 
 		std::vector<VkExtensionProperties> available_extensions( extension_count );
 		vkEnumerateDeviceExtensionProperties( device, nullptr, &extension_count, available_extensions.data() );
 
-		std::set<std::string> requiredExtensions( required_device_extensions.begin(), required_device_extensions.end() );
+		std::set<std::string> requiredExtensions( extensions.begin(), extensions.end() );
 
 		for( const auto& extension : available_extensions ) {
 			requiredExtensions.erase( extension.extensionName );
@@ -101,6 +130,83 @@ namespace R_HW
 		return requiredExtensions.empty();
 	}
 
+	static bool check_maintenance5_support( VkPhysicalDevice device )
+	{
+		if( !check_device_extension_support( device, maintenance5_device_extensions ) )
+			return false;
+
+		VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features = {};
+		maintenance5Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR;
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &maintenance5Features;
+		vkGetPhysicalDeviceFeatures2( device, &features );
+
+		return maintenance5Features.maintenance5 == VK_TRUE;
+	}
+
+	static bool check_present_wait_support( VkPhysicalDevice device )
+	{
+		if( !check_device_extension_support( device, present_wait_device_extensions ) )
+			return false;
+
+		VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+		presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+		VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+		presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+		presentIdFeatures.pNext = &presentWaitFeatures;
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &presentIdFeatures;
+		vkGetPhysicalDeviceFeatures2( device, &features );
+
+		return presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+	}
+
+	static bool check_calibrated_timestamps_support( VkPhysicalDevice device )
+	{
+		if( !check_device_extension_support( device, calibrated_timestamps_device_extensions ) )
+			return false;
+
+		auto getTimeDomains = ( PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT )vkGetInstanceProcAddr( g_gfx.instance.instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT" );
+		if( !getTimeDomains )
+			return false;
+
+		uint32_t timeDomainCount = 0;
+		getTimeDomains( device, &timeDomainCount, nullptr );
+		std::vector<VkTimeDomainEXT> timeDomains( timeDomainCount );
+		getTimeDomains( device, &timeDomainCount, timeDomains.data() );
+
+		return std::find( timeDomains.begin(), timeDomains.end(), VK_TIME_DOMAIN_DEVICE_EXT ) != timeDomains.end()
+			&& std::find( timeDomains.begin(), timeDomains.end(), HOST_TIME_DOMAIN ) != timeDomains.end();
+	}
+
+	static bool check_descriptor_indexing_support( VkPhysicalDevice device )
+	{
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &descriptorIndexingFeatures;
+		vkGetPhysicalDeviceFeatures2( device, &features );
+
+		return descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+			&& descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+			&& descriptorIndexingFeatures.descriptorBindingPartiallyBound == VK_TRUE;
+	}
+
+	static bool check_timeline_semaphore_support( VkPhysicalDevice device )
+	{
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures = {};
+		timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &timelineSemaphoreFeatures;
+		vkGetPhysicalDeviceFeatures2( device, &features );
+
+		return timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+	}
+
 	static bool is_device_suitable( const VkPhysicalDevice device, DisplaySurface swapchain_surface )
 	{
 		VkPhysicalDeviceProperties deviceProperties;
@@ -111,10 +217,15 @@ namespace R_HW
 
 		bool suitable = deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
 		suitable |= find_queue_families( device, swapchain_surface ).is_complete();
-		suitable |= check_device_extension_support( device );
+		suitable |= check_device_extension_support( device, required_device_extensions );
 		suitable |= deviceFeatures.samplerAnisotropy == VK_TRUE;
 		suitable |= deviceFeatures.depthClamp == VK_TRUE;
 		suitable |= deviceFeatures.shaderSampledImageArrayDynamicIndexing == VK_TRUE;
+		suitable &= deviceFeatures.multiDrawIndirect == VK_TRUE;
+		suitable &= check_descriptor_indexing_support( device );
+		suitable &= check_timeline_semaphore_support( device );
+		//The indirect draws start at their batch's instances
+		suitable &= deviceFeatures.drawIndirectFirstInstance == VK_TRUE;
 
 		if( suitable ) {
 			SwapChainSupportDetails swapchain_details = query_swap_chain_support( device, swapchain_surface );
@@ -175,6 +286,8 @@ namespace R_HW
 		device_features.samplerAnisotropy = VK_TRUE;
 		device_features.depthClamp = VK_TRUE;
 		device_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		device_features.multiDrawIndirect = VK_TRUE;
+		device_features.drawIndirectFirstInstance = VK_TRUE;
 
 		VkDeviceCreateInfo create_info = {};
 		create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -183,8 +296,51 @@ namespace R_HW
 		create_info.pEnabledFeatures = &device_features;
 
 		//Exensions
-		create_info.enabledExtensionCount = static_cast< uint32_t >(required_device_extensions.size());
-		create_info.ppEnabledExtensionNames = required_device_extensions.data();
+		std::vector<const char*> enabled_extensions = required_device_extensions;
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		create_info.pNext = &descriptorIndexingFeatures;
+
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures = {};
+		timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+		descriptorIndexingFeatures.pNext = &timelineSemaphoreFeatures;
+
+		VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features = {};
+		maintenance5Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR;
+		const bool maintenance5 = check_maintenance5_support( physicalDevice );
+		if( maintenance5 )
+		{
+			enabled_extensions.insert( enabled_extensions.end(), maintenance5_device_extensions.begin(), maintenance5_device_extensions.end() );
+			maintenance5Features.maintenance5 = VK_TRUE;
+			timelineSemaphoreFeatures.pNext = &maintenance5Features;
+		}
+
+		VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+		presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+		VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+		presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+		const bool presentWait = check_present_wait_support( physicalDevice );
+		if( presentWait )
+		{
+			enabled_extensions.insert( enabled_extensions.end(), present_wait_device_extensions.begin(), present_wait_device_extensions.end() );
+			presentIdFeatures.presentId = VK_TRUE;
+			presentWaitFeatures.presentWait = VK_TRUE;
+			presentIdFeatures.pNext = &presentWaitFeatures;
+			presentWaitFeatures.pNext = timelineSemaphoreFeatures.pNext;
+			timelineSemaphoreFeatures.pNext = &presentIdFeatures;
+		}
+
+		const bool calibratedTimestamps = check_calibrated_timestamps_support( physicalDevice );
+		if( calibratedTimestamps )
+			enabled_extensions.insert( enabled_extensions.end(), calibrated_timestamps_device_extensions.begin(), calibrated_timestamps_device_extensions.end() );
+
+		create_info.enabledExtensionCount = static_cast< uint32_t >(enabled_extensions.size());
+		create_info.ppEnabledExtensionNames = enabled_extensions.data();
 
 		if( enableValidationLayers ) {
 			create_info.enabledLayerCount = static_cast< uint32_t >(validationLayers.size());
@@ -230,6 +386,16 @@ namespace R_HW
 		device.transfer_queue.queue = transfer_queue;
 		device.transfer_queue.queueFamilyIndex = indices.transfer_family.value();
 
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties( physicalDevice, &deviceProperties );
+		device.minUniformBufferOffsetAlignment = deviceProperties.limits.minUniformBufferOffsetAlignment;
+		device.minStorageBufferOffsetAlignment = deviceProperties.limits.minStorageBufferOffsetAlignment;
+		device.nonCoherentAtomSize = deviceProperties.limits.nonCoherentAtomSize;
+		device.inlineShaderModules = maintenance5;
+		device.presentWait = presentWait;
+		device.calibratedTimestamps = calibratedTimestamps;
+		device.timestampPeriod = deviceProperties.limits.timestampPeriod;
+
 		return device;
 	}
 }
\ No newline at end of file
@@ -45,6 +45,7 @@ VK_GLOBAL_LEVEL_FUNCTION(vkEnumerateInstanceExtensionProperties)
 VK_INSTANCE_LEVEL_FUNCTION(vkEnumeratePhysicalDevices)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceProperties)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceFeatures)
+VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceFeatures2)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceQueueFamilyProperties)
 VK_INSTANCE_LEVEL_FUNCTION(vkCreateDevice)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetDeviceProcAddr)
@@ -107,6 +108,9 @@ VK_DEVICE_LEVEL_FUNCTION(vkCreateFramebuffer)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateShaderModule)
 VK_DEVICE_LEVEL_FUNCTION(vkCreatePipelineLayout)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateGraphicsPipelines)
+VK_DEVICE_LEVEL_FUNCTION(vkCreatePipelineCache)
+VK_DEVICE_LEVEL_FUNCTION(vkGetPipelineCacheData)
+VK_DEVICE_LEVEL_FUNCTION(vkDestroyPipelineCache)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdBeginRenderPass)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdBindPipeline)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdDraw)
@@ -143,6 +147,9 @@ VK_DEVICE_LEVEL_FUNCTION(vkCreateDescriptorSetLayout)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateDescriptorPool)
 VK_DEVICE_LEVEL_FUNCTION(vkAllocateDescriptorSets)
 VK_DEVICE_LEVEL_FUNCTION(vkUpdateDescriptorSets)
+VK_DEVICE_LEVEL_FUNCTION(vkCreateDescriptorUpdateTemplate)
+VK_DEVICE_LEVEL_FUNCTION(vkUpdateDescriptorSetWithTemplate)
+VK_DEVICE_LEVEL_FUNCTION(vkDestroyDescriptorUpdateTemplate)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdBindDescriptorSets)
 VK_DEVICE_LEVEL_FUNCTION(vkDestroyDescriptorPool)
 VK_DEVICE_LEVEL_FUNCTION(vkDestroyDescriptorSetLayout)
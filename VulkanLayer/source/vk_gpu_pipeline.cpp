@@ -5,7 +5,8 @@
 namespace R_HW
 {
 	void GetAPIVIBindingDescription( const VIBinding * bindingsDescs, uint32_t count, VkVertexInputBindingDescription* VIBDescs, VkVertexInputAttributeDescription* VIADescs );
-	VkShaderModule create_shader_module( const uint32_t* byte_code, size_t size );
+	void GetAPIInterleavedVIBindingDescription( const std::vector<VIBinding>& vertexLayout, const VIBinding* bindingsDescs, uint32_t count, VkVertexInputBindingDescription* VIBDesc, VkVertexInputAttributeDescription* VIADescs );
+	void FillShaderStage( const ShaderCreation& shader, VkPipelineShaderStageCreateInfo* o_stage, VkShaderModuleCreateInfo* o_inlineModule );
 
 	uint32_t GetBindingDescription( const std::vector<VIBinding>& VIBindings, VIState* o_viCreation )
 	{
@@ -20,6 +21,19 @@ namespace R_HW
 		return count;
 	}
 
+	uint32_t GetInterleavedBindingDescription( const std::vector<VIBinding>& vertexLayout, const std::vector<VIBinding>& VIBindings, VIState* o_viCreation )
+	{
+		uint32_t count = VIBindings.size();
+		assert( count <= VI_STATE_MAX_DESCRIPTIONS );
+
+		GetAPIInterleavedVIBindingDescription( vertexLayout, VIBindings.data(), count, o_viCreation->vibDescription, o_viCreation->visDescriptions );
+
+		o_viCreation->vibDescriptionsCount = 1;
+		o_viCreation->visDescriptionsCount = count;
+
+		return 1;
+	}
+
 	void CreateGfxPipelineLayout( const GfxDescriptorTableDesc* descriptorTablesDescs, const GfxDescriptorTableLayout* descriptorTableLayouts, uint32_t descriptorTablesDescsCount, const GfxRootConstantRange* rootConstantRanges, uint32_t rootConstantRangesCount, GfxPipelineLayout* o_pipelineLayout )
 	{
 		//Order the table layouts in the order they are bound in the pipeline
@@ -55,8 +69,6 @@ namespace R_HW
 
 	void CreatePipeline( const GpuPipelineStateDesc& gpuPipelineDesc, const RenderPass& renderPass, GfxPipelineLayout pipelineLayout, GfxPipeline* o_pipeline )
 	{
-		const VkExtent2D& viewportSize = renderPass.outputFrameBuffer[0].extent;//TODO: temp hack to get a relative size;
-
 		//Vertex Input
 		const VIState& viState = gpuPipelineDesc.viState;
 		VkPipelineVertexInputStateCreateInfo vertex_input_info = {};
@@ -73,17 +85,14 @@ namespace R_HW
 		input_assembly.primitiveRestartEnable = VK_FALSE;
 
 		VkPipelineShaderStageCreateInfo shader_stages[8];
+		VkShaderModuleCreateInfo inline_modules[8];
 		uint32_t shadersCount = 0;
 
+		assert( gpuPipelineDesc.shaders.size() <= 8 );
 		for( uint8_t i = 0; i < gpuPipelineDesc.shaders.size(); ++i )
 		{
-			VkPipelineShaderStageCreateInfo& shaderStageInfo = shader_stages[shadersCount++];
-			shaderStageInfo = {};
-			shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-			shaderStageInfo.stage = ToVkShaderStageFlagBits( gpuPipelineDesc.shaders[i].flags );
-			//TODO: these cast are dangerous for alligment
-			shaderStageInfo.module = create_shader_module( reinterpret_cast< const uint32_t * >(gpuPipelineDesc.shaders[i].code.data()), gpuPipelineDesc.shaders[i].code.size() );
-			shaderStageInfo.pName = gpuPipelineDesc.shaders[i].entryPoint;
+			FillShaderStage( gpuPipelineDesc.shaders[i], &shader_stages[shadersCount], &inline_modules[shadersCount] );
+			++shadersCount;
 		}
 
 		//Rasterizer
@@ -156,25 +165,17 @@ namespace R_HW
 		color_blending_info.blendConstants[2] = 0.0f; // Optional
 		color_blending_info.blendConstants[3] = 0.0f; // Optional
 
-		//Viewport and scissors
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast< float >(viewportSize.width);
-		viewport.height = static_cast< float >(viewportSize.height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = viewportSize;
-
+		//Viewport and scissors, set by BeginRenderPass so the pipeline doesn't depend on the framebuffer size
 		VkPipelineViewportStateCreateInfo viewport_state_info = {};
 		viewport_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewport_state_info.viewportCount = 1;
-		viewport_state_info.pViewports = &viewport;
 		viewport_state_info.scissorCount = 1;
-		viewport_state_info.pScissors = &scissor;
+
+		const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineDynamicStateCreateInfo dynamic_state_info = {};
+		dynamic_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamic_state_info.dynamicStateCount = 2;
+		dynamic_state_info.pDynamicStates = dynamicStates;
 
 		//Pipeline
 		VkGraphicsPipelineCreateInfo pipeline_info = {};
@@ -189,7 +190,7 @@ namespace R_HW
 		pipeline_info.pMultisampleState = &multisampling;
 		pipeline_info.pDepthStencilState = &depthStencil; //optional
 		pipeline_info.pColorBlendState = &color_blending_info;
-		pipeline_info.pDynamicState = nullptr; //optional
+		pipeline_info.pDynamicState = &dynamic_state_info;
 
 		pipeline_info.layout = pipelineLayout;
 
@@ -205,12 +206,24 @@ namespace R_HW
 		pipeline_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
 		pipeline_info.basePipelineIndex = -1; // Optional
 
-		if( vkCreateGraphicsPipelines( g_gfx.device.device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, o_pipeline ) != VK_SUCCESS )
+		if( vkCreateGraphicsPipelines( g_gfx.device.device, g_gfx.device.pipelineCache, 1, &pipeline_info, nullptr, o_pipeline ) != VK_SUCCESS )
 			throw std::runtime_error( "failed to create graphics pipeline!" );
+	}
+
+	void CreateComputePipeline( const ShaderCreation& shader, GfxPipelineLayout pipelineLayout, GfxPipeline* o_pipeline )
+	{
+		assert( shader.flags == GFX_SHADER_STAGE_COMPUTE_BIT );
 
+		VkShaderModuleCreateInfo inline_module;
+		VkComputePipelineCreateInfo pipeline_info = {};
+		pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		FillShaderStage( shader, &pipeline_info.stage, &inline_module );
+		pipeline_info.layout = pipelineLayout;
+		pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+		pipeline_info.basePipelineIndex = -1;
 
-		for( uint8_t i = 0; i < shadersCount; ++i )
-			vkDestroyShaderModule( g_gfx.device.device, shader_stages[i].module, nullptr );
+		if( vkCreateComputePipelines( g_gfx.device.device, g_gfx.device.pipelineCache, 1, &pipeline_info, nullptr, o_pipeline ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to create compute pipeline!" );
 	}
 
 	void Destroy( GfxPipeline* pipeline )
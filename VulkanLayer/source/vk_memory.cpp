@@ -6,6 +6,13 @@
 
 namespace R_HW
 {
+	static VkMemoryPropertyFlags GetMemoryTypeProperties( GfxMemoryType type )
+	{
+		VkPhysicalDeviceMemoryProperties memProperties;
+		vkGetPhysicalDeviceMemoryProperties( g_gfx.physicalDevice, &memProperties );
+		return memProperties.memoryTypes[type].propertyFlags;
+	}
+
 	GfxMemAlloc allocate_gfx_memory( GfxDeviceSize size, GfxMemoryType type )
 	{
 		VkMemoryAllocateInfo allocInfo = {};
@@ -17,9 +24,19 @@ namespace R_HW
 		if( vkAllocateMemory( g_gfx.device.device, &allocInfo, nullptr, &memory ) != VK_SUCCESS )
 			throw std::runtime_error( "failed to allocate buffer memory!" );
 
+		//Map once, every sub allocation and update uses this mapping
+		const VkMemoryPropertyFlags properties = GetMemoryTypeProperties( type );
+		void* mappedData = nullptr;
+		if( properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+		{
+			if( vkMapMemory( g_gfx.device.device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData ) != VK_SUCCESS )
+				throw std::runtime_error( "failed to map memory!" );
+		}
+		const bool hostCoherent = ( properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) != 0;
+
 		const VkDeviceSize offset = 0;
 		const bool is_parent_pool = true;
-		return { memory, offset, size, is_parent_pool };
+		return { memory, offset, size, is_parent_pool, mappedData, hostCoherent, size };
 	}
 
 	GfxMemAlloc suballocate_gfx_memory( const GfxMemAlloc& gfx_mem, GfxDeviceSize size, GfxDeviceSize offset )
@@ -27,14 +44,19 @@ namespace R_HW
 		assert( offset + size <= gfx_mem.size );
 		assert( gfx_mem.offset == 0 );//Just to be sure right now
 		const bool is_parent_pool = false;
-		const GfxMemAlloc sub_alloc { gfx_mem.memory, gfx_mem.offset + offset, size, is_parent_pool };
+		void* mappedData = gfx_mem.mappedData ? static_cast< uint8_t* >( gfx_mem.mappedData ) + offset : nullptr;
+		const GfxMemAlloc sub_alloc { gfx_mem.memory, gfx_mem.offset + offset, size, is_parent_pool, mappedData, gfx_mem.hostCoherent, gfx_mem.memorySize };
 		return sub_alloc;
 	}
 
 	void destroy_gfx_memory( GfxMemAlloc* gfx_mem )
 	{
 		if( gfx_mem->is_parent_pool )
+		{
+			if( gfx_mem->mappedData )
+				vkUnmapMemory( g_gfx.device.device, gfx_mem->memory );
 			vkFreeMemory( g_gfx.device.device, gfx_mem->memory, nullptr );
+		}
 	}
 
 	void* MapGpuMemory( const GfxMemAlloc& dstMemory, GfxDeviceSize size, GfxDeviceSize offset )
@@ -44,6 +66,9 @@ namespace R_HW
 
 		assert( offset + size <= dstMemory.size );
 
+		if( dstMemory.mappedData )
+			return static_cast< uint8_t* >( dstMemory.mappedData ) + offset;
+
 		void* map;
 		vkMapMemory( g_gfx.device.device, dstMemory.memory, dstMemory.offset + offset, size, 0, &map );
 
@@ -52,6 +77,11 @@ namespace R_HW
 
 	void UnmapMemory( const GfxMemAlloc& dstMemory )
 	{
+		if( dstMemory.mappedData )
+		{
+			FlushGpuMemory( dstMemory, dstMemory.size, 0 );
+			return;
+		}
 		vkUnmapMemory( g_gfx.device.device, dstMemory.memory );
 	}
 
@@ -59,7 +89,30 @@ namespace R_HW
 	{
 		void* dst = MapGpuMemory( *dstMemory, size, offset );
 		memcpy( dst, src, size );
-		UnmapMemory( *dstMemory );
+		if( dstMemory->mappedData )
+			FlushGpuMemory( *dstMemory, size, offset );
+		else
+			UnmapMemory( *dstMemory );
+	}
+
+	void FlushGpuMemory( const GfxMemAlloc& dstMemory, GfxDeviceSize size, GfxDeviceSize offset )
+	{
+		assert( dstMemory.mappedData );
+		assert( offset + size <= dstMemory.size );
+		if( dstMemory.hostCoherent || size == 0 )
+			return;
+
+		//The range has to be aligned on the atom size, except when it goes to the end of the memory
+		const GfxDeviceSize atomSize = g_gfx.device.nonCoherentAtomSize;
+		const GfxDeviceSize begin = ( ( dstMemory.offset + offset ) / atomSize ) * atomSize;
+		const GfxDeviceSize end = ( ( dstMemory.offset + offset + size + atomSize - 1 ) / atomSize ) * atomSize;
+
+		VkMappedMemoryRange range = {};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = dstMemory.memory;
+		range.offset = begin;
+		range.size = end >= dstMemory.memorySize ? VK_WHOLE_SIZE : end - begin;
+		vkFlushMappedMemoryRanges( g_gfx.device.device, 1, &range );
 	}
 
 	bool IsRequiredMemoryType( GfxMemoryTypeFilter typeFilter, GfxMemoryType memoryType )
@@ -0,0 +1,96 @@
+#include "vk_globals.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace R_HW
+{
+	constexpr uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x48435050; //"PPCH"
+	constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
+	//Put in front of the driver data when saved, the driver checks its own header too but not every driver handles garbage gracefully
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+	static PipelineCacheFileHeader GetExpectedHeader( PhysicalDevice physicalDevice )
+	{
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties( physicalDevice, &deviceProperties );
+
+		PipelineCacheFileHeader header = {};
+		header.magic = PIPELINE_CACHE_FILE_MAGIC;
+		header.version = PIPELINE_CACHE_FILE_VERSION;
+		header.vendorID = deviceProperties.vendorID;
+		header.deviceID = deviceProperties.deviceID;
+		header.driverVersion = deviceProperties.driverVersion;
+		memcpy( header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE );
+		return header;
+	}
+
+	static bool IsSavedDataValid( const PipelineCacheFileHeader& expectedHeader, const std::vector<char>& savedData )
+	{
+		if( savedData.size() < sizeof( PipelineCacheFileHeader ) )
+			return false;
+
+		PipelineCacheFileHeader header;
+		memcpy( &header, savedData.data(), sizeof( header ) );
+		return header.magic == expectedHeader.magic &&
+			header.version == expectedHeader.version &&
+			header.vendorID == expectedHeader.vendorID &&
+			header.deviceID == expectedHeader.deviceID &&
+			header.driverVersion == expectedHeader.driverVersion &&
+			memcmp( header.pipelineCacheUUID, expectedHeader.pipelineCacheUUID, VK_UUID_SIZE ) == 0 &&
+			header.dataSize == savedData.size() - sizeof( PipelineCacheFileHeader ) &&
+			header.dataHash == HashFnv1a( savedData.data() + sizeof( PipelineCacheFileHeader ), header.dataSize );
+	}
+
+	void CreatePipelineCache( PhysicalDevice physicalDevice, const std::vector<char>& savedData, Device* device )
+	{
+		assert( device->pipelineCache == VK_NULL_HANDLE );
+
+		VkPipelineCacheCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		if( IsSavedDataValid( GetExpectedHeader( physicalDevice ), savedData ) )
+		{
+			createInfo.initialDataSize = savedData.size() - sizeof( PipelineCacheFileHeader );
+			createInfo.pInitialData = savedData.data() + sizeof( PipelineCacheFileHeader );
+		}
+
+		if( vkCreatePipelineCache( device->device, &createInfo, nullptr, &device->pipelineCache ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to create pipeline cache!" );
+	}
+
+	std::vector<char> GetPipelineCacheData( PhysicalDevice physicalDevice, const Device& device )
+	{
+		std::vector<char> fileData;
+		if( device.pipelineCache == VK_NULL_HANDLE )
+			return fileData;
+
+		size_t dataSize = 0;
+		if( vkGetPipelineCacheData( device.device, device.pipelineCache, &dataSize, nullptr ) != VK_SUCCESS )
+			return fileData;
+
+		fileData.resize( sizeof( PipelineCacheFileHeader ) + dataSize );
+		if( vkGetPipelineCacheData( device.device, device.pipelineCache, &dataSize, fileData.data() + sizeof( PipelineCacheFileHeader ) ) != VK_SUCCESS )
+		{
+			fileData.clear();
+			return fileData;
+		}
+		fileData.resize( sizeof( PipelineCacheFileHeader ) + dataSize );
+
+		PipelineCacheFileHeader header = GetExpectedHeader( physicalDevice );
+		header.dataSize = dataSize;
+		header.dataHash = HashFnv1a( fileData.data() + sizeof( PipelineCacheFileHeader ), dataSize );
+		memcpy( fileData.data(), &header, sizeof( header ) );
+		return fileData;
+	}
+}
\ No newline at end of file
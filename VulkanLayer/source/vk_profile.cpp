@@ -1,5 +1,7 @@
 #include "vk_globals.h"
 
+#include <cassert>
+
 namespace R_HW
 {
 	GfxTimeStampQueryPool GfxApiCreateTimeStampsQueryPool( uint32_t queriesCount )
@@ -35,4 +37,31 @@ namespace R_HW
 	{
 		vkCmdWriteTimestamp( commandBuffer, ( VkPipelineStageFlagBits )stageBits, timeStampQueryPool, queryId );
 	}
+
+	void GetCalibratedTimestamps( uint64_t* o_gpuTimestamp, uint64_t* o_hostNanoseconds )
+	{
+		assert( g_gfx.device.calibratedTimestamps );
+		//Extension functions aren't exported by the loader
+		static const PFN_vkGetCalibratedTimestampsEXT getCalibratedTimestamps = ( PFN_vkGetCalibratedTimestampsEXT )vkGetDeviceProcAddr( g_gfx.device.device, "vkGetCalibratedTimestampsEXT" );
+
+		VkCalibratedTimestampInfoEXT timestampInfos[2] = {};
+		timestampInfos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+		timestampInfos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+		timestampInfos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+		timestampInfos[1].timeDomain = HOST_TIME_DOMAIN;
+		uint64_t timestamps[2];
+		uint64_t maxDeviation;
+		getCalibratedTimestamps( g_gfx.device.device, 2, timestampInfos, timestamps, &maxDeviation );
+
+		*o_gpuTimestamp = timestamps[0];
+#ifdef _WIN32
+		//Performance counter ticks, converted the way the steady clock does
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency( &frequency );
+		const uint64_t ticksPerSecond = static_cast< uint64_t >( frequency.QuadPart );
+		*o_hostNanoseconds = timestamps[1] / ticksPerSecond * 1000000000ull + timestamps[1] % ticksPerSecond * 1000000000ull / ticksPerSecond;
+#else
+		*o_hostNanoseconds = timestamps[1];
+#endif
+	}
 }
\ No newline at end of file
@@ -1,13 +1,47 @@
 #include "vk_globals.h"
 
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
 namespace R_HW
 {
-	VkShaderModule create_shader_module( const uint32_t* byte_code, size_t size )
+	struct CachedShaderModule
+	{
+		VkShaderModule module;
+		//Codes with the same hash are told apart by their words
+		std::vector<uint32_t> words;
+	};
+
+	typedef std::unordered_multimap<uint64_t, CachedShaderModule> ShaderModules;
+
+	//Pipelines are created from several threads, see CreateTechniques
+	static std::mutex shaderModulesMutex;
+	static ShaderModules shaderModules;
+
+	constexpr uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+
+	ShaderCode CreateShaderCode( const char* spirv, size_t size )
+	{
+		if( size == 0 || size % sizeof( uint32_t ) != 0 )
+			throw std::runtime_error( "invalid SPIR-V size!" );
+
+		//Copied in uint32_t so the code is always aligned correctly
+		ShaderCode code;
+		code.words.resize( size / sizeof( uint32_t ) );
+		memcpy( code.words.data(), spirv, size );
+		if( code.words[0] != SPIRV_MAGIC_NUMBER )
+			throw std::runtime_error( "invalid SPIR-V magic number!" );
+		code.hash = HashFnv1a( code.words.data(), code.words.size() * sizeof( uint32_t ) );
+		return code;
+	}
+
+	static VkShaderModule create_shader_module( const uint32_t* byte_code, size_t size )
 	{
 		VkShaderModuleCreateInfo create_info = {};
 		create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 		create_info.codeSize = size;
-		//vector should ensure that we are aligned correctly
 		create_info.pCode = byte_code;
 
 		VkShaderModule shader_module;
@@ -16,4 +50,69 @@ namespace R_HW
 
 		return shader_module;
 	}
+
+	//shaderModulesMutex has to be locked
+	static ShaderModules::iterator FindShaderModule( const ShaderCode& code )
+	{
+		const auto range = shaderModules.equal_range( code.hash );
+		for( auto it = range.first; it != range.second; ++it )
+		{
+			if( it->second.words == code.words )
+				return it;
+		}
+		return shaderModules.end();
+	}
+
+	static VkShaderModule GetShaderModule( const ShaderCode& code )
+	{
+		std::lock_guard<std::mutex> lock( shaderModulesMutex );
+		auto it = FindShaderModule( code );
+		if( it != shaderModules.end() )
+			return it->second.module;
+
+		const VkShaderModule module = create_shader_module( code.words.data(), code.words.size() * sizeof( uint32_t ) );
+		shaderModules.insert( { code.hash, { module, code.words } } );
+		return module;
+	}
+
+	void FillShaderStage( const ShaderCreation& shader, VkPipelineShaderStageCreateInfo* o_stage, VkShaderModuleCreateInfo* o_inlineModule )
+	{
+		*o_stage = {};
+		o_stage->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		o_stage->stage = ToVkShaderStageFlagBits( shader.flags );
+		o_stage->pName = shader.entryPoint;
+
+		if( g_gfx.device.inlineShaderModules )
+		{
+			*o_inlineModule = {};
+			o_inlineModule->sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			o_inlineModule->codeSize = shader.code->words.size() * sizeof( uint32_t );
+			o_inlineModule->pCode = shader.code->words.data();
+			o_stage->pNext = o_inlineModule;
+			o_stage->module = VK_NULL_HANDLE;
+		}
+		else
+		{
+			o_stage->module = GetShaderModule( *shader.code );
+		}
+	}
+
+	void DestroyShaderModules()
+	{
+		std::lock_guard<std::mutex> lock( shaderModulesMutex );
+		for( auto& module : shaderModules )
+			vkDestroyShaderModule( g_gfx.device.device, module.second.module, nullptr );
+		shaderModules.clear();
+	}
+
+	void DestroyShaderModule( const ShaderCode& code )
+	{
+		std::lock_guard<std::mutex> lock( shaderModulesMutex );
+		auto it = FindShaderModule( code );
+		if( it == shaderModules.end() )
+			return;
+
+		vkDestroyShaderModule( g_gfx.device.device, it->second.module, nullptr );
+		shaderModules.erase( it );
+	}
 }
\ No newline at end of file
@@ -15,10 +15,24 @@ namespace R_HW
 			//A bit dangerous, there's 3 elements to reach the next float definition
 			return static_cast< VkFormat >(static_cast< uint32_t >(VK_FORMAT_R32_SFLOAT) + (binding->elementsCount - 1) * 3);
 		}
-		else
-		{
+
+		//3 components 16 and 8 bits formats are rarely supported for vertex buffers, pad to 4
+		static const VkFormat halfFormats[] = { VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16B16A16_SFLOAT };
+		static const VkFormat snormShortFormats[] = { VK_FORMAT_R16_SNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16B16A16_SNORM };
+		static const VkFormat unormByteFormats[] = { VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_UNDEFINED, VK_FORMAT_R8G8B8A8_UNORM };
+
+		const VkFormat* formats = nullptr;
+		if( binding->elementType == eVIDataElementType::HALF_FLOAT )
+			formats = halfFormats;
+		else if( binding->elementType == eVIDataElementType::SNORM_SHORT )
+			formats = snormShortFormats;
+		else if( binding->elementType == eVIDataElementType::UNORM_BYTE )
+			formats = unormByteFormats;
+
+		if( !formats || binding->elementsCount == 0 || binding->elementsCount > 4 || formats[binding->elementsCount - 1] == VK_FORMAT_UNDEFINED )
 			throw std::runtime_error( "Unimplemented" );
-		}
+
+		return formats[binding->elementsCount - 1];
 	}
 
 	void GetAPIVIBindingDescription( const VIBinding * bindingsDescs, uint32_t count, VkVertexInputBindingDescription* VIBDescs, VkVertexInputAttributeDescription* VIADescs )
@@ -35,4 +49,41 @@ namespace R_HW
 			VIADescs[i].offset = 0;
 		}
 	}
+
+	uint32_t GetInterleavedStride( const std::vector<VIBinding>& vertexLayout )
+	{
+		uint32_t stride = 0;
+		for( const VIBinding& layoutBinding : vertexLayout )
+			stride += GetBindingSize( &layoutBinding.desc );
+		return stride;
+	}
+
+	void GetAPIInterleavedVIBindingDescription( const std::vector<VIBinding>& vertexLayout, const VIBinding* bindingsDescs, uint32_t count, VkVertexInputBindingDescription* VIBDesc, VkVertexInputAttributeDescription* VIADescs )
+	{
+		VIBDesc->binding = 0;
+		VIBDesc->inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		VIBDesc->stride = GetInterleavedStride( vertexLayout );
+
+		for( uint32_t i = 0; i < count; ++i )
+		{
+			uint32_t offset = 0;
+			bool found = false;
+			for( const VIBinding& layoutBinding : vertexLayout )
+			{
+				if( layoutBinding.desc == bindingsDescs[i].desc )
+				{
+					found = true;
+					break;
+				}
+				offset += GetBindingSize( &layoutBinding.desc );
+			}
+			if( !found )
+				throw std::runtime_error( "Vertex input isn't part of the interleaved layout" );
+
+			VIADescs[i].binding = 0;
+			VIADescs[i].format = GetBindingFormat( &bindingsDescs[i].desc );
+			VIADescs[i].location = bindingsDescs[i].location;
+			VIADescs[i].offset = offset;
+		}
+	}
 }
\ No newline at end of file